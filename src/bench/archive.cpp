@@ -0,0 +1,219 @@
+#include "bench.h"
+
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+#include "loaders/loaders.h"
+
+static constexpr auto ARCHIVE_DIR = "bench_archive";
+
+// the same small files loose, packed as they are and packed compressed, then how long finding
+// a name takes and how fast compressed entries come back out
+int Bench::archive(const int argc, char** argv)
+{
+    const uint32_t nFiles = std::max(arg(argc, argv, 0, 4000), 1u);
+    const uint32_t nBytes = arg(argc, argv, 1, 16384);
+
+    const std::string looseDir = std::string(ARCHIVE_DIR) + "/loose";
+    const std::string rawPath = std::string(ARCHIVE_DIR) + "/raw.arc";
+    const std::string compressedPath = std::string(ARCHIVE_DIR) + "/compressed.arc";
+
+    std::filesystem::create_directories(looseDir);
+
+    std::vector<std::string> names;
+    std::vector<char> contents(nBytes);
+
+    Loaders::ArchiveWriter rawWriter;
+    Loaders::ArchiveWriter compressedWriter;
+
+    for (uint32_t i = 0; i < nFiles; i++)
+    {
+        // runs of repeated values with noise in between, closer to vertex data than random bytes
+        for (uint32_t j = 0; j < nBytes; j++)
+        {
+            contents[j] = static_cast<char>(j % 7 == 0 ? (i * 2654435761u + j * 40503u) >> 13 : i + j / 32);
+        }
+
+        names.push_back(std::to_string(i) + ".bin");
+        const std::string filename = looseDir + "/" + names.back();
+
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        file.write(contents.data(), nBytes);
+        file.close();
+
+        rawWriter.add(names.back(), filename, false);
+        compressedWriter.add(names.back(), filename, true);
+    }
+
+    Loaders::Archive raw;
+    Loaders::Archive compressed;
+
+    if (!rawWriter.write(rawPath.c_str()) || !compressedWriter.write(compressedPath.c_str()) ||
+        !raw.open(rawPath.c_str()) || !compressed.open(compressedPath.c_str()))
+    {
+        std::cerr << "failed to pack " << looseDir << '\n';
+        std::filesystem::remove_all(ARCHIVE_DIR);
+        return 1;
+    }
+
+    const bool canEvict = evict(rawPath);
+
+    struct Method
+    {
+        const char* name;
+        std::function<uint64_t()> run;
+    };
+
+    // through resolve() like the loaders do, with the archive mounted over the loose directory
+    const auto resolveAll = [&names, &looseDir](const Loaders::Archive* archive)
+    {
+        if (archive != nullptr)
+        {
+            Loaders::mount(archive, looseDir);
+        }
+
+        uint64_t bytes = 0;
+        Loaders::Asset asset;
+
+        for (const auto& name : names)
+        {
+            Loaders::resolve(looseDir + "/" + name, &asset);
+
+            // touched so the page actually gets read
+            bytes += asset.size() > 0 ? asset.size() + (asset.data()[0] & 0) : 0;
+        }
+
+        if (archive != nullptr)
+        {
+            Loaders::unmount(archive);
+        }
+
+        return bytes;
+    };
+
+    const Method methods[] = {
+        {"readfile", [&names, &looseDir]
+        {
+            uint64_t bytes = 0;
+            std::vector<char> buffer;
+
+            for (const auto& name : names)
+            {
+                Loaders::readfile(&buffer, (looseDir + "/" + name).c_str());
+                bytes += buffer.size();
+            }
+
+            return bytes;
+        }},
+        {"loose FileView", [&] { return resolveAll(nullptr); }},
+        {"archive", [&] { return resolveAll(&raw); }},
+        {"archive compressed", [&] { return resolveAll(&compressed); }},
+    };
+
+    uint64_t stored = 0;
+
+    for (uint32_t i = 0; i < compressed.size(); i++)
+    {
+        stored += compressed.entry(i).storedSize;
+    }
+
+    std::cout << std::fixed << std::setprecision(2)
+        << nFiles << " files of " << nBytes << " bytes, compressed to "
+        << 100.0 * static_cast<double>(stored) / (static_cast<double>(nFiles) * nBytes) << "%" << '\n';
+
+    for (const auto& method : methods)
+    {
+        for (const bool cold : {false, true})
+        {
+            if (cold && !canEvict)
+            {
+                continue;
+            }
+
+            Samples samples;
+            uint64_t bytes = 0;
+
+            for (uint32_t run = 0; run < 6; run++)
+            {
+                if (cold)
+                {
+                    for (const auto& name : names)
+                    {
+                        evict(looseDir + "/" + name);
+                    }
+
+                    evict(rawPath);
+                    evict(compressedPath);
+                }
+
+                const auto start = Clock::now();
+                bytes = method.run();
+
+                // the first run warms the cache up
+                if (run > 0)
+                {
+                    samples.add(millis(Clock::now() - start));
+                }
+            }
+
+            const double median = samples.percentile(0.5);
+
+            std::cout << "  " << std::left << std::setw(20) << method.name << std::right
+                << (cold ? " cold: " : " warm: ") << median << "ms p50, "
+                << static_cast<double>(nFiles) / (median / 1000.0) << " files/s"
+                << (bytes == static_cast<uint64_t>(nFiles) * nBytes ? "" : " (short reads!)") << '\n';
+        }
+    }
+
+    // names are looked up in a shuffled order so the entries aren't walked in sequence
+    std::vector<std::string> lookups = names;
+
+    for (size_t i = lookups.size() - 1; i > 0; i--)
+    {
+        std::swap(lookups[i], lookups[(i * 2654435761u) % (i + 1)]);
+    }
+
+    uint32_t found = 0;
+    const auto lookupStart = Clock::now();
+
+    for (uint32_t round = 0; round < 100; round++)
+    {
+        for (const auto& name : lookups)
+        {
+            found += raw.find(name) != nullptr;
+        }
+    }
+
+    const double lookupNs = millis(Clock::now() - lookupStart) * 1e6 / (100.0 * nFiles);
+    std::cout << "  find: " << lookupNs << "ns per name" << (found == 100 * nFiles ? "" : " (missing names!)") << '\n';
+
+    const std::unique_ptr<char[]> buffer(new char[nBytes]);
+    Samples decompress;
+    bool intact = true;
+
+    for (uint32_t run = 0; run < 5; run++)
+    {
+        const auto start = Clock::now();
+
+        for (uint32_t i = 0; i < compressed.size(); i++)
+        {
+            intact &= compressed.extract(compressed.entry(i), buffer.get());
+        }
+
+        decompress.add(millis(Clock::now() - start));
+    }
+
+    const double megabytes = static_cast<double>(nFiles) * nBytes / (1024.0 * 1024.0);
+    std::cout << "  extract: " << megabytes / (decompress.percentile(0.5) / 1000.0) << "MB/s, CRC checked"
+        << (intact ? "" : " (corrupt entries!)") << '\n';
+
+    raw.close();
+    compressed.close();
+
+    std::filesystem::remove_all(ARCHIVE_DIR);
+    return 0;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "test/random.h"
+
+#ifdef HAS_VULKAN
+#include "engine.h"
+#endif
+
+namespace Bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    inline double millis(const Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    // busy-waits to stand in for game logic, sleeping would hand the core away
+    inline void spin(const uint32_t micros)
+    {
+        const auto end = Clock::now() + std::chrono::microseconds(micros);
+        while (Clock::now() < end) {}
+    }
+
+    inline uint32_t arg(const int argc, char** argv, const int i, const uint32_t fallback)
+    {
+        return i < argc ? static_cast<uint32_t>(std::strtoul(argv[i], nullptr, 10)) : fallback;
+    }
+
+    struct Samples
+    {
+        std::vector<double> values;
+
+        void add(const double value)
+        {
+            this->values.push_back(value);
+        }
+
+        [[nodiscard]] double mean() const
+        {
+            if (this->values.empty()) return 0.0;
+
+            double sum = 0.0;
+            for (const auto& value : this->values) sum += value;
+
+            return sum / static_cast<double>(this->values.size());
+        }
+
+        [[nodiscard]] double percentile(const double p) const
+        {
+            if (this->values.empty()) return 0.0;
+
+            std::vector<double> sorted = this->values;
+            const auto index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+
+            std::nth_element(sorted.begin(), sorted.begin() + static_cast<long>(index), sorted.end());
+            return sorted[index];
+        }
+    };
+
+    // drops a file from the page cache so the next read comes from disk, false where that isn't possible
+    bool evict(const std::string& filename);
+
+#ifdef HAS_VULKAN
+
+    // loads the test triangle shaders (relative to the build directory) into the renderer's pipeline
+    VkResult createTrianglePipeline(Engine::Renderer* renderer);
+
+    // instance, surfaceless device, offscreen targets and the triangle pipeline
+    VkResult createHeadlessRenderer(Engine::Renderer* renderer, uint32_t width, uint32_t height);
+
+    // the triangle shaders make up their own vertices, so there's nothing to upload
+    inline Engine::Mesh triangleMesh()
+    {
+        Engine::Mesh mesh{};
+        mesh.vertexCount = 3;
+        return mesh;
+    }
+
+#endif
+
+    // every benchmark gets the arguments after its own name
+    int frames(int argc, char** argv);
+    int headless(int argc, char** argv);
+    int startup(int argc, char** argv);
+    int record(int argc, char** argv);
+    int jobs(int argc, char** argv);
+    int profiler(int argc, char** argv);
+    int graph(int argc, char** argv);
+    int resize(int argc, char** argv);
+    int pipelines(int argc, char** argv);
+    int spirv(int argc, char** argv);
+    int reload(int argc, char** argv);
+    int files(int argc, char** argv);
+    int io(int argc, char** argv);
+    int archive(int argc, char** argv);
+    int textures(int argc, char** argv);
+    int meshes(int argc, char** argv);
+    int math(int argc, char** argv);
+    int ecs(int argc, char** argv);
+    int scene(int argc, char** argv);
+    int cull(int argc, char** argv);
+}
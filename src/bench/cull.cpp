@@ -0,0 +1,165 @@
+#include "bench.h"
+
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "engine.h"
+
+using Engine::Aabb;
+using Engine::CullList;
+using Engine::Frustum;
+using Engine::JobSystem;
+using Engine::Mat4;
+using Engine::SimdLevel;
+using Engine::Sphere;
+using Engine::Vec3;
+
+namespace
+{
+    constexpr const char* LEVEL_NAMES[] = {"scalar", "sse", "avx2"};
+
+    // median of a few runs in milliseconds, the first one warms up
+    template<typename F>
+    double measure(const F& run)
+    {
+        Bench::Samples samples;
+
+        for (uint32_t i = 0; i < 12; i++)
+        {
+            const auto start = Bench::Clock::now();
+            run();
+
+            if (i > 0)
+            {
+                samples.add(Bench::millis(Bench::Clock::now() - start));
+            }
+        }
+
+        return samples.percentile(0.5);
+    }
+
+    void report(const char* name, const char* level, const uint32_t threads, const double millis, const size_t count, const double reference, const bool matches)
+    {
+        const double rate = static_cast<double>(count) / (millis * 1e3);
+
+        std::cout << "  " << std::left << std::setw(16) << name << std::setw(8) << level << std::right << std::setw(2) << threads
+            << " threads: " << std::setw(7) << millis << "ms, " << std::setw(8) << rate << "M tests/s, "
+            << std::setw(8) << rate / threads << "M per core (" << reference / millis << "x)" << (matches ? "" : " (different!)") << '\n';
+    }
+}
+
+// A million objects (or as many as given) spread over a 2km square around a camera that sees a few
+// percent of them, half bounded by spheres and half by boxes. What a draw list would do without
+// culling is test each one with intersects() and push the visible ones; CullList does it in batches
+// of 4 or 8 at every SIMD level, then split between jobs.
+int Bench::cull(const int argc, char** argv)
+{
+    const uint32_t count = std::max(arg(argc, argv, 0, 1000000), 2u);
+    const uint32_t maxThreads = std::max(arg(argc, argv, 1, std::thread::hardware_concurrency()), 1u);
+
+    uint32_t seed = 1;
+
+    std::vector<Sphere> spheres(count / 2);
+    std::vector<Aabb> boxes(count - count / 2);
+
+    for (Sphere& sphere : spheres)
+    {
+        sphere.center = {Test::random(&seed, -1000.0f, 1000.0f), Test::random(&seed, -20.0f, 20.0f), Test::random(&seed, -1000.0f, 1000.0f)};
+        sphere.radius = Test::random(&seed, 0.5f, 5.0f);
+    }
+
+    for (Aabb& box : boxes)
+    {
+        const Vec3 center = {Test::random(&seed, -1000.0f, 1000.0f), Test::random(&seed, -20.0f, 20.0f), Test::random(&seed, -1000.0f, 1000.0f)};
+        const Vec3 extent = {Test::random(&seed, 0.5f, 5.0f), Test::random(&seed, 0.5f, 5.0f), Test::random(&seed, 0.5f, 5.0f)};
+        box = {center - extent, center + extent};
+    }
+
+    const Mat4 view = Mat4::lookAt({0.0f, 10.0f, 0.0f}, {0.0f, 0.0f, -100.0f}, {0.0f, 1.0f, 0.0f});
+    const Frustum frustum = Frustum::fromMatrix(Mat4::perspective(1.0f, 16.0f / 9.0f, 0.1f, 300.0f) * view);
+
+    std::vector<uint32_t> expectedSpheres;
+    std::vector<uint32_t> expectedBoxes;
+
+    const double sphereReference = measure([&]
+    {
+        expectedSpheres.clear();
+
+        for (uint32_t i = 0; i < spheres.size(); i++)
+        {
+            if (Engine::intersects(frustum, spheres[i]))
+            {
+                expectedSpheres.push_back(i);
+            }
+        }
+    });
+
+    const double boxReference = measure([&]
+    {
+        expectedBoxes.clear();
+
+        for (uint32_t i = 0; i < boxes.size(); i++)
+        {
+            if (Engine::intersects(frustum, boxes[i]))
+            {
+                expectedBoxes.push_back(i);
+            }
+        }
+    });
+
+    std::cout << std::fixed << std::setprecision(2)
+        << spheres.size() << " spheres and " << boxes.size() << " boxes, " << expectedSpheres.size() << " and "
+        << expectedBoxes.size() << " visible" << '\n';
+
+    report("intersects()", "scalar", 1, sphereReference, spheres.size(), sphereReference, true);
+    report("  boxes", "scalar", 1, boxReference, boxes.size(), boxReference, true);
+
+    CullList sphereList;
+    CullList boxList;
+
+    for (uint32_t i = 0; i < spheres.size(); i++)
+    {
+        sphereList.add(spheres[i], i);
+    }
+
+    for (uint32_t i = 0; i < boxes.size(); i++)
+    {
+        boxList.add(boxes[i], i);
+    }
+
+    std::vector<uint32_t> visible;
+    const SimdLevel original = Engine::simdLevel();
+
+    // objects right on a plane can go either way with FMA, so a handful different is still right
+    const auto matches = [&visible](const std::vector<uint32_t>& expected)
+    {
+        const size_t larger = std::max(visible.size(), expected.size());
+        return larger - std::min(visible.size(), expected.size()) <= larger / 10000;
+    };
+
+    for (uint32_t threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        JobSystem* jobs = threads > 1 ? new JobSystem(threads) : nullptr;
+
+        // every level on one thread, just the best one on more
+        const int lowest = threads > 1 ? static_cast<int>(Engine::supportedSimdLevel()) : 0;
+
+        for (int level = lowest; level <= static_cast<int>(Engine::supportedSimdLevel()); level++)
+        {
+            Engine::setSimdLevel(static_cast<SimdLevel>(level));
+            const char* name = LEVEL_NAMES[static_cast<int>(Engine::simdLevel())];
+
+            const double sphereTime = measure([&] { sphereList.cull(frustum, &visible, jobs); });
+            report("CullList", name, threads, sphereTime, spheres.size(), sphereReference, matches(expectedSpheres));
+
+            const double boxTime = measure([&] { boxList.cull(frustum, &visible, jobs); });
+            report("  boxes", name, threads, boxTime, boxes.size(), boxReference, matches(expectedBoxes));
+        }
+
+        delete jobs;
+    }
+
+    Engine::setSimdLevel(original);
+    return 0;
+}
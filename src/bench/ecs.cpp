@@ -0,0 +1,255 @@
+#include "bench.h"
+
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "engine.h"
+
+using Engine::Commands;
+using Engine::Entity;
+using Engine::JobSystem;
+using Engine::Vec3;
+using Engine::World;
+
+namespace
+{
+    struct Position
+    {
+        Vec3 value;
+    };
+
+    struct Velocity
+    {
+        Vec3 value;
+    };
+
+    struct Health
+    {
+        float value;
+    };
+
+    struct Hit {};
+
+    // read a position and a velocity, write the position back
+    constexpr double BYTES_PER_ENTITY = 3 * sizeof(Vec3);
+    constexpr float DT = 1.0f / 60.0f;
+
+    struct Result
+    {
+        double millis;
+        double gbs;
+    };
+
+    template<typename F>
+    Result update(const size_t count, const F& update)
+    {
+        Bench::Samples samples;
+
+        for (uint32_t frame = 0; frame < 21; frame++)
+        {
+            const auto start = Bench::Clock::now();
+            update();
+
+            // the first one faults the pages in
+            if (frame > 0)
+            {
+                samples.add(Bench::millis(Bench::Clock::now() - start));
+            }
+        }
+
+        const double median = samples.percentile(0.5);
+        return {median, static_cast<double>(count) * BYTES_PER_ENTITY / (median * 1e6)};
+    }
+
+    void report(const char* name, const uint32_t threads, const Result& result, const Result& baseline)
+    {
+        std::cout << "  " << std::left << std::setw(20) << name << std::right << std::setw(2) << threads << " threads: "
+            << std::setw(7) << result.millis << "ms, " << std::setw(6) << result.gbs << "GB/s ("
+            << std::setprecision(0) << 100.0 * result.gbs / baseline.gbs << std::setprecision(2) << "% of flat arrays)" << '\n';
+    }
+}
+
+// Moves a million entities (or as many as given) by their velocity every frame, through the world
+// and through flat arrays of the same data, which is as close to memory bandwidth as it gets.
+// A quarter of them have health too and one in sixteen are tagged on top of that, so the query
+// goes over three archetypes.
+int Bench::ecs(const int argc, char** argv)
+{
+    const uint32_t count = std::max(arg(argc, argv, 0, 1000000), 1u);
+    const uint32_t maxThreads = std::max(arg(argc, argv, 1, std::thread::hardware_concurrency()), 1u);
+
+    std::cout << std::fixed << std::setprecision(2);
+
+    World world;
+    std::vector<Entity> entities(count);
+
+    auto start = Clock::now();
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const Position position = {{static_cast<float>(i % 1000), static_cast<float>(i / 1000), 0.0f}};
+        const Velocity velocity = {{1.0f, 0.5f, static_cast<float>(i % 7)}};
+
+        if (i % 16 == 0)
+        {
+            entities[i] = world.create(position, velocity, Health{100.0f}, Hit{});
+        }
+        else if (i % 4 == 0)
+        {
+            entities[i] = world.create(position, velocity, Health{100.0f});
+        }
+        else
+        {
+            entities[i] = world.create(position, velocity);
+        }
+    }
+
+    const double createMs = millis(Clock::now() - start);
+
+    std::cout << count << " entities in " << world.archetypeCount() << " archetypes and " << world.chunkCount()
+        << " chunks of " << Engine::CHUNK_SIZE / 1024 << "KB, created in " << createMs << "ms ("
+        << createMs * 1e6 / count << "ns each)" << '\n';
+
+    // the same data as it would be without any entities around it
+    std::vector<Vec3> positions(count);
+    std::vector<Vec3> velocities(count);
+
+    size_t copied = 0;
+
+    world.eachChunk<const Position, const Velocity>([&positions, &velocities, &copied](
+        const uint32_t n, const Entity*, const Position* position, const Velocity* velocity)
+    {
+        for (uint32_t i = 0; i < n; i++, copied++)
+        {
+            positions[copied] = position[i].value;
+            velocities[copied] = velocity[i].value;
+        }
+    });
+
+    Result baseline = update(count, [&positions, &velocities, count]
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            positions[i] += velocities[i] * DT;
+        }
+    });
+
+    report("flat arrays", 1, baseline, baseline);
+
+    const Result each = update(count, [&world]
+    {
+        world.each<Position, const Velocity>([](Entity, Position& position, const Velocity& velocity)
+        {
+            position.value += velocity.value * DT;
+        });
+    });
+
+    report("each()", 1, each, baseline);
+
+    const auto updateChunk = [](const uint32_t n, const Entity*, Position* position, const Velocity* velocity)
+    {
+        for (uint32_t i = 0; i < n; i++)
+        {
+            position[i].value += velocity[i].value * DT;
+        }
+    };
+
+    const Result chunks = update(count, [&world, &updateChunk]
+    {
+        world.eachChunk<Position, const Velocity>(updateChunk);
+    });
+
+    report("eachChunk()", 1, chunks, baseline);
+
+    for (uint32_t threads = 2; threads <= maxThreads; threads *= 2)
+    {
+        JobSystem jobs(threads);
+
+        // the flat arrays split into as many pieces as there are chunks
+        const uint32_t batch = std::max(count / static_cast<uint32_t>(world.chunkCount()), 1u) * 4;
+
+        baseline = update(count, [&jobs, &positions, &velocities, count, batch]
+        {
+            jobs.parallelFor(count, batch, [&positions, &velocities](const uint32_t begin, const uint32_t end)
+            {
+                for (uint32_t i = begin; i < end; i++)
+                {
+                    positions[i] += velocities[i] * DT;
+                }
+            });
+        });
+
+        report("flat arrays", threads, baseline, baseline);
+
+        const Result parallel = update(count, [&world, &jobs, &updateChunk]
+        {
+            world.parallelEachChunk<Position, const Velocity>(&jobs, updateChunk);
+        });
+
+        report("parallelEachChunk()", threads, parallel, baseline);
+    }
+
+    // a frame's worth of structural changes, recorded from jobs and applied at the end
+    JobSystem jobs(maxThreads);
+    Commands commands;
+
+    const auto recordStart = Clock::now();
+
+    // a quarter of the ones with health die, another quarter get hit
+    world.parallelEach<Health>(&jobs, [&commands](const Entity entity, Health& health)
+    {
+        health.value -= 1.0f;
+
+        if (entity.index / 4 % 4 == 0)
+        {
+            commands.destroy(entity);
+        }
+        else if (entity.index / 4 % 4 == 1)
+        {
+            commands.add<Hit>(entity);
+        }
+    });
+
+    const double recordMs = millis(Clock::now() - recordStart);
+    const size_t nCommands = commands.size();
+
+    const auto applyStart = Clock::now();
+    world.apply(&commands);
+    const double applyMs = millis(Clock::now() - applyStart);
+
+    std::cout << "  " << nCommands << " destroys and adds recorded by " << maxThreads << " threads in " << recordMs
+        << "ms, applied in " << applyMs << "ms (" << applyMs * 1e6 / static_cast<double>(std::max(nCommands, static_cast<size_t>(1)))
+        << "ns each), " << world.size() << " entities left" << '\n';
+
+    // looking entities up by handle, in a scattered order
+    uint32_t seed = 1;
+    float sum = 0.0f;
+
+    start = Clock::now();
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+
+        if (const Position* position = world.get<Position>(entities[seed % count]))
+        {
+            sum += position->value.x;
+        }
+    }
+
+    std::cout << "  get() by handle: " << millis(Clock::now() - start) * 1e6 / count << "ns each"
+        << (sum == 0.123f ? " " : "") << '\n';
+
+    start = Clock::now();
+
+    for (const Entity entity : entities)
+    {
+        world.destroy(entity);
+    }
+
+    std::cout << "  destroying them all: " << millis(Clock::now() - start) * 1e6 / count << "ns each, "
+        << world.size() << " entities and " << world.chunkCount() << " chunks left" << '\n';
+
+    return 0;
+}
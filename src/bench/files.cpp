@@ -0,0 +1,205 @@
+#include "bench.h"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "loaders/loaders.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// every byte gets read, so both paths pay for actually getting the data in
+static uint64_t checksum(const char* data, const size_t size)
+{
+    uint64_t sum = 0;
+    size_t i = 0;
+
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        sum += word;
+    }
+
+    for (; i < size; i++)
+    {
+        sum += static_cast<unsigned char>(data[i]);
+    }
+
+    return sum;
+}
+
+static bool createFile(const std::string& filename, const size_t size)
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    std::vector<uint64_t> chunk(1 << 17);
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+
+    for (size_t written = 0; written < size && file.good();)
+    {
+        for (auto& word : chunk)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            word = state;
+        }
+
+        const size_t n = std::min(size - written, chunk.size() * 8);
+        file.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(n));
+        written += n;
+    }
+
+    return file.good();
+}
+
+bool Bench::evict(const std::string& filename)
+{
+#ifdef __linux__
+    const int fd = open(filename.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    fdatasync(fd);
+    const bool evicted = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+
+    return evicted;
+#else
+    return false;
+#endif
+}
+
+struct Method
+{
+    const char* name;
+    bool mapped;
+    Loaders::FileView::Options options;
+};
+
+static double run(const Method& method, const std::string& filename, const bool cold, uint64_t* pSum)
+{
+    if (cold)
+    {
+        Bench::evict(filename);
+    }
+
+    const auto start = Bench::Clock::now();
+
+    if (method.mapped)
+    {
+        Loaders::FileView file;
+
+        if (!file.open(filename.c_str(), method.options))
+        {
+            return -1.0;
+        }
+
+        *pSum = checksum(file.data(), file.size());
+    } else
+    {
+        std::vector<char> buffer;
+
+        if (!Loaders::readfile(&buffer, filename.c_str()))
+        {
+            return -1.0;
+        }
+
+        *pSum = checksum(buffer.data(), buffer.size());
+    }
+
+    return Bench::millis(Bench::Clock::now() - start);
+}
+
+// readfile() against FileView on 1MB, 100MB and 1GB files, from the page cache and from disk
+int Bench::files(const int argc, char** argv)
+{
+    const uint32_t maxMegabytes = arg(argc, argv, 0, 1024);
+
+    Loaders::FileView::Options sequential;
+    Loaders::FileView::Options populate;
+    populate.populate = true;
+    Loaders::FileView::Options hugePages;
+    hugePages.hugePages = true;
+
+    const Method methods[] = {
+        {"readfile", false, {}},
+        {"FileView", true, sequential},
+        {"FileView populate", true, populate},
+        {"FileView huge pages", true, hugePages},
+    };
+
+    std::cout << std::fixed << std::setprecision(2);
+
+    for (const uint32_t megabytes : {1u, 100u, 1024u})
+    {
+        if (megabytes > maxMegabytes)
+        {
+            continue;
+        }
+
+        const size_t size = static_cast<size_t>(megabytes) << 20;
+        const std::string filename = "bench_files_" + std::to_string(megabytes) + ".bin";
+
+        if (!createFile(filename, size))
+        {
+            std::cerr << "failed to write " << filename << '\n';
+            return 1;
+        }
+
+        const uint32_t runs = std::max(200u / megabytes, 3u);
+        const bool canEvict = evict(filename);
+
+        std::cout << megabytes << "MB, " << runs << " runs" << '\n';
+
+        for (const auto& method : methods)
+        {
+            for (const bool cold : {false, true})
+            {
+                if (cold && !canEvict)
+                {
+                    continue;
+                }
+
+                Samples samples;
+                uint64_t sum = 0;
+
+                // a warm run first so warm really means in the page cache
+                run(method, filename, cold, &sum);
+
+                for (uint32_t i = 0; i < runs; i++)
+                {
+                    const double elapsed = run(method, filename, cold, &sum);
+
+                    if (elapsed < 0.0)
+                    {
+                        std::cerr << method.name << " failed to read " << filename << '\n';
+                        std::remove(filename.c_str());
+                        return 1;
+                    }
+
+                    samples.add(elapsed);
+                }
+
+                const double median = samples.percentile(0.5);
+
+                std::cout << "  " << std::left << std::setw(20) << method.name << std::right
+                    << (cold ? " cold: " : " warm: ") << median << "ms p50, "
+                    << static_cast<double>(megabytes) / 1024.0 / (median / 1000.0) << "GB/s"
+                    << " (checksum " << std::hex << (sum & 0xFFFF) << std::dec << ')' << '\n';
+            }
+        }
+
+        std::remove(filename.c_str());
+    }
+
+    return 0;
+}
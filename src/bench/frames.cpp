@@ -0,0 +1,147 @@
+#include "bench.h"
+
+#include <iostream>
+
+#if !defined(HAS_VULKAN) || !defined(HAS_GLFW)
+
+int Bench::frames(int, char**)
+{
+    std::cerr << "frames benchmark needs Vulkan and GLFW" << '\n';
+    return 1;
+}
+
+#else
+
+#include "engine.h"
+#include <GLFW/glfw3.h>
+
+using Engine::Game;
+using Engine::Renderer;
+
+static VkResult setupRenderer(Renderer* renderer, GLFWwindow* win, const uint32_t width, const uint32_t height)
+{
+    uint32_t nExtensions;
+    const char* const* extensions = glfwGetRequiredInstanceExtensions(&nExtensions);
+
+    VkResult result = renderer->createInstance(nExtensions, extensions);
+    if (result != VK_SUCCESS) return result;
+
+    VkSurfaceKHR surface;
+    result = glfwCreateWindowSurface(renderer->vkInst, win, nullptr, &surface);
+    if (result != VK_SUCCESS) return result;
+
+    result = renderer->createDevice(surface);
+    if (result != VK_SUCCESS) return result;
+
+    result = renderer->createSwapchain(width, height);
+    if (result != VK_SUCCESS) return result;
+
+    return Bench::createTrianglePipeline(renderer);
+}
+
+static bool runFrames(
+    const uint32_t framesInFlight,
+    const uint32_t nFrames,
+    const uint32_t cpuMicros,
+    Bench::Samples* samples)
+{
+    constexpr uint32_t width = 640;
+    constexpr uint32_t height = 480;
+
+    GLFWwindow* win = glfwCreateWindow(width, height, "bench", nullptr, nullptr);
+
+    if (win == nullptr)
+    {
+        std::cerr << "failed to create GLFWwindow" << '\n';
+        return false;
+    }
+
+    constexpr int version[] = {0, 1, 0};
+    Game game("bench", version);
+
+    const auto renderer = new Renderer(&game);
+    renderer->framesInFlight = framesInFlight;
+
+    // don't let vsync hide the difference
+    renderer->preferredPresentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+
+    const VkResult setupResult = setupRenderer(renderer, win, width, height);
+
+    if (setupResult != VK_SUCCESS)
+    {
+        std::cerr << "failed to set up renderer (" << setupResult << ')' << '\n';
+
+        delete renderer;
+        glfwDestroyWindow(win);
+        return false;
+    }
+
+    const Engine::Mesh triangle = Bench::triangleMesh();
+
+    // let the driver settle before measuring
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        Bench::spin(cpuMicros);
+        renderer->draw(&triangle);
+        renderer->render();
+    }
+
+    for (uint32_t i = 0; i < nFrames; i++)
+    {
+        const auto start = Bench::Clock::now();
+
+        glfwPollEvents();
+        Bench::spin(cpuMicros);
+        renderer->draw(&triangle);
+        renderer->render();
+
+        samples->add(Bench::millis(Bench::Clock::now() - start));
+    }
+
+    delete renderer;
+    glfwDestroyWindow(win);
+
+    return true;
+}
+
+int Bench::frames(const int argc, char** argv)
+{
+    const uint32_t nFrames = arg(argc, argv, 0, 2000);
+    const uint32_t cpuMicros = arg(argc, argv, 1, 0);
+    const uint32_t maxInFlight = arg(argc, argv, 2, 3);
+
+    if (!glfwInit())
+    {
+        std::cerr << "failed to initialize GLFW" << '\n';
+        return 1;
+    }
+
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+
+    std::cout << nFrames << " frames, " << cpuMicros << "us simulated CPU work per frame" << '\n';
+
+    for (uint32_t n = 1; n <= maxInFlight; n++)
+    {
+        Samples samples;
+
+        if (!runFrames(n, nFrames, cpuMicros, &samples))
+        {
+            glfwTerminate();
+            return 1;
+        }
+
+        const double mean = samples.mean();
+
+        std::cout << n << " in flight: "
+            << mean << "ms mean, "
+            << samples.percentile(0.5) << "ms p50, "
+            << samples.percentile(0.99) << "ms p99, "
+            << (mean > 0.0 ? 1000.0 / mean : 0.0) << " fps" << '\n';
+    }
+
+    glfwTerminate();
+    return 0;
+}
+
+#endif
@@ -0,0 +1,197 @@
+#include "bench.h"
+
+#include <iostream>
+
+#ifndef HAS_VULKAN
+
+int Bench::graph(int, char**)
+{
+    std::cerr << "graph benchmark needs Vulkan" << '\n';
+    return 1;
+}
+
+#else
+
+using Engine::Game;
+using Engine::Renderer;
+using Engine::RenderGraph;
+
+// something shaped like a deferred frame: shadows, gbuffer, lighting, a post chain and a
+// debug view nobody looks at, so there's culling, aliasing and layout changes to work out
+static void buildFrame(RenderGraph* graph, VkImage target, VkImageView targetView, const VkExtent2D extent, const uint32_t nPost)
+{
+    const auto nothing = [](const RenderGraph::PassContext&) {};
+    constexpr VkClearValue clear{};
+
+    graph->reset();
+
+    const RenderGraph::Resource backbuffer = graph->importImage(
+        "backbuffer",
+        target,
+        targetView,
+        VK_FORMAT_R8G8B8A8_UNORM,
+        extent,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+    const RenderGraph::Resource shadow = graph->createImage("shadow", {VK_FORMAT_D32_SFLOAT, {2048, 2048}});
+    const RenderGraph::Resource depth = graph->createImage("depth", {VK_FORMAT_D32_SFLOAT, extent});
+    const RenderGraph::Resource albedo = graph->createImage("albedo", {VK_FORMAT_R8G8B8A8_UNORM, extent});
+    const RenderGraph::Resource normal = graph->createImage("normal", {VK_FORMAT_R16G16B16A16_SFLOAT, extent});
+    const RenderGraph::Resource hdr = graph->createImage("hdr", {VK_FORMAT_R16G16B16A16_SFLOAT, extent});
+    const RenderGraph::Resource debug = graph->createImage("debug", {VK_FORMAT_R8G8B8A8_UNORM, extent});
+
+    RenderGraph::Pass pass = graph->addPass("shadow", nothing);
+    graph->clear(pass, shadow, RenderGraph::DEPTH_ATTACHMENT, clear);
+
+    pass = graph->addPass("gbuffer", nothing);
+    graph->clear(pass, albedo, RenderGraph::COLOR_ATTACHMENT, clear);
+    graph->clear(pass, normal, RenderGraph::COLOR_ATTACHMENT, clear);
+    graph->clear(pass, depth, RenderGraph::DEPTH_ATTACHMENT, clear);
+
+    pass = graph->addPass("debug", nothing);
+    graph->read(pass, normal, RenderGraph::SAMPLED);
+    graph->write(pass, debug, RenderGraph::COLOR_ATTACHMENT);
+
+    pass = graph->addPass("lighting", nothing);
+    graph->read(pass, shadow, RenderGraph::SAMPLED);
+    graph->read(pass, depth, RenderGraph::SAMPLED);
+    graph->read(pass, albedo, RenderGraph::SAMPLED);
+    graph->read(pass, normal, RenderGraph::SAMPLED);
+    graph->write(pass, hdr, RenderGraph::COLOR_ATTACHMENT);
+
+    // ping-pong post effects, each only needs the one before it
+    RenderGraph::Resource last = hdr;
+
+    for (uint32_t i = 0; i < nPost; i++)
+    {
+        const RenderGraph::Resource next = graph->createImage("post", {VK_FORMAT_R16G16B16A16_SFLOAT, extent});
+
+        pass = graph->addPass("post", nothing);
+        graph->read(pass, last, RenderGraph::SAMPLED);
+        graph->write(pass, next, RenderGraph::COLOR_ATTACHMENT);
+
+        last = next;
+    }
+
+    pass = graph->addPass("tonemap", nothing);
+    graph->read(pass, last, RenderGraph::SAMPLED);
+    graph->clear(pass, backbuffer, RenderGraph::COLOR_ATTACHMENT, clear);
+}
+
+int Bench::graph(const int argc, char** argv)
+{
+    const uint32_t nCompiles = arg(argc, argv, 0, 10000);
+    const uint32_t nPost = arg(argc, argv, 1, 8);
+    const uint32_t width = arg(argc, argv, 2, 1920);
+    const uint32_t height = arg(argc, argv, 3, 1080);
+
+    constexpr int version[] = {0, 1, 0};
+    Game game("bench", version);
+
+    const auto renderer = new Renderer(&game);
+    const VkResult setupResult = createHeadlessRenderer(renderer, 64, 64);
+
+    if (setupResult != VK_SUCCESS)
+    {
+        std::cerr << "failed to set up headless renderer (" << setupResult << ')' << '\n';
+
+        delete renderer;
+        return 1;
+    }
+
+    // never rendered to, the graph only needs handles to put in barriers and framebuffers
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    imageInfo.extent = {width, height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkImage target;
+    Engine::Allocation targetAllocation;
+    VkResult result = renderer->allocator->createImage(imageInfo, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &target, &targetAllocation);
+
+    VkImageView targetView = VK_NULL_HANDLE;
+
+    if (result == VK_SUCCESS)
+    {
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = target;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = imageInfo.format;
+        viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+        result = vkCreateImageView(renderer->vkDev, &viewInfo, nullptr, &targetView);
+    }
+
+    RenderGraph graph;
+    graph.create(renderer->vkDev, renderer->allocator, 2);
+
+    const VkExtent2D extent = {width, height};
+
+    // the first compile creates every image, render pass and framebuffer
+    const auto coldStart = Clock::now();
+
+    if (result == VK_SUCCESS)
+    {
+        buildFrame(&graph, target, targetView, extent, nPost);
+        result = graph.compile(0);
+    }
+
+    const double cold = millis(Clock::now() - coldStart);
+
+    if (result != VK_SUCCESS)
+    {
+        std::cerr << "failed to compile the graph (" << result << ')' << '\n';
+    }
+
+    Samples samples;
+
+    for (uint32_t i = 0; result == VK_SUCCESS && i < nCompiles; i++)
+    {
+        const auto start = Clock::now();
+
+        buildFrame(&graph, target, targetView, extent, nPost);
+        result = graph.compile(i + 1);
+
+        samples.add(millis(Clock::now() - start) * 1000.0);
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        const RenderGraph::Stats& stats = graph.stats();
+
+        std::cout << stats.passes << " passes (" << stats.culledPasses << " culled), "
+            << stats.barrierBatches << " barrier batches with " << stats.imageBarriers << " image barriers" << '\n';
+
+        std::cout << stats.transientImages << " transient images in "
+            << static_cast<double>(stats.transientBytes) / (1024.0 * 1024.0) << "MiB, "
+            << static_cast<double>(stats.unaliasedBytes) / (1024.0 * 1024.0) << "MiB without aliasing" << '\n';
+
+        std::cout << "compile: " << cold << "ms cold, "
+            << samples.percentile(0.5) << "us p50, "
+            << samples.percentile(0.99) << "us p99 (declaring the passes included)" << '\n';
+    }
+
+    graph.destroy();
+
+    if (targetView != VK_NULL_HANDLE)
+    {
+        vkDestroyImageView(renderer->vkDev, targetView, nullptr);
+    }
+
+    renderer->allocator->destroyImage(target, targetAllocation);
+
+    delete renderer;
+    return result == VK_SUCCESS ? 0 : 1;
+}
+
+#endif
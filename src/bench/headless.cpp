@@ -0,0 +1,117 @@
+#include "bench.h"
+
+#include <iostream>
+#include <string>
+
+#ifndef HAS_VULKAN
+
+int Bench::headless(int, char**)
+{
+    std::cerr << "headless benchmark needs Vulkan" << '\n';
+    return 1;
+}
+
+#else
+
+using Engine::Game;
+using Engine::Renderer;
+
+int Bench::headless(const int argc, char** argv)
+{
+    const uint32_t nFrames = arg(argc, argv, 0, 10000);
+    const uint32_t width = arg(argc, argv, 1, 640);
+    const uint32_t height = arg(argc, argv, 2, 480);
+    const uint32_t framesInFlight = arg(argc, argv, 3, 2);
+    const uint32_t readbackEvery = arg(argc, argv, 4, 0);
+
+    constexpr int version[] = {0, 1, 0};
+    Game game("bench", version);
+
+    const auto renderer = new Renderer(&game);
+    renderer->framesInFlight = framesInFlight;
+    renderer->readback = readbackEvery > 0;
+
+    const VkResult setupResult = createHeadlessRenderer(renderer, width, height);
+
+    if (setupResult != VK_SUCCESS)
+    {
+        std::cerr << "failed to set up headless renderer (" << setupResult << ')' << '\n';
+
+        delete renderer;
+        return 1;
+    }
+
+    const Engine::Mesh triangle = triangleMesh();
+
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        renderer->draw(&triangle);
+        renderer->render();
+    }
+
+    Samples samples;
+    std::vector<char> pixels;
+
+    const auto start = Clock::now();
+
+    for (uint32_t i = 0; i < nFrames; i++)
+    {
+        const auto frameStart = Clock::now();
+
+        renderer->draw(&triangle);
+        const VkResult result = renderer->render();
+
+        if (result != VK_SUCCESS)
+        {
+            std::cerr << "frame " << i << " failed (" << result << ')' << '\n';
+
+            delete renderer;
+            return 1;
+        }
+
+        if (readbackEvery > 0 && i % readbackEvery == 0)
+        {
+            renderer->readPixels(&pixels);
+        }
+
+        samples.add(millis(Clock::now() - frameStart));
+    }
+
+    // the last frames are still in flight, count them too
+    vkDeviceWaitIdle(renderer->vkDev);
+    const double total = millis(Clock::now() - start);
+
+    std::cout << nFrames << " frames at " << width << 'x' << height << ", "
+        << framesInFlight << " in flight"
+        << (renderer->usesDynamicRendering() ? ", dynamic rendering: " : ", render passes: ")
+        << static_cast<double>(nFrames) * 1000.0 / total << " fps, "
+        << samples.mean() << "ms mean, "
+        << samples.percentile(0.5) << "ms p50, "
+        << samples.percentile(0.99) << "ms p99" << '\n';
+
+    // only with -DENGINE_PROFILING=ON
+    if (const Engine::GpuFrameStats* stats = renderer->gpuStats())
+    {
+        for (const auto& scope : stats->scopes)
+        {
+            std::cout << std::string(scope.depth * 2, ' ') << scope.name << ": " << scope.end - scope.begin << "ms GPU" << '\n';
+        }
+
+        if (stats->hasStatistics)
+        {
+            std::cout << stats->inputPrimitives << " primitives, "
+                << stats->vertexInvocations << " vertex and "
+                << stats->fragmentInvocations << " fragment invocations" << '\n';
+        }
+
+        if (renderer->exportGpuTrace("gpu_trace.json"))
+        {
+            std::cout << "GPU trace written to gpu_trace.json" << '\n';
+        }
+    }
+
+    delete renderer;
+    return 0;
+}
+
+#endif
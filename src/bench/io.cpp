@@ -0,0 +1,150 @@
+#include "bench.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "loaders/loaders.h"
+
+static constexpr auto IO_DIR = "bench_io";
+
+// what a level load looks like: lots of small files, each needed once
+int Bench::io(const int argc, char** argv)
+{
+    const uint32_t nFiles = std::max(arg(argc, argv, 0, 4000), 1u);
+    const uint32_t nBytes = arg(argc, argv, 1, 4096);
+    const uint32_t inFlight = std::max(arg(argc, argv, 2, 256), 1u);
+
+    std::filesystem::create_directories(IO_DIR);
+
+    std::vector<std::string> filenames;
+    std::vector<char> contents(nBytes);
+
+    for (uint32_t i = 0; i < nFiles; i++)
+    {
+        for (uint32_t j = 0; j < nBytes; j++)
+        {
+            contents[j] = static_cast<char>(i * 131 + j);
+        }
+
+        filenames.push_back(std::string(IO_DIR) + "/" + std::to_string(i) + ".bin");
+        std::ofstream file(filenames.back(), std::ios::binary | std::ios::trunc);
+        file.write(contents.data(), nBytes);
+    }
+
+    const bool canEvict = evict(filenames.front());
+
+    Loaders::AsyncReader pool;
+    pool.create(inFlight, 8, false);
+
+    Loaders::AsyncReader ring;
+    ring.create(inFlight);
+
+    if (!ring.usesIoUring())
+    {
+        std::cout << "io_uring isn't available, the second async run uses the thread pool too" << '\n';
+    }
+
+    struct Method
+    {
+        const char* name;
+        std::function<uint64_t()> run;
+    };
+
+    const auto async = [&filenames](Loaders::AsyncReader* reader)
+    {
+        uint64_t bytes = 0;
+
+        for (const auto& filename : filenames)
+        {
+            reader->read(filename, [&bytes](Loaders::AsyncReader::File& file)
+            {
+                bytes += file.size;
+            });
+        }
+
+        reader->wait();
+        return bytes;
+    };
+
+    const Method methods[] = {
+        {"readfile", [&filenames]
+        {
+            uint64_t bytes = 0;
+            std::vector<char> buffer;
+
+            for (const auto& filename : filenames)
+            {
+                Loaders::readfile(&buffer, filename.c_str());
+                bytes += buffer.size();
+            }
+
+            return bytes;
+        }},
+        {"FileView", [&filenames]
+        {
+            uint64_t bytes = 0;
+
+            for (const auto& filename : filenames)
+            {
+                Loaders::FileView file;
+                file.open(filename.c_str());
+
+                // touched so the page actually gets read
+                bytes += file.size() > 0 ? file.size() + (file.data()[0] & 0) : 0;
+            }
+
+            return bytes;
+        }},
+        {"AsyncReader threads", [&] { return async(&pool); }},
+        {"AsyncReader io_uring", [&] { return async(&ring); }},
+    };
+
+    std::cout << std::fixed << std::setprecision(2)
+        << nFiles << " files of " << nBytes << " bytes, " << inFlight << " in flight" << '\n';
+
+    for (const auto& method : methods)
+    {
+        for (const bool cold : {false, true})
+        {
+            if (cold && !canEvict)
+            {
+                continue;
+            }
+
+            Samples samples;
+            uint64_t bytes = 0;
+
+            for (uint32_t run = 0; run < 6; run++)
+            {
+                if (cold)
+                {
+                    for (const auto& filename : filenames)
+                    {
+                        evict(filename);
+                    }
+                }
+
+                const auto start = Clock::now();
+                bytes = method.run();
+
+                // the first run warms the cache up
+                if (run > 0)
+                {
+                    samples.add(millis(Clock::now() - start));
+                }
+            }
+
+            const double median = samples.percentile(0.5);
+
+            std::cout << "  " << std::left << std::setw(22) << method.name << std::right
+                << (cold ? " cold: " : " warm: ") << median << "ms p50, "
+                << static_cast<double>(nFiles) / (median / 1000.0) << " files/s"
+                << (bytes == static_cast<uint64_t>(nFiles) * nBytes ? "" : " (short reads!)") << '\n';
+        }
+    }
+
+    std::filesystem::remove_all(IO_DIR);
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include "bench.h"
+
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <iostream>
+
+#include "engine.h"
+
+using Engine::JobCounter;
+using Engine::JobSystem;
+
+// cheap enough that the scheduler overhead shows, heavy enough not to be memory bound
+static float work(const std::vector<float>& values, const uint32_t begin, const uint32_t end)
+{
+    float sum = 0.0f;
+
+    for (uint32_t i = begin; i < end; i++)
+    {
+        sum += std::sqrt(values[i]) * std::sin(values[i]);
+    }
+
+    return sum;
+}
+
+static void spawn(const uint32_t nJobs, const uint32_t threads)
+{
+    std::atomic<uint32_t> done{0};
+    std::atomic<uint32_t>* pDone = &done;
+
+    JobSystem jobs(threads);
+    Bench::Samples samples;
+
+    for (uint32_t round = 0; round < 10; round++)
+    {
+        JobCounter counter;
+        const auto start = Bench::Clock::now();
+
+        for (uint32_t i = 0; i < nJobs; i++)
+        {
+            jobs.run([pDone] { pDone->fetch_add(1, std::memory_order_relaxed); }, &counter);
+        }
+
+        jobs.wait(&counter);
+        samples.add(Bench::millis(Bench::Clock::now() - start) * 1e6 / nJobs);
+    }
+
+    // std::async starts a thread per task, so give it fewer
+    const uint32_t nAsync = nJobs / 100;
+    const auto asyncStart = Bench::Clock::now();
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(nAsync);
+
+    for (uint32_t i = 0; i < nAsync; i++)
+    {
+        futures.push_back(std::async(std::launch::async, [pDone] { pDone->fetch_add(1, std::memory_order_relaxed); }));
+    }
+
+    for (auto& future : futures)
+    {
+        future.wait();
+    }
+
+    const double asyncNs = Bench::millis(Bench::Clock::now() - asyncStart) * 1e6 / nAsync;
+
+    std::cout << "spawn + wait, " << threads << " threads: "
+        << samples.percentile(0.5) << "ns per job, std::async "
+        << asyncNs << "ns per task" << '\n';
+}
+
+static void scaling(const std::vector<float>& values, const uint32_t threads, double* baseline)
+{
+    const auto count = static_cast<uint32_t>(values.size());
+    const std::vector<float>* pValues = &values;
+
+    JobSystem jobs(threads);
+    Bench::Samples jobSamples;
+    Bench::Samples asyncSamples;
+
+    for (uint32_t round = 0; round < 10; round++)
+    {
+        std::atomic<uint32_t> bits{0};
+        const auto start = Bench::Clock::now();
+
+        jobs.parallelFor(count, 16384, [pValues, &bits](const uint32_t begin, const uint32_t end)
+        {
+            // keep the result alive without contending on it every iteration
+            const float sum = work(*pValues, begin, end);
+            if (sum == 0.123f) bits.fetch_add(1);
+        });
+
+        jobSamples.add(Bench::millis(Bench::Clock::now() - start));
+
+        const auto asyncStart = Bench::Clock::now();
+        const uint32_t chunk = (count + threads - 1) / threads;
+
+        std::vector<std::future<float>> futures;
+
+        for (uint32_t begin = 0; begin < count; begin += chunk)
+        {
+            const uint32_t end = std::min(begin + chunk, count);
+            futures.push_back(std::async(std::launch::async, work, std::cref(values), begin, end));
+        }
+
+        for (auto& future : futures)
+        {
+            future.get();
+        }
+
+        asyncSamples.add(Bench::millis(Bench::Clock::now() - asyncStart));
+    }
+
+    const double median = jobSamples.percentile(0.5);
+    if (threads == 1) *baseline = median;
+
+    std::cout << "parallelFor over " << count << ", " << threads << " threads: "
+        << median << "ms (" << *baseline / median << "x), std::async "
+        << asyncSamples.percentile(0.5) << "ms" << '\n';
+}
+
+int Bench::jobs(const int argc, char** argv)
+{
+    const uint32_t nJobs = arg(argc, argv, 0, 100000);
+    const uint32_t count = arg(argc, argv, 1, 1 << 24);
+    const uint32_t maxThreads = arg(argc, argv, 2, std::thread::hardware_concurrency());
+
+    for (uint32_t threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        spawn(nJobs, threads);
+    }
+
+    std::vector<float> values(count);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        values[i] = static_cast<float>(i % 1000) * 0.01f;
+    }
+
+    double baseline = 0.0;
+
+    for (uint32_t threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        scaling(values, threads, &baseline);
+    }
+
+    return 0;
+}
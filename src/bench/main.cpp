@@ -0,0 +1,57 @@
+#include "bench.h"
+
+#include <cstring>
+#include <iostream>
+
+struct Benchmark
+{
+    const char* name;
+    const char* usage;
+    int (*run)(int argc, char** argv);
+};
+
+static constexpr Benchmark BENCHMARKS[] = {
+    {"frames", "[frames] [cpu-us] [max-in-flight]", Bench::frames},
+    {"headless", "[frames] [width] [height] [in-flight] [readback-every]", Bench::headless},
+    {"startup", "[runs]", Bench::startup},
+    {"record", "[draws] [max-threads] [frames]", Bench::record},
+    {"jobs", "[jobs] [count] [max-threads]", Bench::jobs},
+    {"profiler", "[zones] [frames]", Bench::profiler},
+    {"graph", "[compiles] [post-passes] [width] [height]", Bench::graph},
+    {"resize", "[resizes]", Bench::resize},
+    {"pipelines", "[permutations]", Bench::pipelines},
+    {"spirv", "[iterations] [files...]", Bench::spirv},
+    {"reload", "[reloads]", Bench::reload},
+    {"files", "[max-mb]", Bench::files},
+    {"io", "[files] [bytes] [in-flight]", Bench::io},
+    {"archive", "[files] [bytes]", Bench::archive},
+    {"textures", "[textures] [size] [budget-mb]", Bench::textures},
+    {"meshes", "[triangles]", Bench::meshes},
+    {"math", "[count]", Bench::math},
+    {"ecs", "[entities] [max-threads]", Bench::ecs},
+    {"scene", "[nodes] [max-threads]", Bench::scene},
+    {"cull", "[objects] [max-threads]", Bench::cull},
+};
+
+int main(const int argc, char** argv)
+{
+    if (argc >= 2)
+    {
+        for (const auto& benchmark : BENCHMARKS)
+        {
+            if (strcmp(argv[1], benchmark.name) == 0)
+            {
+                return benchmark.run(argc - 2, argv + 2);
+            }
+        }
+    }
+
+    std::cerr << "usage:" << '\n';
+
+    for (const auto& benchmark : BENCHMARKS)
+    {
+        std::cerr << "  bench " << benchmark.name << ' ' << benchmark.usage << '\n';
+    }
+
+    return 1;
+}
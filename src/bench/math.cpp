@@ -0,0 +1,294 @@
+#include "bench.h"
+
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+
+#include "engine.h"
+
+using Engine::Frustum;
+using Engine::Mat4;
+using Engine::SimdLevel;
+using Engine::Vec3;
+
+static constexpr const char* LEVEL_NAMES[] = {"scalar", "sse", "avx2"};
+
+static Mat4 randomTrs(uint32_t* seed)
+{
+    const Vec3 axis = {Test::random(seed, -1.0f, 1.0f), Test::random(seed, -1.0f, 1.0f), Test::random(seed, -1.0f, 1.0f) + 0.01f};
+
+    return Mat4::trs(
+        {Test::random(seed, -100.0f, 100.0f), Test::random(seed, -100.0f, 100.0f), Test::random(seed, -100.0f, 100.0f)},
+        Engine::Quat::axisAngle(axis, Test::random(seed, -3.14f, 3.14f)),
+        {Test::random(seed, 0.5f, 2.0f), Test::random(seed, 0.5f, 2.0f), Test::random(seed, 0.5f, 2.0f)});
+}
+
+// median of a few runs, in nanoseconds per element, each run going over the arrays until it's seen
+// a few million elements so the small counts still take long enough to time
+static double measure(const std::function<void()>& run, const size_t count)
+{
+    const size_t repeats = std::max((static_cast<size_t>(1) << 22) / count, static_cast<size_t>(1));
+
+    Bench::Samples samples;
+
+    for (uint32_t i = 0; i < 11; i++)
+    {
+        const auto start = Bench::Clock::now();
+
+        for (size_t repeat = 0; repeat < repeats; repeat++)
+        {
+            run();
+        }
+
+        // the first one warms the caches up
+        if (i > 0)
+        {
+            samples.add(Bench::millis(Bench::Clock::now() - start) * 1e6 / static_cast<double>(count * repeats));
+        }
+    }
+
+    return samples.percentile(0.5);
+}
+
+static void report(const char* name, const double reference, const double library, const SimdLevel level, const char* error)
+{
+    std::cout << "  " << std::left << std::setw(18) << name << std::setw(8) << LEVEL_NAMES[static_cast<int>(level)] << std::right
+        << std::setw(8) << library << "ns (" << reference / library << "x)" << error << '\n';
+}
+
+// What the batched functions replace: one point, matrix or bounding volume at a time through the
+// array of structs a game would naively keep, in plain scalar code (the compiler may still vectorize
+// some of it). Then the library's batched kernels at every level the CPU has.
+int Bench::math(const int argc, char** argv)
+{
+    const size_t count = std::max(arg(argc, argv, 0, 8192), 1u);
+    const size_t matrixCount = std::max(count / 16, static_cast<size_t>(1));
+
+    uint32_t seed = 1;
+
+    // points and bounding volumes spread around the camera, roughly half end up visible
+    std::vector<Vec3> points(count);
+    std::vector<float> x(count);
+    std::vector<float> y(count);
+    std::vector<float> z(count);
+    std::vector<float> radius(count);
+    std::vector<float> extentX(count);
+    std::vector<float> extentY(count);
+    std::vector<float> extentZ(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        points[i] = {Test::random(&seed, -200.0f, 200.0f), Test::random(&seed, -200.0f, 200.0f), Test::random(&seed, -400.0f, 50.0f)};
+        x[i] = points[i].x;
+        y[i] = points[i].y;
+        z[i] = points[i].z;
+        radius[i] = Test::random(&seed, 0.1f, 10.0f);
+        extentX[i] = Test::random(&seed, 0.1f, 10.0f);
+        extentY[i] = Test::random(&seed, 0.1f, 10.0f);
+        extentZ[i] = Test::random(&seed, 0.1f, 10.0f);
+    }
+
+    std::vector<Mat4> parents(matrixCount);
+    std::vector<Mat4> locals(matrixCount);
+
+    for (size_t i = 0; i < matrixCount; i++)
+    {
+        parents[i] = randomTrs(&seed);
+        locals[i] = randomTrs(&seed);
+    }
+
+    const Mat4 model = randomTrs(&seed);
+    const Mat4 view = Mat4::lookAt({0.0f, 10.0f, 30.0f}, {0.0f, 0.0f, -100.0f}, {0.0f, 1.0f, 0.0f});
+    const Mat4 viewProjection = Mat4::perspective(1.2f, 16.0f / 9.0f, 0.1f, 300.0f) * view;
+    const Frustum frustum = Frustum::fromMatrix(viewProjection);
+
+    // the reference results, which every level gets checked against
+    std::vector<Vec3> transformed(count);
+    std::vector<Mat4> products(matrixCount);
+    std::vector<Mat4> viewProducts(matrixCount);
+    std::vector<uint8_t> spheresVisible(count);
+    std::vector<uint8_t> boxesVisible(count);
+
+    const double transformReference = measure([&]
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            transformed[i] = Engine::transformPoint(model, points[i]);
+        }
+    }, count);
+
+    const auto multiply = [](const Mat4& a, const Mat4& b, Mat4* out)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            for (int row = 0; row < 4; row++)
+            {
+                float sum = 0.0f;
+
+                for (int k = 0; k < 4; k++)
+                {
+                    sum += a.m[k * 4 + row] * b.m[column * 4 + k];
+                }
+
+                out->m[column * 4 + row] = sum;
+            }
+        }
+    };
+
+    const double multiplyReference = measure([&]
+    {
+        for (size_t i = 0; i < matrixCount; i++)
+        {
+            multiply(parents[i], locals[i], &products[i]);
+        }
+    }, matrixCount);
+
+    const double viewReference = measure([&]
+    {
+        for (size_t i = 0; i < matrixCount; i++)
+        {
+            multiply(view, locals[i], &viewProducts[i]);
+        }
+    }, matrixCount);
+
+    size_t nSpheres = 0;
+    size_t nBoxes = 0;
+
+    const double sphereReference = measure([&]
+    {
+        nSpheres = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            spheresVisible[i] = Engine::intersects(frustum, Engine::Sphere{points[i], radius[i]});
+            nSpheres += spheresVisible[i];
+        }
+    }, count);
+
+    const double boxReference = measure([&]
+    {
+        nBoxes = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const Vec3 extent = {extentX[i], extentY[i], extentZ[i]};
+            boxesVisible[i] = Engine::intersects(frustum, Engine::Aabb{points[i] - extent, points[i] + extent});
+            nBoxes += boxesVisible[i];
+        }
+    }, count);
+
+    std::cout << std::fixed << std::setprecision(2)
+        << count << " points and bounding volumes, " << matrixCount << " matrices, "
+        << nSpheres << " spheres and " << nBoxes << " boxes visible" << '\n'
+        << "  scalar reference: transform " << transformReference << "ns, multiply " << multiplyReference
+        << "ns, multiply by view " << viewReference << "ns, spheres " << sphereReference << "ns, boxes " << boxReference << "ns" << '\n';
+
+    std::vector<float> outX(count);
+    std::vector<float> outY(count);
+    std::vector<float> outZ(count);
+    std::vector<Mat4> outMatrices(matrixCount);
+    std::vector<uint8_t> visible(count);
+
+    // FMA rounds differently, so close enough is good enough, relative to the largest element since
+    // the small ones can come out of large terms cancelling
+    const auto close = [](const float a, const float b, const float scale) { return std::fabs(a - b) <= 1e-5f * (1.0f + scale); };
+
+    const auto matricesMatch = [&outMatrices, &close, matrixCount](const std::vector<Mat4>& expected)
+    {
+        for (size_t i = 0; i < matrixCount; i++)
+        {
+            float scale = 0.0f;
+
+            for (const float element : expected[i].m)
+            {
+                scale = std::max(scale, std::fabs(element));
+            }
+
+            for (int k = 0; k < 16; k++)
+            {
+                if (!close(outMatrices[i].m[k], expected[i].m[k], scale))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    };
+
+    // culling tests that land right on a plane can go either way with FMA, so only count them
+    const auto differences = [&visible, count](const std::vector<uint8_t>& expected, const size_t nVisible, const size_t nExpected)
+    {
+        size_t nDifferent = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            nDifferent += visible[i] != expected[i];
+        }
+
+        if (nDifferent == 0 && nVisible == nExpected)
+        {
+            return std::string();
+        }
+
+        return " (" + std::to_string(nDifferent) + " different!)";
+    };
+
+    const SimdLevel original = Engine::simdLevel();
+
+    for (int level = 0; level <= static_cast<int>(Engine::supportedSimdLevel()); level++)
+    {
+        Engine::setSimdLevel(static_cast<SimdLevel>(level));
+        const SimdLevel active = Engine::simdLevel();
+
+        const double transformTime = measure([&]
+        {
+            Engine::transformPoints(model, x.data(), y.data(), z.data(), outX.data(), outY.data(), outZ.data(), count);
+        }, count);
+
+        bool transformMatches = true;
+
+        for (size_t i = 0; i < count && transformMatches; i++)
+        {
+            // the terms can be as large as the input
+            const float scale = std::max({std::fabs(transformed[i].x), std::fabs(transformed[i].y), std::fabs(transformed[i].z), std::fabs(x[i]), std::fabs(y[i]), std::fabs(z[i])});
+            transformMatches = close(outX[i], transformed[i].x, scale) && close(outY[i], transformed[i].y, scale) && close(outZ[i], transformed[i].z, scale);
+        }
+
+        report("transformPoints", transformReference, transformTime, active, transformMatches ? "" : " (wrong!)");
+
+        const double multiplyTime = measure([&]
+        {
+            Engine::multiplyMatrices(parents.data(), locals.data(), outMatrices.data(), matrixCount);
+        }, matrixCount);
+
+        report("multiplyMatrices", multiplyReference, multiplyTime, active, matricesMatch(products) ? "" : " (wrong!)");
+
+        const double viewTime = measure([&]
+        {
+            Engine::multiplyMatrices(view, locals.data(), outMatrices.data(), matrixCount);
+        }, matrixCount);
+
+        report("  by one matrix", viewReference, viewTime, active, matricesMatch(viewProducts) ? "" : " (wrong!)");
+
+        size_t nVisible = 0;
+
+        const double sphereTime = measure([&]
+        {
+            nVisible = Engine::cullSpheres(frustum, x.data(), y.data(), z.data(), radius.data(), visible.data(), count);
+        }, count);
+
+        report("cullSpheres", sphereReference, sphereTime, active, differences(spheresVisible, nVisible, nSpheres).c_str());
+
+        const double boxTime = measure([&]
+        {
+            nVisible = Engine::cullBoxes(frustum, x.data(), y.data(), z.data(), extentX.data(), extentY.data(), extentZ.data(), visible.data(), count);
+        }, count);
+
+        report("cullBoxes", boxReference, boxTime, active, differences(boxesVisible, nVisible, nBoxes).c_str());
+    }
+
+    Engine::setSimdLevel(original);
+    return 0;
+}
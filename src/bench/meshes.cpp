@@ -0,0 +1,268 @@
+#include "bench.h"
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+#include "loaders/loaders.h"
+
+static constexpr auto MESH_DIR = "bench_meshes";
+
+// a lumpy sphere with its triangles shuffled, like an export that never went through an optimizer
+static std::vector<char> buildGlb(const uint32_t triangles)
+{
+    const auto rings = std::max(static_cast<uint32_t>(std::sqrt(triangles / 4.0)), 2u);
+    const uint32_t segments = rings * 2;
+    const uint32_t vertexCount = (rings + 1) * (segments + 1);
+
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> uvs;
+
+    for (uint32_t ring = 0; ring <= rings; ring++)
+    {
+        for (uint32_t segment = 0; segment <= segments; segment++)
+        {
+            const float u = static_cast<float>(segment) / static_cast<float>(segments);
+            const float v = static_cast<float>(ring) / static_cast<float>(rings);
+            const float theta = v * 3.14159265f;
+            const float phi = u * 6.28318531f;
+            const float radius = 1.0f + 0.1f * std::sin(theta * 5.0f) * std::cos(phi * 7.0f);
+
+            const float normal[3] = {std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)};
+
+            for (const float n : normal)
+            {
+                positions.push_back(n * radius);
+                normals.push_back(n);
+            }
+
+            uvs.push_back(u);
+            uvs.push_back(v);
+        }
+    }
+
+    std::vector<uint32_t> indices;
+
+    for (uint32_t ring = 0; ring < rings; ring++)
+    {
+        for (uint32_t segment = 0; segment < segments; segment++)
+        {
+            const uint32_t a = ring * (segments + 1) + segment;
+            const uint32_t b = a + segments + 1;
+
+            indices.insert(indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+        }
+    }
+
+    uint32_t seed = 12345;
+
+    for (size_t t = indices.size() / 3 - 1; t > 0; t--)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        const size_t other = seed % (t + 1);
+
+        for (int c = 0; c < 3; c++)
+        {
+            std::swap(indices[t * 3 + c], indices[other * 3 + c]);
+        }
+    }
+
+    const size_t positionBytes = positions.size() * 4;
+    const size_t normalBytes = normals.size() * 4;
+    const size_t uvBytes = uvs.size() * 4;
+    const size_t indexBytes = indices.size() * 4;
+    const size_t binSize = positionBytes + normalBytes + uvBytes + indexBytes;
+
+    const std::string views =
+        "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":" + std::to_string(positionBytes) + "}," +
+        "{\"buffer\":0,\"byteOffset\":" + std::to_string(positionBytes) + ",\"byteLength\":" + std::to_string(normalBytes) + "}," +
+        "{\"buffer\":0,\"byteOffset\":" + std::to_string(positionBytes + normalBytes) + ",\"byteLength\":" + std::to_string(uvBytes) + "}," +
+        "{\"buffer\":0,\"byteOffset\":" + std::to_string(positionBytes + normalBytes + uvBytes) + ",\"byteLength\":" + std::to_string(indexBytes) + "}";
+
+    const std::string count = std::to_string(vertexCount);
+    const std::string accessors =
+        "{\"bufferView\":0,\"componentType\":5126,\"count\":" + count + ",\"type\":\"VEC3\",\"min\":[-1.1,-1.1,-1.1],\"max\":[1.1,1.1,1.1]}," +
+        "{\"bufferView\":1,\"componentType\":5126,\"count\":" + count + ",\"type\":\"VEC3\"}," +
+        "{\"bufferView\":2,\"componentType\":5126,\"count\":" + count + ",\"type\":\"VEC2\"}," +
+        "{\"bufferView\":3,\"componentType\":5125,\"count\":" + std::to_string(indices.size()) + ",\"type\":\"SCALAR\"}";
+
+    std::string json =
+        "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],"
+        "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":3}]}],"
+        "\"buffers\":[{\"byteLength\":" + std::to_string(binSize) + "}],"
+        "\"bufferViews\":[" + views + "],\"accessors\":[" + accessors + "]}";
+
+    json.resize((json.size() + 3) & ~static_cast<size_t>(3), ' ');
+
+    const uint32_t header[5] = {
+        0x46546C67, 2, static_cast<uint32_t>(12 + 8 + json.size() + 8 + binSize),
+        static_cast<uint32_t>(json.size()), 0x4E4F534A
+    };
+    const uint32_t binHeader[2] = {static_cast<uint32_t>(binSize), 0x004E4942};
+
+    std::vector<char> glb(header[2]);
+    char* out = glb.data();
+
+    const auto append = [&out](const void* data, const size_t size)
+    {
+        memcpy(out, data, size);
+        out += size;
+    };
+
+    append(header, sizeof(header));
+    append(json.data(), json.size());
+    append(binHeader, sizeof(binHeader));
+    append(positions.data(), positionBytes);
+    append(normals.data(), normalBytes);
+    append(uvs.data(), uvBytes);
+    append(indices.data(), indexBytes);
+
+    return glb;
+}
+
+// glTF import, optimizing and cooking, then loading the model at runtime from the glTF against
+// loading the cooked mesh into (what stands in for) the staging ring
+int Bench::meshes(const int argc, char** argv)
+{
+    const uint32_t triangles = std::max(arg(argc, argv, 0, 1000000), 8u);
+
+    const std::string glbPath = std::string(MESH_DIR) + "/model.glb";
+    const std::string meshPath = std::string(MESH_DIR) + "/model.mesh";
+
+    std::filesystem::create_directories(MESH_DIR);
+
+    if (!Loaders::writefile(buildGlb(triangles), glbPath.c_str()))
+    {
+        std::cerr << "couldn't write " << glbPath << '\n';
+        return 1;
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+
+    Samples importTimes;
+    Samples optimizeTimes;
+    Samples writeTimes;
+
+    Loaders::MeshData mesh;
+    std::vector<char> cooked;
+    float before = 0.0f;
+    uint32_t imported = 0;
+
+    for (uint32_t run = 0; run < 3; run++)
+    {
+        auto start = Clock::now();
+
+        if (!Loaders::importGltf(glbPath.c_str(), &mesh))
+        {
+            std::cerr << "couldn't import " << glbPath << '\n';
+            std::filesystem::remove_all(MESH_DIR);
+            return 1;
+        }
+
+        importTimes.add(millis(Clock::now() - start));
+
+        before = Loaders::cacheMissRatio(mesh.indices, mesh.vertexCount());
+        imported = mesh.vertexCount();
+
+        start = Clock::now();
+        Loaders::optimizeMesh(&mesh);
+        optimizeTimes.add(millis(Clock::now() - start));
+
+        start = Clock::now();
+        Loaders::writeMesh(mesh, &cooked);
+        writeTimes.add(millis(Clock::now() - start));
+    }
+
+    if (!Loaders::writefile(cooked, meshPath.c_str()))
+    {
+        std::cerr << "couldn't write " << meshPath << '\n';
+        std::filesystem::remove_all(MESH_DIR);
+        return 1;
+    }
+
+    std::cout << mesh.indices.size() / 3 << " triangles, " << imported << " vertices welded to " << mesh.vertexCount()
+        << ", " << std::filesystem::file_size(glbPath) / 1024 << "KB glb cooked to " << cooked.size() / 1024 << "KB" << '\n'
+        << "  import: " << importTimes.percentile(0.5) << "ms p50" << '\n'
+        << "  optimize: " << optimizeTimes.percentile(0.5) << "ms p50, cache miss ratio "
+        << std::setprecision(3) << before << " to " << Loaders::cacheMissRatio(mesh.indices, mesh.vertexCount()) << std::setprecision(2) << '\n'
+        << "  quantize and write: " << writeTimes.percentile(0.5) << "ms p50" << '\n';
+
+    // the cooked data gets copied once, like createMesh() stages it
+    const std::unique_ptr<char[]> staging(new char[cooked.size()]);
+
+    struct Method
+    {
+        const char* name;
+        std::function<bool()> run;
+    };
+
+    const Method methods[] = {
+        {"glb import", [&glbPath]
+        {
+            Loaders::MeshData loaded;
+            return Loaders::importGltf(glbPath.c_str(), &loaded);
+        }},
+        {"cooked mesh", [&meshPath, &staging]
+        {
+            Loaders::Asset file;
+            Loaders::MeshInfo info;
+
+            if (!Loaders::resolve(meshPath, &file) || !Loaders::parseMesh(file.data(), file.size(), &info))
+            {
+                return false;
+            }
+
+            const size_t vertexBytes = static_cast<size_t>(info.vertexCount) * info.vertexStride;
+            memcpy(staging.get(), info.vertices, vertexBytes);
+            memcpy(staging.get() + vertexBytes, info.indices, static_cast<size_t>(info.indexCount) * info.indexSize);
+
+            return true;
+        }},
+    };
+
+    const bool canEvict = evict(meshPath);
+
+    for (const auto& method : methods)
+    {
+        for (const bool cold : {false, true})
+        {
+            if (cold && !canEvict)
+            {
+                continue;
+            }
+
+            Samples samples;
+            bool loaded = true;
+
+            for (uint32_t run = 0; run < 6; run++)
+            {
+                if (cold)
+                {
+                    evict(glbPath);
+                    evict(meshPath);
+                }
+
+                const auto start = Clock::now();
+                loaded &= method.run();
+
+                // the first run warms the cache up
+                if (run > 0)
+                {
+                    samples.add(millis(Clock::now() - start));
+                }
+            }
+
+            std::cout << "  " << std::left << std::setw(12) << method.name << std::right
+                << (cold ? " cold: " : " warm: ") << samples.percentile(0.5) << "ms p50"
+                << (loaded ? "" : " (failed!)") << '\n';
+        }
+    }
+
+    std::filesystem::remove_all(MESH_DIR);
+    return 0;
+}
@@ -0,0 +1,174 @@
+#include "bench.h"
+
+#include <iostream>
+
+#ifndef HAS_VULKAN
+
+int Bench::pipelines(int, char**)
+{
+    std::cerr << "pipelines benchmark needs Vulkan" << '\n';
+    return 1;
+}
+
+#else
+
+using Engine::Game;
+using Engine::PipelineDesc;
+using Engine::Renderer;
+
+// the triangle shaders with a different mix of fixed function state each, like a material system would
+static std::vector<PipelineDesc> permutations(const PipelineDesc& base, const uint32_t count, const VkFrontFace frontFace)
+{
+    std::vector<PipelineDesc> descs;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        PipelineDesc desc = base;
+        desc.frontFace = frontFace;
+        desc.cullMode = i % 4;
+        desc.blend = static_cast<PipelineDesc::Blend>(i / 4 % 3);
+        desc.topology = i / 12 % 2 == 0 ? VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+        desc.depthCompare = static_cast<VkCompareOp>(i / 24 % 8);
+        desc.depthWrite = i / 192 % 2 == 1;
+
+        descs.push_back(desc);
+    }
+
+    return descs;
+}
+
+int Bench::pipelines(const int argc, char** argv)
+{
+    const uint32_t nPermutations = std::min(arg(argc, argv, 0, 200), 384u);
+
+    constexpr int version[] = {0, 1, 0};
+    Game game("bench", version);
+
+    const auto renderer = new Renderer(&game);
+    const VkResult setupResult = createHeadlessRenderer(renderer, 64, 64);
+
+    if (setupResult != VK_SUCCESS)
+    {
+        std::cerr << "failed to set up headless renderer (" << setupResult << ')' << '\n';
+
+        delete renderer;
+        return 1;
+    }
+
+    VkShaderModule vertShader = VK_NULL_HANDLE;
+    VkShaderModule fragShader = VK_NULL_HANDLE;
+
+    VkResult result = Loaders::loadShaderModule(renderer->vkDev, "../src/test/shaders/compiled/triangle.vert.spv", &vertShader);
+    if (result == VK_SUCCESS) result = Loaders::loadShaderModule(renderer->vkDev, "../src/test/shaders/compiled/triangle.frag.spv", &fragShader);
+
+    if (result != VK_SUCCESS)
+    {
+        std::cerr << "failed to load the triangle shaders (" << result << ')' << '\n';
+
+        delete renderer;
+        return 1;
+    }
+
+    PipelineDesc base;
+    base.shaders = {{VK_SHADER_STAGE_VERTEX_BIT, vertShader}, {VK_SHADER_STAGE_FRAGMENT_BIT, fragShader}};
+    base.colorFormat = renderer->targetFormat();
+    base.depthFormat = VK_FORMAT_D32_SFLOAT;
+    base.depthTest = true;
+
+    const Engine::Mesh triangle = triangleMesh();
+    Engine::PipelineCache* cache = renderer->pipelines;
+
+    // compiled where they're needed, every new one is a hitch on the render thread
+    Samples blocking;
+
+    for (const auto& desc : permutations(base, nPermutations, VK_FRONT_FACE_CLOCKWISE))
+    {
+        VkPipeline pipeline;
+        const auto start = Clock::now();
+
+        result = cache->get(desc, &pipeline);
+        blocking.add(millis(Clock::now() - start));
+
+        if (result != VK_SUCCESS)
+        {
+            std::cerr << "failed to compile a permutation (" << result << ')' << '\n';
+            break;
+        }
+    }
+
+    // the same amount of new ones again, but requested from frames that draw with the fallback meanwhile
+    const std::vector<PipelineDesc> descs = permutations(base, nPermutations, VK_FRONT_FACE_COUNTER_CLOCKWISE);
+
+    Samples frames;
+    uint32_t nFrames = 0;
+    const auto asyncStart = Clock::now();
+
+    while (result == VK_SUCCESS)
+    {
+        const auto start = Clock::now();
+        uint32_t nReady = 0;
+
+        for (const auto& desc : descs)
+        {
+            nReady += cache->request(desc, VK_NULL_HANDLE) != VK_NULL_HANDLE;
+        }
+
+        renderer->draw(&triangle);
+        result = renderer->render();
+
+        frames.add(millis(Clock::now() - start));
+        nFrames++;
+
+        if (nReady == descs.size())
+        {
+            break;
+        }
+    }
+
+    const double asyncTotal = millis(Clock::now() - asyncStart);
+
+    // and what asking for one costs once they're all there
+    const auto lookupStart = Clock::now();
+    uint32_t nLookups = 0;
+
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        for (const auto& desc : descs)
+        {
+            cache->request(desc, VK_NULL_HANDLE);
+            nLookups++;
+        }
+    }
+
+    const double lookupNanos = millis(Clock::now() - lookupStart) * 1e6 / static_cast<double>(nLookups);
+
+    if (result == VK_SUCCESS)
+    {
+        std::cout << nPermutations << " permutations" << '\n';
+
+        std::cout << "compiled on the render thread: "
+            << blocking.mean() << "ms mean, "
+            << blocking.percentile(0.99) << "ms p99 stall per new pipeline" << '\n';
+
+        std::cout << "compiled on " << renderer->jobs->size() - 1 << " worker threads: all ready after "
+            << nFrames << " frames (" << asyncTotal << "ms), frames took "
+            << frames.percentile(0.5) << "ms p50, "
+            << frames.percentile(0.99) << "ms p99" << '\n';
+
+        std::cout << "request() of a ready pipeline: " << lookupNanos << "ns" << '\n';
+    } else
+    {
+        std::cerr << "frame failed (" << result << ')' << '\n';
+    }
+
+    // compiles might still be reading the modules if a frame failed
+    cache->wait();
+
+    vkDestroyShaderModule(renderer->vkDev, vertShader, nullptr);
+    vkDestroyShaderModule(renderer->vkDev, fragShader, nullptr);
+
+    delete renderer;
+    return result == VK_SUCCESS ? 0 : 1;
+}
+
+#endif
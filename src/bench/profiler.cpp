@@ -0,0 +1,75 @@
+#include "bench.h"
+
+#include <iostream>
+
+#include "engine.h"
+
+using Engine::Profiler;
+
+// each zone still gets written to the ring, so the loop can't be folded away
+static void zones(const uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const Profiler::Zone zone("bench");
+    }
+}
+
+int Bench::profiler(const int argc, char** argv)
+{
+    const uint32_t nZones = arg(argc, argv, 0, 10000000);
+    const uint32_t nFrames = arg(argc, argv, 1, 1000);
+
+    // the first zone on a thread allocates its ring
+    zones(1);
+
+    Samples samples;
+
+    for (uint32_t round = 0; round < 10; round++)
+    {
+        const auto start = Clock::now();
+        zones(nZones);
+        samples.add(millis(Clock::now() - start) * 1e6 / nZones);
+    }
+
+    Samples clockSamples;
+
+    for (uint32_t round = 0; round < 10; round++)
+    {
+        uint64_t sum = 0;
+        const auto start = Clock::now();
+
+        for (uint32_t i = 0; i < nZones; i++)
+        {
+            sum += Clock::now().time_since_epoch().count();
+        }
+
+        clockSamples.add(millis(Clock::now() - start) * 1e6 / nZones);
+        if (sum == 1) std::cout << ' ';
+    }
+
+    std::cout << "zone: " << samples.percentile(0.5) << "ns p50, " << samples.percentile(0.99) << "ns p99, "
+        << "steady_clock::now(): " << clockSamples.percentile(0.5) << "ns, "
+        << Profiler::ticksPerNanosecond() << " ticks/ns" << '\n';
+
+    // fake frames to check the percentiles come out right, ~100us each
+    Profiler::reset();
+
+    for (uint32_t i = 0; i < nFrames; i++)
+    {
+        Profiler::frame();
+
+        {
+            const Profiler::Zone zone("work");
+            spin(i % 100 == 0 ? 500 : 100);
+        }
+    }
+
+    Profiler::frame();
+
+    const Engine::ProfileStats stats = Profiler::stats("work");
+    std::cout << "work: " << stats.p50 << "ms p50, " << stats.p99 << "ms p99 over "
+        << stats.frames << " frames (expect 0.1 and 0.5)" << '\n';
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include "bench.h"
+
+#include <iostream>
+
+#ifndef HAS_VULKAN
+
+int Bench::record(int, char**)
+{
+    std::cerr << "record benchmark needs Vulkan" << '\n';
+    return 1;
+}
+
+#else
+
+using Engine::Game;
+using Engine::Renderer;
+
+// frames are tiny so the GPU keeps up and the CPU side (mostly recording) sets the pace
+static bool runRecord(const uint32_t threads, const uint32_t nDraws, const uint32_t nFrames, Bench::Samples* samples)
+{
+    constexpr int version[] = {0, 1, 0};
+    Game game("bench", version);
+
+    const auto renderer = new Renderer(&game);
+    renderer->recordThreads = threads;
+    renderer->framesInFlight = 3;
+
+    const VkResult setupResult = Bench::createHeadlessRenderer(renderer, 64, 64);
+
+    if (setupResult != VK_SUCCESS)
+    {
+        std::cerr << "failed to set up headless renderer (" << setupResult << ')' << '\n';
+
+        delete renderer;
+        return false;
+    }
+
+    const Engine::Mesh triangle = Bench::triangleMesh();
+
+    for (uint32_t i = 0; i < nFrames + 50; i++)
+    {
+        const auto start = Bench::Clock::now();
+
+        for (uint32_t j = 0; j < nDraws; j++)
+        {
+            renderer->draw(&triangle);
+        }
+
+        const VkResult result = renderer->render();
+
+        if (result != VK_SUCCESS)
+        {
+            std::cerr << "frame " << i << " failed (" << result << ')' << '\n';
+
+            delete renderer;
+            return false;
+        }
+
+        // first few frames are warmup
+        if (i >= 50)
+        {
+            samples->add(Bench::millis(Bench::Clock::now() - start));
+        }
+    }
+
+    delete renderer;
+    return true;
+}
+
+int Bench::record(const int argc, char** argv)
+{
+    const uint32_t nDraws = arg(argc, argv, 0, 50000);
+    const uint32_t maxThreads = arg(argc, argv, 1, 8);
+    const uint32_t nFrames = arg(argc, argv, 2, 500);
+
+    double baseline = 0.0;
+
+    for (uint32_t threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        Samples samples;
+        if (!runRecord(threads, nDraws, nFrames, &samples)) return 1;
+
+        const double median = samples.percentile(0.5);
+        if (threads == 1) baseline = median;
+
+        std::cout << threads << " threads, " << nDraws << " draws: "
+            << median << "ms p50, "
+            << samples.percentile(0.99) << "ms p99, "
+            << baseline / median << "x" << '\n';
+    }
+
+    return 0;
+}
+
+#endif
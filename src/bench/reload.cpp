@@ -0,0 +1,160 @@
+#include "bench.h"
+
+#include <iostream>
+
+#ifndef HAS_VULKAN
+
+int Bench::reload(int, char**)
+{
+    std::cerr << "reload benchmark needs Vulkan" << '\n';
+    return 1;
+}
+
+#else
+
+#include <cstring>
+#include <filesystem>
+
+using Engine::Game;
+using Engine::Renderer;
+using Engine::ShaderLibrary;
+
+static constexpr auto SHADER_DIR = "../src/test/shaders/compiled";
+static constexpr auto RELOAD_DIR = "bench_reload";
+
+// stands in for recompiling: the shader with a different number of OpNops at the end
+static bool writeShader(const std::string& to, const std::vector<char>& code, const uint32_t nops)
+{
+    std::vector<char> buffer = code;
+    constexpr uint32_t nop = 1 << 16;
+
+    for (uint32_t i = 0; i < nops; i++)
+    {
+        buffer.insert(buffer.end(), reinterpret_cast<const char*>(&nop), reinterpret_cast<const char*>(&nop) + 4);
+    }
+
+    return Loaders::writefile(buffer, to.c_str());
+}
+
+// how long from a .spv changing on disk to frames drawing with the rebuilt pipeline, and
+// what the frames in between cost, next to setting the renderer up again from scratch
+int Bench::reload(const int argc, char** argv)
+{
+    const uint32_t nReloads = std::max(arg(argc, argv, 0, 20), 1u);
+
+    std::vector<char> vertCode;
+    std::vector<char> fragCode;
+
+    if (!Loaders::readfile(&vertCode, (std::string(SHADER_DIR) + "/triangle.vert.spv").c_str()) ||
+        !Loaders::readfile(&fragCode, (std::string(SHADER_DIR) + "/triangle.frag.spv").c_str()))
+    {
+        std::cerr << "failed to read the triangle shaders" << '\n';
+        return 1;
+    }
+
+    std::filesystem::create_directories(RELOAD_DIR);
+
+    const std::string vertPath = std::string(RELOAD_DIR) + "/triangle.vert.spv";
+    const std::string fragPath = std::string(RELOAD_DIR) + "/triangle.frag.spv";
+
+    writeShader(vertPath, vertCode, 0);
+    writeShader(fragPath, fragCode, 0);
+
+    constexpr int version[] = {0, 1, 0};
+    Game game("bench", version);
+
+    // what iterating on a shader cost before, restarting everything
+    const auto restartStart = Clock::now();
+    auto renderer = new Renderer(&game);
+    VkResult result = createHeadlessRenderer(renderer, 256, 256);
+    const double restartMillis = millis(Clock::now() - restartStart);
+
+    if (result != VK_SUCCESS)
+    {
+        std::cerr << "failed to set up headless renderer (" << result << ')' << '\n';
+
+        delete renderer;
+        return 1;
+    }
+
+    ShaderLibrary* shaders = renderer->shaders;
+
+    Engine::PipelineDesc desc;
+    desc.colorFormat = renderer->targetFormat();
+
+    ShaderLibrary::Pipeline pipeline;
+    result = shaders->addPipeline(desc, {vertPath, fragPath}, &pipeline);
+
+    if (result == VK_SUCCESS)
+    {
+        result = shaders->watch(RELOAD_DIR);
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        std::cerr << "failed to set up hot reload (" << result << ')' << '\n';
+
+        delete renderer;
+        return 1;
+    }
+
+    const Engine::Mesh triangle = triangleMesh();
+
+    Samples latency;
+    Samples frames;
+
+    for (uint32_t i = 1; i <= nReloads && result == VK_SUCCESS; i++)
+    {
+        const VkPipeline previous = shaders->pipeline(pipeline);
+
+        // every other reload changes the vertex shader instead
+        writeShader(i % 2 == 0 ? vertPath : fragPath, i % 2 == 0 ? vertCode : fragCode, i);
+        const auto start = Clock::now();
+
+        while (result == VK_SUCCESS)
+        {
+            const auto frameStart = Clock::now();
+            const VkPipeline current = shaders->pipeline(pipeline);
+
+            renderer->draw(&triangle, current);
+            result = renderer->render();
+            frames.add(millis(Clock::now() - frameStart));
+
+            if (current != previous)
+            {
+                latency.add(millis(Clock::now() - start));
+                break;
+            }
+
+            // never seeing the change shouldn't hang the benchmark
+            if (millis(Clock::now() - start) > 5000.0)
+            {
+                std::cerr << "reload " << i << " never showed up" << '\n';
+                result = VK_TIMEOUT;
+            }
+        }
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        const ShaderLibrary::Stats stats = shaders->stats();
+
+        std::cout << stats.reloads << " reloads: " << latency.percentile(0.5) << "ms p50, "
+            << latency.percentile(0.99) << "ms p99 from the file changing to drawing with the new pipeline" << '\n';
+
+        std::cout << "frames meanwhile: " << frames.percentile(0.5) << "ms p50, "
+            << frames.percentile(0.99) << "ms p99" << '\n';
+
+        std::cout << "restarting the renderer instead: " << restartMillis << "ms" << '\n';
+    } else
+    {
+        std::cerr << "frame failed (" << result << ')' << '\n';
+    }
+
+    delete renderer;
+    std::filesystem::remove_all(RELOAD_DIR);
+
+    return result == VK_SUCCESS ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,61 @@
+#include "bench.h"
+#ifdef HAS_VULKAN
+
+VkResult Bench::createTrianglePipeline(Engine::Renderer* renderer)
+{
+    VkShaderModule vertShader;
+    VkShaderModule fragShader;
+    Loaders::ShaderReflection vertReflection;
+    Loaders::ShaderReflection fragReflection;
+
+    VkResult result = Loaders::loadShaderModule(renderer->vkDev, "../src/test/shaders/compiled/triangle.vert.spv", &vertShader, &vertReflection);
+    if (result != VK_SUCCESS) return result;
+
+    result = Loaders::loadShaderModule(renderer->vkDev, "../src/test/shaders/compiled/triangle.frag.spv", &fragShader, &fragReflection);
+    if (result != VK_SUCCESS) return result;
+
+    VkPipelineLayout layout;
+    result = renderer->layouts->pipelineLayout({&vertReflection, &fragReflection}, &layout);
+    if (result != VK_SUCCESS) return result;
+
+    VkPipelineShaderStageCreateInfo vertInfo{};
+    vertInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    vertInfo.module = vertShader;
+    vertInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+    vertInfo.pName = vertReflection.entryPoint.c_str();
+
+    VkPipelineShaderStageCreateInfo fragInfo{};
+    fragInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    fragInfo.module = fragShader;
+    fragInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    fragInfo.pName = fragReflection.entryPoint.c_str();
+
+    Engine::VertexLayout vertexLayout;
+    result = Engine::LayoutCache::vertexLayout(vertReflection, &vertexLayout);
+
+    if (result == VK_SUCCESS)
+    {
+        result = renderer->createRenderPipeline({vertInfo, fragInfo}, vertexLayout, layout);
+    }
+
+    vkDestroyShaderModule(renderer->vkDev, vertShader, nullptr);
+    vkDestroyShaderModule(renderer->vkDev, fragShader, nullptr);
+
+    return result;
+}
+
+VkResult Bench::createHeadlessRenderer(Engine::Renderer* renderer, const uint32_t width, const uint32_t height)
+{
+    VkResult result = renderer->createInstance(0, nullptr);
+    if (result != VK_SUCCESS) return result;
+
+    result = renderer->createDevice(VK_NULL_HANDLE);
+    if (result != VK_SUCCESS) return result;
+
+    result = renderer->createOffscreen(width, height);
+    if (result != VK_SUCCESS) return result;
+
+    return createTrianglePipeline(renderer);
+}
+
+#endif
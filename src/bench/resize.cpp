@@ -0,0 +1,139 @@
+#include "bench.h"
+
+#include <iostream>
+
+#if !defined(HAS_VULKAN) || !defined(HAS_GLFW)
+
+int Bench::resize(int, char**)
+{
+    std::cerr << "resize benchmark needs Vulkan and GLFW" << '\n';
+    return 1;
+}
+
+#else
+
+#include "engine.h"
+#include <GLFW/glfw3.h>
+
+using Engine::Game;
+using Engine::Renderer;
+
+// times the frame right after each resize, which is the one recreating the swapchain
+static bool runResizes(const bool dynamicRendering, const uint32_t nResizes, Bench::Samples* samples, bool* pDynamic)
+{
+    constexpr uint32_t sizes[2][2] = {{640, 480}, {800, 600}};
+
+    GLFWwindow* win = glfwCreateWindow(sizes[0][0], sizes[0][1], "bench", nullptr, nullptr);
+
+    if (win == nullptr)
+    {
+        std::cerr << "failed to create GLFWwindow" << '\n';
+        return false;
+    }
+
+    constexpr int version[] = {0, 1, 0};
+    Game game("bench", version);
+
+    const auto renderer = new Renderer(&game);
+    renderer->dynamicRendering = dynamicRendering;
+    renderer->preferredPresentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+
+    uint32_t nExtensions;
+    const char* const* extensions = glfwGetRequiredInstanceExtensions(&nExtensions);
+
+    VkResult result = renderer->createInstance(nExtensions, extensions);
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
+
+    if (result == VK_SUCCESS) result = glfwCreateWindowSurface(renderer->vkInst, win, nullptr, &surface);
+    if (result == VK_SUCCESS) result = renderer->createDevice(surface);
+    if (result == VK_SUCCESS) result = renderer->createSwapchain(sizes[0][0], sizes[0][1]);
+    if (result == VK_SUCCESS) result = Bench::createTrianglePipeline(renderer);
+
+    if (result != VK_SUCCESS)
+    {
+        std::cerr << "failed to set up renderer (" << result << ')' << '\n';
+
+        delete renderer;
+        glfwDestroyWindow(win);
+        return false;
+    }
+
+    *pDynamic = renderer->usesDynamicRendering();
+    const Engine::Mesh triangle = Bench::triangleMesh();
+
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        renderer->draw(&triangle);
+        renderer->render();
+    }
+
+    for (uint32_t i = 0; i < nResizes; i++)
+    {
+        const uint32_t* size = sizes[(i + 1) % 2];
+
+        glfwSetWindowSize(win, static_cast<int>(size[0]), static_cast<int>(size[1]));
+        glfwPollEvents();
+
+        const auto start = Bench::Clock::now();
+
+        renderer->resize(size[0], size[1]);
+        renderer->draw(&triangle);
+        renderer->render();
+
+        samples->add(Bench::millis(Bench::Clock::now() - start));
+
+        // a few ordinary frames in between, so retired swapchains get cleaned up like they would in a game
+        for (uint32_t j = 0; j < 4; j++)
+        {
+            renderer->draw(&triangle);
+            renderer->render();
+        }
+    }
+
+    delete renderer;
+    glfwDestroyWindow(win);
+
+    return true;
+}
+
+int Bench::resize(const int argc, char** argv)
+{
+    const uint32_t nResizes = arg(argc, argv, 0, 500);
+
+    if (!glfwInit())
+    {
+        std::cerr << "failed to initialize GLFW" << '\n';
+        return 1;
+    }
+
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+
+    std::cout << nResizes << " resizes" << '\n';
+
+    for (const bool dynamicRendering : {false, true})
+    {
+        Samples samples;
+        bool dynamic = false;
+
+        if (!runResizes(dynamicRendering, nResizes, &samples, &dynamic))
+        {
+            glfwTerminate();
+            return 1;
+        }
+
+        if (dynamicRendering && !dynamic)
+        {
+            std::cout << "no dynamic rendering on this device, the second run used render passes too" << '\n';
+        }
+
+        std::cout << (dynamic ? "dynamic rendering: " : "render passes: ")
+            << samples.mean() << "ms mean, "
+            << samples.percentile(0.5) << "ms p50, "
+            << samples.percentile(0.99) << "ms p99 for the frame recreating the swapchain" << '\n';
+    }
+
+    glfwTerminate();
+    return 0;
+}
+
+#endif
@@ -0,0 +1,218 @@
+#include "bench.h"
+
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "engine.h"
+
+using Engine::JobSystem;
+using Engine::Mat4;
+using Engine::Node;
+using Engine::Quat;
+using Engine::Scene;
+using Engine::Vec3;
+
+namespace
+{
+    // what the flat arrays replace: every node its own allocation with its children behind pointers,
+    // all of it recomputed every frame
+    struct PointerNode
+    {
+        Vec3 translation;
+        Quat rotation;
+        Vec3 scale = {1.0f, 1.0f, 1.0f};
+        Mat4 world;
+        std::vector<PointerNode*> children;
+    };
+
+    void updatePointers(PointerNode* node, const Mat4& parent)
+    {
+        node->world = parent * Mat4::trs(node->translation, node->rotation, node->scale);
+
+        for (PointerNode* child : node->children)
+        {
+            updatePointers(child, node->world);
+        }
+    }
+
+    void deletePointers(const PointerNode* node)
+    {
+        for (const PointerNode* child : node->children)
+        {
+            deletePointers(child);
+        }
+
+        delete node;
+    }
+
+    // median of a few frames, move() runs before each one and isn't timed
+    template<typename F>
+    double measure(Scene* scene, JobSystem* jobs, const F& move, size_t* recomputed)
+    {
+        Bench::Samples samples;
+
+        for (uint32_t frame = 0; frame < 11; frame++)
+        {
+            move(frame);
+
+            const auto start = Bench::Clock::now();
+            *recomputed = scene->update(jobs);
+            samples.add(Bench::millis(Bench::Clock::now() - start));
+        }
+
+        return samples.percentile(0.5);
+    }
+
+    void report(const char* name, const uint32_t threads, const double millis, const size_t recomputed, const double everything)
+    {
+        std::cout << "  " << std::left << std::setw(16) << name << std::right << std::setw(2) << threads << " threads: "
+            << std::setw(8) << millis << "ms, " << std::setw(8) << recomputed << " recomputed";
+
+        if (recomputed > 0)
+        {
+            std::cout << " (" << millis * 1e6 / static_cast<double>(recomputed) << "ns each)";
+        }
+
+        std::cout << ", " << std::setprecision(1) << 100.0 * millis / everything << std::setprecision(2) << "% of everything" << '\n';
+    }
+}
+
+// A million nodes (or as many as given) as trees of a root, 8 children, 64 grandchildren and 512
+// great grandchildren, created depth first like a loader would. Then frames where nothing moves, where
+// a random 1% of the nodes turn and where all of them do, on one thread and on more, against the
+// same trees behind pointers recomputed every frame.
+int Bench::scene(const int argc, char** argv)
+{
+    const uint32_t count = std::max(arg(argc, argv, 0, 1000000), 1u);
+    const uint32_t maxThreads = std::max(arg(argc, argv, 1, std::thread::hardware_concurrency()), 1u);
+
+    std::cout << std::fixed << std::setprecision(2);
+
+    Scene scene;
+    std::vector<Node> nodes;
+    std::vector<PointerNode*> roots;
+    nodes.reserve(count);
+
+    uint32_t seed = 1;
+
+    const auto createTree = [&](const auto& self, const Node parent, PointerNode* pointerParent, const uint32_t depth) -> void
+    {
+        if (nodes.size() == count)
+        {
+            return;
+        }
+
+        const Vec3 translation = {static_cast<float>(Test::random(&seed) % 100), static_cast<float>(depth), 0.0f};
+        nodes.push_back(scene.create(parent, translation, {}, {1.0f, 1.0f, 1.0f}));
+
+        auto* pointerNode = new PointerNode();
+        pointerNode->translation = translation;
+
+        if (pointerParent != nullptr)
+        {
+            pointerParent->children.push_back(pointerNode);
+        }
+        else
+        {
+            roots.push_back(pointerNode);
+        }
+
+        if (depth < 3)
+        {
+            const Node node = nodes.back();
+
+            for (uint32_t i = 0; i < 8; i++)
+            {
+                self(self, node, pointerNode, depth + 1);
+            }
+        }
+    };
+
+    auto start = Clock::now();
+
+    while (nodes.size() < count)
+    {
+        createTree(createTree, {}, nullptr, 0);
+    }
+
+    const double createMs = millis(Clock::now() - start);
+
+    start = Clock::now();
+    const size_t first = scene.update();
+
+    std::cout << count << " nodes in " << roots.size() << " trees, created in " << createMs << "ms, the first update did "
+        << first << " of them in " << millis(Clock::now() - start) << "ms" << '\n';
+
+    Samples pointerSamples;
+
+    for (uint32_t frame = 0; frame < 11; frame++)
+    {
+        start = Clock::now();
+
+        for (PointerNode* root : roots)
+        {
+            updatePointers(root, Mat4());
+        }
+
+        pointerSamples.add(millis(Clock::now() - start));
+    }
+
+    const double pointerMs = pointerSamples.percentile(0.5);
+    std::cout << "  pointers, everything every frame: " << pointerMs << "ms" << '\n';
+
+    const auto turn = [](const uint32_t frame, const uint32_t i)
+    {
+        return Quat::axisAngle({0.0f, 1.0f, 0.0f}, 0.01f * static_cast<float>(frame + i));
+    };
+
+    const auto still = [](uint32_t) {};
+
+    const auto someMoving = [&scene, &nodes, &seed, &turn, count](const uint32_t frame)
+    {
+        for (uint32_t i = 0; i < count / 100; i++)
+        {
+            scene.setRotation(nodes[Test::random(&seed) % count], turn(frame, i));
+        }
+    };
+
+    const auto allMoving = [&scene, &nodes, &turn, count](const uint32_t frame)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            scene.setRotation(nodes[i], turn(frame, i));
+        }
+    };
+
+    for (uint32_t threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        JobSystem* jobs = threads > 1 ? new JobSystem(threads) : nullptr;
+        size_t recomputed = 0;
+
+        const double everything = measure(&scene, jobs, allMoving, &recomputed);
+        report("all moving", threads, everything, recomputed, everything);
+
+        const double some = measure(&scene, jobs, someMoving, &recomputed);
+        report("1% moving", threads, some, recomputed, everything);
+
+        const double none = measure(&scene, jobs, still, &recomputed);
+        report("static", threads, none, recomputed, everything);
+
+        delete jobs;
+    }
+
+    // moving a tree under another one is the only thing here that needs them sorted again
+    scene.setParent(nodes[0], nodes[count - 1]);
+
+    start = Clock::now();
+    scene.update();
+
+    std::cout << "  reparenting one tree, then sorting and updating: " << millis(Clock::now() - start) << "ms" << '\n';
+
+    for (const PointerNode* root : roots)
+    {
+        deletePointers(root);
+    }
+
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include "bench.h"
+
+#include <iostream>
+
+#ifndef HAS_VULKAN
+
+int Bench::spirv(int, char**)
+{
+    std::cerr << "spirv benchmark needs Vulkan" << '\n';
+    return 1;
+}
+
+#else
+
+#include <cstring>
+#include <iomanip>
+
+static const char* DEFAULT_SHADERS[] = {
+    "../src/test/shaders/compiled/triangle.vert.spv",
+    "../src/test/shaders/compiled/triangle.frag.spv",
+};
+
+static void print(const char* filename, const Loaders::ShaderReflection& reflection)
+{
+    std::cout << filename << ": stage " << reflection.stage << " entry " << reflection.entryPoint << '\n';
+
+    for (const auto& binding : reflection.bindings)
+    {
+        std::cout << "  set " << binding.set << " binding " << binding.binding << " type " << binding.type
+            << " count " << binding.count << ' ' << binding.name << '\n';
+    }
+
+    for (const auto& input : reflection.inputs)
+    {
+        std::cout << "  input " << input.location << " format " << input.format << ' ' << input.name << '\n';
+    }
+
+    for (const auto& constant : reflection.specializationConstants)
+    {
+        std::cout << "  spec " << constant.id << " size " << constant.size << " default " << constant.defaultValue
+            << ' ' << constant.name << '\n';
+    }
+
+    if (reflection.pushConstants.size != 0)
+    {
+        std::cout << "  push constants " << reflection.pushConstants.offset << '+' << reflection.pushConstants.size << '\n';
+    }
+}
+
+// reflection runs on every shader load (and every hot reload), so it has to be cheap next to reading the file
+int Bench::spirv(const int argc, char** argv)
+{
+    const uint32_t iterations = std::max(arg(argc, argv, 0, 100000), 1u);
+
+    std::vector<const char*> filenames;
+
+    for (int i = 1; i < argc; i++)
+    {
+        filenames.push_back(argv[i]);
+    }
+
+    if (filenames.empty())
+    {
+        filenames.assign(std::begin(DEFAULT_SHADERS), std::end(DEFAULT_SHADERS));
+    }
+
+    std::vector<std::vector<uint32_t>> shaders;
+    size_t totalBytes = 0;
+
+    for (const auto filename : filenames)
+    {
+        std::vector<char> buffer;
+
+        if (!Loaders::readfile(&buffer, filename))
+        {
+            std::cerr << "failed to read " << filename << '\n';
+            return 1;
+        }
+
+        std::vector<uint32_t> words(buffer.size() / 4);
+        std::memcpy(words.data(), buffer.data(), words.size() * 4);
+
+        Loaders::ShaderReflection reflection;
+
+        if (!Loaders::reflectShader(words.data(), words.size(), &reflection))
+        {
+            std::cerr << filename << " isn't valid SPIR-V" << '\n';
+            return 1;
+        }
+
+        print(filename, reflection);
+
+        totalBytes += words.size() * 4;
+        shaders.push_back(std::move(words));
+    }
+
+    Loaders::ShaderReflection reflection;
+    const auto start = Clock::now();
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        for (const auto& words : shaders)
+        {
+            Loaders::reflectShader(words.data(), words.size(), &reflection);
+        }
+    }
+
+    const double elapsed = millis(Clock::now() - start);
+    const double reflections = static_cast<double>(iterations) * static_cast<double>(shaders.size());
+
+    std::cout << std::fixed << std::setprecision(2)
+        << shaders.size() << " shaders (" << totalBytes << " bytes) x " << iterations << ": "
+        << elapsed * 1000.0 / reflections << " us per shader, "
+        << reflections / (elapsed / 1000.0) << " shaders/s, "
+        << static_cast<double>(totalBytes) * iterations / (elapsed / 1000.0) / (1024.0 * 1024.0) << " MB/s" << '\n';
+
+    return 0;
+}
+
+#endif
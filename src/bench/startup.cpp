@@ -0,0 +1,81 @@
+#include "bench.h"
+
+#include <cstdio>
+#include <iostream>
+
+#ifndef HAS_VULKAN
+
+int Bench::startup(int, char**)
+{
+    std::cerr << "startup benchmark needs Vulkan" << '\n';
+    return 1;
+}
+
+#else
+
+using Engine::Game;
+using Engine::Renderer;
+
+static constexpr auto CACHE_PATH = "bench_pipelines.cache";
+
+// times renderer setup up to a usable pipeline, the cache is saved when the renderer goes away
+static bool timeStartup(Bench::Samples* total, Bench::Samples* pipeline)
+{
+    constexpr int version[] = {0, 1, 0};
+    Game game("bench", version);
+
+    const auto start = Bench::Clock::now();
+
+    const auto renderer = new Renderer(&game);
+    renderer->pipelineCachePath = CACHE_PATH;
+
+    VkResult result = renderer->createInstance(0, nullptr);
+    if (result == VK_SUCCESS) result = renderer->createDevice(VK_NULL_HANDLE);
+    if (result == VK_SUCCESS) result = renderer->createOffscreen(640, 480);
+
+    const auto pipelineStart = Bench::Clock::now();
+    if (result == VK_SUCCESS) result = Bench::createTrianglePipeline(renderer);
+
+    const auto end = Bench::Clock::now();
+
+    if (result != VK_SUCCESS)
+    {
+        std::cerr << "failed to set up headless renderer (" << result << ')' << '\n';
+
+        delete renderer;
+        return false;
+    }
+
+    total->add(Bench::millis(end - start));
+    pipeline->add(Bench::millis(end - pipelineStart));
+
+    delete renderer;
+    return true;
+}
+
+int Bench::startup(const int argc, char** argv)
+{
+    const uint32_t runs = arg(argc, argv, 0, 10);
+
+    Samples coldTotal, coldPipeline;
+    Samples warmTotal, warmPipeline;
+
+    for (uint32_t i = 0; i < runs; i++)
+    {
+        std::remove(CACHE_PATH);
+        if (!timeStartup(&coldTotal, &coldPipeline)) return 1;
+
+        // the cold run above just wrote the cache
+        if (!timeStartup(&warmTotal, &warmPipeline)) return 1;
+    }
+
+    std::remove(CACHE_PATH);
+
+    std::cout << runs << " runs (set MESA_SHADER_CACHE_DISABLE=true or similar to keep the driver's own cache out of it)" << '\n';
+    std::cout << "cold: " << coldTotal.percentile(0.5) << "ms startup, " << coldPipeline.percentile(0.5) << "ms pipeline (median)" << '\n';
+    std::cout << "warm: " << warmTotal.percentile(0.5) << "ms startup, " << warmPipeline.percentile(0.5) << "ms pipeline (median)" << '\n';
+
+    return 0;
+}
+
+#endif
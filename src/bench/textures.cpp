@@ -0,0 +1,188 @@
+#include "bench.h"
+
+#include <iostream>
+
+#ifndef HAS_VULKAN
+
+int Bench::textures(int, char**)
+{
+    std::cerr << "textures benchmark needs Vulkan" << '\n';
+    return 1;
+}
+
+#else
+
+#include <filesystem>
+#include <iomanip>
+
+using Engine::Game;
+using Engine::Renderer;
+using Engine::Texture;
+using Engine::TextureStreamer;
+
+static constexpr auto TEXTURE_DIR = "bench_textures";
+
+// loads every texture at once and renders until they're all in, stagingSize and budget of 0 mean
+// no limit (one frame takes everything)
+static int streamTextures(
+    const std::vector<std::string>& filenames,
+    const uint64_t totalBytes,
+    const VkDeviceSize budget,
+    const char* name)
+{
+    constexpr int version[] = {0, 1, 0};
+    Game game("bench", version);
+
+    const auto renderer = new Renderer(&game);
+    renderer->textureStagingSize = budget > 0 ? budget * (renderer->framesInFlight + 1) : totalBytes * (renderer->framesInFlight + 1);
+
+    const VkResult setupResult = Bench::createHeadlessRenderer(renderer, 640, 480);
+
+    if (setupResult != VK_SUCCESS)
+    {
+        std::cerr << "failed to set up headless renderer (" << setupResult << ')' << '\n';
+
+        delete renderer;
+        return 1;
+    }
+
+    renderer->textures->budget = budget > 0 ? budget : totalBytes;
+
+    const Engine::Mesh triangle = Bench::triangleMesh();
+
+    // settle in before anything gets loaded
+    for (uint32_t i = 0; i < 60; i++)
+    {
+        renderer->draw(&triangle);
+        renderer->render();
+    }
+
+    std::vector<Texture*> textures(filenames.size());
+
+    for (size_t i = 0; i < filenames.size(); i++)
+    {
+        const VkResult result = renderer->textures->load(filenames[i], {}, &textures[i]);
+
+        if (result != VK_SUCCESS)
+        {
+            std::cerr << "failed to load " << filenames[i] << " (" << result << ')' << '\n';
+
+            delete renderer;
+            return 1;
+        }
+    }
+
+    Bench::Samples frames;
+    VkDeviceSize largestFrame = 0;
+    int32_t visibleFrame = -1;
+    uint32_t frame = 0;
+
+    const auto start = Bench::Clock::now();
+
+    for (; renderer->textures->stats().streaming > 0; frame++)
+    {
+        const auto frameStart = Bench::Clock::now();
+
+        renderer->draw(&triangle);
+        const VkResult result = renderer->render();
+
+        if (result != VK_SUCCESS)
+        {
+            std::cerr << "frame " << frame << " failed (" << result << ')' << '\n';
+
+            delete renderer;
+            return 1;
+        }
+
+        frames.add(Bench::millis(Bench::Clock::now() - frameStart));
+        largestFrame = std::max(largestFrame, renderer->textures->stats().uploadedLastFrame);
+
+        if (visibleFrame < 0 && std::all_of(textures.begin(), textures.end(), [](const Texture* texture) { return texture->view != VK_NULL_HANDLE; }))
+        {
+            visibleFrame = static_cast<int32_t>(frame);
+        }
+    }
+
+    vkDeviceWaitIdle(renderer->vkDev);
+    const double total = Bench::millis(Bench::Clock::now() - start);
+    const TextureStreamer::Stats stats = renderer->textures->stats();
+
+    std::cout << "  " << name << ": all visible after " << visibleFrame + 1 << " frames, sharp after "
+        << frame << " (" << total << "ms), frames " << frames.percentile(0.5) << "ms p50, "
+        << frames.percentile(0.99) << "ms p99, largest upload " << static_cast<double>(largestFrame) / (1024.0 * 1024.0) << "MB" << '\n'
+        << "    budget " << static_cast<double>(stats.budget) / (1024.0 * 1024.0) << "MB, first level after "
+        << stats.firstLevelMs << "ms, resident after " << stats.residentMs << "ms mean, "
+        << stats.maxResidentMs << "ms max" << '\n';
+
+    delete renderer;
+    return 0;
+}
+
+// a level's worth of textures loaded at once, streamed under a budget and all in one go
+int Bench::textures(const int argc, char** argv)
+{
+    const uint32_t nTextures = std::max(arg(argc, argv, 0, 32), 1u);
+    const uint32_t size = std::max(arg(argc, argv, 1, 1024), 1u);
+    const VkDeviceSize budget = static_cast<VkDeviceSize>(std::max(arg(argc, argv, 2, 8), 1u)) * 1024 * 1024;
+
+    std::filesystem::create_directories(TEXTURE_DIR);
+
+    std::vector<std::vector<char>> levels;
+
+    for (uint32_t level = size; ; level /= 2)
+    {
+        levels.emplace_back(static_cast<size_t>(level) * level * 4);
+
+        if (level == 1)
+        {
+            break;
+        }
+    }
+
+    std::vector<std::string> filenames;
+    uint64_t totalBytes = 0;
+
+    for (uint32_t i = 0; i < nTextures; i++)
+    {
+        // a different checkerboard each, so no two files are the same
+        for (size_t level = 0; level < levels.size(); level++)
+        {
+            const uint32_t width = std::max(size >> level, 1u);
+
+            for (size_t texel = 0; texel < levels[level].size() / 4; texel++)
+            {
+                const bool odd = (texel % width / 8 + texel / width / 8) % 2;
+                const auto value = static_cast<char>(odd ? i * 37 : 255 - i * 37);
+
+                levels[level][texel * 4] = value;
+                levels[level][texel * 4 + 1] = static_cast<char>(level * 16);
+                levels[level][texel * 4 + 2] = value;
+                levels[level][texel * 4 + 3] = static_cast<char>(255);
+            }
+        }
+
+        std::vector<char> file;
+        Loaders::writeKtx2(VK_FORMAT_R8G8B8A8_UNORM, size, size, levels, &file);
+
+        filenames.push_back(std::string(TEXTURE_DIR) + "/" + std::to_string(i) + ".ktx2");
+        Loaders::writefile(file, filenames.back().c_str());
+
+        totalBytes += file.size();
+    }
+
+    std::cout << std::fixed << std::setprecision(2)
+        << nTextures << " textures of " << size << 'x' << size << " RGBA8 with " << levels.size() << " levels, "
+        << static_cast<double>(totalBytes) / (1024.0 * 1024.0) << "MB in all" << '\n';
+
+    int result = streamTextures(filenames, totalBytes, budget, "budgeted");
+
+    if (result == 0)
+    {
+        result = streamTextures(filenames, totalBytes, 0, "all at once");
+    }
+
+    std::filesystem::remove_all(TEXTURE_DIR);
+    return result;
+}
+
+#endif
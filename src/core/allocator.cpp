@@ -0,0 +1,707 @@
+#include "engine.h"
+#include "allocator.h"
+
+#ifdef HAS_VULKAN
+
+#include <algorithm>
+#include <bit>
+
+static uint32_t orderFor(const VkDeviceSize size)
+{
+    const VkDeviceSize units = (std::max(size, Engine::Allocator::MIN_ALLOCATION) + Engine::Allocator::MIN_ALLOCATION - 1) / Engine::Allocator::MIN_ALLOCATION;
+    return static_cast<uint32_t>(std::bit_width(std::bit_ceil(units)) - 1);
+}
+
+static VkDeviceSize alignUp(const VkDeviceSize value, const VkDeviceSize alignment)
+{
+    return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+double Engine::AllocatorStats::utilisation() const
+{
+    return this->reserved > 0 ? static_cast<double>(this->used) / static_cast<double>(this->reserved) : 0.0;
+}
+
+double Engine::AllocatorStats::internalFragmentation() const
+{
+    return this->used > 0 ? 1.0 - static_cast<double>(this->requested) / static_cast<double>(this->used) : 0.0;
+}
+
+double Engine::AllocatorStats::externalFragmentation() const
+{
+    const VkDeviceSize free = this->reserved - this->used;
+    return free > 0 ? 1.0 - static_cast<double>(this->largestFree) / static_cast<double>(free) : 0.0;
+}
+
+Engine::Allocator::Allocator(VkPhysicalDevice physDev, VkDevice dev)
+{
+    this->vkDev = dev;
+
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(physDev, &props);
+    vkGetPhysicalDeviceMemoryProperties(physDev, &this->memProps);
+
+    this->granularity = props.limits.bufferImageGranularity;
+    this->maxAllocations = props.limits.maxMemoryAllocationCount;
+
+    // even pools hold buffers and linear images, odd ones optimal images
+    this->pools.resize(this->memProps.memoryTypeCount * 2);
+
+    for (uint32_t i = 0; i < this->pools.size(); i++)
+    {
+        this->pools[i].memoryType = i / 2;
+    }
+}
+
+uint32_t Engine::Allocator::findMemoryType(
+    const uint32_t typeBits,
+    const VkMemoryPropertyFlags required,
+    const VkMemoryPropertyFlags preferred) const
+{
+    uint32_t fallback = UINT32_MAX;
+
+    for (uint32_t i = 0; i < this->memProps.memoryTypeCount; i++)
+    {
+        const VkMemoryPropertyFlags flags = this->memProps.memoryTypes[i].propertyFlags;
+
+        if (!(typeBits & (1u << i)) || (flags & required) != required)
+        {
+            continue;
+        }
+
+        if ((flags & preferred) == preferred)
+        {
+            return i;
+        }
+
+        if (fallback == UINT32_MAX)
+        {
+            fallback = i;
+        }
+    }
+
+    return fallback;
+}
+
+VkResult Engine::Allocator::allocateMemory(const uint32_t memoryType, const VkDeviceSize size, VkDeviceMemory* pMemory, char** pMapped)
+{
+    if (this->deviceAllocations >= this->maxAllocations)
+    {
+        return VK_ERROR_TOO_MANY_OBJECTS;
+    }
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryType;
+
+    VkResult result = vkAllocateMemory(this->vkDev, &allocInfo, nullptr, pMemory);
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
+    *pMapped = nullptr;
+
+    if (this->memProps.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        void* mapped;
+        result = vkMapMemory(this->vkDev, *pMemory, 0, VK_WHOLE_SIZE, 0, &mapped);
+
+        if (result != VK_SUCCESS)
+        {
+            vkFreeMemory(this->vkDev, *pMemory, nullptr);
+            return result;
+        }
+
+        *pMapped = static_cast<char*>(mapped);
+    }
+
+    this->deviceAllocations++;
+    return VK_SUCCESS;
+}
+
+VkResult Engine::Allocator::createBlock(Pool& pool, const VkDeviceSize minSize, uint32_t* pIndex)
+{
+    const VkDeviceSize needed = MIN_ALLOCATION << orderFor(minSize);
+    const VkDeviceSize heapSize = this->memProps.memoryHeaps[this->memProps.memoryTypes[pool.memoryType].heapIndex].size;
+
+    VkDeviceSize size = std::bit_floor(std::min(this->blockSize, heapSize / 8));
+    size = std::max(size, needed);
+
+    auto block = std::make_unique<Block>();
+    VkResult result;
+
+    // a smaller block beats no block when the heap is nearly full
+    while ((result = this->allocateMemory(pool.memoryType, size, &block->memory, &block->mapped)) == VK_ERROR_OUT_OF_DEVICE_MEMORY &&
+        size / 2 >= needed)
+    {
+        size /= 2;
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
+    const uint32_t maxOrder = orderFor(size);
+
+    block->size = size;
+    block->free.resize(maxOrder + 1);
+    block->free[maxOrder].insert(0);
+
+    for (uint32_t i = 0; i < pool.blocks.size(); i++)
+    {
+        if (pool.blocks[i] == nullptr)
+        {
+            pool.blocks[i] = std::move(block);
+            *pIndex = i;
+
+            return VK_SUCCESS;
+        }
+    }
+
+    *pIndex = static_cast<uint32_t>(pool.blocks.size());
+    pool.blocks.push_back(std::move(block));
+
+    return VK_SUCCESS;
+}
+
+bool Engine::Allocator::allocateFromBlock(Pool& pool, const uint32_t index, const uint32_t order, Allocation* out)
+{
+    Block* block = pool.blocks[index].get();
+
+    if (block == nullptr || order >= block->free.size())
+    {
+        return false;
+    }
+
+    uint32_t j = order;
+    while (j < block->free.size() && block->free[j].empty()) j++;
+
+    if (j == block->free.size())
+    {
+        return false;
+    }
+
+    const VkDeviceSize offset = *block->free[j].begin();
+    block->free[j].erase(block->free[j].begin());
+
+    // split down, handing the upper halves back as free buddies
+    while (j > order)
+    {
+        j--;
+        block->free[j].insert(offset + (MIN_ALLOCATION << j));
+    }
+
+    out->memory = block->memory;
+    out->offset = offset;
+    out->mapped = block->mapped != nullptr ? block->mapped + offset : nullptr;
+    out->kind = Allocation::BLOCK;
+    out->memoryType = pool.memoryType;
+    out->pool = static_cast<uint32_t>(&pool - this->pools.data());
+    out->block = index;
+    out->order = order;
+
+    block->live[offset] = *out;
+    block->used += MIN_ALLOCATION << order;
+
+    return true;
+}
+
+void Engine::Allocator::freeInBlock(Pool& pool, const Allocation& allocation)
+{
+    Block* block = pool.blocks[allocation.block].get();
+
+    if (block == nullptr || block->live.erase(allocation.offset) == 0)
+    {
+        return;
+    }
+
+    block->used -= MIN_ALLOCATION << allocation.order;
+
+    VkDeviceSize offset = allocation.offset;
+    uint32_t order = allocation.order;
+
+    // merge with the buddy for as long as it's free too
+    while (order + 1 < block->free.size())
+    {
+        const VkDeviceSize buddy = offset ^ (MIN_ALLOCATION << order);
+
+        if (block->free[order].erase(buddy) == 0)
+        {
+            break;
+        }
+
+        offset = std::min(offset, buddy);
+        order++;
+    }
+
+    block->free[order].insert(offset);
+
+    if (block->used > 0)
+    {
+        return;
+    }
+
+    // keep one empty block around so alloc/free churn doesn't hit the driver every time
+    uint32_t blocksLeft = 0;
+
+    for (const auto& other : pool.blocks)
+    {
+        if (other != nullptr) blocksLeft++;
+    }
+
+    if (blocksLeft > 1 || block->draining)
+    {
+        vkFreeMemory(this->vkDev, block->memory, nullptr);
+        pool.blocks[allocation.block] = nullptr;
+
+        this->deviceAllocations--;
+    }
+}
+
+VkResult Engine::Allocator::allocate(
+    const VkMemoryRequirements& reqs,
+    const VkMemoryPropertyFlags required,
+    const VkMemoryPropertyFlags preferred,
+    const bool optimalImage,
+    Allocation* out)
+{
+    std::lock_guard lock(this->mutex);
+
+    const uint32_t preferredType = this->findMemoryType(reqs.memoryTypeBits, required, preferred);
+    const uint32_t requiredType = this->findMemoryType(reqs.memoryTypeBits, required, 0);
+
+    if (requiredType == UINT32_MAX)
+    {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    // buddy blocks are aligned to their own size, so this covers the alignment too
+    const uint32_t order = orderFor(std::max(reqs.size, reqs.alignment));
+    VkResult result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+
+    for (const uint32_t type : {preferredType, requiredType})
+    {
+        const VkDeviceSize heapSize = this->memProps.memoryHeaps[this->memProps.memoryTypes[type].heapIndex].size;
+        const VkDeviceSize typeBlockSize = std::bit_floor(std::min(this->blockSize, heapSize / 8));
+
+        *out = Allocation{};
+
+        if ((MIN_ALLOCATION << order) > typeBlockSize / 2)
+        {
+            char* mapped;
+            result = this->allocateMemory(type, reqs.size, &out->memory, &mapped);
+
+            if (result == VK_SUCCESS)
+            {
+                out->mapped = mapped;
+                out->kind = Allocation::DEDICATED;
+                out->memoryType = type;
+                out->size = reqs.size;
+
+                this->dedicatedCount++;
+                this->dedicatedSize += reqs.size;
+                this->requested += reqs.size;
+
+                return VK_SUCCESS;
+            }
+
+            continue;
+        }
+
+        Pool& pool = this->pools[type * 2 + (optimalImage ? 1 : 0)];
+
+        for (uint32_t i = 0; i < pool.blocks.size(); i++)
+        {
+            if (pool.blocks[i] != nullptr && !pool.blocks[i]->draining && this->allocateFromBlock(pool, i, order, out))
+            {
+                out->size = reqs.size;
+                pool.blocks[i]->live[out->offset].size = reqs.size;
+                this->requested += reqs.size;
+
+                return VK_SUCCESS;
+            }
+        }
+
+        uint32_t index;
+        result = this->createBlock(pool, MIN_ALLOCATION << order, &index);
+
+        if (result == VK_SUCCESS && this->allocateFromBlock(pool, index, order, out))
+        {
+            out->size = reqs.size;
+            pool.blocks[index]->live[out->offset].size = reqs.size;
+            this->requested += reqs.size;
+
+            return VK_SUCCESS;
+        }
+
+        if (preferredType == requiredType)
+        {
+            break;
+        }
+    }
+
+    return result;
+}
+
+void Engine::Allocator::free(const Allocation& allocation)
+{
+    std::lock_guard lock(this->mutex);
+
+    switch (allocation.kind)
+    {
+    case Allocation::BLOCK:
+        this->freeInBlock(this->pools[allocation.pool], allocation);
+        this->requested -= allocation.size;
+        break;
+
+    case Allocation::DEDICATED:
+        vkFreeMemory(this->vkDev, allocation.memory, nullptr);
+
+        this->deviceAllocations--;
+        this->dedicatedCount--;
+        this->dedicatedSize -= allocation.size;
+        this->requested -= allocation.size;
+        break;
+
+    default:
+        break;
+    }
+}
+
+void Engine::Allocator::setUserData(Allocation& allocation, void* userData)
+{
+    std::lock_guard lock(this->mutex);
+    allocation.userData = userData;
+
+    if (allocation.kind != Allocation::BLOCK)
+    {
+        return;
+    }
+
+    const auto& block = this->pools[allocation.pool].blocks[allocation.block];
+    const auto live = block->live.find(allocation.offset);
+
+    if (live != block->live.end())
+    {
+        live->second.userData = userData;
+    }
+}
+
+VkResult Engine::Allocator::createBuffer(
+    const VkBufferCreateInfo& createInfo,
+    const VkMemoryPropertyFlags required,
+    const VkMemoryPropertyFlags preferred,
+    VkBuffer* pBuffer,
+    Allocation* out)
+{
+    VkResult result = vkCreateBuffer(this->vkDev, &createInfo, nullptr, pBuffer);
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
+    VkMemoryRequirements memReqs;
+    vkGetBufferMemoryRequirements(this->vkDev, *pBuffer, &memReqs);
+
+    result = this->allocate(memReqs, required, preferred, false, out);
+
+    if (result == VK_SUCCESS)
+    {
+        result = vkBindBufferMemory(this->vkDev, *pBuffer, out->memory, out->offset);
+
+        if (result != VK_SUCCESS)
+        {
+            this->free(*out);
+        }
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        vkDestroyBuffer(this->vkDev, *pBuffer, nullptr);
+        *pBuffer = VK_NULL_HANDLE;
+    }
+
+    return result;
+}
+
+VkResult Engine::Allocator::createImage(
+    const VkImageCreateInfo& createInfo,
+    const VkMemoryPropertyFlags required,
+    const VkMemoryPropertyFlags preferred,
+    VkImage* pImage,
+    Allocation* out)
+{
+    VkResult result = vkCreateImage(this->vkDev, &createInfo, nullptr, pImage);
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
+    VkMemoryRequirements memReqs;
+    vkGetImageMemoryRequirements(this->vkDev, *pImage, &memReqs);
+
+    result = this->allocate(memReqs, required, preferred, createInfo.tiling == VK_IMAGE_TILING_OPTIMAL, out);
+
+    if (result == VK_SUCCESS)
+    {
+        result = vkBindImageMemory(this->vkDev, *pImage, out->memory, out->offset);
+
+        if (result != VK_SUCCESS)
+        {
+            this->free(*out);
+        }
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        vkDestroyImage(this->vkDev, *pImage, nullptr);
+        *pImage = VK_NULL_HANDLE;
+    }
+
+    return result;
+}
+
+void Engine::Allocator::destroyBuffer(VkBuffer buffer, const Allocation& allocation)
+{
+    vkDestroyBuffer(this->vkDev, buffer, nullptr);
+    this->free(allocation);
+}
+
+void Engine::Allocator::destroyImage(VkImage image, const Allocation& allocation)
+{
+    vkDestroyImage(this->vkDev, image, nullptr);
+    this->free(allocation);
+}
+
+VkResult Engine::Allocator::createLinearPool(
+    const VkDeviceSize size,
+    const uint32_t typeBits,
+    const VkMemoryPropertyFlags required,
+    uint32_t* pPool)
+{
+    std::lock_guard lock(this->mutex);
+
+    LinearPool pool{};
+    pool.memoryType = this->findMemoryType(typeBits, required, 0);
+    pool.size = size;
+
+    if (pool.memoryType == UINT32_MAX)
+    {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    VkResult result = this->allocateMemory(pool.memoryType, size, &pool.memory, &pool.mapped);
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
+    *pPool = static_cast<uint32_t>(this->linearPools.size());
+    this->linearPools.push_back(pool);
+
+    return VK_SUCCESS;
+}
+
+VkResult Engine::Allocator::allocateLinear(
+    const uint32_t pool,
+    const VkMemoryRequirements& reqs,
+    const bool optimalImage,
+    Allocation* out)
+{
+    std::lock_guard lock(this->mutex);
+    LinearPool& linear = this->linearPools[pool];
+
+    if (!(reqs.memoryTypeBits & (1u << linear.memoryType)))
+    {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    // optimal images can sit next to anything as long as we don't know what the neighbour is
+    const VkDeviceSize alignment = optimalImage ? std::max(reqs.alignment, this->granularity) : reqs.alignment;
+    const VkDeviceSize offset = alignUp(linear.head, alignment);
+
+    if (offset + reqs.size > linear.size)
+    {
+        return VK_ERROR_OUT_OF_POOL_MEMORY;
+    }
+
+    // the next resource must not share a granularity page with this image either
+    linear.head = optimalImage ? alignUp(offset + reqs.size, this->granularity) : offset + reqs.size;
+
+    *out = Allocation{};
+    out->memory = linear.memory;
+    out->offset = offset;
+    out->size = reqs.size;
+    out->mapped = linear.mapped != nullptr ? linear.mapped + offset : nullptr;
+    out->kind = Allocation::LINEAR;
+    out->memoryType = linear.memoryType;
+    out->pool = pool;
+
+    return VK_SUCCESS;
+}
+
+void Engine::Allocator::resetLinear(const uint32_t pool)
+{
+    std::lock_guard lock(this->mutex);
+    this->linearPools[pool].head = 0;
+}
+
+std::vector<Engine::DefragmentationMove> Engine::Allocator::planDefragmentation(const uint32_t maxMoves)
+{
+    std::lock_guard lock(this->mutex);
+    std::vector<DefragmentationMove> moves;
+
+    for (auto& pool : this->pools)
+    {
+        std::vector<uint32_t> order;
+
+        for (uint32_t i = 0; i < pool.blocks.size(); i++)
+        {
+            if (pool.blocks[i] != nullptr && !pool.blocks[i]->draining) order.push_back(i);
+        }
+
+        std::sort(order.begin(), order.end(), [&pool](const uint32_t a, const uint32_t b)
+        {
+            return pool.blocks[a]->used < pool.blocks[b]->used;
+        });
+
+        // empty the emptiest blocks into the fullest ones, a block is only
+        // worth touching if everything in it finds a new home
+        for (uint32_t src = 0; src + 1 < order.size(); src++)
+        {
+            Block* block = pool.blocks[order[src]].get();
+
+            if (block->live.empty() || moves.size() + block->live.size() > maxMoves)
+            {
+                continue;
+            }
+
+            std::vector<DefragmentationMove> blockMoves;
+
+            for (const auto& [offset, live] : block->live)
+            {
+                DefragmentationMove move{};
+                move.src = live;
+
+                for (auto dst = order.size() - 1; dst > src; dst--)
+                {
+                    if (this->allocateFromBlock(pool, order[dst], live.order, &move.dst))
+                    {
+                        break;
+                    }
+                }
+
+                if (move.dst.kind == Allocation::NONE)
+                {
+                    break;
+                }
+
+                move.dst.size = live.size;
+                move.dst.userData = live.userData;
+                pool.blocks[move.dst.block]->live[move.dst.offset] = move.dst;
+
+                blockMoves.push_back(move);
+            }
+
+            if (blockMoves.size() < block->live.size())
+            {
+                for (const auto& move : blockMoves)
+                {
+                    this->freeInBlock(pool, move.dst);
+                }
+
+                continue;
+            }
+
+            // nothing new goes in here, the last free releases it
+            block->draining = true;
+
+            for (const auto& move : blockMoves)
+            {
+                this->requested += move.dst.size;
+                moves.push_back(move);
+            }
+        }
+    }
+
+    return moves;
+}
+
+Engine::AllocatorStats Engine::Allocator::stats()
+{
+    std::lock_guard lock(this->mutex);
+    AllocatorStats stats{};
+
+    for (const auto& pool : this->pools)
+    {
+        for (const auto& block : pool.blocks)
+        {
+            if (block == nullptr)
+            {
+                continue;
+            }
+
+            stats.blockCount++;
+            stats.allocationCount += static_cast<uint32_t>(block->live.size());
+            stats.reserved += block->size;
+            stats.used += block->used;
+
+            for (uint32_t j = static_cast<uint32_t>(block->free.size()); j > 0; j--)
+            {
+                if (!block->free[j - 1].empty())
+                {
+                    stats.largestFree = std::max(stats.largestFree, MIN_ALLOCATION << (j - 1));
+                    break;
+                }
+            }
+        }
+    }
+
+    for (const auto& linear : this->linearPools)
+    {
+        stats.reserved += linear.size;
+        stats.used += linear.head;
+        stats.requested += linear.head;
+        stats.largestFree = std::max(stats.largestFree, linear.size - linear.head);
+    }
+
+    stats.dedicatedCount = this->dedicatedCount;
+    stats.allocationCount += this->dedicatedCount;
+    stats.reserved += this->dedicatedSize;
+    stats.used += this->dedicatedSize;
+    stats.requested += this->requested;
+
+    return stats;
+}
+
+Engine::Allocator::~Allocator()
+{
+    for (auto& pool : this->pools)
+    {
+        for (auto& block : pool.blocks)
+        {
+            if (block != nullptr)
+            {
+                vkFreeMemory(this->vkDev, block->memory, nullptr);
+            }
+        }
+
+        pool.blocks.clear();
+    }
+
+    for (const auto& linear : this->linearPools)
+    {
+        vkFreeMemory(this->vkDev, linear.memory, nullptr);
+    }
+
+    this->linearPools.clear();
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,176 @@
+#pragma once
+#include "engine.h"
+
+#ifdef HAS_VULKAN
+
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
+struct Engine::Allocation
+{
+    enum Kind : uint8_t
+    {
+        NONE,
+        BLOCK,
+        DEDICATED,
+        LINEAR
+    };
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+
+    // persistently mapped for host-visible memory, nullptr otherwise
+    void* mapped = nullptr;
+
+    // handed back in defragmentation moves so the owner can find its resource
+    void* userData = nullptr;
+
+    Kind kind = NONE;
+    uint32_t memoryType = 0;
+    uint32_t pool = 0;
+    uint32_t block = 0;
+    uint32_t order = 0;
+};
+
+struct Engine::AllocatorStats
+{
+    uint32_t blockCount = 0;
+    uint32_t dedicatedCount = 0;
+    uint32_t allocationCount = 0;
+
+    // device memory held by blocks and dedicated allocations
+    VkDeviceSize reserved = 0;
+    // bytes handed out, including buddy rounding
+    VkDeviceSize used = 0;
+    // bytes actually asked for
+    VkDeviceSize requested = 0;
+    VkDeviceSize largestFree = 0;
+
+    [[nodiscard]] double utilisation() const;
+    // share of handed out memory lost to rounding up to a power of two
+    [[nodiscard]] double internalFragmentation() const;
+    // how much of the free space can't be handed out as one allocation
+    [[nodiscard]] double externalFragmentation() const;
+};
+
+// an allocation that planDefragmentation() wants moved: copy src into dst,
+// rebind the resource to dst, and free src once the GPU is done with the copy
+struct Engine::DefragmentationMove
+{
+    Allocation src;
+    Allocation dst;
+};
+
+// Carves big vkAllocateMemory blocks into buddy sub-allocations, one set of
+// blocks per memory type (and per linear/optimal resource, so neighbours never
+// trip over bufferImageGranularity). Big resources get a dedicated allocation.
+class Engine::Allocator
+{
+    struct Block
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        char* mapped = nullptr;
+
+        // free offsets per buddy order, order 0 is MIN_ALLOCATION bytes
+        std::vector<std::set<VkDeviceSize>> free;
+        std::unordered_map<VkDeviceSize, Allocation> live;
+        VkDeviceSize used = 0;
+
+        // being emptied by a defragmentation pass, takes no new allocations
+        bool draining = false;
+    };
+
+    struct Pool
+    {
+        uint32_t memoryType = 0;
+        std::vector<std::unique_ptr<Block>> blocks;
+    };
+
+    struct LinearPool
+    {
+        uint32_t memoryType = 0;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        VkDeviceSize head = 0;
+        char* mapped = nullptr;
+    };
+
+    VkDevice vkDev;
+    VkPhysicalDeviceMemoryProperties memProps{};
+    VkDeviceSize granularity = 1;
+    uint32_t maxAllocations = 0;
+    uint32_t deviceAllocations = 0;
+
+    // two per memory type, see above
+    std::vector<Pool> pools;
+    std::vector<LinearPool> linearPools;
+
+    uint32_t dedicatedCount = 0;
+    VkDeviceSize dedicatedSize = 0;
+    VkDeviceSize requested = 0;
+
+    std::mutex mutex;
+
+    uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const;
+    VkResult allocateMemory(uint32_t memoryType, VkDeviceSize size, VkDeviceMemory* pMemory, char** pMapped);
+
+    VkResult createBlock(Pool& pool, VkDeviceSize minSize, uint32_t* pIndex);
+    bool allocateFromBlock(Pool& pool, uint32_t index, uint32_t order, Allocation* out);
+    void freeInBlock(Pool& pool, const Allocation& allocation);
+
+public:
+    static constexpr VkDeviceSize MIN_ALLOCATION = 256;
+
+    // set before the first allocation, rounded down to a power of two and capped to an eighth of the heap
+    VkDeviceSize blockSize = 64ull * 1024 * 1024;
+
+    Allocator(VkPhysicalDevice physDev, VkDevice dev);
+
+    // picks a type with all of required and, if possible, all of preferred
+    VkResult allocate(
+        const VkMemoryRequirements& reqs,
+        VkMemoryPropertyFlags required,
+        VkMemoryPropertyFlags preferred,
+        bool optimalImage,
+        Allocation* out);
+
+    void free(const Allocation& allocation);
+    void setUserData(Allocation& allocation, void* userData);
+
+    VkResult createBuffer(
+        const VkBufferCreateInfo& createInfo,
+        VkMemoryPropertyFlags required,
+        VkMemoryPropertyFlags preferred,
+        VkBuffer* pBuffer,
+        Allocation* out);
+
+    VkResult createImage(
+        const VkImageCreateInfo& createInfo,
+        VkMemoryPropertyFlags required,
+        VkMemoryPropertyFlags preferred,
+        VkImage* pImage,
+        Allocation* out);
+
+    void destroyBuffer(VkBuffer buffer, const Allocation& allocation);
+    void destroyImage(VkImage image, const Allocation& allocation);
+
+    // bump allocator for resources that all die at once (per-frame data, transient attachments),
+    // freeing single allocations is a no-op, resetLinear() frees all of them
+    VkResult createLinearPool(VkDeviceSize size, uint32_t typeBits, VkMemoryPropertyFlags required, uint32_t* pPool);
+    VkResult allocateLinear(uint32_t pool, const VkMemoryRequirements& reqs, bool optimalImage, Allocation* out);
+    void resetLinear(uint32_t pool);
+
+    // reserves a new home in fuller blocks for up to maxMoves allocations out of the emptiest
+    // ones, once all of those are freed the emptied blocks go back to the driver
+    std::vector<DefragmentationMove> planDefragmentation(uint32_t maxMoves);
+
+    AllocatorStats stats();
+
+    ~Allocator();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "culling.h"
+#include "jobs.h"
+
+#include <algorithm>
+#include <cstring>
+
+// below this many objects it's over before the jobs would have started
+static constexpr size_t MIN_PARALLEL = 16384;
+
+void Engine::CullList::add(const Sphere& sphere, const uint32_t id)
+{
+    this->sphereX.push_back(sphere.center.x);
+    this->sphereY.push_back(sphere.center.y);
+    this->sphereZ.push_back(sphere.center.z);
+    this->radius.push_back(sphere.radius);
+    this->sphereIds.push_back(id);
+}
+
+void Engine::CullList::add(const Aabb& box, const uint32_t id)
+{
+    const Vec3 center = (box.min + box.max) * 0.5f;
+    const Vec3 extent = (box.max - box.min) * 0.5f;
+
+    this->boxX.push_back(center.x);
+    this->boxY.push_back(center.y);
+    this->boxZ.push_back(center.z);
+    this->extentX.push_back(extent.x);
+    this->extentY.push_back(extent.y);
+    this->extentZ.push_back(extent.z);
+    this->boxIds.push_back(id);
+}
+
+void Engine::CullList::clear()
+{
+    this->sphereX.resize(0);
+    this->sphereY.resize(0);
+    this->sphereZ.resize(0);
+    this->radius.resize(0);
+    this->sphereIds.resize(0);
+
+    this->boxX.resize(0);
+    this->boxY.resize(0);
+    this->boxZ.resize(0);
+    this->extentX.resize(0);
+    this->extentY.resize(0);
+    this->extentZ.resize(0);
+    this->boxIds.resize(0);
+}
+
+size_t Engine::CullList::size() const
+{
+    return this->sphereIds.size() + this->boxIds.size();
+}
+
+void Engine::CullList::cullBatch(const Frustum& frustum, const uint32_t batch)
+{
+    const size_t nSpheres = this->sphereIds.size();
+    const size_t sphereBatches = (nSpheres + BATCH_SIZE - 1) / BATCH_SIZE;
+
+    uint8_t visible[BATCH_SIZE];
+    const uint32_t* ids;
+    size_t first;
+    size_t count;
+
+    if (batch < sphereBatches)
+    {
+        first = static_cast<size_t>(batch) * BATCH_SIZE;
+        count = std::min(nSpheres - first, static_cast<size_t>(BATCH_SIZE));
+        ids = this->sphereIds.data() + first;
+
+        cullSpheres(frustum, &this->sphereX[first], &this->sphereY[first], &this->sphereZ[first], &this->radius[first], visible, count);
+    }
+    else
+    {
+        const size_t box = (batch - sphereBatches) * BATCH_SIZE;
+        count = std::min(this->boxIds.size() - box, static_cast<size_t>(BATCH_SIZE));
+        ids = this->boxIds.data() + box;
+        first = nSpheres + box;
+
+        cullBoxes(
+            frustum,
+            &this->boxX[box],
+            &this->boxY[box],
+            &this->boxZ[box],
+            &this->extentX[box],
+            &this->extentY[box],
+            &this->extentZ[box],
+            visible,
+            count);
+    }
+
+    // every id gets written, only the visible ones move the cursor on
+    uint32_t* out = this->found.data() + first;
+    uint32_t nVisible = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        out[nVisible] = ids[i];
+        nVisible += visible[i];
+    }
+
+    this->counts[batch] = nVisible;
+}
+
+size_t Engine::CullList::cull(const Frustum& frustum, std::vector<uint32_t>* visible, JobSystem* jobs)
+{
+    const size_t count = this->size();
+    const auto nBatches = static_cast<uint32_t>(
+        (this->sphereIds.size() + BATCH_SIZE - 1) / BATCH_SIZE + (this->boxIds.size() + BATCH_SIZE - 1) / BATCH_SIZE);
+
+    this->found.resize(count);
+    this->counts.resize(nBatches);
+
+    if (jobs != nullptr && jobs->size() > 1 && count >= MIN_PARALLEL)
+    {
+        // a few jobs per thread so a slow one doesn't hold the rest up
+        const uint32_t perJob = std::max(nBatches / (jobs->size() * 4), 1u);
+
+        jobs->parallelFor(nBatches, perJob, [this, &frustum](const uint32_t begin, const uint32_t end)
+        {
+            for (uint32_t batch = begin; batch < end; batch++)
+            {
+                this->cullBatch(frustum, batch);
+            }
+        });
+    }
+    else
+    {
+        for (uint32_t batch = 0; batch < nBatches; batch++)
+        {
+            this->cullBatch(frustum, batch);
+        }
+    }
+
+    size_t total = 0;
+
+    for (const uint32_t n : this->counts)
+    {
+        total += n;
+    }
+
+    visible->resize(total);
+
+    // the batches' ids stitched back together
+    size_t offset = 0;
+    const size_t sphereBatches = (this->sphereIds.size() + BATCH_SIZE - 1) / BATCH_SIZE;
+
+    for (uint32_t batch = 0; batch < nBatches; batch++)
+    {
+        const size_t first = batch < sphereBatches
+            ? static_cast<size_t>(batch) * BATCH_SIZE
+            : this->sphereIds.size() + (batch - sphereBatches) * BATCH_SIZE;
+
+        if (this->counts[batch] > 0)
+        {
+            memcpy(visible->data() + offset, this->found.data() + first, this->counts[batch] * sizeof(uint32_t));
+        }
+
+        offset += this->counts[batch];
+    }
+
+    return total;
+}
\ No newline at end of file
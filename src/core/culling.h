@@ -0,0 +1,44 @@
+#pragma once
+#include "engine.h"
+
+// Bounding volumes to test against a frustum, each with an id (like an index into a draw list).
+// They're kept as structure of arrays so cull() can hand them straight to cullSpheres() and
+// cullBoxes(), which test 4 or 8 at a time, and it splits them into batches between jobs.
+class Engine::CullList
+{
+    // objects per batch, their flags and ids stay in L1 while it's compacted
+    static constexpr uint32_t BATCH_SIZE = 4096;
+
+    std::vector<float> sphereX;
+    std::vector<float> sphereY;
+    std::vector<float> sphereZ;
+    std::vector<float> radius;
+    std::vector<uint32_t> sphereIds;
+
+    // as centers and half extents
+    std::vector<float> boxX;
+    std::vector<float> boxY;
+    std::vector<float> boxZ;
+    std::vector<float> extentX;
+    std::vector<float> extentY;
+    std::vector<float> extentZ;
+    std::vector<uint32_t> boxIds;
+
+    // every batch compacts its visible ids into its own part of found, at the same offset as its
+    // objects (spheres first, then boxes)
+    std::vector<uint32_t> found;
+    std::vector<uint32_t> counts;
+
+    void cullBatch(const Frustum& frustum, uint32_t batch);
+
+public:
+    void add(const Sphere& sphere, uint32_t id);
+    void add(const Aabb& box, uint32_t id);
+    void clear();
+
+    [[nodiscard]] size_t size() const;
+
+    // replaces visible with the ids of everything at least partly inside, the spheres' in the order
+    // they were added, then the boxes'. Split between jobs if there are any and enough objects.
+    size_t cull(const Frustum& frustum, std::vector<uint32_t>* visible, JobSystem* jobs = nullptr);
+};
\ No newline at end of file
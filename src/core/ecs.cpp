@@ -0,0 +1,539 @@
+#include "ecs.h"
+#include "jobs.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+    struct ComponentInfo
+    {
+        uint32_t size = 0;
+        uint32_t alignment = 0;
+    };
+
+    struct Registry
+    {
+        std::mutex mutex;
+        ComponentInfo components[Engine::MAX_COMPONENTS];
+        uint32_t size = 0;
+    };
+
+    // a function so components can be registered from other static initializers
+    Registry& registry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    // registered types never change, so no lock needed to read one that's in a mask
+    const ComponentInfo& info(const uint32_t type)
+    {
+        return registry().components[type];
+    }
+
+    uint32_t align(const uint32_t value, const uint32_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    Engine::Entity* entities(const Engine::World::Chunk& chunk)
+    {
+        return reinterpret_cast<Engine::Entity*>(chunk.data);
+    }
+}
+
+uint32_t Engine::registerComponent(const uint32_t size, const uint32_t alignment)
+{
+    Registry& registry = ::registry();
+    std::lock_guard lock(registry.mutex);
+
+    if (registry.size == MAX_COMPONENTS)
+    {
+        return MAX_COMPONENTS;
+    }
+
+    registry.components[registry.size] = {size, alignment};
+    return registry.size++;
+}
+
+void Engine::Commands::record(const Kind kind, const Entity entity, const uint32_t nComponents, const uint32_t* types, const void* const* values)
+{
+    size_t size = sizeof(Record);
+
+    for (uint32_t i = 0; i < nComponents; i++)
+    {
+        const uint32_t componentSize = values[i] != nullptr && types[i] < MAX_COMPONENTS ? info(types[i]).size : 0;
+        size += 8 + align(componentSize, 8);
+    }
+
+    std::lock_guard lock(this->mutex);
+
+    const size_t start = this->buffer.size();
+    this->buffer.resize(start + size);
+
+    unsigned char* out = this->buffer.data() + start;
+
+    const Record record = {kind, nComponents, entity};
+    memcpy(out, &record, sizeof(Record));
+    out += sizeof(Record);
+
+    for (uint32_t i = 0; i < nComponents; i++)
+    {
+        const uint32_t componentSize = values[i] != nullptr && types[i] < MAX_COMPONENTS ? info(types[i]).size : 0;
+        const uint32_t header[2] = {types[i], componentSize};
+
+        memcpy(out, header, sizeof(header));
+
+        if (componentSize != 0)
+        {
+            memcpy(out + 8, values[i], componentSize);
+        }
+
+        out += 8 + align(componentSize, 8);
+    }
+
+    this->nRecords++;
+}
+
+void Engine::Commands::destroy(const Entity entity)
+{
+    this->record(DESTROY, entity, 0, nullptr, nullptr);
+}
+
+size_t Engine::Commands::size() const
+{
+    return this->nRecords;
+}
+
+void Engine::Commands::clear()
+{
+    this->buffer.clear();
+    this->nRecords = 0;
+}
+
+Engine::World::~World()
+{
+    for (Archetype* archetype : this->archetypes)
+    {
+        // the ones in blocks go with their block
+        if (archetype->chunkSize != CHUNK_SIZE)
+        {
+            for (const Chunk& chunk : archetype->chunks)
+            {
+                operator delete(chunk.data, std::align_val_t(64));
+            }
+        }
+
+        delete archetype;
+    }
+
+    for (unsigned char* block : this->blocks)
+    {
+        operator delete(block, std::align_val_t(BLOCK_SIZE));
+    }
+}
+
+void Engine::World::parallelFor(JobSystem* jobs, const uint32_t count, const uint32_t batchSize, void (*fn)(const void*, uint32_t, uint32_t), const void* context)
+{
+    jobs->parallelFor(count, batchSize, [fn, context](const uint32_t begin, const uint32_t end) { fn(context, begin, end); });
+}
+
+Engine::World::Archetype* Engine::World::archetype(const uint64_t mask)
+{
+    if (const auto it = this->byMask.find(mask); it != this->byMask.end())
+    {
+        return it->second;
+    }
+
+    auto* archetype = new Archetype();
+    archetype->mask = mask;
+
+    uint32_t entitySize = sizeof(Entity);
+
+    for (uint32_t type = 0; type < MAX_COMPONENTS; type++)
+    {
+        if (mask >> type & 1)
+        {
+            archetype->components.push_back(type);
+            entitySize += info(type).size;
+        }
+    }
+
+    // every array starts on its own cache line, which takes up to 63 bytes each
+    const auto padding = static_cast<uint32_t>(64 * (archetype->components.size() + 1));
+    archetype->capacity = std::max((CHUNK_SIZE - std::min(padding, CHUNK_SIZE)) / entitySize, 1u);
+
+    uint32_t offset = align(archetype->capacity * static_cast<uint32_t>(sizeof(Entity)), 64);
+
+    for (const uint32_t type : archetype->components)
+    {
+        archetype->offsets[type] = offset;
+        offset = align(offset + archetype->capacity * info(type).size, 64);
+    }
+
+    archetype->chunkSize = std::max(offset, CHUNK_SIZE);
+
+    this->archetypes.push_back(archetype);
+    this->byMask[mask] = archetype;
+
+    return archetype;
+}
+
+Engine::World::Archetype* Engine::World::neighbour(Archetype* from, const uint32_t type, const bool add)
+{
+    Archetype** edge = add ? &from->added[type] : &from->removed[type];
+
+    if (*edge == nullptr)
+    {
+        const uint64_t bit = static_cast<uint64_t>(1) << type;
+        *edge = this->archetype(add ? from->mask | bit : from->mask & ~bit);
+    }
+
+    return *edge;
+}
+
+unsigned char* Engine::World::allocateChunk(const uint32_t size)
+{
+    this->nChunks++;
+
+    if (size != CHUNK_SIZE)
+    {
+        return static_cast<unsigned char*>(operator new(size, std::align_val_t(64)));
+    }
+
+    if (!this->freeChunks.empty())
+    {
+        unsigned char* data = this->freeChunks.back();
+        this->freeChunks.pop_back();
+        return data;
+    }
+
+    if (this->blockUsed == BLOCK_SIZE)
+    {
+        // aligned so the huge pages can line up with it
+        this->blocks.push_back(static_cast<unsigned char*>(operator new(BLOCK_SIZE, std::align_val_t(BLOCK_SIZE))));
+        this->blockUsed = 0;
+
+#ifdef MADV_HUGEPAGE
+        madvise(this->blocks.back(), BLOCK_SIZE, MADV_HUGEPAGE);
+#endif
+    }
+
+    unsigned char* data = this->blocks.back() + this->blockUsed;
+    this->blockUsed += CHUNK_SIZE;
+
+    return data;
+}
+
+void Engine::World::releaseChunk(unsigned char* data, const uint32_t size)
+{
+    this->nChunks--;
+
+    if (size == CHUNK_SIZE)
+    {
+        this->freeChunks.push_back(data);
+        return;
+    }
+
+    operator delete(data, std::align_val_t(64));
+}
+
+void Engine::World::insert(Archetype* archetype, const Entity entity, Slot* slot)
+{
+    if (archetype->chunks.empty() || archetype->chunks.back().count == archetype->capacity)
+    {
+        archetype->chunks.push_back({this->allocateChunk(archetype->chunkSize), 0});
+    }
+
+    Chunk& chunk = archetype->chunks.back();
+    entities(chunk)[chunk.count] = entity;
+
+    slot->archetype = archetype;
+    slot->chunk = static_cast<uint32_t>(archetype->chunks.size() - 1);
+    slot->row = chunk.count;
+
+    chunk.count++;
+    archetype->size++;
+}
+
+void Engine::World::erase(const Slot& slot)
+{
+    Archetype* archetype = slot.archetype;
+    Chunk& chunk = archetype->chunks[slot.chunk];
+    Chunk& last = archetype->chunks.back();
+    const uint32_t lastRow = last.count - 1;
+
+    if (&chunk != &last || slot.row != lastRow)
+    {
+        const Entity moved = entities(last)[lastRow];
+        entities(chunk)[slot.row] = moved;
+
+        for (const uint32_t type : archetype->components)
+        {
+            const uint32_t size = info(type).size;
+            const uint32_t offset = archetype->offsets[type];
+
+            memcpy(chunk.data + offset + slot.row * size, last.data + offset + lastRow * size, size);
+        }
+
+        Slot& movedSlot = this->slots[moved.index];
+        movedSlot.chunk = slot.chunk;
+        movedSlot.row = slot.row;
+    }
+
+    last.count--;
+    archetype->size--;
+
+    if (last.count == 0)
+    {
+        this->releaseChunk(last.data, archetype->chunkSize);
+        archetype->chunks.pop_back();
+    }
+}
+
+void Engine::World::move(const Entity entity, Archetype* to)
+{
+    Slot& slot = this->slots[entity.index];
+    const Slot from = slot;
+
+    this->insert(to, entity, &slot);
+
+    const Chunk& source = from.archetype->chunks[from.chunk];
+    const Chunk& target = to->chunks[slot.chunk];
+
+    for (const uint32_t type : to->components)
+    {
+        if (from.archetype->mask >> type & 1)
+        {
+            const uint32_t size = info(type).size;
+
+            memcpy(
+                target.data + to->offsets[type] + slot.row * size,
+                source.data + from.archetype->offsets[type] + from.row * size,
+                size);
+        }
+    }
+
+    this->erase(from);
+}
+
+const Engine::World::Slot* Engine::World::find(const Entity entity) const
+{
+    if (entity.index >= this->slots.size())
+    {
+        return nullptr;
+    }
+
+    const Slot& slot = this->slots[entity.index];
+    return slot.generation == entity.generation && slot.archetype != nullptr ? &slot : nullptr;
+}
+
+Engine::Entity Engine::World::createRaw(const uint32_t* types, const void* const* values, const uint32_t count)
+{
+    if (this->iterating.load(std::memory_order_acquire) != 0)
+    {
+        return {};
+    }
+
+    uint64_t mask = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (types[i] >= MAX_COMPONENTS)
+        {
+            return {};
+        }
+
+        mask |= static_cast<uint64_t>(1) << types[i];
+    }
+
+    uint32_t index;
+
+    if (!this->freeSlots.empty())
+    {
+        index = this->freeSlots.back();
+        this->freeSlots.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(this->slots.size());
+        this->slots.emplace_back();
+    }
+
+    Slot& slot = this->slots[index];
+    const Entity entity = {index, slot.generation};
+
+    Archetype* archetype = this->archetype(mask);
+    this->insert(archetype, entity, &slot);
+
+    const Chunk& chunk = archetype->chunks[slot.chunk];
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint32_t size = info(types[i]).size;
+        memcpy(chunk.data + archetype->offsets[types[i]] + slot.row * size, values[i], size);
+    }
+
+    this->nEntities++;
+    return entity;
+}
+
+bool Engine::World::destroy(const Entity entity)
+{
+    if (this->iterating.load(std::memory_order_acquire) != 0 || this->find(entity) == nullptr)
+    {
+        return false;
+    }
+
+    Slot& slot = this->slots[entity.index];
+    this->erase(slot);
+
+    slot.archetype = nullptr;
+
+    // skipping 0 so no handle ever matches a wrapped around slot by accident
+    slot.generation = slot.generation + 1 == 0 ? 1 : slot.generation + 1;
+
+    this->freeSlots.push_back(entity.index);
+    this->nEntities--;
+
+    return true;
+}
+
+bool Engine::World::alive(const Entity entity) const
+{
+    return this->find(entity) != nullptr;
+}
+
+bool Engine::World::addRaw(const Entity entity, const uint32_t type, const void* value)
+{
+    if (this->iterating.load(std::memory_order_acquire) != 0 || type >= MAX_COMPONENTS || this->find(entity) == nullptr)
+    {
+        return false;
+    }
+
+    const Slot& slot = this->slots[entity.index];
+
+    if (!(slot.archetype->mask >> type & 1))
+    {
+        this->move(entity, this->neighbour(slot.archetype, type, true));
+    }
+
+    const uint32_t size = info(type).size;
+    memcpy(slot.archetype->chunks[slot.chunk].data + slot.archetype->offsets[type] + slot.row * size, value, size);
+
+    return true;
+}
+
+bool Engine::World::removeRaw(const Entity entity, const uint32_t type)
+{
+    if (this->iterating.load(std::memory_order_acquire) != 0 || type >= MAX_COMPONENTS || this->find(entity) == nullptr)
+    {
+        return false;
+    }
+
+    const Slot& slot = this->slots[entity.index];
+
+    if (slot.archetype->mask >> type & 1)
+    {
+        this->move(entity, this->neighbour(slot.archetype, type, false));
+    }
+
+    return true;
+}
+
+void* Engine::World::getRaw(const Entity entity, const uint32_t type) const
+{
+    const Slot* slot = this->find(entity);
+
+    if (slot == nullptr || type >= MAX_COMPONENTS || !(slot->archetype->mask >> type & 1))
+    {
+        return nullptr;
+    }
+
+    const uint32_t size = info(type).size;
+    return slot->archetype->chunks[slot->chunk].data + slot->archetype->offsets[type] + slot->row * size;
+}
+
+bool Engine::World::apply(Commands* commands)
+{
+    if (this->iterating.load(std::memory_order_acquire) != 0)
+    {
+        return false;
+    }
+
+    std::lock_guard lock(commands->mutex);
+
+    const unsigned char* in = commands->buffer.data();
+    const unsigned char* end = in + commands->buffer.size();
+
+    // at most one of each type per record, since each has its own bit
+    uint32_t types[MAX_COMPONENTS];
+    const void* values[MAX_COMPONENTS];
+
+    while (in < end)
+    {
+        Commands::Record record;
+        memcpy(&record, in, sizeof(Commands::Record));
+        in += sizeof(Commands::Record);
+
+        uint32_t count = 0;
+
+        for (uint32_t i = 0; i < record.nComponents; i++)
+        {
+            uint32_t header[2];
+            memcpy(header, in, sizeof(header));
+
+            // later ones of the same type win, like they would have one after the other
+            if (count < MAX_COMPONENTS)
+            {
+                types[count] = header[0];
+                values[count] = in + 8;
+                count++;
+            }
+
+            in += 8 + align(header[1], 8);
+        }
+
+        switch (record.kind)
+        {
+        case Commands::CREATE:
+            this->createRaw(types, values, count);
+            break;
+        case Commands::DESTROY:
+            this->destroy(record.entity);
+            break;
+        case Commands::ADD:
+            this->addRaw(record.entity, types[0], values[0]);
+            break;
+        case Commands::REMOVE:
+            this->removeRaw(record.entity, types[0]);
+            break;
+        }
+    }
+
+    commands->buffer.clear();
+    commands->nRecords = 0;
+
+    return true;
+}
+
+size_t Engine::World::size() const
+{
+    return this->nEntities;
+}
+
+size_t Engine::World::chunkCount() const
+{
+    return this->nChunks;
+}
+
+size_t Engine::World::archetypeCount() const
+{
+    return this->archetypes.size();
+}
\ No newline at end of file
@@ -0,0 +1,403 @@
+#pragma once
+#include "engine.h"
+
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace Engine
+{
+    // bits in an archetype's mask, so at most this many component types per process
+    static constexpr uint32_t MAX_COMPONENTS = 64;
+
+    // what a chunk of entities takes, unless a single one of them doesn't fit
+    static constexpr uint32_t CHUNK_SIZE = 16384;
+
+    // ids are handed out the first time a type gets used and are the same in every world,
+    // MAX_COMPONENTS once they run out (and worlds then refuse that type)
+    uint32_t registerComponent(uint32_t size, uint32_t alignment);
+
+    template<typename T>
+    uint32_t componentType()
+    {
+        // const T in a query is the same component
+        if constexpr (std::is_const_v<T>)
+        {
+            return componentType<std::remove_const_t<T>>();
+        }
+        else
+        {
+            static_assert(
+                std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>,
+                "components get moved between chunks with memcpy, keep them plain data");
+            static_assert(alignof(T) <= 64, "chunk arrays are only aligned to cache lines");
+
+            // empty types are tags, they change the archetype but take no space
+            static const uint32_t id = registerComponent(std::is_empty_v<T> ? 0 : sizeof(T), alignof(T));
+            return id;
+        }
+    }
+}
+
+// an index into the world's slots plus the generation the slot was on when the entity got it,
+// so a handle to a destroyed entity stays dead once the slot is reused
+struct Engine::Entity
+{
+    uint32_t index = 0;
+
+    // 0 is never alive, so Entity{} is a null handle
+    uint32_t generation = 0;
+
+    bool operator==(const Entity& other) const = default;
+    explicit operator bool() const { return this->generation != 0; }
+};
+
+// Structural changes recorded while queries run, from any number of jobs at once, and made by
+// World::apply() afterwards in the order they were recorded.
+class Engine::Commands
+{
+    friend class World;
+
+    enum Kind : uint32_t
+    {
+        CREATE,
+        DESTROY,
+        ADD,
+        REMOVE
+    };
+
+    // followed by nComponents of type, size and that many bytes padded to 8
+    struct Record
+    {
+        Kind kind;
+        uint32_t nComponents;
+        Entity entity;
+    };
+
+    std::mutex mutex;
+    std::vector<unsigned char> buffer;
+    uint32_t nRecords = 0;
+
+    void record(Kind kind, Entity entity, uint32_t nComponents, const uint32_t* types, const void* const* values);
+
+public:
+    // the handle only exists after apply(), record what needs it in a component
+    template<typename... T>
+    void create(const T&... components)
+    {
+        const uint32_t types[] = {componentType<T>()..., 0};
+        const void* values[] = {static_cast<const void*>(&components)..., nullptr};
+        this->record(CREATE, {}, sizeof...(T), types, values);
+    }
+
+    void destroy(Entity entity);
+
+    // overwrites the component if it's already there
+    template<typename T>
+    void add(const Entity entity, const T& component = {})
+    {
+        const uint32_t type = componentType<T>();
+        const void* value = &component;
+        this->record(ADD, entity, 1, &type, &value);
+    }
+
+    template<typename T>
+    void remove(const Entity entity)
+    {
+        const uint32_t type = componentType<T>();
+        const void* value = nullptr;
+        this->record(REMOVE, entity, 1, &type, &value);
+    }
+
+    [[nodiscard]] size_t size() const;
+    void clear();
+};
+
+// Entities and their components, stored by archetype (the set of component types an entity has).
+// Every archetype keeps its entities in chunks of CHUNK_SIZE bytes, each component in its own
+// array there, so a query walks through a few tightly packed arrays per chunk and nothing else.
+// Chunks stay full except for the last one, removing an entity moves the archetype's last one
+// into the hole.
+//
+// Components are plain data, looked up by type. Queries can run from several threads at once,
+// but creating, destroying, adding or removing has to happen outside of them: either before or
+// after, or recorded in Commands and applied once they're done. These refuse (returning false or
+// a null entity) while a query is running.
+class Engine::World
+{
+public:
+    struct Chunk
+    {
+        unsigned char* data = nullptr;
+        uint32_t count = 0;
+    };
+
+private:
+    struct Archetype
+    {
+        uint64_t mask = 0;
+        uint32_t capacity = 0;
+        uint32_t chunkSize = 0;
+        size_t size = 0;
+
+        std::vector<uint32_t> components;
+        std::vector<Chunk> chunks;
+
+        // where each component's array starts in a chunk, the entities are at 0
+        uint32_t offsets[MAX_COMPONENTS]{};
+
+        // archetypes with one component more or less, filled in as they're needed
+        Archetype* added[MAX_COMPONENTS]{};
+        Archetype* removed[MAX_COMPONENTS]{};
+    };
+
+    struct Slot
+    {
+        Archetype* archetype = nullptr;
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+        uint32_t generation = 1;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+
+    std::vector<Archetype*> archetypes;
+    std::unordered_map<uint64_t, Archetype*> byMask;
+
+    // Chunks get carved out of blocks this big, which (with transparent huge pages) saves a
+    // query a TLB miss every few KB. Emptied ones go on the free list for the next archetype.
+    static constexpr size_t BLOCK_SIZE = 2 * 1024 * 1024;
+
+    std::vector<unsigned char*> blocks;
+    size_t blockUsed = BLOCK_SIZE;
+    std::vector<unsigned char*> freeChunks;
+
+    size_t nEntities = 0;
+    size_t nChunks = 0;
+
+    std::atomic<uint32_t> iterating{0};
+
+    Archetype* archetype(uint64_t mask);
+    Archetype* neighbour(Archetype* from, uint32_t type, bool add);
+
+    unsigned char* allocateChunk(uint32_t size);
+    void releaseChunk(unsigned char* data, uint32_t size);
+
+    // a new row at the end of the archetype for entity, its components are left as they were
+    void insert(Archetype* archetype, Entity entity, Slot* slot);
+
+    // fills the row from the archetype's last entity
+    void erase(const Slot& slot);
+
+    // to another archetype, carrying over the components both have
+    void move(Entity entity, Archetype* to);
+
+    [[nodiscard]] const Slot* find(Entity entity) const;
+
+    Entity createRaw(const uint32_t* types, const void* const* values, uint32_t count);
+    bool addRaw(Entity entity, uint32_t type, const void* value);
+    bool removeRaw(Entity entity, uint32_t type);
+    [[nodiscard]] void* getRaw(Entity entity, uint32_t type) const;
+
+    // JobSystem::parallelFor() for the templates here, which only see JobSystem declared
+    static void parallelFor(JobSystem* jobs, uint32_t count, uint32_t batchSize, void (*fn)(const void* context, uint32_t begin, uint32_t end), const void* context);
+
+    template<typename... T>
+    static uint64_t maskOf()
+    {
+        uint64_t mask = 0;
+        bool valid = true;
+
+        const auto include = [&mask, &valid](const uint32_t type)
+        {
+            valid &= type < MAX_COMPONENTS;
+            mask |= static_cast<uint64_t>(1) << (type % MAX_COMPONENTS);
+        };
+
+        (include(componentType<T>()), ..., static_cast<void>(include));
+
+        // a type that couldn't be registered matches nothing
+        return valid ? mask : ~static_cast<uint64_t>(0);
+    }
+
+    template<typename... T, typename F, size_t... I>
+    static void visit(const F& fn, const Chunk& chunk, const uint32_t* offsets, std::index_sequence<I...>)
+    {
+        fn(chunk.count, reinterpret_cast<const Entity*>(chunk.data), reinterpret_cast<T*>(chunk.data + offsets[I])...);
+    }
+
+    // the chunks a query goes over and where its components are in each, in archetype order
+    template<typename... T>
+    void match(std::vector<std::pair<const Chunk*, const uint32_t*>>* chunks, std::vector<uint32_t>* offsets) const
+    {
+        const uint64_t mask = maskOf<T...>();
+        const uint32_t types[] = {componentType<T>()..., 0};
+        constexpr size_t n = sizeof...(T) + 1;
+
+        std::vector<const Archetype*> matching;
+
+        for (const Archetype* archetype : this->archetypes)
+        {
+            if ((archetype->mask & mask) == mask && !archetype->chunks.empty())
+            {
+                matching.push_back(archetype);
+            }
+        }
+
+        offsets->resize(matching.size() * n);
+
+        for (size_t a = 0; a < matching.size(); a++)
+        {
+            uint32_t* archetypeOffsets = offsets->data() + a * n;
+
+            for (size_t i = 0; i < n; i++)
+            {
+                archetypeOffsets[i] = matching[a]->offsets[types[i] % MAX_COMPONENTS];
+            }
+
+            for (const Chunk& chunk : matching[a]->chunks)
+            {
+                chunks->emplace_back(&chunk, archetypeOffsets);
+            }
+        }
+    }
+
+public:
+    World() = default;
+    ~World();
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    template<typename... T>
+    Entity create(const T&... components)
+    {
+        const uint32_t types[] = {componentType<T>()..., 0};
+        const void* values[] = {static_cast<const void*>(&components)..., nullptr};
+        return this->createRaw(types, values, sizeof...(T));
+    }
+
+    bool destroy(Entity entity);
+    [[nodiscard]] bool alive(Entity entity) const;
+
+    // overwrites the component if it's already there
+    template<typename T>
+    bool add(const Entity entity, const T& component = {})
+    {
+        return this->addRaw(entity, componentType<T>(), &component);
+    }
+
+    template<typename T>
+    bool remove(const Entity entity)
+    {
+        return this->removeRaw(entity, componentType<T>());
+    }
+
+    // null if the entity doesn't have one, only good until the next structural change
+    template<typename T>
+    T* get(const Entity entity) const
+    {
+        return static_cast<T*>(this->getRaw(entity, componentType<T>()));
+    }
+
+    template<typename T>
+    [[nodiscard]] bool has(const Entity entity) const
+    {
+        return this->getRaw(entity, componentType<T>()) != nullptr;
+    }
+
+    // makes what was recorded and clears it, false if a query is still running
+    bool apply(Commands* commands);
+
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] size_t chunkCount() const;
+    [[nodiscard]] size_t archetypeCount() const;
+
+    // fn(count, entities, T* arrays...) for every chunk with all of T, the arrays have count
+    // elements and are aligned to a cache line, const T gets const arrays
+    template<typename... T, typename F>
+    void eachChunk(const F& fn)
+    {
+        const uint64_t mask = maskOf<T...>();
+        const uint32_t types[] = {componentType<T>()..., 0};
+
+        this->iterating.fetch_add(1, std::memory_order_acquire);
+
+        for (const Archetype* archetype : this->archetypes)
+        {
+            if ((archetype->mask & mask) != mask)
+            {
+                continue;
+            }
+
+            uint32_t offsets[sizeof...(T) + 1];
+
+            for (size_t i = 0; i <= sizeof...(T); i++)
+            {
+                offsets[i] = archetype->offsets[types[i] % MAX_COMPONENTS];
+            }
+
+            for (const Chunk& chunk : archetype->chunks)
+            {
+                visit<T...>(fn, chunk, offsets, std::index_sequence_for<T...>{});
+            }
+        }
+
+        this->iterating.fetch_sub(1, std::memory_order_release);
+    }
+
+    // fn(entity, T&...) for every entity with all of T
+    template<typename... T, typename F>
+    void each(const F& fn)
+    {
+        this->eachChunk<T...>([&fn](const uint32_t count, const Entity* entities, T*... arrays)
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                fn(entities[i], arrays[i]...);
+            }
+        });
+    }
+
+    // eachChunk() with the chunks split between jobs, fn gets called from several threads at once
+    template<typename... T, typename F>
+    void parallelEachChunk(JobSystem* jobs, const F& fn, const uint32_t chunksPerJob = 4)
+    {
+        this->iterating.fetch_add(1, std::memory_order_acquire);
+
+        std::vector<std::pair<const Chunk*, const uint32_t*>> chunks;
+        std::vector<uint32_t> offsets;
+        this->match<T...>(&chunks, &offsets);
+
+        const auto batch = [&chunks, &fn](const uint32_t begin, const uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                visit<T...>(fn, *chunks[i].first, chunks[i].second, std::index_sequence_for<T...>{});
+            }
+        };
+
+        parallelFor(jobs, static_cast<uint32_t>(chunks.size()), chunksPerJob, [](const void* context, const uint32_t begin, const uint32_t end)
+        {
+            (*static_cast<const decltype(batch)*>(context))(begin, end);
+        }, &batch);
+
+        this->iterating.fetch_sub(1, std::memory_order_release);
+    }
+
+    // each() with the chunks split between jobs
+    template<typename... T, typename F>
+    void parallelEach(JobSystem* jobs, const F& fn, const uint32_t chunksPerJob = 4)
+    {
+        this->parallelEachChunk<T...>(jobs, [&fn](const uint32_t count, const Entity* entities, T*... arrays)
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                fn(entities[i], arrays[i]...);
+            }
+        }, chunksPerJob);
+    }
+};
\ No newline at end of file
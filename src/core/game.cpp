@@ -1,9 +1,16 @@
 #include "game.h"
+#include "scene.h"
 
 Engine::Game::Game(const char* name, const int version[3])
 {
     this->name = name;
     this->version = version;
+    this->scene = new Scene();
+}
+
+Engine::Game::~Game()
+{
+    delete this->scene;
 }
 
 const char* Engine::Game::getName() const
@@ -16,8 +23,15 @@ const int* Engine::Game::getVersion() const
     return this->version;
 }
 
+Engine::Scene* Engine::Game::getScene() const
+{
+    return this->scene;
+}
+
 #ifdef HAS_VULKAN
 
+#include <algorithm>
+
 VkApplicationInfo Engine::Game::getVkInfo() const
 {
     auto info = VkApplicationInfo{};
@@ -38,7 +52,17 @@ VkApplicationInfo Engine::Game::getVkInfo() const
         VERSION[2]
     );
 
+    // 1.2 gets timeline semaphores, 1.3 dynamic rendering, 1.0 loaders don't have vkEnumerateInstanceVersion at all
     info.apiVersion = VK_API_VERSION_1_0;
+
+    const auto enumerateVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
+        vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+
+    if (enumerateVersion != nullptr && enumerateVersion(&info.apiVersion) == VK_SUCCESS)
+    {
+        info.apiVersion = std::min(info.apiVersion, VK_API_VERSION_1_3);
+    }
+
     return info;
 }
 
@@ -6,11 +6,19 @@ class Engine::Game
     const char* name;
     const int* version;
 
+    // the game's transform hierarchy, update() it once a frame before anything reads world matrices
+    Scene* scene;
+
 public:
     Game(const char* name, const int version[3]);
+    ~Game();
+
+    Game(const Game&) = delete;
+    Game& operator=(const Game&) = delete;
 
     [[nodiscard]] const char* getName() const;
     [[nodiscard]] const int* getVersion() const;
+    [[nodiscard]] Scene* getScene() const;
 
 #ifdef HAS_VULKAN
     [[nodiscard]] VkApplicationInfo getVkInfo() const;
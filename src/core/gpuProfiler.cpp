@@ -0,0 +1,302 @@
+#include "gpuProfiler.h"
+
+#if defined(HAS_VULKAN) && defined(ENABLE_PROFILING)
+
+#include <string>
+
+#include "loaders/loaders.h"
+
+// the order vkGetQueryPoolResults writes them in
+static constexpr VkQueryPipelineStatisticFlags STATISTICS =
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+VkResult Engine::GpuProfiler::create(
+    VkPhysicalDevice physDev,
+    VkDevice dev,
+    const uint32_t queueFamily,
+    const uint32_t framesInFlight,
+    const bool statistics)
+{
+    this->vkDev = dev;
+
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(physDev, &props);
+    this->period = props.limits.timestampPeriod;
+
+    uint32_t nQueueFamilies;
+    vkGetPhysicalDeviceQueueFamilyProperties(physDev, &nQueueFamilies, nullptr);
+
+    std::vector<VkQueueFamilyProperties> queueFamilies(nQueueFamilies);
+    vkGetPhysicalDeviceQueueFamilyProperties(physDev, &nQueueFamilies, queueFamilies.data());
+
+    const uint32_t validBits = queueFamilies[queueFamily].timestampValidBits;
+    this->mask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    this->slots.resize(framesInFlight);
+
+    for (auto& slot : this->slots)
+    {
+        // no timestamps on this queue, statistics still work
+        if (validBits > 0)
+        {
+            VkQueryPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            poolInfo.queryCount = MAX_SCOPES * 2;
+
+            VkResult result = vkCreateQueryPool(dev, &poolInfo, nullptr, &slot.timestamps);
+
+            if (result != VK_SUCCESS)
+            {
+                return result;
+            }
+        }
+
+        if (statistics)
+        {
+            VkQueryPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            poolInfo.queryCount = 1;
+            poolInfo.pipelineStatistics = STATISTICS;
+
+            VkResult result = vkCreateQueryPool(dev, &poolInfo, nullptr, &slot.statistics);
+
+            if (result != VK_SUCCESS)
+            {
+                return result;
+            }
+        }
+    }
+
+    return VK_SUCCESS;
+}
+
+void Engine::GpuProfiler::destroy()
+{
+    for (const auto& slot : this->slots)
+    {
+        if (slot.timestamps != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(this->vkDev, slot.timestamps, nullptr);
+        }
+
+        if (slot.statistics != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(this->vkDev, slot.statistics, nullptr);
+        }
+    }
+
+    this->slots.resize(0);
+    this->current = nullptr;
+}
+
+void Engine::GpuProfiler::collect(Slot* slot)
+{
+    slot->pending = false;
+
+    GpuFrameStats stats{};
+    stats.frame = slot->frame;
+
+    if (slot->nQueries > 0)
+    {
+        uint64_t ticks[MAX_SCOPES * 2];
+
+        // no WAIT_BIT, the fence says it's done and if it somehow isn't the frame is just dropped
+        const VkResult result = vkGetQueryPoolResults(
+            this->vkDev,
+            slot->timestamps,
+            0,
+            slot->nQueries,
+            sizeof(ticks),
+            ticks,
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT);
+
+        if (result != VK_SUCCESS)
+        {
+            return;
+        }
+
+        if (this->origin == 0)
+        {
+            this->origin = ticks[0] & this->mask;
+        }
+
+        const auto toMillis = [&](const uint64_t tick)
+        {
+            return static_cast<double>((tick & this->mask) - this->origin) * this->period / 1e6;
+        };
+
+        for (const auto& scope : slot->scopes)
+        {
+            stats.scopes.push_back({scope.name, scope.depth, toMillis(ticks[scope.beginQuery]), toMillis(ticks[scope.endQuery])});
+        }
+    }
+
+    if (slot->hasStatistics)
+    {
+        uint64_t values[6];
+
+        const VkResult result = vkGetQueryPoolResults(
+            this->vkDev,
+            slot->statistics,
+            0,
+            1,
+            sizeof(values),
+            values,
+            sizeof(values),
+            VK_QUERY_RESULT_64_BIT);
+
+        if (result == VK_SUCCESS)
+        {
+            stats.hasStatistics = true;
+            stats.inputVertices = values[0];
+            stats.inputPrimitives = values[1];
+            stats.vertexInvocations = values[2];
+            stats.clippingInvocations = values[3];
+            stats.clippingPrimitives = values[4];
+            stats.fragmentInvocations = values[5];
+        }
+    }
+
+    if (this->history.size() >= MAX_HISTORY)
+    {
+        this->history.erase(this->history.begin());
+    }
+
+    this->history.push_back(std::move(stats));
+}
+
+void Engine::GpuProfiler::beginFrame(VkCommandBuffer cmdBuffer, const uint32_t slot, const uint64_t frame)
+{
+    this->current = &this->slots[slot];
+
+    if (this->current->pending)
+    {
+        this->collect(this->current);
+    }
+
+    if (this->current->timestamps != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(cmdBuffer, this->current->timestamps, 0, MAX_SCOPES * 2);
+    }
+
+    if (this->current->statistics != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(cmdBuffer, this->current->statistics, 0, 1);
+    }
+
+    this->current->scopes.resize(0);
+    this->current->nQueries = 0;
+    this->current->hasStatistics = false;
+    this->current->frame = frame;
+    this->current->pending = true;
+    this->open.resize(0);
+}
+
+void Engine::GpuProfiler::endFrame(VkCommandBuffer cmdBuffer)
+{
+    while (!this->open.empty())
+    {
+        this->end(cmdBuffer);
+    }
+}
+
+void Engine::GpuProfiler::begin(VkCommandBuffer cmdBuffer, const char* name)
+{
+    Slot* slot = this->current;
+
+    // out of queries, the matching end() just pops
+    if (slot->timestamps == VK_NULL_HANDLE || slot->nQueries + 2 > MAX_SCOPES * 2)
+    {
+        this->open.push_back(UINT32_MAX);
+        return;
+    }
+
+    vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot->timestamps, slot->nQueries);
+
+    this->open.push_back(static_cast<uint32_t>(slot->scopes.size()));
+    slot->scopes.push_back({name, static_cast<uint32_t>(this->open.size() - 1), slot->nQueries, slot->nQueries + 1});
+    slot->nQueries += 2;
+}
+
+void Engine::GpuProfiler::end(VkCommandBuffer cmdBuffer)
+{
+    const uint32_t index = this->open.back();
+    this->open.pop_back();
+
+    if (index == UINT32_MAX)
+    {
+        return;
+    }
+
+    Slot* slot = this->current;
+    vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slot->timestamps, slot->scopes[index].endQuery);
+}
+
+void Engine::GpuProfiler::beginStatistics(VkCommandBuffer cmdBuffer)
+{
+    if (this->current->statistics == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    vkCmdBeginQuery(cmdBuffer, this->current->statistics, 0, 0);
+    this->current->hasStatistics = true;
+}
+
+void Engine::GpuProfiler::endStatistics(VkCommandBuffer cmdBuffer)
+{
+    if (!this->current->hasStatistics)
+    {
+        return;
+    }
+
+    vkCmdEndQuery(cmdBuffer, this->current->statistics, 0);
+}
+
+VkQueryPipelineStatisticFlags Engine::GpuProfiler::statistics() const
+{
+    return this->current->statistics != VK_NULL_HANDLE ? STATISTICS : 0;
+}
+
+const Engine::GpuFrameStats* Engine::GpuProfiler::latest() const
+{
+    return this->history.empty() ? nullptr : &this->history.back();
+}
+
+const std::vector<Engine::GpuFrameStats>& Engine::GpuProfiler::frames() const
+{
+    return this->history;
+}
+
+bool Engine::GpuProfiler::exportTrace(const char* filename) const
+{
+    std::string json = "{\"traceEvents\":[\n";
+    bool first = true;
+
+    for (const auto& frame : this->history)
+    {
+        for (const auto& scope : frame.scopes)
+        {
+            if (!first) json += ",\n";
+            first = false;
+
+            // complete events, microseconds
+            json += "{\"name\":\"" + std::string(scope.name) + "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":\"GPU\",";
+            json += "\"ts\":" + std::to_string(scope.begin * 1000.0) + ",\"dur\":" + std::to_string((scope.end - scope.begin) * 1000.0);
+            json += ",\"args\":{\"frame\":" + std::to_string(frame.frame) + "}}";
+        }
+    }
+
+    json += "\n]}\n";
+    return Loaders::writefile(std::vector<char>(json.begin(), json.end()), filename);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+#include "engine.h"
+
+#ifdef HAS_VULKAN
+
+// times are in milliseconds since the profiler was created
+struct Engine::GpuScope
+{
+    const char* name;
+    uint32_t depth;
+    double begin;
+    double end;
+};
+
+struct Engine::GpuFrameStats
+{
+    uint64_t frame = 0;
+    std::vector<GpuScope> scopes;
+
+    // pipeline statistics for the main render pass, if the device has them
+    bool hasStatistics = false;
+    uint64_t inputVertices = 0;
+    uint64_t inputPrimitives = 0;
+    uint64_t vertexInvocations = 0;
+    uint64_t clippingInvocations = 0;
+    uint64_t clippingPrimitives = 0;
+    uint64_t fragmentInvocations = 0;
+};
+
+#ifdef ENABLE_PROFILING
+
+// Timestamp and pipeline statistics queries, with one set of query pools per frame in flight.
+// A slot's results are read when it comes around again, by which point its fence has been
+// waited on, so reading never stalls and the numbers are framesInFlight frames old.
+class Engine::GpuProfiler
+{
+    static constexpr uint32_t MAX_SCOPES = 64;
+    static constexpr size_t MAX_HISTORY = 1000;
+
+    struct PendingScope
+    {
+        const char* name;
+        uint32_t depth;
+        uint32_t beginQuery;
+        uint32_t endQuery;
+    };
+
+    struct Slot
+    {
+        VkQueryPool timestamps = VK_NULL_HANDLE;
+        VkQueryPool statistics = VK_NULL_HANDLE;
+
+        std::vector<PendingScope> scopes;
+        uint32_t nQueries = 0;
+        bool hasStatistics = false;
+
+        uint64_t frame = 0;
+        bool pending = false;
+    };
+
+    VkDevice vkDev = VK_NULL_HANDLE;
+
+    // nanoseconds per tick, and the bits of each timestamp that mean anything
+    double period = 1.0;
+    uint64_t mask = 0;
+    uint64_t origin = 0;
+
+    std::vector<Slot> slots;
+    Slot* current = nullptr;
+    std::vector<uint32_t> open;
+
+    std::vector<GpuFrameStats> history;
+
+    void collect(Slot* slot);
+
+public:
+    // statistics needs the pipelineStatisticsQuery feature enabled
+    VkResult create(
+        VkPhysicalDevice physDev,
+        VkDevice dev,
+        uint32_t queueFamily,
+        uint32_t framesInFlight,
+        bool statistics);
+
+    void destroy();
+
+    // picks up what this slot recorded last time around and resets its queries
+    void beginFrame(VkCommandBuffer cmdBuffer, uint32_t slot, uint64_t frame);
+
+    // closes whatever scopes are still open
+    void endFrame(VkCommandBuffer cmdBuffer);
+
+    // name has to outlive the profiler, string literals are what this is meant for
+    void begin(VkCommandBuffer cmdBuffer, const char* name);
+    void end(VkCommandBuffer cmdBuffer);
+
+    // around a render pass, not inside one
+    void beginStatistics(VkCommandBuffer cmdBuffer);
+    void endStatistics(VkCommandBuffer cmdBuffer);
+
+    // what secondaries executed while the statistics query runs have to inherit
+    [[nodiscard]] VkQueryPipelineStatisticFlags statistics() const;
+
+    [[nodiscard]] const GpuFrameStats* latest() const;
+    [[nodiscard]] const std::vector<GpuFrameStats>& frames() const;
+
+    // chrome://tracing (or Perfetto) JSON of the frames still in the history
+    [[nodiscard]] bool exportTrace(const char* filename) const;
+};
+
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,357 @@
+#include "jobs.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define JOBS_PAUSE() _mm_pause()
+#else
+#define JOBS_PAUSE() std::this_thread::yield()
+#endif
+
+// which worker of which system the current thread is
+static thread_local const Engine::JobSystem* tlsSystem = nullptr;
+static thread_local int32_t tlsIndex = -1;
+
+// Lê et al., "Correct and Efficient Work-Stealing for Weak Memory Models", minus the resizing
+bool Engine::JobSystem::Deque::push(Job* job)
+{
+    const int64_t b = this->bottom.load(std::memory_order_relaxed);
+    const int64_t t = this->top.load(std::memory_order_acquire);
+
+    if (b - t >= CAPACITY)
+    {
+        return false;
+    }
+
+    // release publishes the job's data to whoever pops or steals it
+    this->jobs[b & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+    this->bottom.store(b + 1, std::memory_order_release);
+
+    return true;
+}
+
+Engine::Job* Engine::JobSystem::Deque::pop()
+{
+    const int64_t b = this->bottom.load(std::memory_order_relaxed) - 1;
+    this->bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = this->top.load(std::memory_order_relaxed);
+
+    if (t > b)
+    {
+        this->bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = this->jobs[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+
+    // last one, race the thieves for it
+    if (t == b)
+    {
+        if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            job = nullptr;
+        }
+
+        this->bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    return job;
+}
+
+Engine::Job* Engine::JobSystem::Deque::steal()
+{
+    int64_t t = this->top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = this->bottom.load(std::memory_order_acquire);
+
+    if (t >= b)
+    {
+        return nullptr;
+    }
+
+    Job* job = this->jobs[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+
+    if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        return nullptr;
+    }
+
+    return job;
+}
+
+Engine::JobSystem::JobSystem(uint32_t nThreads)
+{
+    if (nThreads == 0)
+    {
+        nThreads = std::thread::hardware_concurrency();
+    }
+
+    this->nWorkers = nThreads > 0 ? nThreads : 1;
+    this->workers = new Worker[this->nWorkers];
+
+    for (uint32_t i = 0; i < this->nWorkers; i++)
+    {
+        this->workers[i].ring = new Job[CAPACITY];
+    }
+
+    tlsSystem = this;
+    tlsIndex = 0;
+
+    for (uint32_t i = 1; i < this->nWorkers; i++)
+    {
+        this->workers[i].thread = std::thread(&JobSystem::work, this, i);
+    }
+}
+
+Engine::JobSystem::~JobSystem()
+{
+    this->quit.store(true);
+    this->epoch.fetch_add(1);
+    this->epoch.notify_all();
+
+    for (uint32_t i = 1; i < this->nWorkers; i++)
+    {
+        this->workers[i].thread.join();
+    }
+
+    // whatever never ran
+    for (const auto& job : this->injected)
+    {
+        delete job;
+    }
+
+    for (uint32_t i = 0; i < this->nWorkers; i++)
+    {
+        delete[] this->workers[i].ring;
+    }
+
+    delete[] this->workers;
+
+    if (tlsSystem == this)
+    {
+        tlsSystem = nullptr;
+        tlsIndex = -1;
+    }
+}
+
+uint32_t Engine::JobSystem::size() const
+{
+    return this->nWorkers;
+}
+
+int32_t Engine::JobSystem::workerIndex() const
+{
+    return tlsSystem == this ? tlsIndex : -1;
+}
+
+Engine::Job* Engine::JobSystem::allocate(const bool heap)
+{
+    const int32_t index = this->workerIndex();
+
+    if (!heap && index >= 0)
+    {
+        Worker& worker = this->workers[index];
+
+        // normally the very next slot is free, a few long jobs can hold some up
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            Job* job = &worker.ring[worker.next];
+            worker.next = (worker.next + 1) % CAPACITY;
+
+            if (!job->busy.load(std::memory_order_acquire))
+            {
+                job->busy.store(true, std::memory_order_relaxed);
+                job->heap = false;
+
+                return job;
+            }
+        }
+    }
+
+    Job* job = new Job();
+    job->heap = true;
+
+    return job;
+}
+
+void Engine::JobSystem::push(Job* job)
+{
+    const int32_t index = this->workerIndex();
+
+    if (index >= 0)
+    {
+        // full deque, just do it now
+        if (!this->workers[index].deque.push(job))
+        {
+            this->execute(job);
+            return;
+        }
+    } else
+    {
+        std::lock_guard lock(this->injectedMutex);
+        this->injected.push_back(job);
+        this->nInjected.fetch_add(1, std::memory_order_release);
+    }
+
+    this->epoch.fetch_add(1, std::memory_order_seq_cst);
+
+    if (this->sleeping.load(std::memory_order_seq_cst) > 0)
+    {
+        this->epoch.notify_one();
+    }
+}
+
+Engine::Job* Engine::JobSystem::find(const int32_t index)
+{
+    if (index >= 0)
+    {
+        if (Job* job = this->workers[index].deque.pop())
+        {
+            return job;
+        }
+    }
+
+    if (this->nInjected.load(std::memory_order_acquire) > 0)
+    {
+        std::lock_guard lock(this->injectedMutex);
+
+        if (!this->injected.empty())
+        {
+            Job* job = this->injected.back();
+            this->injected.pop_back();
+            this->nInjected.fetch_sub(1, std::memory_order_relaxed);
+
+            return job;
+        }
+    }
+
+    // start from a different victim each time so the thieves don't pile onto one deque
+    static thread_local uint32_t victim = 0;
+
+    for (uint32_t i = 0; i < this->nWorkers; i++)
+    {
+        victim = (victim + 1) % this->nWorkers;
+
+        if (static_cast<int32_t>(victim) == index)
+        {
+            continue;
+        }
+
+        if (Job* job = this->workers[victim].deque.steal())
+        {
+            return job;
+        }
+    }
+
+    return nullptr;
+}
+
+void Engine::JobSystem::execute(Job* job)
+{
+    const auto fn = job->fn;
+    JobCounter* counter = job->counter;
+
+    alignas(16) unsigned char data[sizeof(Job::data)];
+    memcpy(data, job->data, sizeof(data));
+
+    if (job->heap)
+    {
+        delete job;
+    } else
+    {
+        job->busy.store(false, std::memory_order_release);
+    }
+
+    fn(data);
+
+    if (counter != nullptr)
+    {
+        this->finish(counter);
+    }
+}
+
+void Engine::JobSystem::finish(JobCounter* counter)
+{
+    counter->finishing.fetch_add(1, std::memory_order_seq_cst);
+
+    if (counter->value.fetch_sub(1, std::memory_order_seq_cst) == 1)
+    {
+        std::vector<Job*> ready;
+
+        {
+            std::lock_guard lock(counter->mutex);
+            ready.swap(counter->dependents);
+        }
+
+        for (const auto& job : ready)
+        {
+            this->push(job);
+        }
+    }
+
+    // last touch, a waiter may free the counter right after
+    counter->finishing.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void Engine::JobSystem::work(const uint32_t index)
+{
+    tlsSystem = this;
+    tlsIndex = static_cast<int32_t>(index);
+
+    uint32_t idle = 0;
+
+    while (!this->quit.load(std::memory_order_relaxed))
+    {
+        if (Job* job = this->find(static_cast<int32_t>(index)))
+        {
+            this->execute(job);
+            idle = 0;
+
+            continue;
+        }
+
+        // spin a little before going to sleep, jobs tend to come in bursts
+        if (++idle < 64)
+        {
+            JOBS_PAUSE();
+            continue;
+        }
+
+        const uint32_t seen = this->epoch.load(std::memory_order_seq_cst);
+        this->sleeping.fetch_add(1, std::memory_order_seq_cst);
+
+        // a push between the last look and the wait bumps the epoch, so nothing gets missed
+        if (Job* job = this->find(static_cast<int32_t>(index)))
+        {
+            this->sleeping.fetch_sub(1, std::memory_order_seq_cst);
+            this->execute(job);
+            idle = 0;
+
+            continue;
+        }
+
+        if (!this->quit.load(std::memory_order_relaxed))
+        {
+            this->epoch.wait(seen, std::memory_order_seq_cst);
+        }
+
+        this->sleeping.fetch_sub(1, std::memory_order_seq_cst);
+        idle = 0;
+    }
+}
+
+void Engine::JobSystem::wait(JobCounter* counter)
+{
+    const int32_t index = this->workerIndex();
+
+    while (counter->value.load(std::memory_order_seq_cst) != 0 || counter->finishing.load(std::memory_order_seq_cst) != 0)
+    {
+        if (Job* job = this->find(index))
+        {
+            this->execute(job);
+        } else
+        {
+            JOBS_PAUSE();
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+#pragma once
+#include "engine.h"
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+// jobs bump this when they're queued and drop it when they finish, wait() on it or
+// use it as a dependency with runAfter()
+struct Engine::JobCounter
+{
+    std::atomic<uint32_t> value{0};
+
+    // jobs still touching the counter after their decrement, it can't go away before this is zero too
+    std::atomic<uint32_t> finishing{0};
+
+    // jobs waiting for value to hit zero
+    std::mutex mutex;
+    std::vector<Job*> dependents;
+};
+
+struct Engine::Job
+{
+    void (*fn)(const void* data) = nullptr;
+    JobCounter* counter = nullptr;
+
+    // ring slots are reused once the job has been picked up, heap ones are deleted
+    std::atomic<bool> busy{false};
+    bool heap = false;
+
+    alignas(16) unsigned char data[96];
+};
+
+// Work-stealing scheduler. Every worker has a Chase-Lev deque it pushes to and pops from
+// (newest first, so it stays in cache), idle workers steal the oldest jobs from the others.
+// The thread creating it is worker 0, it only runs jobs while inside wait(). Threads that
+// aren't workers can still queue jobs and wait, their jobs go through a shared queue.
+//
+// Jobs are small trivially copyable callables (lambdas capturing pointers and numbers),
+// they're copied out of their slot before running so the slot can be reused straight away.
+class Engine::JobSystem
+{
+    static constexpr int64_t CAPACITY = 4096;
+
+    struct Deque
+    {
+        std::atomic<int64_t> top{0};
+        std::atomic<int64_t> bottom{0};
+        std::atomic<Job*> jobs[CAPACITY];
+
+        bool push(Job* job);
+        Job* pop();
+        Job* steal();
+    };
+
+    struct Worker
+    {
+        std::thread thread;
+        Deque deque;
+
+        // only ever allocated from by the owning thread
+        Job* ring = nullptr;
+        uint32_t next = 0;
+    };
+
+    Worker* workers = nullptr;
+    uint32_t nWorkers = 0;
+
+    std::mutex injectedMutex;
+    std::vector<Job*> injected;
+    std::atomic<uint32_t> nInjected{0};
+
+    // bumped on every push, sleeping workers wait for it to change
+    std::atomic<uint32_t> epoch{0};
+    std::atomic<uint32_t> sleeping{0};
+    std::atomic<bool> quit{false};
+
+    void work(uint32_t index);
+
+    [[nodiscard]] int32_t workerIndex() const;
+    Job* allocate(bool heap);
+    void push(Job* job);
+    Job* find(int32_t index);
+    void execute(Job* job);
+    void finish(JobCounter* counter);
+
+    template<typename F>
+    Job* prepare(const F& fn, JobCounter* counter, const bool heap)
+    {
+        static_assert(sizeof(F) <= sizeof(Job::data), "job captures too much, capture a pointer instead");
+        static_assert(std::is_trivially_copyable_v<F>, "jobs get copied around, capture by value or by pointer");
+
+        Job* job = this->allocate(heap);
+        job->fn = [](const void* data) { (*static_cast<const F*>(data))(); };
+        job->counter = counter;
+        new (job->data) F(fn);
+
+        if (counter != nullptr)
+        {
+            counter->value.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        return job;
+    }
+
+public:
+    // 0 threads uses every core, the calling thread counts as one of them
+    explicit JobSystem(uint32_t nThreads = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    [[nodiscard]] uint32_t size() const;
+
+    template<typename F>
+    void run(const F& fn, JobCounter* counter = nullptr)
+    {
+        this->push(this->prepare(fn, counter, false));
+    }
+
+    // queued once after hits zero, counter covers it from now on (not just once it runs)
+    template<typename F>
+    void runAfter(JobCounter* after, const F& fn, JobCounter* counter = nullptr)
+    {
+        // might sit there for a while, so it doesn't get a ring slot
+        Job* job = this->prepare(fn, counter, true);
+
+        std::unique_lock lock(after->mutex);
+
+        if (after->value.load(std::memory_order_acquire) != 0)
+        {
+            after->dependents.push_back(job);
+            return;
+        }
+
+        lock.unlock();
+        this->push(job);
+    }
+
+    // calls fn(begin, end) over [0, count) in batches of batchSize and waits for all of them
+    template<typename F>
+    void parallelFor(const uint32_t count, const uint32_t batchSize, const F& fn)
+    {
+        JobCounter counter;
+        const F* pFn = &fn;
+
+        for (uint32_t begin = 0; begin < count; begin += batchSize)
+        {
+            const uint32_t end = begin + batchSize < count ? begin + batchSize : count;
+            this->run([pFn, begin, end] { (*pFn)(begin, end); }, &counter);
+        }
+
+        this->wait(&counter);
+    }
+
+    // runs other jobs until counter hits zero
+    void wait(JobCounter* counter);
+};
\ No newline at end of file
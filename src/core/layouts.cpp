@@ -0,0 +1,227 @@
+#include "layouts.h"
+
+#ifdef HAS_VULKAN
+
+#include <algorithm>
+
+#include "loaders/loaders.h"
+
+namespace
+{
+    uint32_t formatSize(const VkFormat format)
+    {
+        switch (format)
+        {
+            case VK_FORMAT_R32_SFLOAT:
+            case VK_FORMAT_R32_SINT:
+            case VK_FORMAT_R32_UINT:
+                return 4;
+            case VK_FORMAT_R32G32_SFLOAT:
+            case VK_FORMAT_R32G32_SINT:
+            case VK_FORMAT_R32G32_UINT:
+                return 8;
+            case VK_FORMAT_R32G32B32_SFLOAT:
+            case VK_FORMAT_R32G32B32_SINT:
+            case VK_FORMAT_R32G32B32_UINT:
+                return 12;
+            case VK_FORMAT_R32G32B32A32_SFLOAT:
+            case VK_FORMAT_R32G32B32A32_SINT:
+            case VK_FORMAT_R32G32B32A32_UINT:
+                return 16;
+            default:
+                return 0;
+        }
+    }
+}
+
+void Engine::LayoutCache::create(VkDevice dev)
+{
+    this->vkDev = dev;
+}
+
+void Engine::LayoutCache::destroy()
+{
+    for (const auto& [key, layout] : this->pipelineLayouts)
+    {
+        vkDestroyPipelineLayout(this->vkDev, layout, nullptr);
+    }
+
+    for (const auto& [key, layout] : this->setLayouts)
+    {
+        vkDestroyDescriptorSetLayout(this->vkDev, layout, nullptr);
+    }
+
+    this->pipelineLayouts.clear();
+    this->setLayouts.clear();
+}
+
+VkResult Engine::LayoutCache::setLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, VkDescriptorSetLayout* pLayout)
+{
+    std::vector<uint64_t> key;
+    key.reserve(bindings.size() * 2);
+
+    for (const auto& binding : bindings)
+    {
+        key.push_back((uint64_t)binding.binding << 32 | binding.descriptorType);
+        key.push_back((uint64_t)binding.descriptorCount << 32 | binding.stageFlags);
+    }
+
+    const auto found = this->setLayouts.find(key);
+
+    if (found != this->setLayouts.end())
+    {
+        *pLayout = found->second;
+        return VK_SUCCESS;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = bindings.size();
+    layoutInfo.pBindings = bindings.data();
+
+    const VkResult result = vkCreateDescriptorSetLayout(this->vkDev, &layoutInfo, nullptr, pLayout);
+
+    if (result == VK_SUCCESS)
+    {
+        this->setLayouts.emplace(std::move(key), *pLayout);
+    }
+
+    return result;
+}
+
+VkResult Engine::LayoutCache::pipelineLayout(
+    const std::vector<const Loaders::ShaderReflection*>& shaders,
+    VkPipelineLayout* pLayout,
+    std::vector<VkDescriptorSetLayout>* pSetLayouts)
+{
+    std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets;
+    VkPushConstantRange pushConstants{};
+
+    for (const auto shader : shaders)
+    {
+        for (const auto& binding : shader->bindings)
+        {
+            if (binding.set >= sets.size())
+            {
+                sets.resize(binding.set + 1);
+            }
+
+            auto& set = sets[binding.set];
+            const auto found = std::find_if(set.begin(), set.end(), [&](const auto& other)
+            {
+                return other.binding == binding.binding;
+            });
+
+            // runtime arrays need descriptor indexing to be any bigger, so they get one
+            const uint32_t count = std::max(binding.count, 1u);
+
+            if (found == set.end())
+            {
+                set.push_back({binding.binding, binding.type, count, static_cast<VkShaderStageFlags>(shader->stage), nullptr});
+                continue;
+            }
+
+            if (found->descriptorType != binding.type)
+            {
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+
+            found->descriptorCount = std::max(found->descriptorCount, count);
+            found->stageFlags |= shader->stage;
+        }
+
+        // one range covering every stage's block, simpler to push to than one per stage
+        const VkPushConstantRange& range = shader->pushConstants;
+
+        if (range.size != 0)
+        {
+            const uint32_t end = std::max(pushConstants.offset + pushConstants.size, range.offset + range.size);
+
+            pushConstants.offset = pushConstants.stageFlags != 0 ? std::min(pushConstants.offset, range.offset) : range.offset;
+            pushConstants.size = end - pushConstants.offset;
+            pushConstants.stageFlags |= range.stageFlags;
+        }
+    }
+
+    std::vector<VkDescriptorSetLayout> setLayouts(sets.size());
+    std::vector<uint64_t> key;
+
+    for (size_t i = 0; i < sets.size(); i++)
+    {
+        // sorted so the same bindings always make the same key
+        std::sort(sets[i].begin(), sets[i].end(), [](const auto& a, const auto& b)
+        {
+            return a.binding < b.binding;
+        });
+
+        const VkResult result = this->setLayout(sets[i], &setLayouts[i]);
+
+        if (result != VK_SUCCESS)
+        {
+            return result;
+        }
+
+        key.push_back((uint64_t)setLayouts[i]);
+    }
+
+    key.push_back((uint64_t)pushConstants.offset << 32 | pushConstants.size);
+    key.push_back(pushConstants.stageFlags);
+
+    if (pSetLayouts != nullptr)
+    {
+        *pSetLayouts = setLayouts;
+    }
+
+    const auto found = this->pipelineLayouts.find(key);
+
+    if (found != this->pipelineLayouts.end())
+    {
+        *pLayout = found->second;
+        return VK_SUCCESS;
+    }
+
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = setLayouts.size();
+    layoutInfo.pSetLayouts = setLayouts.data();
+    layoutInfo.pushConstantRangeCount = pushConstants.size != 0 ? 1 : 0;
+    layoutInfo.pPushConstantRanges = &pushConstants;
+
+    const VkResult result = vkCreatePipelineLayout(this->vkDev, &layoutInfo, nullptr, pLayout);
+
+    if (result == VK_SUCCESS)
+    {
+        this->pipelineLayouts.emplace(std::move(key), *pLayout);
+    }
+
+    return result;
+}
+
+VkResult Engine::LayoutCache::vertexLayout(const Loaders::ShaderReflection& shader, VertexLayout* pLayout)
+{
+    VertexLayout layout;
+    uint32_t offset = 0;
+
+    for (const auto& input : shader.inputs)
+    {
+        const uint32_t size = formatSize(input.format);
+
+        if (size == 0)
+        {
+            return VK_ERROR_FORMAT_NOT_SUPPORTED;
+        }
+
+        layout.attributes.push_back({input.location, 0, input.format, offset});
+        offset += size;
+    }
+
+    if (offset != 0)
+    {
+        layout.bindings.push_back({0, offset, VK_VERTEX_INPUT_RATE_VERTEX});
+    }
+
+    *pLayout = std::move(layout);
+    return VK_SUCCESS;
+}
+
+#endif
\ No newline at end of file
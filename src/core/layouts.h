@@ -0,0 +1,40 @@
+#pragma once
+#include "engine.h"
+
+#ifdef HAS_VULKAN
+
+#include <map>
+
+// Pipeline and descriptor set layouts built from shader reflection instead of by hand. The
+// stages of a pipeline are merged (a binding used by several stages gets all their flags),
+// and identical layouts are created once and shared, so pipelines built from the same
+// shaders end up with the same VkPipelineLayout and stay compatible for binding sets.
+class Engine::LayoutCache
+{
+    VkDevice vkDev = VK_NULL_HANDLE;
+
+    // keyed by the bindings or by the set layouts and push range they're made of
+    std::map<std::vector<uint64_t>, VkDescriptorSetLayout> setLayouts;
+    std::map<std::vector<uint64_t>, VkPipelineLayout> pipelineLayouts;
+
+    VkResult setLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, VkDescriptorSetLayout* pLayout);
+
+public:
+    void create(VkDevice dev);
+    void destroy();
+
+    // one set layout per set up to the highest one used, gaps get empty ones. Fails with
+    // VK_ERROR_INITIALIZATION_FAILED if two stages disagree on what a binding is. Everything
+    // returned is owned by the cache.
+    VkResult pipelineLayout(
+        const std::vector<const Loaders::ShaderReflection*>& shaders,
+        VkPipelineLayout* pLayout,
+        std::vector<VkDescriptorSetLayout>* pSetLayouts = nullptr);
+
+    // all inputs interleaved in one per vertex binding, in location order. Fails with
+    // VK_ERROR_FORMAT_NOT_SUPPORTED for inputs reflection couldn't give a format (anything but
+    // 32 bit floats and ints), those need the layout given by hand
+    static VkResult vertexLayout(const Loaders::ShaderReflection& shader, VertexLayout* pLayout);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,887 @@
+#include "math.h"
+
+#include <algorithm>
+#include <atomic>
+
+// AVX2 kernels are compiled for that target on their own, and only run if the CPU has it
+#if defined(MATH_SSE) && (defined(__GNUC__) || defined(__AVX2__))
+#define MATH_AVX2 1
+
+#if defined(__GNUC__)
+#define MATH_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define MATH_TARGET_AVX2
+#endif
+#endif
+
+namespace
+{
+    using namespace Engine;
+
+    void transformPointsScalar(const Mat4& a, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, const size_t count)
+    {
+        // a copy, the outputs could alias it as far as the compiler knows
+        float m[16];
+
+        for (int i = 0; i < 16; i++)
+        {
+            m[i] = a.m[i];
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const float px = x[i];
+            const float py = y[i];
+            const float pz = z[i];
+
+            outX[i] = m[0] * px + m[4] * py + m[8] * pz + m[12];
+            outY[i] = m[1] * px + m[5] * py + m[9] * pz + m[13];
+            outZ[i] = m[2] * px + m[6] * py + m[10] * pz + m[14];
+        }
+    }
+
+    void multiplyScalar(const float* a, const float* b, float* out)
+    {
+        float result[16];
+
+        for (int column = 0; column < 4; column++)
+        {
+            for (int row = 0; row < 4; row++)
+            {
+                result[column * 4 + row] =
+                    a[row] * b[column * 4] + a[4 + row] * b[column * 4 + 1] +
+                    a[8 + row] * b[column * 4 + 2] + a[12 + row] * b[column * 4 + 3];
+            }
+        }
+
+        for (int i = 0; i < 16; i++)
+        {
+            out[i] = result[i];
+        }
+    }
+
+    void multiplyMatricesScalar(const Mat4* a, const Mat4* b, Mat4* out, const size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            multiplyScalar(a[i].m, b[i].m, out[i].m);
+        }
+    }
+
+    void multiplyMatrixScalar(const Mat4& a, const Mat4* b, Mat4* out, const size_t count)
+    {
+        const Mat4 left = a;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            multiplyScalar(left.m, b[i].m, out[i].m);
+        }
+    }
+
+    size_t cullSpheresScalar(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius, uint8_t* visible, const size_t count)
+    {
+        size_t nVisible = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            bool inside = true;
+
+            for (const Plane& plane : frustum.planes)
+            {
+                inside &= plane.normal.x * x[i] + plane.normal.y * y[i] + plane.normal.z * z[i] + plane.distance >= -radius[i];
+            }
+
+            visible[i] = inside;
+            nVisible += inside;
+        }
+
+        return nVisible;
+    }
+
+    size_t cullBoxesScalar(
+        const Frustum& frustum,
+        const float* centerX,
+        const float* centerY,
+        const float* centerZ,
+        const float* extentX,
+        const float* extentY,
+        const float* extentZ,
+        uint8_t* visible,
+        const size_t count)
+    {
+        size_t nVisible = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            bool inside = true;
+
+            for (const Plane& plane : frustum.planes)
+            {
+                // how far the box reaches towards the plane
+                const float reach = std::fabs(plane.normal.x) * extentX[i] + std::fabs(plane.normal.y) * extentY[i] + std::fabs(plane.normal.z) * extentZ[i];
+                inside &= plane.normal.x * centerX[i] + plane.normal.y * centerY[i] + plane.normal.z * centerZ[i] + plane.distance >= -reach;
+            }
+
+            visible[i] = inside;
+            nVisible += inside;
+        }
+
+        return nVisible;
+    }
+
+#ifdef MATH_SSE
+    void transformPointsSse(const Mat4& a, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, const size_t count)
+    {
+        __m128 m[12];
+
+        for (int column = 0; column < 4; column++)
+        {
+            for (int row = 0; row < 3; row++)
+            {
+                m[column * 3 + row] = _mm_set1_ps(a.m[column * 4 + row]);
+            }
+        }
+
+        size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 px = _mm_loadu_ps(x + i);
+            const __m128 py = _mm_loadu_ps(y + i);
+            const __m128 pz = _mm_loadu_ps(z + i);
+
+            __m128 rows[3];
+
+            for (int row = 0; row < 3; row++)
+            {
+                rows[row] = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(m[row], px), _mm_mul_ps(m[3 + row], py)),
+                    _mm_add_ps(_mm_mul_ps(m[6 + row], pz), m[9 + row]));
+            }
+
+            _mm_storeu_ps(outX + i, rows[0]);
+            _mm_storeu_ps(outY + i, rows[1]);
+            _mm_storeu_ps(outZ + i, rows[2]);
+        }
+
+        transformPointsScalar(a, x + i, y + i, z + i, outX + i, outY + i, outZ + i, count - i);
+    }
+
+    void multiplyMatricesSse(const Mat4* a, const Mat4* b, Mat4* out, const size_t count)
+    {
+        // the inline one already is SSE
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i] = a[i] * b[i];
+        }
+    }
+
+    void multiplyMatrixSse(const Mat4& a, const Mat4* b, Mat4* out, const size_t count)
+    {
+        const Mat4 left = a;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i] = left * b[i];
+        }
+    }
+
+    // one lane per volume, planes broadcast across them
+    struct PlanesSse
+    {
+        __m128 x[6];
+        __m128 y[6];
+        __m128 z[6];
+        __m128 d[6];
+
+        explicit PlanesSse(const Frustum& frustum)
+        {
+            for (int p = 0; p < 6; p++)
+            {
+                this->x[p] = _mm_set1_ps(frustum.planes[p].normal.x);
+                this->y[p] = _mm_set1_ps(frustum.planes[p].normal.y);
+                this->z[p] = _mm_set1_ps(frustum.planes[p].normal.z);
+                this->d[p] = _mm_set1_ps(frustum.planes[p].distance);
+            }
+        }
+    };
+
+    size_t writeMask(const uint32_t mask, const uint32_t lanes, uint8_t* visible)
+    {
+        size_t nVisible = 0;
+
+        for (uint32_t lane = 0; lane < lanes; lane++)
+        {
+            visible[lane] = mask >> lane & 1;
+            nVisible += visible[lane];
+        }
+
+        return nVisible;
+    }
+
+    size_t cullSpheresSse(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius, uint8_t* visible, const size_t count)
+    {
+        const PlanesSse planes(frustum);
+        const __m128 zero = _mm_setzero_ps();
+
+        size_t nVisible = 0;
+        size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 cx = _mm_loadu_ps(x + i);
+            const __m128 cy = _mm_loadu_ps(y + i);
+            const __m128 cz = _mm_loadu_ps(z + i);
+            const __m128 negRadius = _mm_sub_ps(zero, _mm_loadu_ps(radius + i));
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+            for (int p = 0; p < 6; p++)
+            {
+                const __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(planes.x[p], cx), _mm_mul_ps(planes.y[p], cy)),
+                    _mm_add_ps(_mm_mul_ps(planes.z[p], cz), planes.d[p]));
+
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+            }
+
+            nVisible += writeMask(static_cast<uint32_t>(_mm_movemask_ps(inside)), 4, visible + i);
+        }
+
+        return nVisible + cullSpheresScalar(frustum, x + i, y + i, z + i, radius + i, visible + i, count - i);
+    }
+
+    size_t cullBoxesSse(
+        const Frustum& frustum,
+        const float* centerX,
+        const float* centerY,
+        const float* centerZ,
+        const float* extentX,
+        const float* extentY,
+        const float* extentZ,
+        uint8_t* visible,
+        const size_t count)
+    {
+        const PlanesSse planes(frustum);
+
+        // the planes' normals without their signs
+        __m128 absX[6];
+        __m128 absY[6];
+        __m128 absZ[6];
+
+        for (int p = 0; p < 6; p++)
+        {
+            absX[p] = _mm_set1_ps(std::fabs(frustum.planes[p].normal.x));
+            absY[p] = _mm_set1_ps(std::fabs(frustum.planes[p].normal.y));
+            absZ[p] = _mm_set1_ps(std::fabs(frustum.planes[p].normal.z));
+        }
+
+        const __m128 zero = _mm_setzero_ps();
+
+        size_t nVisible = 0;
+        size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 cx = _mm_loadu_ps(centerX + i);
+            const __m128 cy = _mm_loadu_ps(centerY + i);
+            const __m128 cz = _mm_loadu_ps(centerZ + i);
+            const __m128 ex = _mm_loadu_ps(extentX + i);
+            const __m128 ey = _mm_loadu_ps(extentY + i);
+            const __m128 ez = _mm_loadu_ps(extentZ + i);
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+            for (int p = 0; p < 6; p++)
+            {
+                const __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(planes.x[p], cx), _mm_mul_ps(planes.y[p], cy)),
+                    _mm_add_ps(_mm_mul_ps(planes.z[p], cz), planes.d[p]));
+
+                const __m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)), _mm_mul_ps(absZ[p], ez));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_sub_ps(zero, reach)));
+            }
+
+            nVisible += writeMask(static_cast<uint32_t>(_mm_movemask_ps(inside)), 4, visible + i);
+        }
+
+        return nVisible + cullBoxesScalar(frustum, centerX + i, centerY + i, centerZ + i, extentX + i, extentY + i, extentZ + i, visible + i, count - i);
+    }
+#endif
+
+#ifdef MATH_AVX2
+    MATH_TARGET_AVX2 void transformPointsAvx2(const Mat4& a, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, const size_t count)
+    {
+        __m256 m[12];
+
+        for (int column = 0; column < 4; column++)
+        {
+            for (int row = 0; row < 3; row++)
+            {
+                m[column * 3 + row] = _mm256_set1_ps(a.m[column * 4 + row]);
+            }
+        }
+
+        size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256 px = _mm256_loadu_ps(x + i);
+            const __m256 py = _mm256_loadu_ps(y + i);
+            const __m256 pz = _mm256_loadu_ps(z + i);
+
+            __m256 rows[3];
+
+            for (int row = 0; row < 3; row++)
+            {
+                rows[row] = _mm256_fmadd_ps(m[row], px, _mm256_fmadd_ps(m[3 + row], py, _mm256_fmadd_ps(m[6 + row], pz, m[9 + row])));
+            }
+
+            _mm256_storeu_ps(outX + i, rows[0]);
+            _mm256_storeu_ps(outY + i, rows[1]);
+            _mm256_storeu_ps(outZ + i, rows[2]);
+        }
+
+        transformPointsScalar(a, x + i, y + i, z + i, outX + i, outY + i, outZ + i, count - i);
+    }
+
+    // two columns of the result at a time, a's columns are in both halves and each half picks
+    // its own column of b's elements
+    MATH_TARGET_AVX2 void multiplyAvx2(const __m256* left, const float* b, float* out)
+    {
+        const __m256 b01 = _mm256_loadu_ps(b);
+        const __m256 b23 = _mm256_loadu_ps(b + 8);
+
+        __m256 sum01 = _mm256_mul_ps(left[0], _mm256_permute_ps(b01, 0x00));
+        __m256 sum23 = _mm256_mul_ps(left[0], _mm256_permute_ps(b23, 0x00));
+
+        sum01 = _mm256_fmadd_ps(left[1], _mm256_permute_ps(b01, 0x55), sum01);
+        sum23 = _mm256_fmadd_ps(left[1], _mm256_permute_ps(b23, 0x55), sum23);
+        sum01 = _mm256_fmadd_ps(left[2], _mm256_permute_ps(b01, 0xAA), sum01);
+        sum23 = _mm256_fmadd_ps(left[2], _mm256_permute_ps(b23, 0xAA), sum23);
+        sum01 = _mm256_fmadd_ps(left[3], _mm256_permute_ps(b01, 0xFF), sum01);
+        sum23 = _mm256_fmadd_ps(left[3], _mm256_permute_ps(b23, 0xFF), sum23);
+
+        _mm256_storeu_ps(out, sum01);
+        _mm256_storeu_ps(out + 8, sum23);
+    }
+
+    MATH_TARGET_AVX2 void multiplyMatricesAvx2(const Mat4* a, const Mat4* b, Mat4* out, const size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const __m256 left[4] = {
+                _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a[i].m)),
+                _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a[i].m + 4)),
+                _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a[i].m + 8)),
+                _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a[i].m + 12))
+            };
+
+            multiplyAvx2(left, b[i].m, out[i].m);
+        }
+    }
+
+    MATH_TARGET_AVX2 void multiplyMatrixAvx2(const Mat4& a, const Mat4* b, Mat4* out, const size_t count)
+    {
+        const __m256 left[4] = {
+            _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a.m)),
+            _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a.m + 4)),
+            _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a.m + 8)),
+            _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a.m + 12))
+        };
+
+        for (size_t i = 0; i < count; i++)
+        {
+            multiplyAvx2(left, b[i].m, out[i].m);
+        }
+    }
+
+    MATH_TARGET_AVX2 size_t cullSpheresAvx2(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius, uint8_t* visible, const size_t count)
+    {
+        __m256 planes[6][4];
+
+        for (int p = 0; p < 6; p++)
+        {
+            planes[p][0] = _mm256_set1_ps(frustum.planes[p].normal.x);
+            planes[p][1] = _mm256_set1_ps(frustum.planes[p].normal.y);
+            planes[p][2] = _mm256_set1_ps(frustum.planes[p].normal.z);
+            planes[p][3] = _mm256_set1_ps(frustum.planes[p].distance);
+        }
+
+        const __m256 zero = _mm256_setzero_ps();
+
+        size_t nVisible = 0;
+        size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256 cx = _mm256_loadu_ps(x + i);
+            const __m256 cy = _mm256_loadu_ps(y + i);
+            const __m256 cz = _mm256_loadu_ps(z + i);
+            const __m256 negRadius = _mm256_sub_ps(zero, _mm256_loadu_ps(radius + i));
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+            for (const auto& plane : planes)
+            {
+                const __m256 distance = _mm256_fmadd_ps(plane[0], cx, _mm256_fmadd_ps(plane[1], cy, _mm256_fmadd_ps(plane[2], cz, plane[3])));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+            }
+
+            nVisible += writeMask(static_cast<uint32_t>(_mm256_movemask_ps(inside)), 8, visible + i);
+        }
+
+        return nVisible + cullSpheresScalar(frustum, x + i, y + i, z + i, radius + i, visible + i, count - i);
+    }
+
+    MATH_TARGET_AVX2 size_t cullBoxesAvx2(
+        const Frustum& frustum,
+        const float* centerX,
+        const float* centerY,
+        const float* centerZ,
+        const float* extentX,
+        const float* extentY,
+        const float* extentZ,
+        uint8_t* visible,
+        const size_t count)
+    {
+        // normal, distance, then the normal without its signs
+        __m256 planes[6][7];
+
+        for (int p = 0; p < 6; p++)
+        {
+            const Plane& plane = frustum.planes[p];
+
+            planes[p][0] = _mm256_set1_ps(plane.normal.x);
+            planes[p][1] = _mm256_set1_ps(plane.normal.y);
+            planes[p][2] = _mm256_set1_ps(plane.normal.z);
+            planes[p][3] = _mm256_set1_ps(plane.distance);
+            planes[p][4] = _mm256_set1_ps(std::fabs(plane.normal.x));
+            planes[p][5] = _mm256_set1_ps(std::fabs(plane.normal.y));
+            planes[p][6] = _mm256_set1_ps(std::fabs(plane.normal.z));
+        }
+
+        const __m256 zero = _mm256_setzero_ps();
+
+        size_t nVisible = 0;
+        size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256 cx = _mm256_loadu_ps(centerX + i);
+            const __m256 cy = _mm256_loadu_ps(centerY + i);
+            const __m256 cz = _mm256_loadu_ps(centerZ + i);
+            const __m256 ex = _mm256_loadu_ps(extentX + i);
+            const __m256 ey = _mm256_loadu_ps(extentY + i);
+            const __m256 ez = _mm256_loadu_ps(extentZ + i);
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+            for (const auto& plane : planes)
+            {
+                const __m256 distance = _mm256_fmadd_ps(plane[0], cx, _mm256_fmadd_ps(plane[1], cy, _mm256_fmadd_ps(plane[2], cz, plane[3])));
+                const __m256 reach = _mm256_fmadd_ps(plane[4], ex, _mm256_fmadd_ps(plane[5], ey, _mm256_mul_ps(plane[6], ez)));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_sub_ps(zero, reach), _CMP_GE_OQ));
+            }
+
+            nVisible += writeMask(static_cast<uint32_t>(_mm256_movemask_ps(inside)), 8, visible + i);
+        }
+
+        return nVisible + cullBoxesScalar(frustum, centerX + i, centerY + i, centerZ + i, extentX + i, extentY + i, extentZ + i, visible + i, count - i);
+    }
+#endif
+
+    struct Kernels
+    {
+        SimdLevel level;
+        void (*transformPoints)(const Mat4&, const float*, const float*, const float*, float*, float*, float*, size_t);
+        void (*multiplyMatrices)(const Mat4*, const Mat4*, Mat4*, size_t);
+        void (*multiplyMatrix)(const Mat4&, const Mat4*, Mat4*, size_t);
+        size_t (*cullSpheres)(const Frustum&, const float*, const float*, const float*, const float*, uint8_t*, size_t);
+        size_t (*cullBoxes)(const Frustum&, const float*, const float*, const float*, const float*, const float*, const float*, uint8_t*, size_t);
+    };
+
+    constexpr Kernels SCALAR_KERNELS = {
+        SimdLevel::SCALAR, transformPointsScalar, multiplyMatricesScalar, multiplyMatrixScalar, cullSpheresScalar, cullBoxesScalar
+    };
+
+#ifdef MATH_SSE
+    constexpr Kernels SSE_KERNELS = {
+        SimdLevel::SSE, transformPointsSse, multiplyMatricesSse, multiplyMatrixSse, cullSpheresSse, cullBoxesSse
+    };
+#endif
+
+#ifdef MATH_AVX2
+    constexpr Kernels AVX2_KERNELS = {
+        SimdLevel::AVX2, transformPointsAvx2, multiplyMatricesAvx2, multiplyMatrixAvx2, cullSpheresAvx2, cullBoxesAvx2
+    };
+#endif
+
+    SimdLevel detect()
+    {
+#if defined(MATH_AVX2) && defined(__GNUC__)
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        {
+            return SimdLevel::AVX2;
+        }
+#elif defined(MATH_AVX2)
+        return SimdLevel::AVX2;
+#endif
+
+#ifdef MATH_SSE
+        return SimdLevel::SSE;
+#else
+        return SimdLevel::SCALAR;
+#endif
+    }
+
+    const Kernels* kernelsFor(const SimdLevel level)
+    {
+        switch (level)
+        {
+#ifdef MATH_AVX2
+        case SimdLevel::AVX2:
+            return &AVX2_KERNELS;
+#endif
+#ifdef MATH_SSE
+        case SimdLevel::SSE:
+            return &SSE_KERNELS;
+#endif
+        default:
+            return &SCALAR_KERNELS;
+        }
+    }
+
+    const SimdLevel SUPPORTED = detect();
+    std::atomic<const Kernels*> active{kernelsFor(SUPPORTED)};
+}
+
+Engine::Vec4 Engine::Mat4::column(const int i) const
+{
+    return {this->m[i * 4], this->m[i * 4 + 1], this->m[i * 4 + 2], this->m[i * 4 + 3]};
+}
+
+Engine::Quat Engine::Quat::axisAngle(const Vec3 axis, const float radians)
+{
+    const Vec3 unit = normalize(axis);
+    const float s = std::sin(radians * 0.5f);
+
+    return {unit.x * s, unit.y * s, unit.z * s, std::cos(radians * 0.5f)};
+}
+
+Engine::Mat4 Engine::Mat4::translation(const Vec3 t)
+{
+    Mat4 result;
+    result.m[12] = t.x;
+    result.m[13] = t.y;
+    result.m[14] = t.z;
+    return result;
+}
+
+Engine::Mat4 Engine::Mat4::scaling(const Vec3 s)
+{
+    Mat4 result;
+    result.m[0] = s.x;
+    result.m[5] = s.y;
+    result.m[10] = s.z;
+    return result;
+}
+
+Engine::Mat4 Engine::Mat4::rotation(const Quat q)
+{
+    return trs({}, q, {1.0f, 1.0f, 1.0f});
+}
+
+Engine::Mat4 Engine::Mat4::trs(const Vec3 t, const Quat r, const Vec3 s)
+{
+    const float x = r.x;
+    const float y = r.y;
+    const float z = r.z;
+    const float w = r.w;
+
+    Mat4 result;
+
+    result.m[0] = (1 - 2 * (y * y + z * z)) * s.x;
+    result.m[1] = 2 * (x * y + z * w) * s.x;
+    result.m[2] = 2 * (x * z - y * w) * s.x;
+    result.m[3] = 0.0f;
+
+    result.m[4] = 2 * (x * y - z * w) * s.y;
+    result.m[5] = (1 - 2 * (x * x + z * z)) * s.y;
+    result.m[6] = 2 * (y * z + x * w) * s.y;
+    result.m[7] = 0.0f;
+
+    result.m[8] = 2 * (x * z + y * w) * s.z;
+    result.m[9] = 2 * (y * z - x * w) * s.z;
+    result.m[10] = (1 - 2 * (x * x + y * y)) * s.z;
+    result.m[11] = 0.0f;
+
+    result.m[12] = t.x;
+    result.m[13] = t.y;
+    result.m[14] = t.z;
+    result.m[15] = 1.0f;
+
+    return result;
+}
+
+Engine::Mat4 Engine::Mat4::perspective(const float fovY, const float aspect, const float near, const float far)
+{
+    const float f = 1.0f / std::tan(fovY * 0.5f);
+
+    Mat4 result;
+    result.m[0] = f / aspect;
+    result.m[5] = -f;
+    result.m[10] = far / (near - far);
+    result.m[11] = -1.0f;
+    result.m[14] = near * far / (near - far);
+    result.m[15] = 0.0f;
+    return result;
+}
+
+Engine::Mat4 Engine::Mat4::orthographic(const float left, const float right, const float bottom, const float top, const float near, const float far)
+{
+    Mat4 result;
+    result.m[0] = 2.0f / (right - left);
+    result.m[5] = -2.0f / (top - bottom);
+    result.m[10] = 1.0f / (near - far);
+    result.m[12] = -(right + left) / (right - left);
+    result.m[13] = (top + bottom) / (top - bottom);
+    result.m[14] = near / (near - far);
+    return result;
+}
+
+Engine::Mat4 Engine::Mat4::lookAt(const Vec3 eye, const Vec3 target, const Vec3 up)
+{
+    const Vec3 f = normalize(target - eye);
+    const Vec3 s = normalize(cross(f, up));
+    const Vec3 u = cross(s, f);
+
+    Mat4 result;
+    result.m[0] = s.x;
+    result.m[1] = u.x;
+    result.m[2] = -f.x;
+    result.m[4] = s.y;
+    result.m[5] = u.y;
+    result.m[6] = -f.y;
+    result.m[8] = s.z;
+    result.m[9] = u.z;
+    result.m[10] = -f.z;
+    result.m[12] = -dot(s, eye);
+    result.m[13] = -dot(u, eye);
+    result.m[14] = dot(f, eye);
+    return result;
+}
+
+Engine::Frustum Engine::Frustum::fromMatrix(const Mat4& viewProjection)
+{
+    const float* m = viewProjection.m;
+
+    // rows of the matrix, clip space is -w <= x, y <= w and 0 <= z <= w
+    const auto row = [m](const int i) { return Vec4{m[i], m[4 + i], m[8 + i], m[12 + i]}; };
+
+    const Vec4 r0 = row(0);
+    const Vec4 r1 = row(1);
+    const Vec4 r2 = row(2);
+    const Vec4 r3 = row(3);
+
+    const Vec4 planes[6] = {r3 + r0, r3 - r0, r3 + r1, r3 - r1, r2, r3 - r2};
+
+    Frustum frustum;
+
+    for (int i = 0; i < 6; i++)
+    {
+        const Vec3 normal = {planes[i].x, planes[i].y, planes[i].z};
+        const float l = length(normal);
+        const float scale = l > 0.0f ? 1.0f / l : 0.0f;
+
+        frustum.planes[i] = {normal * scale, planes[i].w * scale};
+    }
+
+    return frustum;
+}
+
+Engine::Quat Engine::slerp(const Quat& a, const Quat& b, const float t)
+{
+    float cosine = dot(a, b);
+    Quat to = b;
+
+    if (cosine < 0.0f)
+    {
+        cosine = -cosine;
+        to = {-b.x, -b.y, -b.z, -b.w};
+    }
+
+    // close enough that sin() loses it, a lerp is as good there
+    float wa = 1.0f - t;
+    float wb = t;
+
+    if (cosine < 0.9995f)
+    {
+        const float angle = std::acos(cosine);
+        const float s = std::sin(angle);
+
+        wa = std::sin((1.0f - t) * angle) / s;
+        wb = std::sin(t * angle) / s;
+    }
+
+    return normalize(Quat{a.x * wa + to.x * wb, a.y * wa + to.y * wb, a.z * wa + to.z * wb, a.w * wa + to.w * wb});
+}
+
+Engine::Mat4 Engine::inverse(const Mat4& a)
+{
+    const float* m = a.m;
+    float inv[16];
+
+    inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+    inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+    inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+    inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+    inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+    inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+    inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+    inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+    inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+    inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+    inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+    inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+    inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+    inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+    inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+    inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+    const float determinant = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+    const float scale = determinant != 0.0f ? 1.0f / determinant : 0.0f;
+
+    Mat4 result;
+
+    for (int i = 0; i < 16; i++)
+    {
+        result.m[i] = inv[i] * scale;
+    }
+
+    return result;
+}
+
+Engine::Mat4 Engine::affineInverse(const Mat4& a)
+{
+    const Vec3 c0 = {a.m[0], a.m[1], a.m[2]};
+    const Vec3 c1 = {a.m[4], a.m[5], a.m[6]};
+    const Vec3 c2 = {a.m[8], a.m[9], a.m[10]};
+
+    // the inverse's rows are the cross products of the other two columns over the determinant
+    const Vec3 r0 = cross(c1, c2);
+    const Vec3 r1 = cross(c2, c0);
+    const Vec3 r2 = cross(c0, c1);
+
+    const float determinant = dot(c0, r0);
+    const float scale = determinant != 0.0f ? 1.0f / determinant : 0.0f;
+
+    const Vec3 rows[3] = {r0 * scale, r1 * scale, r2 * scale};
+    const Vec3 t = {a.m[12], a.m[13], a.m[14]};
+
+    Mat4 result;
+
+    for (int row = 0; row < 3; row++)
+    {
+        result.m[row] = rows[row].x;
+        result.m[4 + row] = rows[row].y;
+        result.m[8 + row] = rows[row].z;
+        result.m[12 + row] = -dot(rows[row], t);
+    }
+
+    return result;
+}
+
+Engine::Aabb Engine::transform(const Aabb& box, const Mat4& a)
+{
+    const Vec3 center = transformPoint(a, (box.min + box.max) * 0.5f);
+    const Vec3 extent = (box.max - box.min) * 0.5f;
+
+    const Vec3 reach = {
+        std::fabs(a.m[0]) * extent.x + std::fabs(a.m[4]) * extent.y + std::fabs(a.m[8]) * extent.z,
+        std::fabs(a.m[1]) * extent.x + std::fabs(a.m[5]) * extent.y + std::fabs(a.m[9]) * extent.z,
+        std::fabs(a.m[2]) * extent.x + std::fabs(a.m[6]) * extent.y + std::fabs(a.m[10]) * extent.z
+    };
+
+    return {center - reach, center + reach};
+}
+
+bool Engine::intersects(const Frustum& frustum, const Sphere& sphere)
+{
+    for (const Plane& plane : frustum.planes)
+    {
+        if (distance(plane, sphere.center) < -sphere.radius)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Engine::intersects(const Frustum& frustum, const Aabb& box)
+{
+    const Vec3 center = (box.min + box.max) * 0.5f;
+    const Vec3 extent = (box.max - box.min) * 0.5f;
+
+    for (const Plane& plane : frustum.planes)
+    {
+        const float reach = std::fabs(plane.normal.x) * extent.x + std::fabs(plane.normal.y) * extent.y + std::fabs(plane.normal.z) * extent.z;
+
+        if (distance(plane, center) < -reach)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Engine::transformPoints(const Mat4& a, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, const size_t count)
+{
+    active.load(std::memory_order_relaxed)->transformPoints(a, x, y, z, outX, outY, outZ, count);
+}
+
+void Engine::multiplyMatrices(const Mat4* a, const Mat4* b, Mat4* out, const size_t count)
+{
+    active.load(std::memory_order_relaxed)->multiplyMatrices(a, b, out, count);
+}
+
+void Engine::multiplyMatrices(const Mat4& a, const Mat4* b, Mat4* out, const size_t count)
+{
+    active.load(std::memory_order_relaxed)->multiplyMatrix(a, b, out, count);
+}
+
+size_t Engine::cullSpheres(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius, uint8_t* visible, const size_t count)
+{
+    return active.load(std::memory_order_relaxed)->cullSpheres(frustum, x, y, z, radius, visible, count);
+}
+
+size_t Engine::cullBoxes(
+    const Frustum& frustum,
+    const float* centerX,
+    const float* centerY,
+    const float* centerZ,
+    const float* extentX,
+    const float* extentY,
+    const float* extentZ,
+    uint8_t* visible,
+    const size_t count)
+{
+    return active.load(std::memory_order_relaxed)->cullBoxes(frustum, centerX, centerY, centerZ, extentX, extentY, extentZ, visible, count);
+}
+
+Engine::SimdLevel Engine::simdLevel()
+{
+    return active.load(std::memory_order_relaxed)->level;
+}
+
+void Engine::setSimdLevel(const SimdLevel level)
+{
+    active.store(kernelsFor(std::min(level, SUPPORTED)), std::memory_order_relaxed);
+}
+
+Engine::SimdLevel Engine::supportedSimdLevel()
+{
+    return SUPPORTED;
+}
\ No newline at end of file
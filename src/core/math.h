@@ -0,0 +1,338 @@
+#pragma once
+#include "engine.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// SSE2 is always there on x86-64, MATH_SCALAR (ENGINE_SCALAR_MATH in CMake) turns it off
+#if !defined(MATH_SCALAR) && (defined(__x86_64__) || defined(_M_X64))
+#include <immintrin.h>
+#define MATH_SSE 1
+#endif
+
+struct Engine::Vec3
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+};
+
+struct alignas(16) Engine::Vec4
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+    float w = 0.0f;
+};
+
+// unit length for rotations, x y z is the axis times sin(angle / 2)
+struct alignas(16) Engine::Quat
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+    float w = 1.0f;
+
+    static Quat axisAngle(Vec3 axis, float radians);
+};
+
+// Column major like GLSL and glTF, so m[column * 4 + row], and it's uploaded as it is. Vectors are
+// columns on the right (projection * view * model * point). The projections are made for Vulkan:
+// right handed view space looking down -z, depth from 0 to 1 and y pointing down in clip space.
+struct alignas(16) Engine::Mat4
+{
+    float m[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+    [[nodiscard]] Vec4 column(int i) const;
+
+    static Mat4 translation(Vec3 t);
+    static Mat4 scaling(Vec3 s);
+    static Mat4 rotation(Quat q);
+
+    // translation * rotation * scale, what a node's transform usually is
+    static Mat4 trs(Vec3 t, Quat r, Vec3 s);
+
+    static Mat4 perspective(float fovY, float aspect, float near, float far);
+    static Mat4 orthographic(float left, float right, float bottom, float top, float near, float far);
+    static Mat4 lookAt(Vec3 eye, Vec3 target, Vec3 up);
+};
+
+// points with dot(normal, p) + distance >= 0 are in front
+struct Engine::Plane
+{
+    Vec3 normal;
+    float distance = 0.0f;
+};
+
+struct Engine::Aabb
+{
+    Vec3 min;
+    Vec3 max;
+};
+
+struct Engine::Sphere
+{
+    Vec3 center;
+    float radius = 0.0f;
+};
+
+// left, right, bottom, top, near and far, facing inwards with unit normals
+struct Engine::Frustum
+{
+    Plane planes[6];
+
+    // out of a projection (* view) matrix, in the space that matrix takes points from
+    static Frustum fromMatrix(const Mat4& viewProjection);
+};
+
+// which kernels the batched functions run, the best one the CPU has unless told otherwise
+enum class Engine::SimdLevel : uint8_t
+{
+    SCALAR,
+    SSE,
+    AVX2
+};
+
+namespace Engine
+{
+    inline Vec3 operator+(const Vec3 a, const Vec3 b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+    inline Vec3 operator-(const Vec3 a, const Vec3 b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+    inline Vec3 operator*(const Vec3 a, const Vec3 b) { return {a.x * b.x, a.y * b.y, a.z * b.z}; }
+    inline Vec3 operator*(const Vec3 a, const float s) { return {a.x * s, a.y * s, a.z * s}; }
+    inline Vec3 operator*(const float s, const Vec3 a) { return {a.x * s, a.y * s, a.z * s}; }
+    inline Vec3 operator/(const Vec3 a, const float s) { return {a.x / s, a.y / s, a.z / s}; }
+    inline Vec3 operator-(const Vec3 a) { return {-a.x, -a.y, -a.z}; }
+
+    inline Vec3& operator+=(Vec3& a, const Vec3 b) { return a = a + b; }
+    inline Vec3& operator-=(Vec3& a, const Vec3 b) { return a = a - b; }
+    inline Vec3& operator*=(Vec3& a, const float s) { return a = a * s; }
+
+    inline float dot(const Vec3 a, const Vec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    inline Vec3 cross(const Vec3 a, const Vec3 b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+    inline float length(const Vec3 a) { return std::sqrt(dot(a, a)); }
+
+    inline Vec3 min(const Vec3 a, const Vec3 b) { return {std::fmin(a.x, b.x), std::fmin(a.y, b.y), std::fmin(a.z, b.z)}; }
+    inline Vec3 max(const Vec3 a, const Vec3 b) { return {std::fmax(a.x, b.x), std::fmax(a.y, b.y), std::fmax(a.z, b.z)}; }
+    inline Vec3 lerp(const Vec3 a, const Vec3 b, const float t) { return a + (b - a) * t; }
+
+    // zero stays zero
+    inline Vec3 normalize(const Vec3 a)
+    {
+        const float l = length(a);
+        return l > 0.0f ? a / l : a;
+    }
+
+#ifdef MATH_SSE
+    inline __m128 toSimd(const Vec4& v) { return _mm_load_ps(&v.x); }
+
+    inline Vec4 fromSimd(const __m128 v)
+    {
+        Vec4 result;
+        _mm_store_ps(&result.x, v);
+        return result;
+    }
+
+    inline Vec4 operator+(const Vec4& a, const Vec4& b) { return fromSimd(_mm_add_ps(toSimd(a), toSimd(b))); }
+    inline Vec4 operator-(const Vec4& a, const Vec4& b) { return fromSimd(_mm_sub_ps(toSimd(a), toSimd(b))); }
+    inline Vec4 operator*(const Vec4& a, const Vec4& b) { return fromSimd(_mm_mul_ps(toSimd(a), toSimd(b))); }
+    inline Vec4 operator*(const Vec4& a, const float s) { return fromSimd(_mm_mul_ps(toSimd(a), _mm_set1_ps(s))); }
+#else
+    inline Vec4 operator+(const Vec4& a, const Vec4& b) { return {a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w}; }
+    inline Vec4 operator-(const Vec4& a, const Vec4& b) { return {a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w}; }
+    inline Vec4 operator*(const Vec4& a, const Vec4& b) { return {a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w}; }
+    inline Vec4 operator*(const Vec4& a, const float s) { return {a.x * s, a.y * s, a.z * s, a.w * s}; }
+#endif
+
+    inline float dot(const Vec4& a, const Vec4& b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+
+    inline Quat operator*(const Quat& a, const Quat& b)
+    {
+        return {
+            a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+            a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+            a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+            a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+        };
+    }
+
+    inline float dot(const Quat& a, const Quat& b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+    inline Quat conjugate(const Quat& q) { return {-q.x, -q.y, -q.z, q.w}; }
+
+    inline Quat normalize(const Quat& q)
+    {
+        const float l = std::sqrt(dot(q, q));
+        return l > 0.0f ? Quat{q.x / l, q.y / l, q.z / l, q.w / l} : Quat{};
+    }
+
+    inline Vec3 rotate(const Quat& q, const Vec3 v)
+    {
+        const Vec3 axis = {q.x, q.y, q.z};
+        const Vec3 t = cross(axis, v) * 2.0f;
+        return v + t * q.w + cross(axis, t);
+    }
+
+    // the shorter way round, normalized
+    Quat slerp(const Quat& a, const Quat& b, float t);
+
+#ifdef MATH_SSE
+    inline Mat4 operator*(const Mat4& a, const Mat4& b)
+    {
+        const __m128 c0 = _mm_load_ps(a.m);
+        const __m128 c1 = _mm_load_ps(a.m + 4);
+        const __m128 c2 = _mm_load_ps(a.m + 8);
+        const __m128 c3 = _mm_load_ps(a.m + 12);
+
+        Mat4 result;
+
+        for (int i = 0; i < 4; i++)
+        {
+            const __m128 column = _mm_load_ps(b.m + i * 4);
+
+            __m128 sum = _mm_mul_ps(c0, _mm_shuffle_ps(column, column, _MM_SHUFFLE(0, 0, 0, 0)));
+            sum = _mm_add_ps(sum, _mm_mul_ps(c1, _mm_shuffle_ps(column, column, _MM_SHUFFLE(1, 1, 1, 1))));
+            sum = _mm_add_ps(sum, _mm_mul_ps(c2, _mm_shuffle_ps(column, column, _MM_SHUFFLE(2, 2, 2, 2))));
+            sum = _mm_add_ps(sum, _mm_mul_ps(c3, _mm_shuffle_ps(column, column, _MM_SHUFFLE(3, 3, 3, 3))));
+
+            _mm_store_ps(result.m + i * 4, sum);
+        }
+
+        return result;
+    }
+
+    inline Vec4 operator*(const Mat4& a, const Vec4& v)
+    {
+        __m128 sum = _mm_mul_ps(_mm_load_ps(a.m), _mm_set1_ps(v.x));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(a.m + 4), _mm_set1_ps(v.y)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(a.m + 8), _mm_set1_ps(v.z)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(a.m + 12), _mm_set1_ps(v.w)));
+        return fromSimd(sum);
+    }
+
+    inline Mat4 transpose(const Mat4& a)
+    {
+        __m128 c0 = _mm_load_ps(a.m);
+        __m128 c1 = _mm_load_ps(a.m + 4);
+        __m128 c2 = _mm_load_ps(a.m + 8);
+        __m128 c3 = _mm_load_ps(a.m + 12);
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+        Mat4 result;
+        _mm_store_ps(result.m, c0);
+        _mm_store_ps(result.m + 4, c1);
+        _mm_store_ps(result.m + 8, c2);
+        _mm_store_ps(result.m + 12, c3);
+        return result;
+    }
+#else
+    inline Mat4 operator*(const Mat4& a, const Mat4& b)
+    {
+        Mat4 result;
+
+        for (int column = 0; column < 4; column++)
+        {
+            for (int row = 0; row < 4; row++)
+            {
+                result.m[column * 4 + row] =
+                    a.m[row] * b.m[column * 4] + a.m[4 + row] * b.m[column * 4 + 1] +
+                    a.m[8 + row] * b.m[column * 4 + 2] + a.m[12 + row] * b.m[column * 4 + 3];
+            }
+        }
+
+        return result;
+    }
+
+    inline Vec4 operator*(const Mat4& a, const Vec4& v)
+    {
+        return {
+            a.m[0] * v.x + a.m[4] * v.y + a.m[8] * v.z + a.m[12] * v.w,
+            a.m[1] * v.x + a.m[5] * v.y + a.m[9] * v.z + a.m[13] * v.w,
+            a.m[2] * v.x + a.m[6] * v.y + a.m[10] * v.z + a.m[14] * v.w,
+            a.m[3] * v.x + a.m[7] * v.y + a.m[11] * v.z + a.m[15] * v.w
+        };
+    }
+
+    inline Mat4 transpose(const Mat4& a)
+    {
+        Mat4 result;
+
+        for (int column = 0; column < 4; column++)
+        {
+            for (int row = 0; row < 4; row++)
+            {
+                result.m[column * 4 + row] = a.m[row * 4 + column];
+            }
+        }
+
+        return result;
+    }
+#endif
+
+    inline Vec3 transformPoint(const Mat4& a, const Vec3 p)
+    {
+        return {
+            a.m[0] * p.x + a.m[4] * p.y + a.m[8] * p.z + a.m[12],
+            a.m[1] * p.x + a.m[5] * p.y + a.m[9] * p.z + a.m[13],
+            a.m[2] * p.x + a.m[6] * p.y + a.m[10] * p.z + a.m[14]
+        };
+    }
+
+    // without the translation
+    inline Vec3 transformVector(const Mat4& a, const Vec3 v)
+    {
+        return {
+            a.m[0] * v.x + a.m[4] * v.y + a.m[8] * v.z,
+            a.m[1] * v.x + a.m[5] * v.y + a.m[9] * v.z,
+            a.m[2] * v.x + a.m[6] * v.y + a.m[10] * v.z
+        };
+    }
+
+    // all zeros for singular matrices
+    Mat4 inverse(const Mat4& a);
+
+    // for matrices without projection (bottom row 0 0 0 1), a lot cheaper than inverse()
+    Mat4 affineInverse(const Mat4& a);
+
+    inline float distance(const Plane& plane, const Vec3 p) { return dot(plane.normal, p) + plane.distance; }
+
+    // the box around the transformed box, not a tight fit for rotations
+    Aabb transform(const Aabb& box, const Mat4& a);
+
+    // conservative, boxes and spheres just outside a corner count as visible
+    bool intersects(const Frustum& frustum, const Sphere& sphere);
+    bool intersects(const Frustum& frustum, const Aabb& box);
+
+    // The batched versions work on structure of arrays, so every lane of a SIMD register gets a
+    // different point, matrix or bounding volume and nothing needs shuffling. Arrays don't have to
+    // be aligned, outputs may be the same arrays as the inputs.
+
+    // affine only, w is taken to be 1 and the bottom row is ignored
+    void transformPoints(const Mat4& a, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, size_t count);
+
+    // out[i] = a[i] * b[i]
+    void multiplyMatrices(const Mat4* a, const Mat4* b, Mat4* out, size_t count);
+
+    // out[i] = a * b[i], like moving a batch of model matrices into view space
+    void multiplyMatrices(const Mat4& a, const Mat4* b, Mat4* out, size_t count);
+
+    // visible[i] is 1 where the bounding volume is at least partly inside, returns how many are
+    size_t cullSpheres(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius, uint8_t* visible, size_t count);
+
+    // boxes as centers and half extents
+    size_t cullBoxes(
+        const Frustum& frustum,
+        const float* centerX,
+        const float* centerY,
+        const float* centerZ,
+        const float* extentX,
+        const float* extentY,
+        const float* extentZ,
+        uint8_t* visible,
+        size_t count);
+
+    [[nodiscard]] SimdLevel simdLevel();
+
+    // what the CPU supports at most, set before anything else runs batched math
+    void setSimdLevel(SimdLevel level);
+    [[nodiscard]] SimdLevel supportedSimdLevel();
+}
\ No newline at end of file
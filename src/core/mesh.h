@@ -0,0 +1,34 @@
+#pragma once
+#include "engine.h"
+
+#ifdef HAS_VULKAN
+
+struct Engine::VertexLayout
+{
+    std::vector<VkVertexInputBindingDescription> bindings;
+    std::vector<VkVertexInputAttributeDescription> attributes;
+};
+
+// a mesh without a vertex buffer just draws vertexCount vertices, for
+// shaders that make up their own geometry (like the test triangle)
+struct Engine::Mesh
+{
+    VkBuffer vertexBuffer = VK_NULL_HANDLE;
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+
+    Allocation vertexAllocation;
+    Allocation indexAllocation;
+
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+
+    // object space bounding box, and what the positions of a cooked mesh are quantized over
+    float boundsMin[3]{};
+    float boundsMax[3]{};
+
+    // timeline value of the transfer queue upload, the mesh isn't drawn before it completes
+    uint64_t uploadValue = 0;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,438 @@
+#include "pipelines.h"
+
+#ifdef HAS_VULKAN
+
+#include <chrono>
+
+#include "jobs.h"
+#include "profiler.h"
+#include "renderGraph.h"
+
+namespace
+{
+    // FNV-1a, fields are fed one at a time so struct padding never gets in
+    struct Hasher
+    {
+        uint64_t value = 14695981039346656037ull;
+
+        void add(const void* data, const size_t size)
+        {
+            const auto bytes = static_cast<const unsigned char*>(data);
+
+            for (size_t i = 0; i < size; i++)
+            {
+                this->value = (this->value ^ bytes[i]) * 1099511628211ull;
+            }
+        }
+
+        // whole fields at a time, every lookup hashes the description so this has to be quick
+        void add(const uint64_t value)
+        {
+            this->value = (this->value ^ value) * 1099511628211ull;
+        }
+    };
+
+    bool hasStencil(const VkFormat format)
+    {
+        return format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+    }
+}
+
+uint64_t Engine::PipelineDesc::hash() const
+{
+    Hasher hasher;
+
+    for (const auto& shader : this->shaders)
+    {
+        // handles are pointers or plain integers depending on the platform
+        hasher.add(shader.stage);
+        hasher.add(shader.codeHash != 0 ? shader.codeHash : (uint64_t)shader.module);
+        hasher.add(shader.entry.data(), shader.entry.size());
+    }
+
+    for (const auto& binding : this->vertexLayout.bindings)
+    {
+        hasher.add(binding.binding);
+        hasher.add(binding.stride);
+        hasher.add(binding.inputRate);
+    }
+
+    for (const auto& attribute : this->vertexLayout.attributes)
+    {
+        hasher.add(attribute.location);
+        hasher.add(attribute.binding);
+        hasher.add(attribute.format);
+        hasher.add(attribute.offset);
+    }
+
+    hasher.add(this->topology);
+    hasher.add(this->polygonMode);
+    hasher.add(this->cullMode);
+    hasher.add(this->frontFace);
+    hasher.add(this->blend);
+    hasher.add(this->depthTest);
+    hasher.add(this->depthWrite);
+    hasher.add(this->depthCompare);
+    hasher.add(this->colorFormat);
+    hasher.add(this->depthFormat);
+    hasher.add((uint64_t)this->layout);
+
+    return hasher.value;
+}
+
+bool Engine::PipelineDesc::operator==(const PipelineDesc& other) const
+{
+    if (this->shaders.size() != other.shaders.size() ||
+        this->vertexLayout.bindings.size() != other.vertexLayout.bindings.size() ||
+        this->vertexLayout.attributes.size() != other.vertexLayout.attributes.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < this->shaders.size(); i++)
+    {
+        const Shader& a = this->shaders[i];
+        const Shader& b = other.shaders[i];
+
+        // the same code in another module builds the same pipeline
+        const bool sameCode = a.codeHash != 0 || b.codeHash != 0 ? a.codeHash == b.codeHash : a.module == b.module;
+
+        if (a.stage != b.stage || !sameCode || a.entry != b.entry)
+        {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < this->vertexLayout.bindings.size(); i++)
+    {
+        const VkVertexInputBindingDescription& a = this->vertexLayout.bindings[i];
+        const VkVertexInputBindingDescription& b = other.vertexLayout.bindings[i];
+
+        if (a.binding != b.binding || a.stride != b.stride || a.inputRate != b.inputRate)
+        {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < this->vertexLayout.attributes.size(); i++)
+    {
+        const VkVertexInputAttributeDescription& a = this->vertexLayout.attributes[i];
+        const VkVertexInputAttributeDescription& b = other.vertexLayout.attributes[i];
+
+        if (a.location != b.location || a.binding != b.binding || a.format != b.format || a.offset != b.offset)
+        {
+            return false;
+        }
+    }
+
+    return this->topology == other.topology &&
+        this->polygonMode == other.polygonMode &&
+        this->cullMode == other.cullMode &&
+        this->frontFace == other.frontFace &&
+        this->blend == other.blend &&
+        this->depthTest == other.depthTest &&
+        this->depthWrite == other.depthWrite &&
+        this->depthCompare == other.depthCompare &&
+        this->colorFormat == other.colorFormat &&
+        this->depthFormat == other.depthFormat &&
+        this->layout == other.layout;
+}
+
+VkResult Engine::PipelineCache::create(VkDevice dev, VkPipelineCache vkCache, JobSystem* jobs, RenderGraph* graph)
+{
+    this->vkDev = dev;
+    this->vkCache = vkCache;
+    this->jobs = jobs;
+    this->graph = graph;
+    this->compiling = new JobCounter();
+
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+
+    return vkCreatePipelineLayout(this->vkDev, &layoutInfo, nullptr, &this->emptyLayout);
+}
+
+void Engine::PipelineCache::destroy()
+{
+    this->wait();
+
+    for (const auto& [hash, bucket] : this->entries)
+    {
+        for (const auto& entry : bucket)
+        {
+            if (entry->pipeline != VK_NULL_HANDLE)
+            {
+                vkDestroyPipeline(this->vkDev, entry->pipeline, nullptr);
+            }
+        }
+    }
+
+    this->entries.clear();
+
+    if (this->emptyLayout != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineLayout(this->vkDev, this->emptyLayout, nullptr);
+        this->emptyLayout = VK_NULL_HANDLE;
+    }
+
+    delete this->compiling;
+    this->compiling = nullptr;
+}
+
+Engine::PipelineCache::Entry* Engine::PipelineCache::find(const PipelineDesc& desc, const uint64_t hash)
+{
+    const auto found = this->entries.find(hash);
+
+    if (found == this->entries.end())
+    {
+        return nullptr;
+    }
+
+    for (const auto& entry : found->second)
+    {
+        if (entry->desc == desc)
+        {
+            return entry.get();
+        }
+    }
+
+    return nullptr;
+}
+
+Engine::PipelineCache::Entry* Engine::PipelineCache::add(const PipelineDesc& desc, const uint64_t hash)
+{
+    auto entry = std::make_unique<Entry>();
+    entry->desc = desc;
+    entry->dynamicRendering = this->graph->dynamicRendering();
+
+    if (!entry->dynamicRendering)
+    {
+        entry->renderPass = this->graph->compatibleRenderPass(desc.colorFormat, desc.depthFormat);
+
+        if (entry->renderPass == VK_NULL_HANDLE)
+        {
+            entry->state.store(FAILED, std::memory_order_relaxed);
+        }
+    }
+
+    Entry* added = entry.get();
+    this->entries[hash].push_back(std::move(entry));
+
+    return added;
+}
+
+void Engine::PipelineCache::compile(Entry* entry) const
+{
+    PROFILE_ZONE("pipeline compile");
+
+    const auto start = std::chrono::steady_clock::now();
+    const PipelineDesc& desc = entry->desc;
+
+    std::vector<VkPipelineShaderStageCreateInfo> stages;
+
+    for (const auto& shader : desc.shaders)
+    {
+        VkPipelineShaderStageCreateInfo stageInfo{};
+        stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stageInfo.stage = shader.stage;
+        stageInfo.module = shader.module;
+        stageInfo.pName = shader.entry.c_str();
+
+        stages.push_back(stageInfo);
+    }
+
+    VkPipelineVertexInputStateCreateInfo vertexInfo{};
+    vertexInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(desc.vertexLayout.bindings.size());
+    vertexInfo.pVertexBindingDescriptions = desc.vertexLayout.bindings.data();
+    vertexInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(desc.vertexLayout.attributes.size());
+    vertexInfo.pVertexAttributeDescriptions = desc.vertexLayout.attributes.data();
+
+    VkPipelineInputAssemblyStateCreateInfo assembly{};
+    assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    assembly.topology = desc.topology;
+    assembly.primitiveRestartEnable = VK_FALSE;
+
+    constexpr VkDynamicState dynStates[] = {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR
+    };
+
+    VkPipelineDynamicStateCreateInfo dynState{};
+    dynState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynState.dynamicStateCount = 2;
+    dynState.pDynamicStates = dynStates;
+
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = desc.polygonMode;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = desc.cullMode;
+    rasterizer.frontFace = desc.frontFace;
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.depthBiasEnable = VK_FALSE;
+
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = desc.depthTest ? VK_TRUE : VK_FALSE;
+    depthStencil.depthWriteEnable = desc.depthWrite ? VK_TRUE : VK_FALSE;
+    depthStencil.depthCompareOp = desc.depthCompare;
+
+    VkPipelineColorBlendAttachmentState blendAttachment{};
+    blendAttachment.colorWriteMask =
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    blendAttachment.blendEnable = desc.blend != PipelineDesc::BLEND_NONE ? VK_TRUE : VK_FALSE;
+    blendAttachment.srcColorBlendFactor = desc.blend == PipelineDesc::BLEND_ALPHA ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+    blendAttachment.dstColorBlendFactor = desc.blend == PipelineDesc::BLEND_ALPHA ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+    blendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+    blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    blendAttachment.dstAlphaBlendFactor = desc.blend == PipelineDesc::BLEND_ADDITIVE ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ZERO;
+    blendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable = VK_FALSE;
+    colorBlending.attachmentCount = desc.colorFormat != VK_FORMAT_UNDEFINED ? 1 : 0;
+    colorBlending.pAttachments = &blendAttachment;
+
+    VkPipelineRenderingCreateInfo renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+    renderingInfo.colorAttachmentCount = colorBlending.attachmentCount;
+    renderingInfo.pColorAttachmentFormats = &desc.colorFormat;
+    renderingInfo.depthAttachmentFormat = desc.depthFormat;
+    renderingInfo.stencilAttachmentFormat = hasStencil(desc.depthFormat) ? desc.depthFormat : VK_FORMAT_UNDEFINED;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext = entry->dynamicRendering ? &renderingInfo : nullptr;
+
+    pipelineInfo.stageCount = static_cast<uint32_t>(stages.size());
+    pipelineInfo.pStages = stages.data();
+
+    pipelineInfo.pVertexInputState = &vertexInfo;
+    pipelineInfo.pInputAssemblyState = &assembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pDepthStencilState = desc.depthFormat != VK_FORMAT_UNDEFINED ? &depthStencil : nullptr;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynState;
+
+    pipelineInfo.layout = desc.layout != VK_NULL_HANDLE ? desc.layout : this->emptyLayout;
+    pipelineInfo.renderPass = entry->renderPass;
+    pipelineInfo.subpass = 0;
+
+    // VkPipelineCache is synchronised internally, so workers can share it
+    const VkResult result = vkCreateGraphicsPipelines(this->vkDev, this->vkCache, 1, &pipelineInfo, nullptr, &entry->pipeline);
+
+    entry->compileMillis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    entry->state.store(result == VK_SUCCESS ? READY : FAILED, std::memory_order_release);
+}
+
+VkResult Engine::PipelineCache::get(const PipelineDesc& desc, VkPipeline* pPipeline)
+{
+    const uint64_t hash = desc.hash();
+    Entry* entry = this->find(desc, hash);
+
+    if (entry == nullptr)
+    {
+        entry = this->add(desc, hash);
+
+        if (entry->state.load(std::memory_order_relaxed) == PENDING)
+        {
+            this->compile(entry);
+        }
+    } else if (entry->state.load(std::memory_order_acquire) == PENDING)
+    {
+        this->wait();
+    }
+
+    if (entry->state.load(std::memory_order_acquire) != READY)
+    {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    *pPipeline = entry->pipeline;
+    return VK_SUCCESS;
+}
+
+VkPipeline Engine::PipelineCache::request(const PipelineDesc& desc, const VkPipeline fallback)
+{
+    const uint64_t hash = desc.hash();
+    Entry* entry = this->find(desc, hash);
+
+    if (entry == nullptr)
+    {
+        entry = this->add(desc, hash);
+
+        if (entry->state.load(std::memory_order_relaxed) == PENDING)
+        {
+            if (this->jobs != nullptr)
+            {
+                this->jobs->run([this, entry] { this->compile(entry); }, this->compiling);
+            } else
+            {
+                this->compile(entry);
+            }
+        }
+    }
+
+    if (entry->state.load(std::memory_order_acquire) == READY)
+    {
+        this->hits++;
+        return entry->pipeline;
+    }
+
+    this->misses++;
+    return fallback;
+}
+
+void Engine::PipelineCache::wait()
+{
+    if (this->jobs != nullptr && this->compiling != nullptr)
+    {
+        this->jobs->wait(this->compiling);
+    }
+}
+
+Engine::PipelineCache::Stats Engine::PipelineCache::stats() const
+{
+    Stats stats{};
+    stats.hits = this->hits;
+    stats.misses = this->misses;
+
+    for (const auto& [hash, bucket] : this->entries)
+    {
+        for (const auto& entry : bucket)
+        {
+            switch (entry->state.load(std::memory_order_acquire))
+            {
+                case READY:
+                    stats.pipelines++;
+                    stats.compileMillis += entry->compileMillis;
+                    break;
+                case FAILED:
+                    stats.failed++;
+                    break;
+                default:
+                    stats.pending++;
+                    break;
+            }
+        }
+    }
+
+    return stats;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,140 @@
+#pragma once
+#include "engine.h"
+
+#ifdef HAS_VULKAN
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Everything a graphics pipeline is built from. Viewport and scissor are always dynamic,
+// so the same pipeline works at any target size.
+struct Engine::PipelineDesc
+{
+    enum Blend : uint8_t
+    {
+        BLEND_NONE,
+        BLEND_ALPHA,
+        BLEND_ADDITIVE
+    };
+
+    struct Shader
+    {
+        VkShaderStageFlagBits stage;
+        VkShaderModule module;
+        std::string entry = "main";
+
+        // hash of the module's SPIR-V, pipelines are matched on it instead of the module when
+        // it's set. Without it a module destroyed and made again with other code can get the
+        // same handle, and with it the pipeline built from the old code.
+        uint64_t codeHash = 0;
+    };
+
+    // modules have to stay alive until the pipeline is ready, compiles run after request() returns
+    std::vector<Shader> shaders;
+    VertexLayout vertexLayout;
+
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+    VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+    Blend blend = BLEND_ALPHA;
+
+    bool depthTest = false;
+    bool depthWrite = false;
+    VkCompareOp depthCompare = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+    // the attachments it renders to, VK_FORMAT_UNDEFINED for none
+    VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+
+    // VK_NULL_HANDLE for an empty one (no descriptors or push constants)
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+
+    [[nodiscard]] uint64_t hash() const;
+    bool operator==(const PipelineDesc& other) const;
+};
+
+// Pipelines by description, identical descriptions share one VkPipeline. A description that
+// hasn't been seen yet is compiled on the job system while request() hands out a fallback,
+// so new permutations never stall the render thread. Everything but the compiles themselves
+// happens on the render thread.
+class Engine::PipelineCache
+{
+public:
+    struct Stats
+    {
+        uint32_t pipelines = 0;
+        uint32_t pending = 0;
+        uint32_t failed = 0;
+
+        // request() calls that got the pipeline, and ones that got the fallback
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+
+        // time spent compiling the ready ones, across all threads
+        double compileMillis = 0.0;
+    };
+
+private:
+    enum State : uint8_t
+    {
+        PENDING,
+        READY,
+        FAILED
+    };
+
+    struct Entry
+    {
+        PipelineDesc desc;
+
+        // looked up when it's added, compiles can't touch the graph's cache
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        bool dynamicRendering = false;
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        double compileMillis = 0.0;
+
+        // set last by the compiling thread, everything above is visible once it's READY
+        std::atomic<State> state{PENDING};
+    };
+
+    VkDevice vkDev = VK_NULL_HANDLE;
+    VkPipelineCache vkCache = VK_NULL_HANDLE;
+    JobSystem* jobs = nullptr;
+    RenderGraph* graph = nullptr;
+
+    VkPipelineLayout emptyLayout = VK_NULL_HANDLE;
+
+    // by hash, the vector only grows past one on a collision
+    std::unordered_map<uint64_t, std::vector<std::unique_ptr<Entry>>> entries;
+    JobCounter* compiling = nullptr;
+
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    Entry* find(const PipelineDesc& desc, uint64_t hash);
+    Entry* add(const PipelineDesc& desc, uint64_t hash);
+    void compile(Entry* entry) const;
+
+public:
+    // vkCache can be VK_NULL_HANDLE, without jobs everything compiles on the calling thread
+    VkResult create(VkDevice dev, VkPipelineCache vkCache, JobSystem* jobs, RenderGraph* graph);
+
+    // waits for compiles still running
+    void destroy();
+
+    // compiles on the calling thread if it isn't there yet, or waits if it's already compiling
+    VkResult get(const PipelineDesc& desc, VkPipeline* pPipeline);
+
+    // the pipeline if it's ready, fallback while it compiles (or if it failed to)
+    VkPipeline request(const PipelineDesc& desc, VkPipeline fallback);
+
+    // until every queued compile is done
+    void wait();
+
+    [[nodiscard]] Stats stats() const;
+};
+
+#endif
\ No newline at end of file
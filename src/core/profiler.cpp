@@ -0,0 +1,251 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "loaders/loaders.h"
+
+thread_local Engine::Profiler::ThreadBuffer* Engine::Profiler::tlsBuffer = nullptr;
+std::atomic<uint32_t> Engine::Profiler::currentFrame{0};
+
+// buffers outlive their threads, so zones from finished jobs still show up
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<Engine::Profiler::ThreadBuffer>> registry;
+
+static std::atomic<uint64_t> frameStart{0};
+
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        uint64_t start;
+        uint64_t end;
+        uint32_t frame;
+        uint32_t thread;
+    };
+}
+
+// copies out everything still in the rings, skipping slots that were overwritten while reading
+static std::vector<Event> snapshot()
+{
+    std::vector<Event> events;
+    std::lock_guard lock(registryMutex);
+
+    for (const auto& buffer : registry)
+    {
+        constexpr uint64_t capacity = Engine::Profiler::CAPACITY;
+
+        const uint64_t head = buffer->head.load(std::memory_order_acquire);
+        const uint64_t first = head > capacity ? head - capacity : 0;
+        const size_t offset = events.size();
+
+        for (uint64_t i = first; i < head; i++)
+        {
+            const auto& event = buffer->events[i & (capacity - 1)];
+
+            events.push_back({
+                event.name.load(std::memory_order_relaxed),
+                event.start.load(std::memory_order_relaxed),
+                event.end.load(std::memory_order_relaxed),
+                event.frame.load(std::memory_order_relaxed),
+                buffer->index});
+        }
+
+        // the writer may have lapped us, anything below its new tail is garbage
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t newHead = buffer->head.load(std::memory_order_relaxed);
+        const uint64_t valid = newHead > capacity ? newHead - capacity : 0;
+
+        if (valid > first)
+        {
+            const auto torn = static_cast<size_t>(std::min(valid - first, head - first));
+            events.erase(events.begin() + static_cast<long>(offset), events.begin() + static_cast<long>(offset + torn));
+        }
+    }
+
+    return events;
+}
+
+Engine::Profiler::ThreadBuffer* Engine::Profiler::registerThread()
+{
+    auto buffer = std::make_unique<ThreadBuffer>();
+
+    std::lock_guard lock(registryMutex);
+    buffer->index = static_cast<uint32_t>(registry.size());
+
+    tlsBuffer = buffer.get();
+    registry.push_back(std::move(buffer));
+
+    return tlsBuffer;
+}
+
+void Engine::Profiler::frame()
+{
+    const uint64_t time = now();
+    const uint64_t start = frameStart.exchange(time, std::memory_order_relaxed);
+
+    // covers the whole previous frame, so frame times come out of the same numbers
+    if (start != 0)
+    {
+        record("frame", start, time);
+    }
+
+    currentFrame.fetch_add(1, std::memory_order_relaxed);
+}
+
+double Engine::Profiler::ticksPerNanosecond()
+{
+#ifdef PROFILER_RDTSC
+    static const double ratio = []
+    {
+        using Clock = std::chrono::steady_clock;
+
+        const auto clockStart = Clock::now();
+        const uint64_t tickStart = now();
+
+        while (Clock::now() - clockStart < std::chrono::milliseconds(10)) {}
+
+        const auto clockEnd = Clock::now();
+        const uint64_t tickEnd = now();
+
+        const double nanos = std::chrono::duration<double, std::nano>(clockEnd - clockStart).count();
+        return static_cast<double>(tickEnd - tickStart) / nanos;
+    }();
+
+    return ratio;
+#else
+    return 1.0;
+#endif
+}
+
+std::vector<Engine::ProfileStats> Engine::Profiler::summary()
+{
+    const std::vector<Event> events = snapshot();
+    const double millisPerTick = 1.0 / (ticksPerNanosecond() * 1e6);
+
+    // by name rather than pointer, the same literal can end up at different addresses
+    struct Zone
+    {
+        const char* name;
+        uint64_t count = 0;
+        std::map<uint32_t, double> frames;
+    };
+
+    std::vector<std::string> order;
+    std::map<std::string, Zone> zones;
+
+    for (const auto& event : events)
+    {
+        auto [it, inserted] = zones.try_emplace(event.name, Zone{event.name, 0, {}});
+
+        if (inserted)
+        {
+            order.emplace_back(event.name);
+        }
+
+        it->second.frames[event.frame] += static_cast<double>(event.end - event.start) * millisPerTick;
+        it->second.count++;
+    }
+
+    std::vector<ProfileStats> result;
+
+    for (const auto& name : order)
+    {
+        const Zone& zone = zones[name];
+
+        std::vector<double> times;
+        double sum = 0.0;
+
+        for (const auto& [frame, time] : zone.frames)
+        {
+            times.push_back(time);
+            sum += time;
+        }
+
+        std::sort(times.begin(), times.end());
+
+        ProfileStats stats;
+        stats.name = zone.name;
+        stats.frames = static_cast<uint32_t>(times.size());
+        stats.count = zone.count;
+        stats.mean = sum / static_cast<double>(times.size());
+        stats.p50 = times[(times.size() - 1) / 2];
+        stats.p99 = times[(times.size() - 1) * 99 / 100];
+
+        result.push_back(stats);
+    }
+
+    return result;
+}
+
+Engine::ProfileStats Engine::Profiler::stats(const char* name)
+{
+    for (const auto& stats : summary())
+    {
+        if (strcmp(stats.name, name) == 0)
+        {
+            return stats;
+        }
+    }
+
+    ProfileStats empty;
+    empty.name = name;
+    return empty;
+}
+
+bool Engine::Profiler::exportTrace(const char* filename)
+{
+    const std::vector<Event> events = snapshot();
+    const double microsPerTick = 1.0 / (ticksPerNanosecond() * 1e3);
+
+    uint64_t origin = UINT64_MAX;
+    uint32_t nThreads = 0;
+
+    for (const auto& event : events)
+    {
+        origin = std::min(origin, event.start);
+        nThreads = std::max(nThreads, event.thread + 1);
+    }
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    for (uint32_t i = 0; i < nThreads; i++)
+    {
+        json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" + std::to_string(i);
+        json += ",\"args\":{\"name\":\"thread " + std::to_string(i) + "\"}},\n";
+    }
+
+    bool first = true;
+
+    for (const auto& event : events)
+    {
+        if (!first) json += ",\n";
+        first = false;
+
+        json += "{\"name\":\"" + std::string(event.name) + "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" + std::to_string(event.thread);
+        json += ",\"ts\":" + std::to_string(static_cast<double>(event.start - origin) * microsPerTick);
+        json += ",\"dur\":" + std::to_string(static_cast<double>(event.end - event.start) * microsPerTick);
+        json += ",\"args\":{\"frame\":" + std::to_string(event.frame) + "}}";
+    }
+
+    json += "\n]}\n";
+    return Loaders::writefile(std::vector<char>(json.begin(), json.end()), filename);
+}
+
+void Engine::Profiler::reset()
+{
+    std::lock_guard lock(registryMutex);
+
+    for (const auto& buffer : registry)
+    {
+        buffer->head.store(0, std::memory_order_relaxed);
+    }
+
+    frameStart.store(0, std::memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+#include "engine.h"
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <x86intrin.h>
+#define PROFILER_RDTSC 1
+#else
+#include <chrono>
+#endif
+
+// per-frame times of a zone in milliseconds, zones hit several times in a frame are summed
+struct Engine::ProfileStats
+{
+    const char* name = nullptr;
+    uint32_t frames = 0;
+    uint64_t count = 0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p99 = 0.0;
+};
+
+// CPU zones, recorded into a lock-free ring per thread. The hot path is two timestamp reads
+// and four relaxed stores, everything else (clock calibration, grouping, JSON) happens when
+// the results are asked for. Rings keep the last CAPACITY zones of each thread.
+class Engine::Profiler
+{
+public:
+    static constexpr uint32_t CAPACITY = 1 << 16;
+
+    // single writer, readers copy a range out and throw away whatever got overwritten meanwhile
+    struct ThreadBuffer
+    {
+        struct Event
+        {
+            std::atomic<const char*> name;
+            std::atomic<uint64_t> start;
+            std::atomic<uint64_t> end;
+            std::atomic<uint32_t> frame;
+        };
+
+        uint32_t index = 0;
+        std::atomic<uint64_t> head{0};
+        Event events[CAPACITY];
+    };
+
+    // ticks, rdtsc where there is one and steady_clock nanoseconds otherwise
+    static uint64_t now()
+    {
+#ifdef PROFILER_RDTSC
+        return __rdtsc();
+#else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    static void record(const char* name, const uint64_t start, const uint64_t end)
+    {
+        ThreadBuffer* buffer = tlsBuffer != nullptr ? tlsBuffer : registerThread();
+        const uint64_t head = buffer->head.load(std::memory_order_relaxed);
+
+        ThreadBuffer::Event& event = buffer->events[head & (CAPACITY - 1)];
+        event.name.store(name, std::memory_order_relaxed);
+        event.start.store(start, std::memory_order_relaxed);
+        event.end.store(end, std::memory_order_relaxed);
+        event.frame.store(currentFrame.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        buffer->head.store(head + 1, std::memory_order_release);
+    }
+
+    struct Zone
+    {
+        const char* name;
+        uint64_t start;
+
+        explicit Zone(const char* name) : name(name), start(now()) {}
+        ~Zone() { record(this->name, this->start, now()); }
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+    };
+
+    Profiler() = delete;
+
+    // marks the start of a new frame, zones are bucketed by the frame they started in
+    static void frame();
+
+    // busy-waits ~10ms the first time, then returns the cached value
+    static double ticksPerNanosecond();
+
+    // every zone name seen, in the order first seen
+    static std::vector<ProfileStats> summary();
+    static ProfileStats stats(const char* name);
+
+    // chrome://tracing (or Perfetto) JSON of whatever is still in the rings
+    static bool exportTrace(const char* filename);
+
+    // drops everything recorded so far, only safe while no zones are being recorded
+    static void reset();
+
+private:
+    static thread_local ThreadBuffer* tlsBuffer;
+    static std::atomic<uint32_t> currentFrame;
+
+    static ThreadBuffer* registerThread();
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef ENABLE_PROFILING
+// times the rest of the enclosing scope, name has to be a string literal (or live as long)
+#define PROFILE_ZONE(name) const Engine::Profiler::Zone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FRAME() Engine::Profiler::frame()
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#endif
\ No newline at end of file
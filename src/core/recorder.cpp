@@ -0,0 +1,152 @@
+#include "recorder.h"
+
+#ifdef HAS_VULKAN
+
+#include "profiler.h"
+
+VkResult Engine::CommandRecorder::create(
+    VkDevice dev,
+    JobSystem* jobs,
+    const uint32_t queueFamily,
+    const uint32_t nSlices,
+    const uint32_t framesInFlight)
+{
+    this->vkDev = dev;
+    this->jobs = jobs;
+    this->slices = std::vector<Slice>(nSlices);
+
+    for (auto& slice : this->slices)
+    {
+        slice.pools.resize(framesInFlight, VK_NULL_HANDLE);
+        slice.cmdBuffers.resize(framesInFlight, VK_NULL_HANDLE);
+
+        for (uint32_t i = 0; i < framesInFlight; i++)
+        {
+            // no RESET_COMMAND_BUFFER, the whole pool is reset each frame instead
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            poolInfo.queueFamilyIndex = queueFamily;
+
+            VkResult result = vkCreateCommandPool(dev, &poolInfo, nullptr, &slice.pools[i]);
+
+            if (result != VK_SUCCESS)
+            {
+                return result;
+            }
+
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = slice.pools[i];
+            allocInfo.commandBufferCount = 1;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+
+            result = vkAllocateCommandBuffers(dev, &allocInfo, &slice.cmdBuffers[i]);
+
+            if (result != VK_SUCCESS)
+            {
+                return result;
+            }
+        }
+    }
+
+    return VK_SUCCESS;
+}
+
+void Engine::CommandRecorder::destroy()
+{
+    for (const auto& slice : this->slices)
+    {
+        for (const auto& pool : slice.pools)
+        {
+            if (pool != VK_NULL_HANDLE)
+            {
+                vkDestroyCommandPool(this->vkDev, pool, nullptr);
+            }
+        }
+    }
+
+    this->slices.resize(0);
+    this->recorded.resize(0);
+}
+
+uint32_t Engine::CommandRecorder::size() const
+{
+    return static_cast<uint32_t>(this->slices.size());
+}
+
+void Engine::CommandRecorder::record(const uint32_t index)
+{
+    PROFILE_ZONE("record slice");
+
+    Slice& slice = this->slices[index];
+    VkCommandBuffer cmdBuffer = slice.cmdBuffers[this->frame];
+
+    slice.result = vkResetCommandPool(this->vkDev, slice.pools[this->frame], 0);
+
+    if (slice.result != VK_SUCCESS)
+    {
+        return;
+    }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &this->inheritance;
+
+    slice.result = vkBeginCommandBuffer(cmdBuffer, &beginInfo);
+
+    if (slice.result != VK_SUCCESS)
+    {
+        return;
+    }
+
+    (*this->task)(index, cmdBuffer);
+    slice.result = vkEndCommandBuffer(cmdBuffer);
+}
+
+VkResult Engine::CommandRecorder::run(
+    const uint32_t frame,
+    VkRenderPass renderPass,
+    VkFramebuffer framebuffer,
+    const VkCommandBufferInheritanceRenderingInfo* rendering,
+    const Task& task,
+    const std::vector<VkCommandBuffer>** pCmdBuffers,
+    const VkQueryPipelineStatisticFlags statistics)
+{
+    this->task = &task;
+    this->frame = frame;
+
+    this->inheritance = {};
+    this->inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    this->inheritance.pNext = rendering;
+    this->inheritance.renderPass = renderPass;
+    this->inheritance.subpass = 0;
+    this->inheritance.framebuffer = framebuffer;
+    this->inheritance.pipelineStatistics = statistics;
+
+    this->jobs->parallelFor(this->size(), 1, [this](const uint32_t begin, const uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            this->record(i);
+        }
+    });
+
+    this->recorded.resize(0);
+
+    for (const auto& slice : this->slices)
+    {
+        if (slice.result != VK_SUCCESS)
+        {
+            return slice.result;
+        }
+
+        this->recorded.push_back(slice.cmdBuffers[frame]);
+    }
+
+    *pCmdBuffers = &this->recorded;
+    return VK_SUCCESS;
+}
+
+#endif
\ No newline at end of file
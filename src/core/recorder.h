@@ -0,0 +1,54 @@
+#pragma once
+#include "engine.h"
+
+#ifdef HAS_VULKAN
+
+#include <functional>
+
+// Records the draw list as secondary command buffers, one slice per job on the job system.
+// Every slice owns one command pool per frame in flight, so nothing is shared between
+// threads while recording and a whole pool can be reset at once.
+class Engine::CommandRecorder
+{
+    using Task = std::function<void(uint32_t slice, VkCommandBuffer cmdBuffer)>;
+
+    struct Slice
+    {
+        std::vector<VkCommandPool> pools;
+        std::vector<VkCommandBuffer> cmdBuffers;
+        VkResult result = VK_SUCCESS;
+    };
+
+    VkDevice vkDev = VK_NULL_HANDLE;
+    JobSystem* jobs = nullptr;
+
+    std::vector<Slice> slices;
+    std::vector<VkCommandBuffer> recorded;
+
+    const Task* task = nullptr;
+    uint32_t frame = 0;
+    VkCommandBufferInheritanceInfo inheritance{};
+
+    void record(uint32_t index);
+
+public:
+    VkResult create(VkDevice dev, JobSystem* jobs, uint32_t queueFamily, uint32_t nSlices, uint32_t framesInFlight);
+    void destroy();
+
+    [[nodiscard]] uint32_t size() const;
+
+    // records one secondary buffer per slice for use inside renderPass, the calling thread helps,
+    // the buffers stay valid until run() is called again for the same frame
+    // (rendering replaces the render pass under dynamic rendering, statistics are the pipeline
+    // statistics of a query left running around the render pass)
+    VkResult run(
+        uint32_t frame,
+        VkRenderPass renderPass,
+        VkFramebuffer framebuffer,
+        const VkCommandBufferInheritanceRenderingInfo* rendering,
+        const Task& task,
+        const std::vector<VkCommandBuffer>** pCmdBuffers,
+        VkQueryPipelineStatisticFlags statistics = 0);
+};
+
+#endif
\ No newline at end of file
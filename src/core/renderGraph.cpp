@@ -0,0 +1,1189 @@
+#include "renderGraph.h"
+
+#ifdef HAS_VULKAN
+
+#include <algorithm>
+
+#include "allocator.h"
+#include "gpuProfiler.h"
+#include "profiler.h"
+
+namespace
+{
+    struct UsageInfo
+    {
+        VkPipelineStageFlags stage;
+        VkAccessFlags read;
+        VkAccessFlags write;
+        VkImageLayout layout;
+        VkImageUsageFlags imageUsage;
+        bool attachment;
+    };
+
+    // indexed by RenderGraph::Usage
+    constexpr UsageInfo USAGES[] = {
+        {
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_ACCESS_COLOR_ATTACHMENT_READ_BIT,
+            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+            true
+        },
+        {
+            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+            true
+        },
+        {
+            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+            0,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+            true
+        },
+        {
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT,
+            0,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_IMAGE_USAGE_SAMPLED_BIT,
+            false
+        },
+        {
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT,
+            0,
+            VK_IMAGE_LAYOUT_GENERAL,
+            VK_IMAGE_USAGE_STORAGE_BIT,
+            false
+        },
+        {
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT,
+            VK_ACCESS_SHADER_WRITE_BIT,
+            VK_IMAGE_LAYOUT_GENERAL,
+            VK_IMAGE_USAGE_STORAGE_BIT,
+            false
+        },
+        {
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_ACCESS_TRANSFER_READ_BIT,
+            0,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            false
+        },
+        {
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            false
+        }
+    };
+
+    VkImageAspectFlags aspectOf(const VkFormat format)
+    {
+        switch (format)
+        {
+            case VK_FORMAT_D16_UNORM:
+            case VK_FORMAT_X8_D24_UNORM_PACK32:
+            case VK_FORMAT_D32_SFLOAT:
+                return VK_IMAGE_ASPECT_DEPTH_BIT;
+            case VK_FORMAT_D16_UNORM_S8_UINT:
+            case VK_FORMAT_D24_UNORM_S8_UINT:
+            case VK_FORMAT_D32_SFLOAT_S8_UINT:
+                return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+            default:
+                return VK_IMAGE_ASPECT_COLOR_BIT;
+        }
+    }
+
+    // what a pass accessing a resource has to wait for, and what waits for it afterwards
+    struct State
+    {
+        VkImageLayout layout;
+        VkPipelineStageFlags writeStage;
+        VkAccessFlags writeAccess;
+
+        // stages that already waited on the last write, and stages reading since it
+        VkPipelineStageFlags visibleStages;
+        VkPipelineStageFlags readStages;
+    };
+
+    bool overlaps(const uint32_t firstA, const uint32_t lastA, const uint32_t firstB, const uint32_t lastB)
+    {
+        return firstA <= lastB && firstB <= lastA;
+    }
+}
+
+void Engine::RenderGraph::create(VkDevice dev, Allocator* allocator, const uint32_t framesInFlight)
+{
+    this->vkDev = dev;
+    this->allocator = allocator;
+    this->framesInFlight = framesInFlight;
+}
+
+void Engine::RenderGraph::useDynamicRendering(const PFN_vkCmdBeginRenderingKHR begin, const PFN_vkCmdEndRenderingKHR end)
+{
+    this->cmdBeginRendering = begin;
+    this->cmdEndRendering = end;
+}
+
+bool Engine::RenderGraph::dynamicRendering() const
+{
+    return this->cmdBeginRendering != nullptr;
+}
+
+void Engine::RenderGraph::destroy()
+{
+    this->destroyRetired(0, true);
+
+    this->destroyTransients(this->transients, this->heap);
+    this->transients.resize(0);
+    this->heap = Allocation{};
+
+    for (const auto& [key, framebuffer] : this->framebuffers)
+    {
+        vkDestroyFramebuffer(this->vkDev, framebuffer, nullptr);
+    }
+
+    for (const auto& [key, renderPass] : this->renderPasses)
+    {
+        vkDestroyRenderPass(this->vkDev, renderPass, nullptr);
+    }
+
+    this->framebuffers.clear();
+    this->renderPasses.clear();
+    this->reset();
+}
+
+void Engine::RenderGraph::reset()
+{
+    this->resources.resize(0);
+    this->passes.resize(0);
+}
+
+Engine::RenderGraph::Resource Engine::RenderGraph::importImage(
+    const char* name,
+    VkImage image,
+    VkImageView view,
+    const VkFormat format,
+    const VkExtent2D extent,
+    const VkImageLayout initialLayout,
+    const VkPipelineStageFlags readyStage,
+    const VkImageLayout finalLayout)
+{
+    ResourceNode resource{};
+    resource.name = name;
+    resource.desc.format = format;
+    resource.desc.extent = extent;
+    resource.aspect = aspectOf(format);
+
+    resource.imported = true;
+    resource.image = image;
+    resource.view = view;
+
+    resource.initialLayout = initialLayout;
+    resource.finalLayout = finalLayout;
+    resource.readyStage = readyStage;
+
+    this->resources.push_back(resource);
+    return static_cast<Resource>(this->resources.size() - 1);
+}
+
+Engine::RenderGraph::Resource Engine::RenderGraph::createImage(const char* name, const ImageDesc& desc)
+{
+    ResourceNode resource{};
+    resource.name = name;
+    resource.desc = desc;
+    resource.aspect = aspectOf(desc.format);
+
+    this->resources.push_back(resource);
+    return static_cast<Resource>(this->resources.size() - 1);
+}
+
+void Engine::RenderGraph::output(const Resource resource)
+{
+    this->resources[resource].output = true;
+}
+
+Engine::RenderGraph::Pass Engine::RenderGraph::addPass(
+    const char* name,
+    Execute execute,
+    const VkSubpassContents contents,
+    const bool sideEffects)
+{
+    PassNode pass{};
+    pass.name = name;
+    pass.contents = contents;
+    pass.execute = std::move(execute);
+    pass.sideEffects = sideEffects;
+
+    this->passes.push_back(std::move(pass));
+    return static_cast<Pass>(this->passes.size() - 1);
+}
+
+void Engine::RenderGraph::read(const Pass pass, const Resource resource, const Usage usage)
+{
+    this->passes[pass].accesses.push_back({resource, usage, false, false, {}});
+}
+
+void Engine::RenderGraph::write(const Pass pass, const Resource resource, const Usage usage)
+{
+    this->passes[pass].accesses.push_back({resource, usage, true, false, {}});
+}
+
+void Engine::RenderGraph::clear(const Pass pass, const Resource resource, const Usage usage, const VkClearValue value)
+{
+    this->passes[pass].accesses.push_back({resource, usage, true, true, value});
+}
+
+void Engine::RenderGraph::cull()
+{
+    for (auto& resource : this->resources)
+    {
+        resource.writers.resize(0);
+        resource.refs = resource.imported || resource.output ? 1 : 0;
+    }
+
+    for (uint32_t i = 0; i < this->passes.size(); i++)
+    {
+        PassNode& pass = this->passes[i];
+        pass.refs = 0;
+        pass.culled = false;
+
+        for (const auto& access : pass.accesses)
+        {
+            if (access.write)
+            {
+                pass.refs++;
+                this->resources[access.resource].writers.push_back(i);
+            } else
+            {
+                this->resources[access.resource].refs++;
+            }
+        }
+    }
+
+    // passes nobody reads from go, which can leave what they read unread in turn
+    std::vector<Pass> unused;
+
+    for (uint32_t i = 0; i < this->passes.size(); i++)
+    {
+        if (this->passes[i].refs == 0 && !this->passes[i].sideEffects)
+        {
+            unused.push_back(i);
+        }
+    }
+
+    for (uint32_t i = 0; i < this->resources.size(); i++)
+    {
+        if (this->resources[i].refs != 0)
+        {
+            continue;
+        }
+
+        for (const Pass writer : this->resources[i].writers)
+        {
+            PassNode& pass = this->passes[writer];
+
+            if (--pass.refs == 0 && !pass.sideEffects)
+            {
+                unused.push_back(writer);
+            }
+        }
+    }
+
+    while (!unused.empty())
+    {
+        PassNode& pass = this->passes[unused.back()];
+        unused.pop_back();
+
+        pass.culled = true;
+
+        for (const auto& access : pass.accesses)
+        {
+            if (access.write)
+            {
+                continue;
+            }
+
+            ResourceNode& resource = this->resources[access.resource];
+
+            if (--resource.refs != 0)
+            {
+                continue;
+            }
+
+            for (const Pass writer : resource.writers)
+            {
+                PassNode& other = this->passes[writer];
+
+                if (!other.culled && --other.refs == 0 && !other.sideEffects)
+                {
+                    unused.push_back(writer);
+                }
+            }
+        }
+    }
+}
+
+VkResult Engine::RenderGraph::placeTransients(const uint64_t frame)
+{
+    std::vector<Resource> live;
+
+    for (uint32_t i = 0; i < this->resources.size(); i++)
+    {
+        if (!this->resources[i].imported && this->resources[i].firstPass != UINT32_MAX)
+        {
+            live.push_back(i);
+        }
+    }
+
+    // same images with the same lifetimes as last frame, which is nearly always
+    bool same = live.size() == this->transients.size();
+
+    for (uint32_t i = 0; same && i < live.size(); i++)
+    {
+        const ResourceNode& resource = this->resources[live[i]];
+        const Transient& transient = this->transients[i];
+
+        same = resource.desc.format == transient.desc.format &&
+            resource.desc.extent.width == transient.desc.extent.width &&
+            resource.desc.extent.height == transient.desc.extent.height &&
+            resource.desc.usage == transient.desc.usage &&
+            resource.firstPass == transient.firstPass &&
+            resource.lastPass == transient.lastPass;
+    }
+
+    if (same)
+    {
+        for (uint32_t i = 0; i < live.size(); i++)
+        {
+            this->resources[live[i]].transient = i;
+        }
+
+        return VK_SUCCESS;
+    }
+
+    // frames in flight may still be using the old ones
+    if (!this->transients.empty())
+    {
+        Retired retired{};
+        retired.transients = std::move(this->transients);
+        retired.heap = this->heap;
+        retired.retiredAt = frame;
+
+        for (const auto& [key, framebuffer] : this->framebuffers)
+        {
+            retired.framebuffers.push_back(framebuffer);
+        }
+
+        this->retired.push_back(std::move(retired));
+        this->framebuffers.clear();
+        this->transients.resize(0);
+        this->heap = Allocation{};
+    }
+
+    // nothing half made is kept, the next frame starts over
+    const auto fail = [this](const VkResult result)
+    {
+        this->destroyTransients(this->transients, this->heap);
+        this->transients.resize(0);
+        this->heap = Allocation{};
+
+        return result;
+    };
+
+    std::vector<VkMemoryRequirements> reqs(live.size());
+    this->transients.resize(live.size());
+
+    for (uint32_t i = 0; i < live.size(); i++)
+    {
+        ResourceNode& resource = this->resources[live[i]];
+        Transient& transient = this->transients[i];
+
+        transient.desc = resource.desc;
+        transient.aspect = resource.aspect;
+        transient.firstPass = resource.firstPass;
+        transient.lastPass = resource.lastPass;
+        resource.transient = i;
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = resource.desc.format;
+        imageInfo.extent = {resource.desc.extent.width, resource.desc.extent.height, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = resource.desc.usage;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        const VkResult result = vkCreateImage(this->vkDev, &imageInfo, nullptr, &transient.image);
+
+        if (result != VK_SUCCESS)
+        {
+            return fail(result);
+        }
+
+        vkGetImageMemoryRequirements(this->vkDev, transient.image, &reqs[i]);
+        transient.size = reqs[i].size;
+    }
+
+    // biggest first, each at the lowest offset clear of everything alive at the same time
+    std::vector<uint32_t> order(live.size());
+
+    for (uint32_t i = 0; i < order.size(); i++)
+    {
+        order[i] = i;
+    }
+
+    std::sort(order.begin(), order.end(), [&](const uint32_t a, const uint32_t b)
+    {
+        return reqs[a].size > reqs[b].size;
+    });
+
+    VkMemoryRequirements heapReqs{};
+    heapReqs.memoryTypeBits = UINT32_MAX;
+    heapReqs.alignment = 1;
+
+    std::vector<uint32_t> placed;
+
+    for (const uint32_t i : order)
+    {
+        Transient& transient = this->transients[i];
+        const VkDeviceSize alignment = reqs[i].alignment;
+
+        std::vector<VkDeviceSize> candidates = {0};
+
+        for (const uint32_t j : placed)
+        {
+            const Transient& other = this->transients[j];
+
+            if (overlaps(transient.firstPass, transient.lastPass, other.firstPass, other.lastPass))
+            {
+                candidates.push_back((other.offset + other.size + alignment - 1) / alignment * alignment);
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+
+        for (const VkDeviceSize candidate : candidates)
+        {
+            bool fits = true;
+
+            for (const uint32_t j : placed)
+            {
+                const Transient& other = this->transients[j];
+
+                if (overlaps(transient.firstPass, transient.lastPass, other.firstPass, other.lastPass) &&
+                    candidate < other.offset + other.size && other.offset < candidate + transient.size)
+                {
+                    fits = false;
+                    break;
+                }
+            }
+
+            if (fits)
+            {
+                transient.offset = candidate;
+                break;
+            }
+        }
+
+        placed.push_back(i);
+
+        heapReqs.size = std::max(heapReqs.size, transient.offset + transient.size);
+        heapReqs.alignment = std::max(heapReqs.alignment, alignment);
+        heapReqs.memoryTypeBits &= reqs[i].memoryTypeBits;
+    }
+
+    if (live.empty())
+    {
+        return VK_SUCCESS;
+    }
+
+    // attachments all live in the same device local types on anything real
+    if (heapReqs.memoryTypeBits == 0)
+    {
+        return fail(VK_ERROR_FEATURE_NOT_PRESENT);
+    }
+
+    VkResult result = this->allocator->allocate(heapReqs, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true, &this->heap);
+
+    if (result != VK_SUCCESS)
+    {
+        this->heap = Allocation{};
+        return fail(result);
+    }
+
+    for (uint32_t i = 0; i < live.size(); i++)
+    {
+        Transient& transient = this->transients[i];
+
+        result = vkBindImageMemory(this->vkDev, transient.image, this->heap.memory, this->heap.offset + transient.offset);
+
+        if (result != VK_SUCCESS)
+        {
+            return fail(result);
+        }
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = transient.image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = transient.desc.format;
+        viewInfo.subresourceRange.aspectMask = transient.aspect;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        result = vkCreateImageView(this->vkDev, &viewInfo, nullptr, &transient.view);
+
+        if (result != VK_SUCCESS)
+        {
+            return fail(result);
+        }
+
+        // the first use waits on whatever last touched the same memory, this frame or the one before
+        for (uint32_t j = 0; j < live.size(); j++)
+        {
+            const Transient& other = this->transients[j];
+
+            if (transient.offset < other.offset + other.size && other.offset < transient.offset + transient.size)
+            {
+                transient.aliasStages |= this->resources[live[j]].lastStages;
+                transient.aliasAccess |= this->resources[live[j]].lastWrites;
+            }
+        }
+    }
+
+    return VK_SUCCESS;
+}
+
+void Engine::RenderGraph::destroyTransients(const std::vector<Transient>& transients, const Allocation& heap)
+{
+    for (const auto& transient : transients)
+    {
+        if (transient.view != VK_NULL_HANDLE)
+        {
+            vkDestroyImageView(this->vkDev, transient.view, nullptr);
+        }
+
+        if (transient.image != VK_NULL_HANDLE)
+        {
+            vkDestroyImage(this->vkDev, transient.image, nullptr);
+        }
+    }
+
+    if (heap.memory != VK_NULL_HANDLE)
+    {
+        this->allocator->free(heap);
+    }
+}
+
+void Engine::RenderGraph::buildBarriers()
+{
+    std::vector<State> states(this->resources.size());
+
+    for (uint32_t i = 0; i < this->resources.size(); i++)
+    {
+        const ResourceNode& resource = this->resources[i];
+
+        if (resource.imported)
+        {
+            states[i] = {resource.initialLayout, resource.readyStage, 0, 0, 0};
+        } else if (resource.transient != UINT32_MAX)
+        {
+            const Transient& transient = this->transients[resource.transient];
+            states[i] = {VK_IMAGE_LAYOUT_UNDEFINED, transient.aliasStages, transient.aliasAccess, 0, 0};
+        }
+    }
+
+    const auto imageBarrier = [&](
+        const Resource index,
+        const VkAccessFlags srcAccess,
+        const VkAccessFlags dstAccess,
+        const VkImageLayout oldLayout,
+        const VkImageLayout newLayout)
+    {
+        const ResourceNode& resource = this->resources[index];
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = this->image(index);
+        barrier.subresourceRange.aspectMask = resource.aspect;
+        barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+        return barrier;
+    };
+
+    for (auto& pass : this->passes)
+    {
+        pass.barrier = Barrier{};
+
+        if (pass.culled)
+        {
+            continue;
+        }
+
+        for (const auto& access : pass.accesses)
+        {
+            const UsageInfo& usage = USAGES[access.usage];
+            State& state = states[access.resource];
+
+            const VkAccessFlags dstAccess = access.write ? usage.read | usage.write : usage.read;
+            const bool transition = state.layout != usage.layout;
+
+            VkPipelineStageFlags srcStage = 0;
+            const size_t nBarriers = pass.barrier.barriers.size();
+
+            if (access.write || transition)
+            {
+                // WAW and WAR, plus anything moving the image to a new layout
+                srcStage = state.writeStage | state.readStages;
+
+                if (transition || state.writeAccess != 0)
+                {
+                    pass.barrier.barriers.push_back(imageBarrier(access.resource, state.writeAccess, dstAccess, state.layout, usage.layout));
+                }
+
+                state.layout = usage.layout;
+                state.writeStage = usage.stage;
+                state.writeAccess = access.write ? usage.write : 0;
+                state.visibleStages = access.write ? 0 : usage.stage;
+                state.readStages = access.write ? 0 : usage.stage;
+            } else if ((usage.stage & ~state.visibleStages) != 0 && state.writeStage != 0)
+            {
+                // RAW, once per stage that hasn't seen the write yet
+                srcStage = state.writeStage;
+
+                if (state.writeAccess != 0)
+                {
+                    pass.barrier.barriers.push_back(imageBarrier(access.resource, state.writeAccess, dstAccess, state.layout, state.layout));
+                }
+
+                state.visibleStages |= usage.stage;
+                state.readStages |= usage.stage;
+            } else
+            {
+                state.readStages |= usage.stage;
+            }
+
+            if (srcStage != 0 || pass.barrier.barriers.size() > nBarriers)
+            {
+                pass.barrier.srcStage |= srcStage != 0 ? srcStage : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+                pass.barrier.dstStage |= usage.stage;
+            }
+        }
+
+        if (pass.barrier.srcStage != 0)
+        {
+            this->lastStats.barrierBatches++;
+            this->lastStats.imageBarriers += static_cast<uint32_t>(pass.barrier.barriers.size());
+        }
+    }
+
+    // hand imported images back in the layout their owner expects
+    this->finalBarrier = Barrier{};
+
+    for (uint32_t i = 0; i < this->resources.size(); i++)
+    {
+        const ResourceNode& resource = this->resources[i];
+        const State& state = states[i];
+
+        if (!resource.imported || resource.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED || resource.finalLayout == state.layout)
+        {
+            continue;
+        }
+
+        this->finalBarrier.barriers.push_back(imageBarrier(i, state.writeAccess, 0, state.layout, resource.finalLayout));
+        this->finalBarrier.srcStage |= state.writeStage | state.readStages;
+        this->finalBarrier.dstStage |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    }
+
+    if (!this->finalBarrier.barriers.empty())
+    {
+        if (this->finalBarrier.srcStage == 0)
+        {
+            this->finalBarrier.srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        }
+
+        this->lastStats.barrierBatches++;
+        this->lastStats.imageBarriers += static_cast<uint32_t>(this->finalBarrier.barriers.size());
+    }
+}
+
+VkRenderPass Engine::RenderGraph::findRenderPass(
+    const std::vector<uint64_t>& key,
+    const std::vector<VkAttachmentDescription>& attachments)
+{
+    const auto found = this->renderPasses.find(key);
+
+    if (found != this->renderPasses.end())
+    {
+        return found->second;
+    }
+
+    std::vector<VkAttachmentReference> colorRefs;
+    VkAttachmentReference depthRef{};
+    bool hasDepth = false;
+
+    for (uint32_t i = 0; i < attachments.size(); i++)
+    {
+        if (aspectOf(attachments[i].format) & VK_IMAGE_ASPECT_DEPTH_BIT)
+        {
+            depthRef = {i, attachments[i].initialLayout};
+            hasDepth = true;
+        } else
+        {
+            colorRefs.push_back({i, attachments[i].initialLayout});
+        }
+    }
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = static_cast<uint32_t>(colorRefs.size());
+    subpass.pColorAttachments = colorRefs.data();
+    subpass.pDepthStencilAttachment = hasDepth ? &depthRef : nullptr;
+
+    // no dependencies, the graph's barriers do the layout changes before the pass begins
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+
+    VkRenderPass renderPass;
+
+    if (vkCreateRenderPass(this->vkDev, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    this->renderPasses.emplace(key, renderPass);
+    return renderPass;
+}
+
+VkResult Engine::RenderGraph::buildRenderPasses()
+{
+    for (uint32_t index = 0; index < this->passes.size(); index++)
+    {
+        PassNode& pass = this->passes[index];
+
+        pass.renderPass = VK_NULL_HANDLE;
+        pass.framebuffer = VK_NULL_HANDLE;
+        pass.clearValues.resize(0);
+
+        pass.rendering = false;
+        pass.colorAttachments.resize(0);
+        pass.depthAttachment = {};
+        pass.colorFormats.resize(0);
+
+        if (pass.culled)
+        {
+            continue;
+        }
+
+        std::vector<VkAttachmentDescription> attachments;
+        std::vector<VkImageView> views;
+        std::vector<uint64_t> key;
+
+        for (const auto& access : pass.accesses)
+        {
+            const UsageInfo& usage = USAGES[access.usage];
+
+            if (!usage.attachment)
+            {
+                continue;
+            }
+
+            const ResourceNode& resource = this->resources[access.resource];
+
+            // load only what's been written, store only what's read later
+            const bool hasContents = index > resource.firstPass || (resource.imported && resource.initialLayout != VK_IMAGE_LAYOUT_UNDEFINED);
+            const bool needed = index < resource.lastPass || resource.imported || resource.output;
+
+            VkAttachmentDescription attachment{};
+            attachment.format = resource.desc.format;
+            attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            attachment.loadOp = access.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : hasContents ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.storeOp = needed ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.stencilLoadOp = (resource.aspect & VK_IMAGE_ASPECT_STENCIL_BIT) ? attachment.loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.stencilStoreOp = (resource.aspect & VK_IMAGE_ASPECT_STENCIL_BIT) ? attachment.storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.initialLayout = usage.layout;
+            attachment.finalLayout = usage.layout;
+
+            attachments.push_back(attachment);
+            key.insert(key.end(), {attachment.format, attachment.loadOp, attachment.storeOp, attachment.initialLayout});
+
+            pass.clearValues.push_back(access.clearValue);
+            pass.extent = resource.desc.extent;
+            views.push_back(this->view(access.resource));
+        }
+
+        if (attachments.empty())
+        {
+            continue;
+        }
+
+        if (this->dynamicRendering())
+        {
+            pass.rendering = true;
+            pass.inheritance = {};
+            pass.inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+            pass.inheritance.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+            for (uint32_t i = 0; i < attachments.size(); i++)
+            {
+                const VkAttachmentDescription& attachment = attachments[i];
+
+                VkRenderingAttachmentInfo info{};
+                info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+                info.imageView = views[i];
+                info.imageLayout = attachment.initialLayout;
+                info.loadOp = attachment.loadOp;
+                info.storeOp = attachment.storeOp;
+                info.clearValue = pass.clearValues[i];
+
+                const VkImageAspectFlags aspect = aspectOf(attachment.format);
+
+                if (aspect & VK_IMAGE_ASPECT_DEPTH_BIT)
+                {
+                    pass.depthAttachment = info;
+                    pass.inheritance.depthAttachmentFormat = attachment.format;
+                    pass.inheritance.stencilAttachmentFormat = (aspect & VK_IMAGE_ASPECT_STENCIL_BIT) ? attachment.format : VK_FORMAT_UNDEFINED;
+                } else
+                {
+                    pass.colorAttachments.push_back(info);
+                    pass.colorFormats.push_back(attachment.format);
+                }
+            }
+
+            pass.inheritance.colorAttachmentCount = static_cast<uint32_t>(pass.colorFormats.size());
+            pass.inheritance.pColorAttachmentFormats = pass.colorFormats.data();
+
+            if (pass.contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+            {
+                pass.inheritance.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+            }
+
+            continue;
+        }
+
+        pass.renderPass = this->findRenderPass(key, attachments);
+
+        if (pass.renderPass == VK_NULL_HANDLE)
+        {
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+
+        // handles are pointers or plain integers depending on the platform
+        std::vector<uint64_t> framebufferKey = {(uint64_t)pass.renderPass, pass.extent.width, pass.extent.height};
+
+        for (const auto& view : views)
+        {
+            framebufferKey.push_back((uint64_t)view);
+        }
+
+        const auto found = this->framebuffers.find(framebufferKey);
+
+        if (found != this->framebuffers.end())
+        {
+            pass.framebuffer = found->second;
+            continue;
+        }
+
+        VkFramebufferCreateInfo framebufferInfo{};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = pass.renderPass;
+        framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+        framebufferInfo.pAttachments = views.data();
+        framebufferInfo.width = pass.extent.width;
+        framebufferInfo.height = pass.extent.height;
+        framebufferInfo.layers = 1;
+
+        const VkResult result = vkCreateFramebuffer(this->vkDev, &framebufferInfo, nullptr, &pass.framebuffer);
+
+        if (result != VK_SUCCESS)
+        {
+            return result;
+        }
+
+        this->framebuffers.emplace(framebufferKey, pass.framebuffer);
+    }
+
+    return VK_SUCCESS;
+}
+
+VkResult Engine::RenderGraph::compile(const uint64_t frame)
+{
+    PROFILE_ZONE("graph compile");
+
+    this->destroyRetired(frame, false);
+    this->lastStats = Stats{};
+
+    this->cull();
+
+    for (uint32_t i = 0; i < this->passes.size(); i++)
+    {
+        const PassNode& pass = this->passes[i];
+
+        if (pass.culled)
+        {
+            this->lastStats.culledPasses++;
+            continue;
+        }
+
+        this->lastStats.passes++;
+
+        for (const auto& access : pass.accesses)
+        {
+            ResourceNode& resource = this->resources[access.resource];
+            const UsageInfo& usage = USAGES[access.usage];
+
+            resource.desc.usage |= usage.imageUsage;
+            resource.firstPass = std::min(resource.firstPass, i);
+
+            if (i > resource.lastPass)
+            {
+                resource.lastStages = 0;
+                resource.lastWrites = 0;
+            }
+
+            resource.lastPass = std::max(resource.lastPass, i);
+            resource.lastStages |= usage.stage;
+            resource.lastWrites |= access.write ? usage.write : 0;
+        }
+    }
+
+    VkResult result = this->placeTransients(frame);
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
+    this->buildBarriers();
+    result = this->buildRenderPasses();
+
+    this->lastStats.transientImages = static_cast<uint32_t>(this->transients.size());
+    this->lastStats.transientBytes = this->transients.empty() ? 0 : this->heap.size;
+
+    for (const auto& transient : this->transients)
+    {
+        this->lastStats.unaliasedBytes += transient.size;
+    }
+
+    return result;
+}
+
+void Engine::RenderGraph::execute(VkCommandBuffer cmdBuffer) const
+{
+    for (const auto& pass : this->passes)
+    {
+        if (pass.culled)
+        {
+            continue;
+        }
+
+#ifdef ENABLE_PROFILING
+        if (this->profiler != nullptr)
+        {
+            this->profiler->begin(cmdBuffer, pass.name);
+        }
+#endif
+
+        if (pass.barrier.srcStage != 0)
+        {
+            vkCmdPipelineBarrier(
+                cmdBuffer,
+                pass.barrier.srcStage,
+                pass.barrier.dstStage,
+                0,
+                0, nullptr,
+                0, nullptr,
+                static_cast<uint32_t>(pass.barrier.barriers.size()), pass.barrier.barriers.data());
+        }
+
+        const PassContext context{
+            cmdBuffer,
+            pass.renderPass,
+            pass.framebuffer,
+            pass.extent,
+            pass.rendering ? &pass.inheritance : nullptr,
+            this
+        };
+
+        if (pass.renderPass != VK_NULL_HANDLE)
+        {
+            VkRenderPassBeginInfo passBeginInfo{};
+            passBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            passBeginInfo.renderPass = pass.renderPass;
+            passBeginInfo.framebuffer = pass.framebuffer;
+            passBeginInfo.renderArea.extent = pass.extent;
+            passBeginInfo.clearValueCount = static_cast<uint32_t>(pass.clearValues.size());
+            passBeginInfo.pClearValues = pass.clearValues.data();
+
+            vkCmdBeginRenderPass(cmdBuffer, &passBeginInfo, pass.contents);
+            pass.execute(context);
+            vkCmdEndRenderPass(cmdBuffer);
+        } else if (pass.rendering)
+        {
+            const bool hasDepth = pass.inheritance.depthAttachmentFormat != VK_FORMAT_UNDEFINED;
+            const bool hasStencil = pass.inheritance.stencilAttachmentFormat != VK_FORMAT_UNDEFINED;
+
+            VkRenderingInfo renderingInfo{};
+            renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+            renderingInfo.flags = pass.inheritance.flags;
+            renderingInfo.renderArea.extent = pass.extent;
+            renderingInfo.layerCount = 1;
+            renderingInfo.colorAttachmentCount = static_cast<uint32_t>(pass.colorAttachments.size());
+            renderingInfo.pColorAttachments = pass.colorAttachments.data();
+            renderingInfo.pDepthAttachment = hasDepth ? &pass.depthAttachment : nullptr;
+            renderingInfo.pStencilAttachment = hasStencil ? &pass.depthAttachment : nullptr;
+
+            this->cmdBeginRendering(cmdBuffer, &renderingInfo);
+            pass.execute(context);
+            this->cmdEndRendering(cmdBuffer);
+        } else
+        {
+            pass.execute(context);
+        }
+
+#ifdef ENABLE_PROFILING
+        if (this->profiler != nullptr)
+        {
+            this->profiler->end(cmdBuffer);
+        }
+#endif
+    }
+
+    if (this->finalBarrier.srcStage != 0)
+    {
+        vkCmdPipelineBarrier(
+            cmdBuffer,
+            this->finalBarrier.srcStage,
+            this->finalBarrier.dstStage,
+            0,
+            0, nullptr,
+            0, nullptr,
+            static_cast<uint32_t>(this->finalBarrier.barriers.size()), this->finalBarrier.barriers.data());
+    }
+}
+
+VkImage Engine::RenderGraph::image(const Resource resource) const
+{
+    const ResourceNode& node = this->resources[resource];
+
+    if (node.imported)
+    {
+        return node.image;
+    }
+
+    return node.transient != UINT32_MAX ? this->transients[node.transient].image : VK_NULL_HANDLE;
+}
+
+VkImageView Engine::RenderGraph::view(const Resource resource) const
+{
+    const ResourceNode& node = this->resources[resource];
+
+    if (node.imported)
+    {
+        return node.view;
+    }
+
+    return node.transient != UINT32_MAX ? this->transients[node.transient].view : VK_NULL_HANDLE;
+}
+
+const Engine::RenderGraph::Stats& Engine::RenderGraph::stats() const
+{
+    return this->lastStats;
+}
+
+VkRenderPass Engine::RenderGraph::compatibleRenderPass(const VkFormat color, const VkFormat depth)
+{
+    std::vector<VkAttachmentDescription> attachments;
+    std::vector<uint64_t> key;
+
+    // the same ops as a pass clearing and keeping them, so this is usually the very one it ends up using
+    for (const VkFormat format : {color, depth})
+    {
+        if (format == VK_FORMAT_UNDEFINED)
+        {
+            continue;
+        }
+
+        const bool isDepth = aspectOf(format) & VK_IMAGE_ASPECT_DEPTH_BIT;
+
+        VkAttachmentDescription attachment{};
+        attachment.format = format;
+        attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachment.initialLayout = isDepth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        attachment.finalLayout = attachment.initialLayout;
+
+        attachments.push_back(attachment);
+        key.insert(key.end(), {attachment.format, attachment.loadOp, attachment.storeOp, attachment.initialLayout});
+    }
+
+    return this->findRenderPass(key, attachments);
+}
+
+void Engine::RenderGraph::retireFramebuffers(const uint64_t frame)
+{
+    Retired retired{};
+    retired.retiredAt = frame;
+
+    for (const auto& [key, framebuffer] : this->framebuffers)
+    {
+        retired.framebuffers.push_back(framebuffer);
+    }
+
+    this->framebuffers.clear();
+    this->retired.push_back(std::move(retired));
+}
+
+void Engine::RenderGraph::destroyRetired(const uint64_t frame, const bool all)
+{
+    auto retired = this->retired.begin();
+
+    while (retired != this->retired.end())
+    {
+        if (!all && frame < retired->retiredAt + this->framesInFlight)
+        {
+            ++retired;
+            continue;
+        }
+
+        for (const auto& framebuffer : retired->framebuffers)
+        {
+            vkDestroyFramebuffer(this->vkDev, framebuffer, nullptr);
+        }
+
+        this->destroyTransients(retired->transients, retired->heap);
+        retired = this->retired.erase(retired);
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,262 @@
+#pragma once
+#include "engine.h"
+
+#ifdef HAS_VULKAN
+
+#include <functional>
+#include <map>
+
+// Frame graph over the renderer. Every frame the passes are declared again along with the
+// images they read and write, compile() then culls passes nothing depends on, works out one
+// batched barrier per pass from those declarations, and places transient images with
+// non-overlapping lifetimes in the same memory. Render passes, framebuffers and transient
+// images are cached across frames, so compiling an unchanged graph creates nothing.
+//
+// Passes run in the order they're added, which has to be a valid order already (a pass
+// can only read what an earlier one wrote).
+//
+// With useDynamicRendering() passes begin rendering straight on the image views, so there
+// are no render pass or framebuffer objects at all.
+class Engine::RenderGraph
+{
+public:
+    using Resource = uint32_t;
+    using Pass = uint32_t;
+
+    enum Usage : uint8_t
+    {
+        COLOR_ATTACHMENT,
+        DEPTH_ATTACHMENT,
+        DEPTH_READ,
+        SAMPLED,
+        STORAGE_READ,
+        STORAGE_WRITE,
+        TRANSFER_SRC,
+        TRANSFER_DST
+    };
+
+    struct ImageDesc
+    {
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent{};
+
+        // on top of whatever the declared usages need
+        VkImageUsageFlags usage = 0;
+    };
+
+    struct PassContext
+    {
+        VkCommandBuffer cmdBuffer;
+
+        // VK_NULL_HANDLE for passes without attachments, which run outside a render pass,
+        // and always with dynamic rendering
+        VkRenderPass renderPass;
+        VkFramebuffer framebuffer;
+        VkExtent2D extent;
+
+        // what secondaries inherit instead of the render pass with dynamic rendering, nullptr otherwise
+        const VkCommandBufferInheritanceRenderingInfo* rendering;
+
+        // what the pass' images ended up as, transient ones only exist once compiled
+        const RenderGraph* graph;
+    };
+
+    using Execute = std::function<void(const PassContext& context)>;
+
+    struct Stats
+    {
+        uint32_t passes = 0;
+        uint32_t culledPasses = 0;
+        uint32_t barrierBatches = 0;
+        uint32_t imageBarriers = 0;
+        uint32_t transientImages = 0;
+
+        // transient memory with and without aliasing
+        VkDeviceSize transientBytes = 0;
+        VkDeviceSize unaliasedBytes = 0;
+    };
+
+private:
+    struct Access
+    {
+        Resource resource;
+        Usage usage;
+        bool write;
+        bool clear;
+        VkClearValue clearValue;
+    };
+
+    struct ResourceNode
+    {
+        const char* name;
+        ImageDesc desc;
+        VkImageAspectFlags aspect = 0;
+
+        bool imported = false;
+        bool output = false;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+
+        VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags readyStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+        // filled in by compile()
+        std::vector<Pass> writers;
+        uint32_t refs = 0;
+        uint32_t firstPass = UINT32_MAX;
+        uint32_t lastPass = 0;
+        VkPipelineStageFlags lastStages = 0;
+        VkAccessFlags lastWrites = 0;
+        uint32_t transient = UINT32_MAX;
+    };
+
+    struct Barrier
+    {
+        VkPipelineStageFlags srcStage = 0;
+        VkPipelineStageFlags dstStage = 0;
+        std::vector<VkImageMemoryBarrier> barriers;
+    };
+
+    struct PassNode
+    {
+        const char* name;
+        VkSubpassContents contents;
+        Execute execute;
+        std::vector<Access> accesses;
+        bool sideEffects = false;
+
+        // filled in by compile()
+        uint32_t refs = 0;
+        bool culled = false;
+        Barrier barrier;
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        VkExtent2D extent{};
+        std::vector<VkClearValue> clearValues;
+
+        // dynamic rendering only, what vkCmdBeginRendering gets instead of the render pass
+        bool rendering = false;
+        std::vector<VkRenderingAttachmentInfo> colorAttachments;
+        VkRenderingAttachmentInfo depthAttachment{};
+        std::vector<VkFormat> colorFormats;
+        VkCommandBufferInheritanceRenderingInfo inheritance{};
+    };
+
+    // a physical image backing one or more frames' worth of the same transient
+    struct Transient
+    {
+        ImageDesc desc;
+        VkImageAspectFlags aspect = 0;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+
+        // the lifetime it was placed with, aliasing only holds as long as this does
+        uint32_t firstPass = 0;
+        uint32_t lastPass = 0;
+
+        // stages and writes of everything sharing its memory, its first use waits on them
+        VkPipelineStageFlags aliasStages = 0;
+        VkAccessFlags aliasAccess = 0;
+    };
+
+    struct Retired
+    {
+        std::vector<Transient> transients;
+        Allocation heap;
+        std::vector<VkFramebuffer> framebuffers;
+        uint64_t retiredAt = 0;
+    };
+
+    VkDevice vkDev = VK_NULL_HANDLE;
+    Allocator* allocator = nullptr;
+    uint32_t framesInFlight = 1;
+
+    // set when rendering without render passes, the core or KHR entry points
+    PFN_vkCmdBeginRenderingKHR cmdBeginRendering = nullptr;
+    PFN_vkCmdEndRenderingKHR cmdEndRendering = nullptr;
+
+    std::vector<ResourceNode> resources;
+    std::vector<PassNode> passes;
+    Barrier finalBarrier;
+
+    std::vector<Transient> transients;
+    Allocation heap;
+
+    std::map<std::vector<uint64_t>, VkRenderPass> renderPasses;
+    std::map<std::vector<uint64_t>, VkFramebuffer> framebuffers;
+    std::vector<Retired> retired;
+
+    Stats lastStats;
+
+    void cull();
+    VkResult placeTransients(uint64_t frame);
+    void destroyTransients(const std::vector<Transient>& transients, const Allocation& heap);
+    void buildBarriers();
+    VkResult buildRenderPasses();
+    void destroyRetired(uint64_t frame, bool all);
+
+    VkRenderPass findRenderPass(const std::vector<uint64_t>& key, const std::vector<VkAttachmentDescription>& attachments);
+
+public:
+#ifdef ENABLE_PROFILING
+    // each pass gets a GPU timestamp scope when this is set
+    GpuProfiler* profiler = nullptr;
+#endif
+
+    void create(VkDevice dev, Allocator* allocator, uint32_t framesInFlight);
+    void destroy();
+
+    // begin passes with these instead of render passes from now on, pipelines then need a
+    // VkPipelineRenderingCreateInfo instead of compatibleRenderPass()
+    void useDynamicRendering(PFN_vkCmdBeginRenderingKHR begin, PFN_vkCmdEndRenderingKHR end);
+    [[nodiscard]] bool dynamicRendering() const;
+
+    // forgets last frame's passes and resources, keeps everything cached
+    void reset();
+
+    // images owned by someone else, they're never culled and end up in finalLayout,
+    // readyStage is the stage whatever signals the image being usable waits at
+    Resource importImage(
+        const char* name,
+        VkImage image,
+        VkImageView view,
+        VkFormat format,
+        VkExtent2D extent,
+        VkImageLayout initialLayout,
+        VkPipelineStageFlags readyStage,
+        VkImageLayout finalLayout);
+
+    // lives for the frame only, contents are undefined until a pass writes them
+    Resource createImage(const char* name, const ImageDesc& desc);
+
+    // keeps a transient (and the passes writing it) alive without anything reading it
+    void output(Resource resource);
+
+    // passes with side effects outside the graph (readbacks, queries) are never culled
+    Pass addPass(const char* name, Execute execute, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE, bool sideEffects = false);
+
+    void read(Pass pass, Resource resource, Usage usage);
+    void write(Pass pass, Resource resource, Usage usage);
+
+    // like write(), but attachments are cleared first instead of loaded
+    void clear(Pass pass, Resource resource, Usage usage, VkClearValue value);
+
+    VkResult compile(uint64_t frame);
+    void execute(VkCommandBuffer cmdBuffer) const;
+
+    [[nodiscard]] VkImage image(Resource resource) const;
+    [[nodiscard]] VkImageView view(Resource resource) const;
+    [[nodiscard]] const Stats& stats() const;
+
+    // a render pass compatible with a pass writing these, for building pipelines against
+    VkRenderPass compatibleRenderPass(VkFormat color, VkFormat depth = VK_FORMAT_UNDEFINED);
+
+    // framebuffers pointing at images about to go away (a replaced swapchain) are destroyed
+    // once the frames before frame are done with them
+    void retireFramebuffers(uint64_t frame);
+};
+
+#endif
\ No newline at end of file
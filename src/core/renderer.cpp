@@ -2,6 +2,7 @@
 
 #ifdef HAS_VULKAN
 
+#include <algorithm>
 #include <cstring>
 #include <map>
 #include <vector>
@@ -10,7 +11,23 @@
 #include "helpers/vkVLayers.h"
 #include "helpers/vkDevice.h"
 #include "helpers/vkIndices.h"
+#include "helpers/vkPipelineCache.h"
+#include "allocator.h"
+#include "staging.h"
+#include "transfer.h"
+#include "textures.h"
+#include "recorder.h"
+#include "culling.h"
+#include "jobs.h"
+#include "mesh.h"
+#include "renderGraph.h"
+#include "gpuProfiler.h"
+#include "profiler.h"
 #include "game.h"
+#include "loaders/loaders.h"
+
+// below this many draws per slice, recording inline beats the handoff
+static constexpr uint32_t MIN_DRAWS_PER_SLICE = 256;
 
 VkResult tryMacFix(
     VkInstanceCreateInfo vkCreateInfo,
@@ -42,6 +59,10 @@ VkResult tryMacFix(
 Engine::Renderer::Renderer(Game* game)
 {
     this->game = game;
+
+    // a frustum of zero planes has everything inside it
+    this->culling = new CullList();
+    this->frustum = new Frustum();
 }
 
 VkResult Engine::Renderer::createInstance(
@@ -50,6 +71,7 @@ VkResult Engine::Renderer::createInstance(
 {
     VkInstanceCreateInfo vkCreateInfo{};
     const VkApplicationInfo vkAppInfo = this->game->getVkInfo();
+    this->vkApiVersion = vkAppInfo.apiVersion;
 
     vkCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     vkCreateInfo.pApplicationInfo = &vkAppInfo;
@@ -108,6 +130,12 @@ VkResult Engine::Renderer::createDevice(VkSurfaceKHR surface)
     }
 
     auto familyIndices = vkQueueIndices(physDevice->second, surface);
+
+    // single queue devices (and old drivers) just upload on the graphics queue
+    if (!this->asyncTransfer || !vkSupportsTimelineSemaphores(physDevice->second, this->vkApiVersion))
+    {
+        familyIndices.transferFamily.reset();
+    }
     std::vector<VkDeviceQueueCreateInfo> qCreateInfos;
     float qPriority = 1.0f;
 
@@ -123,14 +151,59 @@ VkResult Engine::Renderer::createDevice(VkSurfaceKHR surface)
     }
 
     VkPhysicalDeviceFeatures features{};
+    VkPhysicalDeviceFeatures supported;
+    vkGetPhysicalDeviceFeatures(physDevice->second, &supported);
+
+    // textures ask for it through SamplerDesc, capped to what the device does
+    features.samplerAnisotropy = supported.samplerAnisotropy;
+
+#ifdef ENABLE_PROFILING
+    features.pipelineStatisticsQuery = supported.pipelineStatisticsQuery;
+    features.inheritedQueries = supported.pipelineStatisticsQuery ? supported.inheritedQueries : VK_FALSE;
+    this->inheritedQueries = features.inheritedQueries;
+#endif
+
+    VkPhysicalDeviceVulkan12Features features12{};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features12.timelineSemaphore = VK_TRUE;
+    std::vector<const char*> extensions = vkRequiredDeviceExtensions(surface == VK_NULL_HANDLE);
+
+    // passes render straight into image views when they can, no render passes or framebuffers to keep around
+    const VkDynamicRendering dynamicRenderingSupport = this->dynamicRendering
+        ? vkSupportsDynamicRendering(physDevice->second, this->vkApiVersion)
+        : VkDynamicRendering::UNSUPPORTED;
+
+    VkPhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeatures{};
+    dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+    dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+
+    // only the feature structs that are actually enabled go in the chain
+    void* featureChain = nullptr;
+
+    if (familyIndices.transferFamily.has_value())
+    {
+        featureChain = &features12;
+    }
+
+    if (dynamicRenderingSupport != VkDynamicRendering::UNSUPPORTED)
+    {
+        dynamicRenderingFeatures.pNext = featureChain;
+        featureChain = &dynamicRenderingFeatures;
+    }
+
+    if (dynamicRenderingSupport == VkDynamicRendering::EXTENSION)
+    {
+        extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+    }
 
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     createInfo.pQueueCreateInfos = qCreateInfos.data();
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(qCreateInfos.size());
     createInfo.pEnabledFeatures = &features;
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(VK_DEVICE_EXTENSIONS.size());
-    createInfo.ppEnabledExtensionNames = VK_DEVICE_EXTENSIONS.data();
+    createInfo.pNext = featureChain;
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
     createInfo.enabledLayerCount = 0; // device-level layers are deprecated
 
     VkResult devCreateResult = vkCreateDevice(physDevice->second, &createInfo, nullptr, &this->vkDev);
@@ -141,13 +214,19 @@ VkResult Engine::Renderer::createDevice(VkSurfaceKHR surface)
     }
 
     vkGetDeviceQueue(this->vkDev, familyIndices.graphicsFamily.value(), 0, &this->vkGraphicsQueue);
-    vkGetDeviceQueue(this->vkDev, familyIndices.presentFamily.value(), 0, &this->vkPresentQueue);
+
+    if (familyIndices.presentFamily.has_value())
+    {
+        vkGetDeviceQueue(this->vkDev, familyIndices.presentFamily.value(), 0, &this->vkPresentQueue);
+    }
 
     this->vkPhysDev = physDevice->second;
     this->vkSurface = surface;
+    this->allocator = new Allocator(this->vkPhysDev, this->vkDev);
 
     VkCommandPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
     poolInfo.queueFamilyIndex = familyIndices.graphicsFamily.value();
 
     VkResult cmdPoolResult = vkCreateCommandPool(this->vkDev, &poolInfo, nullptr, &this->vkCmdPool);
@@ -157,18 +236,157 @@ VkResult Engine::Renderer::createDevice(VkSurfaceKHR surface)
         return cmdPoolResult;
     }
 
+    if (this->framesInFlight == 0)
+    {
+        this->framesInFlight = 1;
+    }
+
+    this->graph = new RenderGraph();
+    this->graph->create(this->vkDev, this->allocator, this->framesInFlight);
+
+    if (dynamicRenderingSupport != VkDynamicRendering::UNSUPPORTED)
+    {
+        const bool core = dynamicRenderingSupport == VkDynamicRendering::CORE;
+
+        const auto beginRendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(
+            vkGetDeviceProcAddr(this->vkDev, core ? "vkCmdBeginRendering" : "vkCmdBeginRenderingKHR"));
+        const auto endRendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(
+            vkGetDeviceProcAddr(this->vkDev, core ? "vkCmdEndRendering" : "vkCmdEndRenderingKHR"));
+
+        if (beginRendering != nullptr && endRendering != nullptr)
+        {
+            this->graph->useDynamicRendering(beginRendering, endRendering);
+        }
+    }
+
+    this->vkCmdBuffers.resize(this->framesInFlight);
+
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     allocInfo.commandPool = this->vkCmdPool;
-    allocInfo.commandBufferCount = 1;
+    allocInfo.commandBufferCount = this->framesInFlight;
     allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 
-    return vkAllocateCommandBuffers(this->vkDev, &allocInfo, &this->vkCmdBuffer);
+    VkResult cmdBufferResult = vkAllocateCommandBuffers(this->vkDev, &allocInfo, this->vkCmdBuffers.data());
+
+    if (cmdBufferResult != VK_SUCCESS)
+    {
+        return cmdBufferResult;
+    }
+
+    VkResult syncObjsResult = this->createSyncObjects();
+
+    if (syncObjsResult != VK_SUCCESS)
+    {
+        return syncObjsResult;
+    }
+
+    VkResult stagingResult;
+
+    if (familyIndices.transferFamily.has_value())
+    {
+        VkQueue transferQueue;
+        vkGetDeviceQueue(this->vkDev, familyIndices.transferFamily.value(), 0, &transferQueue);
+
+        this->transfer = new TransferQueue();
+        stagingResult = this->transfer->create(
+            this->vkDev,
+            this->allocator,
+            transferQueue,
+            familyIndices.transferFamily.value(),
+            familyIndices.graphicsFamily.value(),
+            this->stagingSize,
+            this->framesInFlight);
+    } else
+    {
+        this->staging = new StagingRing();
+        stagingResult = this->staging->create(this->allocator, this->stagingSize, this->framesInFlight);
+    }
+
+    if (stagingResult != VK_SUCCESS)
+    {
+        return stagingResult;
+    }
+
+    // pipeline compiles need a thread besides this one even without parallel recording
+    if (this->jobs == nullptr)
+    {
+        this->jobs = new JobSystem(std::max(this->recordThreads, 2u));
+        this->ownsJobs = true;
+    }
+
+    if (this->recordThreads > 1)
+    {
+        this->recorder = new CommandRecorder();
+
+        const VkResult recorderResult = this->recorder->create(
+            this->vkDev,
+            this->jobs,
+            familyIndices.graphicsFamily.value(),
+            this->recordThreads,
+            this->framesInFlight);
+
+        if (recorderResult != VK_SUCCESS)
+        {
+            return recorderResult;
+        }
+    }
+
+#ifdef ENABLE_PROFILING
+    this->profiler = new GpuProfiler();
+
+    const VkResult profilerResult = this->profiler->create(
+        this->vkPhysDev,
+        this->vkDev,
+        familyIndices.graphicsFamily.value(),
+        this->framesInFlight,
+        features.pipelineStatisticsQuery);
+
+    if (profilerResult != VK_SUCCESS)
+    {
+        return profilerResult;
+    }
+
+    this->graph->profiler = this->profiler;
+#endif
+
+    const VkResult cacheResult = vkLoadPipelineCache(this->vkDev, this->vkPhysDev, this->pipelineCachePath, &this->vkPipelineCache);
+
+    if (cacheResult != VK_SUCCESS)
+    {
+        return cacheResult;
+    }
+
+    this->layouts = new LayoutCache();
+    this->layouts->create(this->vkDev);
+
+    this->pipelines = new PipelineCache();
+    const VkResult pipelinesResult = this->pipelines->create(this->vkDev, this->vkPipelineCache, this->jobs, this->graph);
+
+    if (pipelinesResult != VK_SUCCESS)
+    {
+        return pipelinesResult;
+    }
+
+    this->shaders = new ShaderLibrary();
+    this->shaders->create(this->vkDev, this->pipelines, this->layouts);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(this->vkPhysDev, &properties);
+
+    this->textures = new TextureStreamer();
+
+    return this->textures->create(
+        this->vkDev,
+        this->allocator,
+        features.samplerAnisotropy ? properties.limits.maxSamplerAnisotropy : 0.0f,
+        this->textureStagingSize,
+        this->framesInFlight);
 }
 
 VkResult Engine::Renderer::createSwapchain(const uint32_t width, const uint32_t height)
 {
-    if (this->vkInst == VK_NULL_HANDLE || this->vkDev == VK_NULL_HANDLE)
+    if (this->vkInst == VK_NULL_HANDLE || this->vkDev == VK_NULL_HANDLE || this->headless())
     {
         return VK_ERROR_UNKNOWN;
     }
@@ -194,319 +412,402 @@ VkResult Engine::Renderer::createSwapchain(const uint32_t width, const uint32_t
     createInfo.clipped = VK_TRUE;
 
     createInfo.imageExtent = {width, height};
+    this->requestedExtent = createInfo.imageExtent;
 
     VkSwapChainDetails swapChainDetails = vkQuerySwapchain(this->vkPhysDev, this->vkSurface);
     vkSetupSwapchainCreateInfo(this, createInfo, swapChainDetails);
 
-    // TODO: resizing;
-    // "This is a complex topic that we'll learn more about in a future chapter.
-    // For now we'll assume that we'll only ever create one swap chain."
-    //      - vulkan-tutorial.com
-    createInfo.oldSwapchain = VK_NULL_HANDLE;
+    // minimised windows report a zero extent, try again once they come back
+    if (createInfo.imageExtent.width == 0 || createInfo.imageExtent.height == 0)
+    {
+        return VK_NOT_READY;
+    }
 
-    this->vkFormat = createInfo.imageFormat;
-    this->vkExtent = createInfo.imageExtent;
+    // lets the driver reuse the old swapchain's resources, and keeps
+    // its already queued presents valid while we switch over
+    createInfo.oldSwapchain = this->vkSwapchain;
 
-    VkResult result = vkCreateSwapchainKHR(this->vkDev, &createInfo, nullptr, &this->vkSwapchain);
+    VkSwapchainKHR swapchain;
+    VkResult result = vkCreateSwapchainKHR(this->vkDev, &createInfo, nullptr, &swapchain);
 
-    if (result == VK_SUCCESS)
+    if (result != VK_SUCCESS)
     {
-        vkGetSwapchainImages(this->vkDev, this->vkSwapchain, &this->vkImages);
-        return this->createImageViews();
+        return result;
     }
 
-    return result;
-}
+    this->retireSwapchain();
 
-VkResult Engine::Renderer::createImageViews()
-{
-    // I'm kinda lost atp, but trust the process
-    // will move into 3D later
+    this->vkSwapchain = swapchain;
+    this->vkFormat = createInfo.imageFormat;
+    this->vkExtent = createInfo.imageExtent;
+    this->swapchainDirty = false;
 
-    // to past self ^^: you had no clue what you were
-    // talking about, didn't you?
+    vkGetSwapchainImages(this->vkDev, this->vkSwapchain, &this->vkImages);
+    this->imagesInFlight.assign(this->vkImages.size(), VK_NULL_HANDLE);
 
-    this->vkImageViews.resize(this->vkImages.size());
-    uint32_t i = 0;
+    // one per image rather than per frame, a present may still be waiting on
+    // one when the same frame slot comes around again with another image
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    for (const auto& image : this->vkImages)
-    {
-        VkImageViewCreateInfo createInfo{};
-        createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        createInfo.image = image;
+    this->renderFinishedSemaphores.resize(this->vkImages.size(), VK_NULL_HANDLE);
 
-        createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        createInfo.format = this->vkFormat;
+    for (auto& semaphore : this->renderFinishedSemaphores)
+    {
+        result = vkCreateSemaphore(this->vkDev, &semaphoreInfo, nullptr, &semaphore);
 
-        createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-        createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-        createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-        createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+        if (result != VK_SUCCESS)
+        {
+            return result;
+        }
+    }
 
-        createInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        createInfo.subresourceRange.baseMipLevel = 0;
-        createInfo.subresourceRange.levelCount = 1;
-        createInfo.subresourceRange.baseArrayLayer = 0;
+    return this->createImageViews();
+}
 
-        VkResult result = vkCreateImageView(this->vkDev, &createInfo, nullptr, &this->vkImageViews[i]);
+void Engine::Renderer::resize(const uint32_t width, const uint32_t height)
+{
+    this->requestedExtent = {width, height};
+    this->swapchainDirty = true;
+}
 
-        if (result != VK_SUCCESS) return result;
-        i++;
+void Engine::Renderer::retireSwapchain()
+{
+    if (this->vkSwapchain == VK_NULL_HANDLE)
+    {
+        return;
     }
 
-    return VK_SUCCESS;
+    RetiredSwapchain retired{};
+    retired.swapchain = this->vkSwapchain;
+    retired.imageViews = std::move(this->vkImageViews);
+    retired.semaphores = std::move(this->renderFinishedSemaphores);
+    retired.retiredAt = this->frameCount;
+
+    this->retiredSwapchains.push_back(std::move(retired));
+    this->graph->retireFramebuffers(this->frameCount);
+
+    this->vkSwapchain = VK_NULL_HANDLE;
+    this->vkImageViews.resize(0);
+    this->renderFinishedSemaphores.resize(0);
 }
 
-VkResult Engine::Renderer::createRenderPass()
+void Engine::Renderer::destroyRetiredSwapchains(const bool all)
 {
-    VkAttachmentDescription colorAttachment{};
-    colorAttachment.format = this->vkFormat;
-    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    auto retired = this->retiredSwapchains.begin();
+
+    while (retired != this->retiredSwapchains.end())
+    {
+        // every frame submitted before the swap has had its fence waited on
+        // by now, one extra frame covers the present queued behind the last one
+        if (!all && this->frameCount < retired->retiredAt + this->framesInFlight)
+        {
+            ++retired;
+            continue;
+        }
+
+        for (const auto& imageView : retired->imageViews)
+        {
+            vkDestroyImageView(this->vkDev, imageView, nullptr);
+        }
 
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        for (const auto& semaphore : retired->semaphores)
+        {
+            vkDestroySemaphore(this->vkDev, semaphore, nullptr);
+        }
 
-    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        vkDestroySwapchainKHR(this->vkDev, retired->swapchain, nullptr);
+        retired = this->retiredSwapchains.erase(retired);
+    }
+}
 
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+VkResult Engine::Renderer::createOffscreen(const uint32_t width, const uint32_t height)
+{
+    if (this->vkDev == VK_NULL_HANDLE || !this->headless())
+    {
+        return VK_ERROR_UNKNOWN;
+    }
 
-    VkAttachmentReference attachmentRef{};
-    attachmentRef.attachment = 0;
-    attachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    this->vkFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    this->vkExtent = {width, height};
 
-    VkSubpassDescription subpass{};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &attachmentRef;
+    // one target per frame in flight, so no frame waits on another's image
+    this->vkImages.resize(this->framesInFlight, VK_NULL_HANDLE);
+    this->offscreenAllocations.resize(this->framesInFlight);
 
-    VkRenderPassCreateInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount = 1;
-    renderPassInfo.pAttachments = &colorAttachment;
-    renderPassInfo.subpassCount = 1;
-    renderPassInfo.pSubpasses = &subpass;
+    for (uint32_t i = 0; i < this->framesInFlight; i++)
+    {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = this->vkFormat;
+        imageInfo.extent = {width, height, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        VkResult result = this->allocator->createImage(
+            imageInfo,
+            0,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            &this->vkImages[i],
+            &this->offscreenAllocations[i]);
 
-    VkSubpassDependency dependency{};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
+        if (result != VK_SUCCESS)
+        {
+            return result;
+        }
+    }
 
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.srcAccessMask = 0;
+    this->imagesInFlight.assign(this->vkImages.size(), VK_NULL_HANDLE);
 
-    // i'm actually so fucking lost rn
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    VkResult result = this->createImageViews();
 
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &dependency;
+    if (result != VK_SUCCESS || !this->readback)
+    {
+        return result;
+    }
 
-    return vkCreateRenderPass(this->vkDev, &renderPassInfo, nullptr, &this->vkRenderPass);
+    return this->createReadbackBuffers();
 }
 
-VkResult Engine::Renderer::createFramebuffers()
+VkResult Engine::Renderer::createReadbackBuffers()
 {
-    this->vkFramebuffers.resize(this->vkImageViews.size());
+    const VkDeviceSize size = static_cast<VkDeviceSize>(this->vkExtent.width) * this->vkExtent.height * 4;
 
-    uint32_t i = 0;
-    for (const auto& imageView : this->vkImageViews)
-    {
-        VkFramebufferCreateInfo framebufferInfo{};
-        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebufferInfo.renderPass = this->vkRenderPass;
-        framebufferInfo.attachmentCount = 1;
-        framebufferInfo.pAttachments = &imageView;
-        framebufferInfo.width = this->vkExtent.width;
-        framebufferInfo.height = this->vkExtent.height;
-        framebufferInfo.layers = 1;
+    this->vkReadbackBuffers.resize(this->framesInFlight, VK_NULL_HANDLE);
+    this->readbackAllocations.resize(this->framesInFlight);
 
-        VkResult result = vkCreateFramebuffer(this->vkDev, &framebufferInfo, nullptr, &this->vkFramebuffers[i]);
+    for (uint32_t i = 0; i < this->framesInFlight; i++)
+    {
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        // cached memory makes the CPU-side copy out a lot cheaper
+        VkResult result = this->allocator->createBuffer(
+            bufferInfo,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+            &this->vkReadbackBuffers[i],
+            &this->readbackAllocations[i]);
 
         if (result != VK_SUCCESS)
         {
             return result;
         }
-
-        i++;
     }
 
     return VK_SUCCESS;
 }
 
-VkResult Engine::Renderer::createSyncObjects()
+VkResult Engine::Renderer::readPixels(std::vector<char>* pixels)
 {
-    VkSemaphoreCreateInfo semaphoreInfo{};
-    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    if (this->readbackAllocations.empty())
+    {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
 
-    VkResult result;
+    // only stalls if the last submitted frame hasn't finished yet
+    VkResult result = vkWaitForFences(this->vkDev, 1, &this->inFlightFences[this->lastFrame], VK_TRUE, UINT64_MAX);
 
-    if (
-        (result = vkCreateSemaphore(this->vkDev, &semaphoreInfo, nullptr, &this->imageAvailableSemaphore)) != VK_SUCCESS ||
-        (result = vkCreateSemaphore(this->vkDev, &semaphoreInfo, nullptr, &this->renderFinishedSemaphore)) != VK_SUCCESS ||
-        (result = vkCreateFence(this->vkDev, &fenceInfo, nullptr, &this->inFlightFence)) != VK_SUCCESS)
+    if (result != VK_SUCCESS)
     {
         return result;
     }
 
+    const size_t size = static_cast<size_t>(this->vkExtent.width) * this->vkExtent.height * 4;
+    pixels->resize(size);
 
+    memcpy(pixels->data(), this->readbackAllocations[this->lastFrame].mapped, size);
     return VK_SUCCESS;
 }
 
-VkResult Engine::Renderer::createRenderPipeline(std::vector<VkPipelineShaderStageCreateInfo> shaders)
+bool Engine::Renderer::headless() const
 {
-    // TODO: revisit & configure
+    return this->vkSurface == VK_NULL_HANDLE;
+}
+
+VkFormat Engine::Renderer::targetFormat() const
+{
+    return this->vkFormat;
+}
 
-    VkPipelineVertexInputStateCreateInfo vertexInfo{};
-    vertexInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInfo.vertexBindingDescriptionCount = 0;
-    vertexInfo.vertexAttributeDescriptionCount = 0;
+bool Engine::Renderer::usesDynamicRendering() const
+{
+    return this->graph != nullptr && this->graph->dynamicRendering();
+}
 
-    VkPipelineInputAssemblyStateCreateInfo assembly{};
-    assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    assembly.primitiveRestartEnable = VK_FALSE;
+VkResult Engine::Renderer::createImageViews()
+{
+    // I'm kinda lost atp, but trust the process
+    // will move into 3D later
 
-    std::vector dynStates = {
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_SCISSOR
-    };
+    // to past self ^^: you had no clue what you were
+    // talking about, didn't you?
 
-    VkPipelineDynamicStateCreateInfo dynState{};
-    dynState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynState.dynamicStateCount = static_cast<uint32_t>(dynStates.size());
-    dynState.pDynamicStates = dynStates.data();
+    this->vkImageViews.resize(this->vkImages.size());
+    uint32_t i = 0;
 
-    VkPipelineViewportStateCreateInfo viewportState{};
-    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportState.pViewports = &this->vkViewport;
-    viewportState.viewportCount = 1;
-    viewportState.pScissors = &this->vkScissor;
-    viewportState.scissorCount = 1;
+    for (const auto& image : this->vkImages)
+    {
+        VkImageViewCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        createInfo.image = image;
 
-    VkPipelineRasterizationStateCreateInfo rasterizer{};
+        createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        createInfo.format = this->vkFormat;
 
-    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterizer.lineWidth = 1.0f;
+        createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
 
-    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+        createInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        createInfo.subresourceRange.baseMipLevel = 0;
+        createInfo.subresourceRange.levelCount = 1;
+        createInfo.subresourceRange.baseArrayLayer = 0;
+        createInfo.subresourceRange.layerCount = 1;
 
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.depthBiasEnable = VK_FALSE;
+        VkResult result = vkCreateImageView(this->vkDev, &createInfo, nullptr, &this->vkImageViews[i]);
 
-    rasterizer.depthBiasConstantFactor = 0.0f;
-    rasterizer.depthBiasClamp = 0.0f;
-    rasterizer.depthBiasSlopeFactor = 0.0f;
+        if (result != VK_SUCCESS) return result;
+        i++;
+    }
 
-    VkPipelineMultisampleStateCreateInfo multisampling{};
-    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    return VK_SUCCESS;
+}
 
-    VkPipelineColorBlendAttachmentState blendAttachment{};
-    blendAttachment.colorWriteMask =
-        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    blendAttachment.blendEnable = VK_TRUE;
-    blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-    blendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-    blendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-    blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    blendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+VkResult Engine::Renderer::createSyncObjects()
+{
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    VkPipelineColorBlendStateCreateInfo colorBlending{};
-    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colorBlending.logicOpEnable = VK_FALSE;
-    colorBlending.attachmentCount = 1;
-    colorBlending.pAttachments = &blendAttachment;
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-    VkPipelineLayoutCreateInfo layoutInfo{};
-    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    this->imageAvailableSemaphores.resize(this->framesInFlight, VK_NULL_HANDLE);
+    this->inFlightFences.resize(this->framesInFlight, VK_NULL_HANDLE);
 
-    VkResult layoutResult = vkCreatePipelineLayout(this->vkDev, &layoutInfo, nullptr, &this->vkLayout);
-    VkResult renderPassResult = this->createRenderPass();
+    VkResult result;
 
-    if (layoutResult != VK_SUCCESS)
+    for (uint32_t i = 0; i < this->framesInFlight; i++)
     {
-        return layoutResult;
+        if (
+            (result = vkCreateSemaphore(this->vkDev, &semaphoreInfo, nullptr, &this->imageAvailableSemaphores[i])) != VK_SUCCESS ||
+            (result = vkCreateFence(this->vkDev, &fenceInfo, nullptr, &this->inFlightFences[i])) != VK_SUCCESS)
+        {
+            return result;
+        }
     }
 
-    if (renderPassResult != VK_SUCCESS)
-    {
-        return renderPassResult;
-    }
+    return VK_SUCCESS;
+}
 
-    VkResult fbResult = this->createFramebuffers();
+VkResult Engine::Renderer::createRenderPipeline(
+    std::vector<VkPipelineShaderStageCreateInfo> shaders,
+    const VertexLayout& layout,
+    VkPipelineLayout pipelineLayout)
+{
+    // built right away, it's what everything else falls back to
+    PipelineDesc desc;
+    desc.vertexLayout = layout;
+    desc.colorFormat = this->vkFormat;
+    desc.layout = pipelineLayout;
 
-    if (fbResult != VK_SUCCESS)
+    for (const auto& shader : shaders)
     {
-        return fbResult;
+        desc.shaders.push_back({shader.stage, shader.module, shader.pName});
     }
 
-    VkResult syncObjsResult = this->createSyncObjects();
+    return this->pipelines->get(desc, &this->vkPipeline);
+}
 
-    if (syncObjsResult != VK_SUCCESS)
+void Engine::Renderer::recordDraws(VkCommandBuffer cmdBuffer, const uint32_t first, const uint32_t last)
+{
+    // secondary buffers don't inherit any state
+    vkCmdSetViewport(cmdBuffer, 0, 1, &this->vkViewport);
+    vkCmdSetScissor(cmdBuffer, 0, 1, &this->vkScissor);
+
+    VkPipeline bound = VK_NULL_HANDLE;
+
+    for (uint32_t i = first; i < last; i++)
     {
-        return syncObjsResult;
-    }
+        const Mesh* mesh = this->visibleDraws[i].mesh;
+        const VkPipeline pipeline = this->visibleDraws[i].pipeline != VK_NULL_HANDLE ? this->visibleDraws[i].pipeline : this->vkPipeline;
+
+        if (pipeline != bound)
+        {
+            vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            bound = pipeline;
+        }
 
-    VkGraphicsPipelineCreateInfo pipelineInfo{};
-    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        // still on its way, draw it once it's there rather than stall the frame
+        if (mesh->uploadValue > this->transferValue)
+        {
+            continue;
+        }
 
-    pipelineInfo.stageCount = static_cast<uint32_t>(shaders.size());
-    pipelineInfo.pStages = shaders.data();
+        if (mesh->vertexBuffer == VK_NULL_HANDLE)
+        {
+            vkCmdDraw(cmdBuffer, mesh->vertexCount, 1, 0, 0);
+            continue;
+        }
 
-    pipelineInfo.pVertexInputState = &vertexInfo;
-    pipelineInfo.pInputAssemblyState = &assembly;
-    pipelineInfo.pViewportState = &viewportState;
-    pipelineInfo.pRasterizationState = &rasterizer;
-    pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pDepthStencilState = nullptr;
-    pipelineInfo.pColorBlendState = &colorBlending;
-    pipelineInfo.pDynamicState = &dynState;
+        constexpr VkDeviceSize offset = 0;
+        vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &mesh->vertexBuffer, &offset);
 
-    return vkCreateGraphicsPipelines(
-        this->vkDev,
-        VK_NULL_HANDLE,
-        1,
-        &pipelineInfo,
-        nullptr,
-        &this->vkPipeline);
+        if (mesh->indexBuffer == VK_NULL_HANDLE)
+        {
+            vkCmdDraw(cmdBuffer, mesh->vertexCount, 1, 0, 0);
+            continue;
+        }
+
+        vkCmdBindIndexBuffer(cmdBuffer, mesh->indexBuffer, 0, mesh->indexType);
+        vkCmdDrawIndexed(cmdBuffer, mesh->indexCount, 1, 0, 0, 0);
+    }
 }
 
-VkResult Engine::Renderer::recordCommandBuffer(uint32_t imageIndex)
+VkResult Engine::Renderer::recordCommandBuffer(VkCommandBuffer cmdBuffer, uint32_t imageIndex)
 {
     VkCommandBufferBeginInfo bufBeginInfo{};
     bufBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
-    VkResult result = vkBeginCommandBuffer(this->vkCmdBuffer, &bufBeginInfo);
+    VkResult result = vkBeginCommandBuffer(cmdBuffer, &bufBeginInfo);
 
     if (result != VK_SUCCESS)
     {
         return result;
     }
 
-    VkRenderPassBeginInfo passBeginInfo{};
-    passBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    passBeginInfo.framebuffer = this->vkFramebuffers[imageIndex];
-    passBeginInfo.renderPass = this->vkRenderPass;
+#ifdef ENABLE_PROFILING
+    this->profiler->beginFrame(cmdBuffer, this->currentFrame, this->frameCount);
+    this->profiler->begin(cmdBuffer, "frame");
+    this->profiler->begin(cmdBuffer, "uploads");
+#endif
 
-    passBeginInfo.renderArea.offset = {0, 0};
-    passBeginInfo.renderArea.extent = this->vkExtent;
+    // uploads ride along with the frame instead of getting their own submit,
+    // or were copied on the transfer queue and just need to change hands
+    if (this->transfer != nullptr)
+    {
+        this->transferValue = this->transfer->acquire(cmdBuffer);
+    } else
+    {
+        this->staging->record(cmdBuffer, this->currentFrame);
+    }
 
-    constexpr VkClearValue clearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
-    passBeginInfo.clearValueCount = 1;
-    passBeginInfo.pClearValues = &clearColor;
+    this->textures->record(cmdBuffer, this->currentFrame, this->frameCount);
 
-    vkCmdBeginRenderPass(this->vkCmdBuffer, &passBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-    vkCmdBindPipeline(this->vkCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->vkPipeline);
+#ifdef ENABLE_PROFILING
+    this->profiler->end(cmdBuffer);
+#endif
 
     this->vkViewport.x = 0.0f;
     this->vkViewport.y = 0.0f;
@@ -517,88 +818,654 @@ VkResult Engine::Renderer::recordCommandBuffer(uint32_t imageIndex)
     this->vkViewport.minDepth = 0.0f;
     this->vkViewport.maxDepth = 1.0f;
 
-    vkCmdSetViewport(this->vkCmdBuffer, 0, 1, &this->vkViewport);
-
     this->vkScissor.offset = {0, 0};
     this->vkScissor.extent = this->vkExtent;
 
-    vkCmdSetScissor(this->vkCmdBuffer, 0, 1, &this->vkScissor);
+    // not worth handing out jobs for a handful of draws
+    const auto nDraws = static_cast<uint32_t>(this->visibleDraws.size());
+    const bool parallel = this->recorder != nullptr && nDraws >= this->recorder->size() * MIN_DRAWS_PER_SLICE;
+
+    this->graph->reset();
+
+    // swapchain images become usable once the acquire semaphore (waited at colour output) is signalled,
+    // headless targets belong to this frame slot and were fenced along with it
+    const RenderGraph::Resource target = this->graph->importImage(
+        "target",
+        this->vkImages[imageIndex],
+        this->vkImageViews[imageIndex],
+        this->vkFormat,
+        this->vkExtent,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        this->headless() ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        this->headless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+
+    VkResult passResult = VK_SUCCESS;
+
+    const RenderGraph::Pass mainPass = this->graph->addPass(
+        "main",
+        [&](const RenderGraph::PassContext& context)
+        {
+            if (!parallel)
+            {
+                this->recordDraws(context.cmdBuffer, 0, nDraws);
+                return;
+            }
+
+            const uint32_t perSlice = (nDraws + this->recorder->size() - 1) / this->recorder->size();
+            const std::vector<VkCommandBuffer>* secondaries;
+            VkQueryPipelineStatisticFlags statistics = 0;
+
+#ifdef ENABLE_PROFILING
+            if (this->inheritedQueries)
+            {
+                statistics = this->profiler->statistics();
+            }
+#endif
+
+            passResult = this->recorder->run(
+                this->currentFrame,
+                context.renderPass,
+                context.framebuffer,
+                context.rendering,
+                [&](const uint32_t slice, VkCommandBuffer secondary)
+                {
+                    const uint32_t first = std::min(slice * perSlice, nDraws);
+                    this->recordDraws(secondary, first, std::min(first + perSlice, nDraws));
+                },
+                &secondaries,
+                statistics);
+
+            if (passResult == VK_SUCCESS)
+            {
+                vkCmdExecuteCommands(context.cmdBuffer, static_cast<uint32_t>(secondaries->size()), secondaries->data());
+            }
+        },
+        parallel ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+
+    constexpr VkClearValue clearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+    this->graph->clear(mainPass, target, RenderGraph::COLOR_ATTACHMENT, clearColor);
 
-    // TODO: actually count vertices????????????
-    vkCmdDraw(this->vkCmdBuffer, 3, 1, 0, 0);
-    vkCmdEndRenderPass(this->vkCmdBuffer);
+    if (!this->vkReadbackBuffers.empty())
+    {
+        const RenderGraph::Pass readbackPass = this->graph->addPass(
+            "readback",
+            [&](const RenderGraph::PassContext& context)
+            {
+                VkBufferImageCopy region{};
+                region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                region.imageSubresource.layerCount = 1;
+                region.imageExtent = {this->vkExtent.width, this->vkExtent.height, 1};
+
+                VkBuffer readbackBuffer = this->vkReadbackBuffers[imageIndex];
+                vkCmdCopyImageToBuffer(context.cmdBuffer, context.graph->image(target), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &region);
+
+                // the graph only tracks images, the buffer is handed to the host here
+                VkBufferMemoryBarrier hostBarrier{};
+                hostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+                hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                hostBarrier.buffer = readbackBuffer;
+                hostBarrier.size = VK_WHOLE_SIZE;
+
+                vkCmdPipelineBarrier(
+                    context.cmdBuffer,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_PIPELINE_STAGE_HOST_BIT,
+                    0,
+                    0, nullptr,
+                    1, &hostBarrier,
+                    0, nullptr);
+            },
+            VK_SUBPASS_CONTENTS_INLINE,
+            true);
+
+        this->graph->read(readbackPass, target, RenderGraph::TRANSFER_SRC);
+    }
+
+    result = this->graph->compile(this->frameCount);
 
-    return vkEndCommandBuffer(this->vkCmdBuffer);
+    if (result == VK_SUCCESS)
+    {
+#ifdef ENABLE_PROFILING
+        // secondaries can't run inside a statistics query unless they inherit it
+        if (!parallel || this->inheritedQueries)
+        {
+            this->profiler->beginStatistics(cmdBuffer);
+        }
+#endif
+
+        this->graph->execute(cmdBuffer);
+
+#ifdef ENABLE_PROFILING
+        this->profiler->endStatistics(cmdBuffer);
+#endif
+
+        result = passResult;
+    }
+
+#ifdef ENABLE_PROFILING
+    this->profiler->endFrame(cmdBuffer);
+#endif
+
+    // ended even if something failed, so the buffer isn't left recording when it's next reset
+    const VkResult endResult = vkEndCommandBuffer(cmdBuffer);
+    return result != VK_SUCCESS ? result : endResult;
 }
 
 VkResult Engine::Renderer::render()
 {
-    vkWaitForFences(this->vkDev, 1, &this->inFlightFence, VK_TRUE, UINT64_MAX);
-    vkResetFences(this->vkDev, 1, &this->inFlightFence);
+    PROFILE_FRAME();
 
-    uint32_t imageIndex;
-    vkAcquireNextImageKHR(this->vkDev, this->vkSwapchain, UINT64_MAX, this->imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+    VkFence frameFence = this->inFlightFences[this->currentFrame];
+    VkCommandBuffer cmdBuffer = this->vkCmdBuffers[this->currentFrame];
 
-    vkResetCommandBuffer(this->vkCmdBuffer, 0);
-    this->recordCommandBuffer(imageIndex);
+    // only blocks once the GPU falls framesInFlight frames behind
+    {
+        PROFILE_ZONE("wait");
+        vkWaitForFences(this->vkDev, 1, &frameFence, VK_TRUE, UINT64_MAX);
+    }
+
+    if (this->transfer != nullptr)
+    {
+        const VkResult flushResult = this->transfer->flush();
+
+        if (flushResult != VK_SUCCESS)
+        {
+            return flushResult;
+        }
+    } else
+    {
+        this->staging->retire(this->currentFrame);
+    }
+
+    this->textures->retire(this->currentFrame, this->frameCount);
+    this->destroyRetiredMeshes(false);
+    this->shaders->poll();
+
+    if (!this->headless())
+    {
+        this->destroyRetiredSwapchains(false);
+
+        if (this->swapchainDirty)
+        {
+            const VkResult recreateResult = this->createSwapchain(this->requestedExtent.width, this->requestedExtent.height);
+
+            // minimised, skip the frame
+            if (recreateResult == VK_NOT_READY)
+            {
+                this->drawList.resize(0);
+                this->culling->clear();
+                return VK_SUCCESS;
+            }
+
+            if (recreateResult != VK_SUCCESS)
+            {
+                return recreateResult;
+            }
+        }
+    }
+
+    // headless targets are tied to their frame slot, nothing to acquire
+    uint32_t imageIndex = this->currentFrame;
+    VkResult result;
+
+    if (!this->headless())
+    {
+        PROFILE_ZONE("acquire");
+
+        result = vkAcquireNextImageKHR(
+            this->vkDev,
+            this->vkSwapchain,
+            UINT64_MAX,
+            this->imageAvailableSemaphores[this->currentFrame],
+            VK_NULL_HANDLE,
+            &imageIndex);
+
+        // the semaphore isn't signalled in this case, so the frame can just be dropped
+        if (result == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            this->swapchainDirty = true;
+            this->drawList.resize(0);
+            this->culling->clear();
+            return VK_SUCCESS;
+        }
+
+        if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+        {
+            return result;
+        }
+
+        // still presentable, finish this frame and recreate on the next one
+        if (result == VK_SUBOPTIMAL_KHR)
+        {
+            this->swapchainDirty = true;
+        }
+    }
+
+    // the swapchain can hand out images out of order, so an older
+    // frame may still be drawing into this one
+    if (this->imagesInFlight[imageIndex] != VK_NULL_HANDLE && this->imagesInFlight[imageIndex] != frameFence)
+    {
+        vkWaitForFences(this->vkDev, 1, &this->imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+    }
+
+    this->imagesInFlight[imageIndex] = frameFence;
+
+    {
+        PROFILE_ZONE("cull");
+        this->cull();
+    }
+
+    {
+        PROFILE_ZONE("record");
+
+        vkResetCommandBuffer(cmdBuffer, 0);
+        result = this->recordCommandBuffer(cmdBuffer, imageIndex);
+        this->drawList.resize(0);
+        this->visibleDraws.resize(0);
+        this->culling->clear();
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
+    VkSemaphore waitSemaphores[2];
+    VkPipelineStageFlags waitStages[2];
+    uint64_t waitValues[2] = {0, 0};
+    uint32_t nWaits = 0;
+
+    if (!this->headless())
+    {
+        waitSemaphores[nWaits] = this->imageAvailableSemaphores[this->currentFrame];
+        waitStages[nWaits++] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    }
+
+    // already signalled by the time the buffers were acquired, but the
+    // release has to be ordered before the acquire on the GPU as well
+    if (this->transfer != nullptr && this->transferValue > 0)
+    {
+        waitSemaphores[nWaits] = this->transfer->timeline;
+        waitValues[nWaits] = this->transferValue;
+        waitStages[nWaits++] = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+    }
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = nWaits;
+    timelineInfo.pWaitSemaphoreValues = waitValues;
 
     VkSubmitInfo submitInfo{};
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = this->transfer != nullptr ? &timelineInfo : nullptr;
 
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = &this->imageAvailableSemaphore;
+    submitInfo.waitSemaphoreCount = nWaits;
+    submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
 
     submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &this->vkCmdBuffer;
+    submitInfo.pCommandBuffers = &cmdBuffer;
 
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = &this->renderFinishedSemaphore;
+    // nobody would ever wait on it without a present
+    submitInfo.signalSemaphoreCount = this->headless() ? 0 : 1;
+    submitInfo.pSignalSemaphores = this->headless() ? nullptr : &this->renderFinishedSemaphores[imageIndex];
 
-    VkResult result = vkQueueSubmit(this->vkGraphicsQueue, 1, &submitInfo, this->inFlightFence);
+    // reset only once nothing can fail before the submit, otherwise the next wait deadlocks
+    vkResetFences(this->vkDev, 1, &frameFence);
+
+    {
+        PROFILE_ZONE("submit");
+        result = vkQueueSubmit(this->vkGraphicsQueue, 1, &submitInfo, frameFence);
+    }
 
     if (result != VK_SUCCESS)
     {
         return result;
     }
 
+    this->lastFrame = this->currentFrame;
+    this->frameCount++;
+
+    if (this->headless())
+    {
+        this->currentFrame = (this->currentFrame + 1) % this->framesInFlight;
+        return VK_SUCCESS;
+    }
+
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = &this->imageAvailableSemaphore;
+    presentInfo.pWaitSemaphores = &this->renderFinishedSemaphores[imageIndex];
 
     presentInfo.swapchainCount = 1;
     presentInfo.pSwapchains = &this->vkSwapchain;
     presentInfo.pImageIndices = &imageIndex;
 
-    return vkQueuePresentKHR(this->vkPresentQueue, &presentInfo);
+    this->currentFrame = (this->currentFrame + 1) % this->framesInFlight;
+
+    {
+        PROFILE_ZONE("present");
+        result = vkQueuePresentKHR(this->vkPresentQueue, &presentInfo);
+    }
+
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+    {
+        this->swapchainDirty = true;
+        return VK_SUCCESS;
+    }
+
+    return result;
+}
+
+const Engine::GpuFrameStats* Engine::Renderer::gpuStats() const
+{
+#ifdef ENABLE_PROFILING
+    return this->profiler != nullptr ? this->profiler->latest() : nullptr;
+#else
+    return nullptr;
+#endif
 }
 
+bool Engine::Renderer::exportGpuTrace(const char* filename) const
+{
+#ifdef ENABLE_PROFILING
+    return this->profiler != nullptr && this->profiler->exportTrace(filename);
+#else
+    (void)filename;
+    return false;
+#endif
+}
 
-void Engine::Renderer::cleanupSwapchain()
+VkResult Engine::Renderer::createMesh(
+    const void* vertices,
+    const uint32_t vertexCount,
+    const uint32_t vertexStride,
+    const uint32_t* indices,
+    const uint32_t indexCount,
+    Mesh* mesh)
 {
-    if (this->vkSwapchain != VK_NULL_HANDLE)
+    return this->createMesh(vertices, vertexCount, vertexStride, indices, indexCount, VK_INDEX_TYPE_UINT32, mesh);
+}
+
+VkResult Engine::Renderer::createMesh(
+    const void* vertices,
+    const uint32_t vertexCount,
+    const uint32_t vertexStride,
+    const void* indices,
+    const uint32_t indexCount,
+    const VkIndexType indexType,
+    Mesh* mesh)
+{
+    *mesh = Mesh{};
+    mesh->vertexCount = vertexCount;
+    mesh->indexCount = indexCount;
+    mesh->indexType = indexType;
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = static_cast<VkDeviceSize>(vertexCount) * vertexStride;
+    bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkResult result = this->allocator->createBuffer(
+        bufferInfo,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        0,
+        &mesh->vertexBuffer,
+        &mesh->vertexAllocation);
+
+    if (result == VK_SUCCESS)
+    {
+        result = this->upload(mesh->vertexBuffer, vertices, bufferInfo.size, &mesh->uploadValue);
+    }
+
+    if (result == VK_SUCCESS && indexCount > 0)
     {
-        if (this->vkRenderPass != VK_NULL_HANDLE)
+        bufferInfo.size = static_cast<VkDeviceSize>(indexCount) * (indexType == VK_INDEX_TYPE_UINT16 ? 2 : 4);
+        bufferInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+        result = this->allocator->createBuffer(
+            bufferInfo,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            0,
+            &mesh->indexBuffer,
+            &mesh->indexAllocation);
+
+        if (result == VK_SUCCESS)
         {
-            for (const auto& framebuffer : this->vkFramebuffers)
+            result = this->upload(mesh->indexBuffer, indices, bufferInfo.size, &mesh->uploadValue);
+        }
+    }
+
+    // a vertex upload may already be queued, so this has to wait like any other mesh
+    if (result != VK_SUCCESS)
+    {
+        this->destroyMesh(mesh);
+    }
+
+    return result;
+}
+
+VkResult Engine::Renderer::loadMesh(const std::string& path, Mesh* mesh, VertexLayout* pLayout)
+{
+    Loaders::Asset file;
+    Loaders::MeshInfo info;
+
+    if (!Loaders::resolve(path, &file))
+    {
+        return VK_ERROR_UNKNOWN;
+    }
+
+    if (!Loaders::parseMesh(file.data(), file.size(), &info))
+    {
+        return VK_ERROR_FORMAT_NOT_SUPPORTED;
+    }
+
+    const VkResult result = this->createMesh(
+        info.vertices,
+        info.vertexCount,
+        info.vertexStride,
+        info.indices,
+        info.indexCount,
+        info.indexSize == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32,
+        mesh);
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
+    memcpy(mesh->boundsMin, info.boundsMin, sizeof(info.boundsMin));
+    memcpy(mesh->boundsMax, info.boundsMax, sizeof(info.boundsMax));
+
+    if (pLayout != nullptr)
+    {
+        *pLayout = VertexLayout{};
+        pLayout->bindings.push_back({0, info.vertexStride, VK_VERTEX_INPUT_RATE_VERTEX});
+
+        for (uint32_t i = 0; i < info.attributeCount; i++)
+        {
+            const Loaders::MeshInfo::Attribute& attribute = info.attributes[i];
+            VkFormat format = VK_FORMAT_R16G16B16A16_UNORM;
+
+            if (attribute.format == Loaders::MeshInfo::FORMAT_SNORM8X4)
+            {
+                format = VK_FORMAT_R8G8B8A8_SNORM;
+            }
+            else if (attribute.format == Loaders::MeshInfo::FORMAT_FLOAT16X2)
             {
-                vkDestroyFramebuffer(this->vkDev, framebuffer, nullptr);
+                format = VK_FORMAT_R16G16_SFLOAT;
             }
 
-            this->vkFramebuffers.resize(0);
+            pLayout->attributes.push_back({attribute.location, 0, format, attribute.offset});
+        }
+    }
+
+    return VK_SUCCESS;
+}
+
+VkResult Engine::Renderer::upload(VkBuffer dst, const void* data, const VkDeviceSize size, uint64_t* pValue)
+{
+    if (this->transfer != nullptr)
+    {
+        return this->transfer->upload(dst, 0, data, size, pValue);
+    }
+
+    return this->staging->upload(dst, 0, data, size);
+}
+
+void Engine::Renderer::destroyMesh(Mesh* mesh)
+{
+    if (mesh->vertexBuffer != VK_NULL_HANDLE || mesh->indexBuffer != VK_NULL_HANDLE)
+    {
+        this->retiredMeshes.push_back({*mesh, this->frameCount});
+    }
+
+    *mesh = Mesh{};
+}
+
+void Engine::Renderer::destroyRetiredMeshes(const bool all)
+{
+    auto retired = this->retiredMeshes.begin();
+
+    while (retired != this->retiredMeshes.end())
+    {
+        // the acquire barrier naming its buffers goes into a frame that hasn't been recorded yet
+        if (!all && retired->mesh.uploadValue > this->transferValue)
+        {
+            retired->retiredAt = this->frameCount + 1;
+            ++retired;
+            continue;
+        }
+
+        if (!all && this->frameCount < retired->retiredAt + this->framesInFlight)
+        {
+            ++retired;
+            continue;
+        }
+
+        if (retired->mesh.vertexBuffer != VK_NULL_HANDLE)
+        {
+            this->allocator->destroyBuffer(retired->mesh.vertexBuffer, retired->mesh.vertexAllocation);
+        }
+
+        if (retired->mesh.indexBuffer != VK_NULL_HANDLE)
+        {
+            this->allocator->destroyBuffer(retired->mesh.indexBuffer, retired->mesh.indexAllocation);
+        }
+
+        retired = this->retiredMeshes.erase(retired);
+    }
+}
+
+void Engine::Renderer::draw(const Mesh* mesh, VkPipeline pipeline)
+{
+    this->drawList.push_back({mesh, pipeline, true});
+}
+
+void Engine::Renderer::draw(const Mesh* mesh, const Sphere& bounds, VkPipeline pipeline)
+{
+    this->culling->add(bounds, static_cast<uint32_t>(this->drawList.size()));
+    this->drawList.push_back({mesh, pipeline, false});
+}
+
+void Engine::Renderer::draw(const Mesh* mesh, const Aabb& bounds, VkPipeline pipeline)
+{
+    this->culling->add(bounds, static_cast<uint32_t>(this->drawList.size()));
+    this->drawList.push_back({mesh, pipeline, false});
+}
+
+void Engine::Renderer::setCamera(const Mat4& viewProjection)
+{
+    *this->frustum = Frustum::fromMatrix(viewProjection);
+}
+
+void Engine::Renderer::cull()
+{
+    // nothing to cull, everything gets recorded as it is
+    if (this->culling->size() == 0)
+    {
+        std::swap(this->visibleDraws, this->drawList);
+        return;
+    }
+
+    this->culling->cull(*this->frustum, &this->visibleIds, this->jobs);
+
+    for (const uint32_t id : this->visibleIds)
+    {
+        this->drawList[id].visible = true;
+    }
+
+    // in the order they were submitted, which is the order pipelines get bound in
+    this->visibleDraws.resize(0);
+
+    for (const Draw& draw : this->drawList)
+    {
+        if (draw.visible)
+        {
+            this->visibleDraws.push_back(draw);
         }
+    }
+}
+
+void Engine::Renderer::cleanupSwapchain()
+{
+    this->destroyRetiredSwapchains(true);
+
+    if (this->vkSwapchain != VK_NULL_HANDLE)
+    {
+        this->graph->retireFramebuffers(this->frameCount);
 
         for (const auto& imageView : this->vkImageViews)
         {
             vkDestroyImageView(this->vkDev, imageView, nullptr);
         }
 
+        for (const auto& semaphore : this->renderFinishedSemaphores)
+        {
+            vkDestroySemaphore(this->vkDev, semaphore, nullptr);
+        }
+
         vkDestroySwapchainKHR(this->vkDev, this->vkSwapchain, nullptr);
         this->vkSwapchain = VK_NULL_HANDLE;
         this->vkImageViews.resize(0);
+        this->renderFinishedSemaphores.resize(0);
+    }
+}
+
+void Engine::Renderer::cleanupOffscreen()
+{
+    for (uint32_t i = 0; i < this->vkReadbackBuffers.size(); i++)
+    {
+        this->allocator->destroyBuffer(this->vkReadbackBuffers[i], this->readbackAllocations[i]);
     }
+
+    this->vkReadbackBuffers.resize(0);
+    this->readbackAllocations.resize(0);
+
+    if (this->offscreenAllocations.empty())
+    {
+        return;
+    }
+
+    this->graph->retireFramebuffers(this->frameCount);
+
+    for (const auto& imageView : this->vkImageViews)
+    {
+        vkDestroyImageView(this->vkDev, imageView, nullptr);
+    }
+
+    for (uint32_t i = 0; i < this->vkImages.size(); i++)
+    {
+        this->allocator->destroyImage(this->vkImages[i], this->offscreenAllocations[i]);
+    }
+
+    this->vkImageViews.resize(0);
+    this->vkImages.resize(0);
+    this->offscreenAllocations.resize(0);
 }
 
 Engine::Renderer::~Renderer()
@@ -609,35 +1476,121 @@ Engine::Renderer::~Renderer()
     }
 
     this->cleanupSwapchain();
+    this->cleanupOffscreen();
 
-    if (this->inFlightFence != VK_NULL_HANDLE)
+    for (uint32_t i = 0; i < this->inFlightFences.size(); i++)
     {
-        vkDestroySemaphore(this->vkDev, this->imageAvailableSemaphore, nullptr);
-        vkDestroySemaphore(this->vkDev, this->renderFinishedSemaphore, nullptr);
-        vkDestroyFence(this->vkDev, this->inFlightFence, nullptr);
+        vkDestroySemaphore(this->vkDev, this->imageAvailableSemaphores[i], nullptr);
+        vkDestroyFence(this->vkDev, this->inFlightFences[i], nullptr);
+    }
+
+    this->imageAvailableSemaphores.resize(0);
+    this->inFlightFences.resize(0);
+    this->imagesInFlight.resize(0);
 
-        this->imageAvailableSemaphore = VK_NULL_HANDLE;
-        this->renderFinishedSemaphore = VK_NULL_HANDLE;
-        this->inFlightFence = VK_NULL_HANDLE;
+    if (this->shaders != nullptr)
+    {
+        this->shaders->destroy();
+        delete this->shaders;
+        this->shaders = nullptr;
     }
 
-    if (this->vkPipeline != VK_NULL_HANDLE)
+    if (this->textures != nullptr)
     {
-        vkDestroyPipeline(this->vkDev, this->vkPipeline, nullptr);
+        this->textures->destroy();
+        delete this->textures;
+        this->textures = nullptr;
+    }
+
+    // waits for compiles still running before the pipeline cache is saved
+    if (this->pipelines != nullptr)
+    {
+        this->pipelines->destroy();
+        delete this->pipelines;
+        this->pipelines = nullptr;
         this->vkPipeline = VK_NULL_HANDLE;
     }
 
-    if (this->vkLayout != VK_NULL_HANDLE)
+    if (this->layouts != nullptr)
+    {
+        this->layouts->destroy();
+        delete this->layouts;
+        this->layouts = nullptr;
+    }
+
+    if (this->graph != nullptr)
+    {
+        this->graph->destroy();
+        delete this->graph;
+        this->graph = nullptr;
+    }
+
+    if (this->vkPipelineCache != VK_NULL_HANDLE)
+    {
+        if (this->pipelineCachePath != nullptr)
+        {
+            vkSavePipelineCache(this->vkDev, this->vkPipelineCache, this->pipelineCachePath);
+        }
+
+        vkDestroyPipelineCache(this->vkDev, this->vkPipelineCache, nullptr);
+        this->vkPipelineCache = VK_NULL_HANDLE;
+    }
+
+    this->drawList.resize(0);
+    this->destroyRetiredMeshes(true);
+
+    delete this->culling;
+    this->culling = nullptr;
+
+    delete this->frustum;
+    this->frustum = nullptr;
+
+    if (this->recorder != nullptr)
     {
-        vkDestroyPipelineLayout(this->vkDev, this->vkLayout, nullptr);
-        this->vkLayout = VK_NULL_HANDLE;
+        this->recorder->destroy();
+        delete this->recorder;
+        this->recorder = nullptr;
     }
 
-    if (this->vkRenderPass != VK_NULL_HANDLE)
+#ifdef ENABLE_PROFILING
+    if (this->profiler != nullptr)
     {
-        vkDestroyRenderPass(this->vkDev, this->vkRenderPass, nullptr);
-        this->vkRenderPass = VK_NULL_HANDLE;
+        this->profiler->destroy();
+        delete this->profiler;
+        this->profiler = nullptr;
     }
+#endif
+
+    if (this->ownsJobs)
+    {
+        delete this->jobs;
+        this->jobs = nullptr;
+        this->ownsJobs = false;
+    }
+
+    if (this->staging != nullptr)
+    {
+        this->staging->destroy();
+        delete this->staging;
+        this->staging = nullptr;
+    }
+
+    if (this->transfer != nullptr)
+    {
+        this->transfer->destroy();
+        delete this->transfer;
+        this->transfer = nullptr;
+    }
+
+    if (this->vkCmdPool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(this->vkDev, this->vkCmdPool, nullptr);
+        this->vkCmdPool = VK_NULL_HANDLE;
+        this->vkCmdBuffers.resize(0);
+    }
+
+    delete this->allocator;
+    this->allocator = nullptr;
 
     if (this->vkDev != VK_NULL_HANDLE)
     {
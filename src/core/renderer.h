@@ -3,6 +3,8 @@
 
 #ifdef HAS_VULKAN
 
+#include <string>
+
 class Engine::Renderer
 {
     Game* game;
@@ -18,46 +20,240 @@ class Engine::Renderer
     VkSwapchainKHR vkSwapchain = VK_NULL_HANDLE;
     VkSurfaceKHR vkSurface = VK_NULL_HANDLE;
 
+    // replaced swapchains stay alive until the frames still using them are done
+    struct RetiredSwapchain
+    {
+        VkSwapchainKHR swapchain;
+        std::vector<VkImageView> imageViews;
+        std::vector<VkSemaphore> semaphores;
+        uint64_t retiredAt;
+    };
+
+    std::vector<RetiredSwapchain> retiredSwapchains;
+    VkExtent2D requestedExtent{};
+    bool swapchainDirty = false;
+
     VkViewport vkViewport{};
     VkRect2D vkScissor{};
 
-    VkRenderPass vkRenderPass = VK_NULL_HANDLE;
-    VkPipelineLayout vkLayout = VK_NULL_HANDLE;
+    // from createRenderPipeline(), owned by the pipeline cache, draws without a pipeline of their own use it
     VkPipeline vkPipeline = VK_NULL_HANDLE;
+    VkPipelineCache vkPipelineCache = VK_NULL_HANDLE;
 
     VkCommandPool vkCmdPool = VK_NULL_HANDLE;
-    VkCommandBuffer vkCmdBuffer = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> vkCmdBuffers;
+
+    // one of each per frame in flight, made by createDevice()
+    std::vector<VkSemaphore> imageAvailableSemaphores;
+    std::vector<VkFence> inFlightFences;
 
-    VkSemaphore imageAvailableSemaphore = VK_NULL_HANDLE;
-    VkSemaphore renderFinishedSemaphore = VK_NULL_HANDLE;
-    VkFence inFlightFence = VK_NULL_HANDLE;
+    // one per swapchain image, made and retired along with the swapchain
+    std::vector<VkSemaphore> renderFinishedSemaphores;
+
+    // fence of the frame currently rendering into each swapchain image
+    std::vector<VkFence> imagesInFlight;
+    uint32_t currentFrame = 0;
+    uint64_t frameCount = 0;
 
     std::vector<VkImage> vkImages;
     std::vector<VkImageView> vkImageViews;
-    std::vector<VkFramebuffer> vkFramebuffers;
+
+    // headless mode renders into these instead of swapchain images, one per frame in flight
+    std::vector<Allocation> offscreenAllocations;
+    std::vector<VkBuffer> vkReadbackBuffers;
+    std::vector<Allocation> readbackAllocations;
+    uint32_t lastFrame = 0;
+
+    // uploads go through the transfer queue when there is one, the staging ring otherwise
+    StagingRing* staging = nullptr;
+    TransferQueue* transfer = nullptr;
+
+    // last transfer queue value acquired by a frame
+    uint64_t transferValue = 0;
+
+    uint32_t vkApiVersion = VK_API_VERSION_1_0;
+
+    // rebuilt every frame, owns the render passes, framebuffers and transient images
+    RenderGraph* graph = nullptr;
+
+    // only there with recordThreads > 1
+    CommandRecorder* recorder = nullptr;
+    bool ownsJobs = false;
+
+#ifdef ENABLE_PROFILING
+    GpuProfiler* profiler = nullptr;
+
+    // secondaries can only run inside a statistics query with this
+    bool inheritedQueries = false;
+#endif
+
+    // meshes submitted with draw() since the last render(), the ones with bounds aren't visible
+    // until cull() finds them inside the frustum
+    struct Draw
+    {
+        const Mesh* mesh;
+        VkPipeline pipeline;
+        bool visible;
+    };
+
+    std::vector<Draw> drawList;
+
+    // bounds of the draws that have them, by index into drawList, and the camera they're tested against
+    CullList* culling = nullptr;
+    Frustum* frustum = nullptr;
+    std::vector<uint32_t> visibleIds;
+
+    // what's left of drawList once it's culled, this is what gets recorded
+    std::vector<Draw> visibleDraws;
+    void cull();
+
+    // destroyed meshes stay alive until the frames drawing them are done
+    struct RetiredMesh
+    {
+        Mesh mesh;
+        uint64_t retiredAt;
+    };
+
+    std::vector<RetiredMesh> retiredMeshes;
+    void destroyRetiredMeshes(bool all);
+
+    VkResult upload(VkBuffer dst, const void* data, VkDeviceSize size, uint64_t* pValue);
+
+    void retireSwapchain();
+    void destroyRetiredSwapchains(bool all);
+
+    VkResult createReadbackBuffers();
+    void cleanupOffscreen();
 
     VkResult createImageViews();
-    VkResult createFramebuffers();
     VkResult createSyncObjects();
-    VkResult createRenderPass();
 
-    VkResult recordCommandBuffer(uint32_t imageIndex);
+    // binds the pipeline and dynamic state, then draws visibleDraws[first, last)
+    void recordDraws(VkCommandBuffer cmdBuffer, uint32_t first, uint32_t last);
+    VkResult recordCommandBuffer(VkCommandBuffer cmdBuffer, uint32_t imageIndex);
 public:
     VkInstance vkInst = VK_NULL_HANDLE;
     VkDevice vkDev = VK_NULL_HANDLE;
+    Allocator* allocator = nullptr;
+
+    // pipelines by description, made by createDevice(), request() them every frame while they compile
+    PipelineCache* pipelines = nullptr;
+
+    // layouts from shader reflection, shared by pipelines with the same bindings
+    LayoutCache* layouts = nullptr;
+
+    // shader modules by file, watched files are reloaded at the start of every render()
+    ShaderLibrary* shaders = nullptr;
+
+    // KTX2 textures, streamed in a few levels per frame at the start of every frame
+    TextureStreamer* textures = nullptr;
+
+    // the colour format pipelines drawn in the main pass need
+    [[nodiscard]] VkFormat targetFormat() const;
 
     VkPresentModeKHR preferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
 
+    // how many frames the CPU may record ahead of the GPU, set before createDevice()
+    uint32_t framesInFlight = 2;
+
+    // pipeline cache file, loaded by createDevice() and saved on destruction (nullptr keeps it in memory only)
+    const char* pipelineCachePath = nullptr;
+
+    // size of the upload ring, set before createDevice(), a single upload can't be bigger than this
+    VkDeviceSize stagingSize = 64ull * 1024 * 1024;
+
+    // ring the texture streamer stages into, set before createDevice(), bounds its per frame budget
+    VkDeviceSize textureStagingSize = 32ull * 1024 * 1024;
+
+    // upload on a dedicated transfer queue if the device has one (and timeline semaphores), set before createDevice()
+    bool asyncTransfer = true;
+
+    // slices the draw list is split into for recording, set before createDevice()
+    uint32_t recordThreads = 1;
+
+    // runs the recording slices, one with recordThreads threads is made if this isn't set
+    JobSystem* jobs = nullptr;
+
+    // render without render pass and framebuffer objects on 1.3 or VK_KHR_dynamic_rendering devices, set before createDevice()
+    bool dynamicRendering = true;
+
     explicit Renderer(Game* game);
     VkResult createInstance(uint32_t vkExtensionCount, const char* const* vkExtensionNames);
+    // pass VK_NULL_HANDLE for a headless device, then use createOffscreen() instead of createSwapchain()
     VkResult createDevice(VkSurfaceKHR surface);
 
+    // also recreates an existing swapchain, returns VK_NOT_READY for a zero-sized (minimised) surface
     VkResult createSwapchain(uint32_t width, uint32_t height);
     void cleanupSwapchain();
 
-    VkResult createRenderPipeline(std::vector<VkPipelineShaderStageCreateInfo> shaders);
+    // the swapchain is recreated at the start of the next frame
+    void resize(uint32_t width, uint32_t height);
+
+    // copy each headless frame back to host memory, set before createOffscreen()
+    bool readback = false;
+
+    VkResult createOffscreen(uint32_t width, uint32_t height);
+    VkResult readPixels(std::vector<char>* pixels);
+    [[nodiscard]] bool headless() const;
+
+    // whether createDevice() ended up on dynamic rendering
+    [[nodiscard]] bool usesDynamicRendering() const;
+
+    // pipelineLayout is usually one from layouts, VK_NULL_HANDLE for an empty one
+    VkResult createRenderPipeline(
+        std::vector<VkPipelineShaderStageCreateInfo> shaders,
+        const VertexLayout& layout = {},
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE);
+
+    // the data is staged right away and copied to the GPU at the start of the next frame,
+    // VK_ERROR_OUT_OF_POOL_MEMORY means the ring is full so try again after a render()
+    VkResult createMesh(
+        const void* vertices,
+        uint32_t vertexCount,
+        uint32_t vertexStride,
+        const uint32_t* indices,
+        uint32_t indexCount,
+        Mesh* mesh);
+
+    // the same with 16 or 32 bit indices
+    VkResult createMesh(
+        const void* vertices,
+        uint32_t vertexCount,
+        uint32_t vertexStride,
+        const void* indices,
+        uint32_t indexCount,
+        VkIndexType indexType,
+        Mesh* mesh);
+
+    // a mesh cooked by writeMesh(), through Loaders::resolve(). Its data goes straight from the file
+    // into the staging ring, pLayout gets what a pipeline drawing it needs, and the positions have
+    // to be scaled into mesh->boundsMin and boundsMax. VK_ERROR_FORMAT_NOT_SUPPORTED for files
+    // parseMesh() doesn't take, VK_ERROR_UNKNOWN if there's no such file
+    VkResult loadMesh(const std::string& path, Mesh* mesh, VertexLayout* pLayout = nullptr);
+
+    void destroyMesh(Mesh* mesh);
+
+    // queues the mesh for the next render(), it has to stay alive until then,
+    // VK_NULL_HANDLE draws it with the pipeline from createRenderPipeline()
+    void draw(const Mesh* mesh, VkPipeline pipeline = VK_NULL_HANDLE);
+
+    // the same, but skipped if its world space bounds (like transform() of the mesh's bounds by its
+    // model matrix) are entirely outside the camera
+    void draw(const Mesh* mesh, const Sphere& bounds, VkPipeline pipeline = VK_NULL_HANDLE);
+    void draw(const Mesh* mesh, const Aabb& bounds, VkPipeline pipeline = VK_NULL_HANDLE);
+
+    // projection * view, draws with bounds are culled against it from the next render() on.
+    // Until it's set nothing gets culled.
+    void setCamera(const Mat4& viewProjection);
+
     VkResult render();
 
+    // results of a frame a few frames back, nullptr without ENABLE_PROFILING or before any came in
+    [[nodiscard]] const GpuFrameStats* gpuStats() const;
+
+    // writes the GPU timings of the last ~1000 frames as a chrome://tracing file
+    [[nodiscard]] bool exportGpuTrace(const char* filename) const;
+
     ~Renderer();
 };
 
@@ -0,0 +1,582 @@
+#include "scene.h"
+#include "jobs.h"
+
+#include <algorithm>
+
+const Engine::Scene::Slot* Engine::Scene::find(const Node node) const
+{
+    if (node.index >= this->slots.size())
+    {
+        return nullptr;
+    }
+
+    const Slot& slot = this->slots[node.index];
+    return slot.generation == node.generation && slot.row != NONE ? &slot : nullptr;
+}
+
+void Engine::Scene::link(const uint32_t slot, const uint32_t parent)
+{
+    uint32_t& first = parent == NONE ? this->firstRoot : this->slots[parent].firstChild;
+
+    Slot& linked = this->slots[slot];
+    linked.parent = parent;
+    linked.previous = NONE;
+    linked.next = first;
+
+    if (first != NONE)
+    {
+        this->slots[first].previous = slot;
+    }
+
+    first = slot;
+}
+
+void Engine::Scene::unlink(const uint32_t slot)
+{
+    Slot& unlinked = this->slots[slot];
+
+    if (unlinked.previous != NONE)
+    {
+        this->slots[unlinked.previous].next = unlinked.next;
+    }
+    else if (unlinked.parent != NONE)
+    {
+        this->slots[unlinked.parent].firstChild = unlinked.next;
+    }
+    else
+    {
+        this->firstRoot = unlinked.next;
+    }
+
+    if (unlinked.next != NONE)
+    {
+        this->slots[unlinked.next].previous = unlinked.previous;
+    }
+
+    unlinked.parent = NONE;
+    unlinked.next = NONE;
+    unlinked.previous = NONE;
+}
+
+void Engine::Scene::markDirty(const uint32_t row)
+{
+    if (this->dirty[row] == 0)
+    {
+        this->dirty[row] = 1;
+        this->dirtySlots.push_back(this->owners[row]);
+    }
+}
+
+Engine::Node Engine::Scene::create(const Node parent)
+{
+    return this->create(parent, {}, {}, {1.0f, 1.0f, 1.0f});
+}
+
+Engine::Node Engine::Scene::create(const Node parent, const Vec3 translation, const Quat rotation, const Vec3 scale)
+{
+    uint32_t parentSlot = NONE;
+
+    if (parent)
+    {
+        if (this->find(parent) == nullptr)
+        {
+            return {};
+        }
+
+        parentSlot = parent.index;
+    }
+
+    uint32_t index;
+
+    if (!this->freeSlots.empty())
+    {
+        index = this->freeSlots.back();
+        this->freeSlots.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(this->slots.size());
+        this->slots.emplace_back();
+    }
+
+    const auto row = static_cast<uint32_t>(this->owners.size());
+    const uint32_t parentRow = parentSlot == NONE ? NONE : this->slots[parentSlot].row;
+
+    this->translations.push_back(translation);
+    this->rotations.push_back(rotation);
+    this->scales.push_back(scale);
+    this->worlds.emplace_back();
+    this->parents.push_back(parentRow);
+    this->ends.push_back(row + 1);
+    this->owners.push_back(index);
+    this->dirty.push_back(0);
+
+    this->slots[index].row = row;
+    this->link(index, parentSlot);
+
+    // still sorted if the parent's subtree ended at the end of the arrays, then so did every
+    // subtree above it and they all grow by this one row
+    if (this->sorted && parentRow != NONE)
+    {
+        if (this->ends[parentRow] == row)
+        {
+            for (uint32_t above = parentRow; above != NONE; above = this->parents[above])
+            {
+                this->ends[above] = row + 1;
+            }
+        }
+        else
+        {
+            this->sorted = false;
+        }
+    }
+
+    this->markDirty(row);
+    this->nNodes++;
+
+    return {index, this->slots[index].generation};
+}
+
+bool Engine::Scene::destroy(const Node node)
+{
+    const Slot* found = this->find(node);
+
+    if (found == nullptr)
+    {
+        return false;
+    }
+
+    const uint32_t row = found->row;
+
+    // a subtree at the end of the arrays can just be cut off, which only shrinks the ones above it
+    const bool last = this->sorted && this->ends[row] == this->owners.size();
+
+    this->unlink(node.index);
+
+    // the rows might not be sorted, so the subtree goes through the links
+    std::vector<uint32_t> stack = {node.index};
+
+    while (!stack.empty())
+    {
+        const uint32_t index = stack.back();
+        stack.pop_back();
+
+        Slot& slot = this->slots[index];
+
+        for (uint32_t child = slot.firstChild; child != NONE; child = this->slots[child].next)
+        {
+            stack.push_back(child);
+        }
+
+        this->owners[slot.row] = NONE;
+
+        slot.row = NONE;
+        slot.parent = NONE;
+        slot.firstChild = NONE;
+        slot.next = NONE;
+        slot.previous = NONE;
+        slot.generation = slot.generation + 1 == 0 ? 1 : slot.generation + 1;
+
+        this->freeSlots.push_back(index);
+        this->nNodes--;
+    }
+
+    if (!last)
+    {
+        this->sorted = false;
+        return true;
+    }
+
+    for (uint32_t above = this->parents[row]; above != NONE; above = this->parents[above])
+    {
+        this->ends[above] = row;
+    }
+
+    this->translations.resize(row);
+    this->rotations.resize(row);
+    this->scales.resize(row);
+    this->worlds.resize(row);
+    this->parents.resize(row);
+    this->ends.resize(row);
+    this->owners.resize(row);
+    this->dirty.resize(row);
+
+    return true;
+}
+
+bool Engine::Scene::alive(const Node node) const
+{
+    return this->find(node) != nullptr;
+}
+
+bool Engine::Scene::setParent(const Node node, const Node parent)
+{
+    const Slot* slot = this->find(node);
+
+    if (slot == nullptr)
+    {
+        return false;
+    }
+
+    uint32_t parentSlot = NONE;
+
+    if (parent)
+    {
+        if (this->find(parent) == nullptr)
+        {
+            return false;
+        }
+
+        parentSlot = parent.index;
+
+        for (uint32_t above = parentSlot; above != NONE; above = this->slots[above].parent)
+        {
+            if (above == node.index)
+            {
+                return false;
+            }
+        }
+    }
+
+    if (slot->parent == parentSlot)
+    {
+        return true;
+    }
+
+    this->unlink(node.index);
+    this->link(node.index, parentSlot);
+
+    this->parents[slot->row] = parentSlot == NONE ? NONE : this->slots[parentSlot].row;
+    this->sorted = false;
+    this->markDirty(slot->row);
+
+    return true;
+}
+
+Engine::Node Engine::Scene::getParent(const Node node) const
+{
+    const Slot* slot = this->find(node);
+
+    if (slot == nullptr || slot->parent == NONE)
+    {
+        return {};
+    }
+
+    return {slot->parent, this->slots[slot->parent].generation};
+}
+
+bool Engine::Scene::setLocal(const Node node, const Vec3 translation, const Quat rotation, const Vec3 scale)
+{
+    const Slot* slot = this->find(node);
+
+    if (slot == nullptr)
+    {
+        return false;
+    }
+
+    this->translations[slot->row] = translation;
+    this->rotations[slot->row] = rotation;
+    this->scales[slot->row] = scale;
+    this->markDirty(slot->row);
+
+    return true;
+}
+
+bool Engine::Scene::setTranslation(const Node node, const Vec3 translation)
+{
+    const Slot* slot = this->find(node);
+
+    if (slot == nullptr)
+    {
+        return false;
+    }
+
+    this->translations[slot->row] = translation;
+    this->markDirty(slot->row);
+
+    return true;
+}
+
+bool Engine::Scene::setRotation(const Node node, const Quat rotation)
+{
+    const Slot* slot = this->find(node);
+
+    if (slot == nullptr)
+    {
+        return false;
+    }
+
+    this->rotations[slot->row] = rotation;
+    this->markDirty(slot->row);
+
+    return true;
+}
+
+bool Engine::Scene::setScale(const Node node, const Vec3 scale)
+{
+    const Slot* slot = this->find(node);
+
+    if (slot == nullptr)
+    {
+        return false;
+    }
+
+    this->scales[slot->row] = scale;
+    this->markDirty(slot->row);
+
+    return true;
+}
+
+bool Engine::Scene::getLocal(const Node node, Vec3* translation, Quat* rotation, Vec3* scale) const
+{
+    const Slot* slot = this->find(node);
+
+    if (slot == nullptr)
+    {
+        return false;
+    }
+
+    if (translation != nullptr) *translation = this->translations[slot->row];
+    if (rotation != nullptr) *rotation = this->rotations[slot->row];
+    if (scale != nullptr) *scale = this->scales[slot->row];
+
+    return true;
+}
+
+const Engine::Mat4* Engine::Scene::getWorld(const Node node) const
+{
+    const Slot* slot = this->find(node);
+    return slot != nullptr ? &this->worlds[slot->row] : nullptr;
+}
+
+void Engine::Scene::sort()
+{
+    const size_t count = this->nNodes;
+
+    // depth first through the links, a node's whole subtree comes out before anything next to it
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> stack;
+    order.reserve(count);
+
+    for (uint32_t root = this->firstRoot; root != NONE; root = this->slots[root].next)
+    {
+        stack.push_back(root);
+    }
+
+    while (!stack.empty())
+    {
+        const uint32_t index = stack.back();
+        stack.pop_back();
+        order.push_back(index);
+
+        for (uint32_t child = this->slots[index].firstChild; child != NONE; child = this->slots[child].next)
+        {
+            stack.push_back(child);
+        }
+    }
+
+    std::vector<Vec3> sortedTranslations(count);
+    std::vector<Quat> sortedRotations(count);
+    std::vector<Vec3> sortedScales(count);
+    std::vector<Mat4> sortedWorlds(count);
+    std::vector<uint32_t> sortedParents(count);
+    std::vector<uint32_t> sortedEnds(count);
+    std::vector<uint8_t> sortedDirty(count);
+
+    for (uint32_t row = 0; row < count; row++)
+    {
+        Slot& slot = this->slots[order[row]];
+        const uint32_t from = slot.row;
+
+        sortedTranslations[row] = this->translations[from];
+        sortedRotations[row] = this->rotations[from];
+        sortedScales[row] = this->scales[from];
+        sortedWorlds[row] = this->worlds[from];
+        sortedDirty[row] = this->dirty[from];
+        sortedEnds[row] = row + 1;
+
+        // parents came out first, so they're already on their new row
+        slot.row = row;
+        sortedParents[row] = slot.parent == NONE ? NONE : this->slots[slot.parent].row;
+    }
+
+    // children after their parents, so going backwards every subtree is done before it's needed
+    for (uint32_t row = static_cast<uint32_t>(count); row-- > 0;)
+    {
+        if (sortedParents[row] != NONE)
+        {
+            sortedEnds[sortedParents[row]] = std::max(sortedEnds[sortedParents[row]], sortedEnds[row]);
+        }
+    }
+
+    this->translations = std::move(sortedTranslations);
+    this->rotations = std::move(sortedRotations);
+    this->scales = std::move(sortedScales);
+    this->worlds = std::move(sortedWorlds);
+    this->parents = std::move(sortedParents);
+    this->ends = std::move(sortedEnds);
+    this->owners = std::move(order);
+    this->dirty = std::move(sortedDirty);
+
+    this->sorted = true;
+}
+
+void Engine::Scene::updateRange(const uint32_t begin, const uint32_t end)
+{
+    for (uint32_t row = begin; row < end; row++)
+    {
+        const Mat4 local = Mat4::trs(this->translations[row], this->rotations[row], this->scales[row]);
+        const uint32_t parent = this->parents[row];
+
+        this->worlds[row] = parent == NONE ? local : this->worlds[parent] * local;
+        this->dirty[row] = 0;
+    }
+}
+
+size_t Engine::Scene::update(JobSystem* jobs)
+{
+    if (!this->sorted)
+    {
+        this->sort();
+    }
+
+    // the subtrees under dirty nodes, leaving out the ones inside another
+    this->ranges.clear();
+    size_t total = 0;
+
+    const auto rows = static_cast<uint32_t>(this->owners.size());
+
+    if (this->dirtySlots.size() > rows / 16)
+    {
+        // with this many it's quicker to look at every flag, skipping over the subtrees found
+        for (uint32_t row = 0; row < rows;)
+        {
+            if (this->dirty[row] == 0)
+            {
+                row++;
+                continue;
+            }
+
+            this->ranges.emplace_back(row, this->ends[row]);
+            total += this->ends[row] - row;
+            row = this->ends[row];
+        }
+    }
+    else
+    {
+        this->dirtyRows.clear();
+
+        for (const uint32_t index : this->dirtySlots)
+        {
+            const uint32_t row = this->slots[index].row;
+
+            if (row != NONE && this->dirty[row] != 0)
+            {
+                this->dirtyRows.push_back(row);
+            }
+        }
+
+        std::sort(this->dirtyRows.begin(), this->dirtyRows.end());
+
+        uint32_t covered = 0;
+
+        for (const uint32_t row : this->dirtyRows)
+        {
+            if (row >= covered)
+            {
+                covered = this->ends[row];
+                total += covered - row;
+                this->ranges.emplace_back(row, covered);
+            }
+        }
+    }
+
+    this->dirtySlots.clear();
+
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    if (jobs == nullptr || jobs->size() <= 1)
+    {
+        for (const auto& [begin, end] : this->ranges)
+        {
+            this->updateRange(begin, end);
+        }
+
+        return total;
+    }
+
+    // a few jobs' worth per thread, small ones aren't worth queueing
+    const size_t target = std::max(total / (jobs->size() * 4), static_cast<size_t>(1024));
+
+    // subtrees bigger than that get their root done here, then their children's subtrees are
+    // independent of each other
+    this->pieces.clear();
+
+    for (const auto& range : this->ranges)
+    {
+        this->split.push_back(range);
+
+        while (!this->split.empty())
+        {
+            const auto [begin, end] = this->split.back();
+            this->split.pop_back();
+
+            if (end - begin <= target)
+            {
+                this->pieces.emplace_back(begin, end);
+                continue;
+            }
+
+            this->updateRange(begin, begin + 1);
+
+            for (uint32_t child = begin + 1; child < end; child = this->ends[child])
+            {
+                this->split.emplace_back(child, this->ends[child]);
+            }
+        }
+    }
+
+    // and the small pieces grouped back up into jobs of about the target size
+    this->batches.clear();
+
+    uint32_t first = 0;
+    size_t nodes = 0;
+
+    for (uint32_t i = 0; i < this->pieces.size(); i++)
+    {
+        nodes += this->pieces[i].second - this->pieces[i].first;
+
+        if (nodes >= target)
+        {
+            this->batches.emplace_back(first, i + 1);
+            first = i + 1;
+            nodes = 0;
+        }
+    }
+
+    if (first < this->pieces.size())
+    {
+        this->batches.emplace_back(first, static_cast<uint32_t>(this->pieces.size()));
+    }
+
+    jobs->parallelFor(static_cast<uint32_t>(this->batches.size()), 1, [this](const uint32_t begin, const uint32_t end)
+    {
+        for (uint32_t batch = begin; batch < end; batch++)
+        {
+            for (uint32_t piece = this->batches[batch].first; piece < this->batches[batch].second; piece++)
+            {
+                this->updateRange(this->pieces[piece].first, this->pieces[piece].second);
+            }
+        }
+    });
+
+    return total;
+}
+
+size_t Engine::Scene::size() const
+{
+    return this->nNodes;
+}
\ No newline at end of file
@@ -0,0 +1,124 @@
+#pragma once
+#include "engine.h"
+
+#include "math.h"
+
+#include <utility>
+
+// same as an entity, an index into the scene's slots plus the generation it was on
+struct Engine::Node
+{
+    uint32_t index = 0;
+
+    // 0 is never alive, so Node{} is a null handle (and the parent of roots)
+    uint32_t generation = 0;
+
+    bool operator==(const Node& other) const = default;
+    explicit operator bool() const { return this->generation != 0; }
+};
+
+// Transform hierarchy. Every node has a local translation, rotation and scale and a world matrix
+// (its parent's world matrix times its local one), which update() brings up to date.
+//
+// The nodes are kept in flat arrays sorted depth first, so parents come before their children and
+// every subtree is one contiguous range of rows. Changing a node's transform marks it dirty, and
+// update() only goes over the subtrees under dirty nodes: nothing at all if nothing moved, and
+// each independent subtree can go to a different job. Creating a node under one at the end of the
+// arrays (so roots, or a hierarchy created depth first like walking a glTF scene) or destroying one
+// there keeps them sorted, anything else structural sorts everything again at the next update().
+//
+// Not thread safe, other than update() splitting itself between jobs.
+class Engine::Scene
+{
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Slot
+    {
+        uint32_t row = NONE;
+        uint32_t generation = 1;
+
+        // slots, children are a linked list hanging off the parent (or firstRoot)
+        uint32_t parent = NONE;
+        uint32_t firstChild = NONE;
+        uint32_t next = NONE;
+        uint32_t previous = NONE;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    uint32_t firstRoot = NONE;
+
+    // by row
+    std::vector<Vec3> translations;
+    std::vector<Quat> rotations;
+    std::vector<Vec3> scales;
+    std::vector<Mat4> worlds;
+
+    // the parent's row (NONE for roots), one past the subtree's last row and which slot it is
+    // (NONE once destroyed, until the next sort)
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> ends;
+    std::vector<uint32_t> owners;
+    std::vector<uint8_t> dirty;
+
+    // slots marked dirty since the last update, may have been destroyed since
+    std::vector<uint32_t> dirtySlots;
+    bool sorted = true;
+
+    // scratch for update(), kept to not allocate every frame. Ranges are rows, batches are
+    // ranges of pieces.
+    std::vector<uint32_t> dirtyRows;
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    std::vector<std::pair<uint32_t, uint32_t>> split;
+    std::vector<std::pair<uint32_t, uint32_t>> pieces;
+    std::vector<std::pair<uint32_t, uint32_t>> batches;
+
+    size_t nNodes = 0;
+
+    [[nodiscard]] const Slot* find(Node node) const;
+
+    void link(uint32_t slot, uint32_t parent);
+    void unlink(uint32_t slot);
+    void markDirty(uint32_t row);
+
+    void sort();
+
+    // world matrices for [begin, end), the parent of begin has to be up to date already
+    void updateRange(uint32_t begin, uint32_t end);
+
+public:
+    Scene() = default;
+
+    Scene(const Scene&) = delete;
+    Scene& operator=(const Scene&) = delete;
+
+    // null if parent isn't alive (and isn't null), the first one starts out at the parent's origin
+    Node create(Node parent = {});
+    Node create(Node parent, Vec3 translation, Quat rotation, Vec3 scale);
+
+    // and everything under it
+    bool destroy(Node node);
+    [[nodiscard]] bool alive(Node node) const;
+
+    // keeps the local transform, so the node moves along with its new parent. Refuses to put a
+    // node under itself or one of its children.
+    bool setParent(Node node, Node parent);
+    [[nodiscard]] Node getParent(Node node) const;
+
+    bool setLocal(Node node, Vec3 translation, Quat rotation, Vec3 scale);
+    bool setTranslation(Node node, Vec3 translation);
+    bool setRotation(Node node, Quat rotation);
+    bool setScale(Node node, Vec3 scale);
+
+    // any of them can be null
+    bool getLocal(Node node, Vec3* translation, Quat* rotation, Vec3* scale) const;
+
+    // as of the last update(), null if the node isn't alive
+    [[nodiscard]] const Mat4* getWorld(Node node) const;
+
+    // brings the world matrices of everything that moved (and everything under it) up to date,
+    // split between jobs if there are any. Returns how many it recomputed.
+    size_t update(JobSystem* jobs = nullptr);
+
+    [[nodiscard]] size_t size() const;
+};
\ No newline at end of file
@@ -0,0 +1,440 @@
+#include "shaders.h"
+
+#ifdef HAS_VULKAN
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "layouts.h"
+#include "pipelines.h"
+#include "profiler.h"
+
+namespace
+{
+    uint64_t hashCode(const uint32_t* words, const size_t nWords)
+    {
+        uint64_t value = 14695981039346656037ull;
+
+        for (size_t i = 0; i < nWords; i++)
+        {
+            value = (value ^ words[i]) * 1099511628211ull;
+        }
+
+        return value;
+    }
+
+    // so a watched directory plus a file name matches the path it was loaded with
+    std::string normalizePath(const std::string& path)
+    {
+        return std::filesystem::path(path).lexically_normal().string();
+    }
+}
+
+struct Engine::ShaderLibrary::Program
+{
+    PipelineDesc desc;
+    std::vector<std::string> paths;
+
+    // left empty when added, so they follow the shaders' reflection
+    bool reflectLayout = false;
+    bool reflectVertexLayout = false;
+
+    VkPipeline current = VK_NULL_HANDLE;
+};
+
+void Engine::ShaderLibrary::create(VkDevice dev, PipelineCache* pipelines, LayoutCache* layouts)
+{
+    this->vkDev = dev;
+    this->pipelines = pipelines;
+    this->layouts = layouts;
+}
+
+void Engine::ShaderLibrary::destroy()
+{
+    this->pipelines->wait();
+
+#ifdef __linux__
+    if (this->watchFd >= 0)
+    {
+        close(this->watchFd);
+        this->watchFd = -1;
+    }
+#endif
+
+    this->watches.clear();
+
+    for (const auto& [hash, bucket] : this->modules)
+    {
+        for (const auto module : bucket)
+        {
+            vkDestroyShaderModule(this->vkDev, module->module, nullptr);
+            delete module;
+        }
+    }
+
+    for (const auto module : this->retired)
+    {
+        vkDestroyShaderModule(this->vkDev, module->module, nullptr);
+        delete module;
+    }
+
+    for (const auto program : this->programs)
+    {
+        delete program;
+    }
+
+    this->modules.clear();
+    this->files.clear();
+    this->programs.clear();
+    this->retired.clear();
+}
+
+VkResult Engine::ShaderLibrary::read(const std::string& path, Module** pModule, const bool loose)
+{
+    Loaders::Asset asset;
+    Loaders::FileView file;
+
+    // reloads come from the file that changed, not an archive it was packed into
+    const bool opened = loose ? file.open(path.c_str()) : Loaders::resolve(path, &asset);
+    const char* data = loose ? file.data() : asset.data();
+    const size_t size = loose ? file.size() : asset.size();
+
+    if (!opened || size % 4 != 0)
+    {
+        return VK_ERROR_UNKNOWN;
+    }
+
+    // hashed and compared straight from the mapping, only new code gets copied
+    const auto words = reinterpret_cast<const uint32_t*>(data);
+    const size_t nWords = size / 4;
+
+    const uint64_t hash = hashCode(words, nWords);
+    const auto found = this->modules.find(hash);
+
+    if (found != this->modules.end())
+    {
+        for (const auto module : found->second)
+        {
+            if (module->code.size() == nWords && memcmp(module->code.data(), words, size) == 0)
+            {
+                *pModule = module;
+                return VK_SUCCESS;
+            }
+        }
+    }
+
+    const auto module = new Module();
+    module->hash = hash;
+    module->code.assign(words, words + nWords);
+
+    if (!Loaders::reflectShader(module->code.data(), module->code.size(), &module->reflection))
+    {
+        delete module;
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = module->code.size() * 4;
+    createInfo.pCode = module->code.data();
+
+    const VkResult result = vkCreateShaderModule(this->vkDev, &createInfo, nullptr, &module->module);
+
+    if (result != VK_SUCCESS)
+    {
+        delete module;
+        return result;
+    }
+
+    this->modules[hash].push_back(module);
+    *pModule = module;
+
+    return VK_SUCCESS;
+}
+
+void Engine::ShaderLibrary::release(Module* module)
+{
+    if (--module->refs > 0)
+    {
+        return;
+    }
+
+    auto& bucket = this->modules[module->hash];
+    std::erase(bucket, module);
+
+    if (bucket.empty())
+    {
+        this->modules.erase(module->hash);
+    }
+
+    this->retired.push_back(module);
+}
+
+VkResult Engine::ShaderLibrary::load(const std::string& path, VkShaderModule* pModule, const Loaders::ShaderReflection** pReflection)
+{
+    const std::string key = normalizePath(path);
+    const auto found = this->files.find(key);
+
+    Module* module;
+
+    if (found != this->files.end())
+    {
+        module = found->second;
+    } else
+    {
+        const VkResult result = this->read(key, &module, false);
+
+        if (result != VK_SUCCESS)
+        {
+            return result;
+        }
+
+        module->refs++;
+        this->files.emplace(key, module);
+    }
+
+    *pModule = module->module;
+
+    if (pReflection != nullptr)
+    {
+        *pReflection = &module->reflection;
+    }
+
+    return VK_SUCCESS;
+}
+
+VkResult Engine::ShaderLibrary::build(Program* program) const
+{
+    std::vector<const Loaders::ShaderReflection*> reflections;
+    program->desc.shaders.clear();
+
+    for (const auto& path : program->paths)
+    {
+        const Module* module = this->files.at(path);
+
+        reflections.push_back(&module->reflection);
+        program->desc.shaders.push_back({module->reflection.stage, module->module, module->reflection.entryPoint, module->hash});
+
+        if (program->reflectVertexLayout && module->reflection.stage == VK_SHADER_STAGE_VERTEX_BIT)
+        {
+            const VkResult result = LayoutCache::vertexLayout(module->reflection, &program->desc.vertexLayout);
+
+            if (result != VK_SUCCESS)
+            {
+                return result;
+            }
+        }
+    }
+
+    if (program->reflectLayout)
+    {
+        return this->layouts->pipelineLayout(reflections, &program->desc.layout);
+    }
+
+    return VK_SUCCESS;
+}
+
+VkResult Engine::ShaderLibrary::addPipeline(const PipelineDesc& desc, const std::vector<std::string>& paths, Pipeline* pPipeline)
+{
+    const auto program = new Program();
+    program->desc = desc;
+    program->reflectLayout = desc.layout == VK_NULL_HANDLE && this->layouts != nullptr;
+    program->reflectVertexLayout = desc.vertexLayout.bindings.empty() && desc.vertexLayout.attributes.empty();
+
+    for (const auto& path : paths)
+    {
+        VkShaderModule module;
+        const VkResult result = this->load(path, &module);
+
+        if (result != VK_SUCCESS)
+        {
+            delete program;
+            return result;
+        }
+
+        program->paths.push_back(normalizePath(path));
+    }
+
+    VkResult result = this->build(program);
+
+    if (result == VK_SUCCESS)
+    {
+        result = this->pipelines->get(program->desc, &program->current);
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        delete program;
+        return result;
+    }
+
+    *pPipeline = this->programs.size();
+    this->programs.push_back(program);
+
+    return VK_SUCCESS;
+}
+
+VkPipeline Engine::ShaderLibrary::pipeline(const Pipeline pipeline)
+{
+    Program* program = this->programs[pipeline];
+    program->current = this->pipelines->request(program->desc, program->current);
+
+    return program->current;
+}
+
+VkResult Engine::ShaderLibrary::watch(const std::string& directory)
+{
+#ifdef __linux__
+    if (this->watchFd < 0)
+    {
+        this->watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+        if (this->watchFd < 0)
+        {
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+    }
+
+    // compilers either write the file in place or rename a temporary over it
+    const int wd = inotify_add_watch(this->watchFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+
+    if (wd < 0)
+    {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    this->watches[wd] = directory;
+    return VK_SUCCESS;
+#else
+    return VK_ERROR_FEATURE_NOT_PRESENT;
+#endif
+}
+
+void Engine::ShaderLibrary::reload(const std::string& path)
+{
+    Module* previous = this->files.at(path);
+    Module* module;
+
+    if (this->read(path, &module, true) != VK_SUCCESS)
+    {
+        this->failedReloads++;
+        return;
+    }
+
+    // touched but not changed
+    if (module == previous)
+    {
+        return;
+    }
+
+    module->refs++;
+    this->files[path] = module;
+    this->release(previous);
+    this->reloads++;
+
+    for (const auto program : this->programs)
+    {
+        if (std::find(program->paths.begin(), program->paths.end(), path) == program->paths.end())
+        {
+            continue;
+        }
+
+        // a layout that can't be built (stages disagreeing on a binding) keeps the old pipeline
+        PipelineDesc previousDesc = program->desc;
+
+        if (this->build(program) != VK_SUCCESS)
+        {
+            program->desc = std::move(previousDesc);
+            continue;
+        }
+
+        // starts the compile now instead of on the next draw
+        program->current = this->pipelines->request(program->desc, program->current);
+    }
+}
+
+void Engine::ShaderLibrary::poll()
+{
+    PROFILE_ZONE("shader reload");
+
+    // nothing can be compiling from a module retired before the last poll anymore
+    if (!this->retired.empty() && this->pipelines->stats().pending == 0)
+    {
+        for (const auto module : this->retired)
+        {
+            vkDestroyShaderModule(this->vkDev, module->module, nullptr);
+            delete module;
+        }
+
+        this->retired.clear();
+    }
+
+#ifdef __linux__
+    if (this->watchFd < 0)
+    {
+        return;
+    }
+
+    std::vector<std::string> changed;
+    alignas(inotify_event) char buffer[4096];
+
+    while (true)
+    {
+        const ssize_t size = ::read(this->watchFd, buffer, sizeof(buffer));
+
+        if (size <= 0)
+        {
+            break;
+        }
+
+        for (ssize_t offset = 0; offset < size;)
+        {
+            const auto event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            const auto directory = this->watches.find(event->wd);
+
+            if (event->len == 0 || directory == this->watches.end())
+            {
+                continue;
+            }
+
+            // only files something was loaded from, and each once however many events it got
+            const std::string path = normalizePath((std::filesystem::path(directory->second) / event->name).string());
+
+            if (this->files.contains(path) && std::find(changed.begin(), changed.end(), path) == changed.end())
+            {
+                changed.push_back(path);
+            }
+        }
+    }
+
+    for (const auto& path : changed)
+    {
+        this->reload(path);
+    }
+#endif
+}
+
+Engine::ShaderLibrary::Stats Engine::ShaderLibrary::stats() const
+{
+    Stats stats;
+    stats.pipelines = this->programs.size();
+    stats.reloads = this->reloads;
+    stats.failedReloads = this->failedReloads;
+
+    for (const auto& [hash, bucket] : this->modules)
+    {
+        stats.modules += bucket.size();
+    }
+
+    return stats;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+#include "engine.h"
+
+#ifdef HAS_VULKAN
+
+#include <string>
+#include <unordered_map>
+
+#include "loaders/loaders.h"
+
+// Shader modules by file, loaded once and kept alive until the file is reloaded, so pipelines
+// can be rebuilt from them at any point. Files with the same contents share a module. Pipelines
+// added here are rebuilt when one of their files changes: watch() the directories the .spv
+// files are compiled into and poll() every frame (the renderer does), the new pipelines compile
+// on the job system while the old ones keep drawing. They're matched on the code's hash rather
+// than the module, so a handle reused after a reload never finds a pipeline built from old code.
+class Engine::ShaderLibrary
+{
+public:
+    using Pipeline = uint32_t;
+
+    struct Stats
+    {
+        uint32_t modules = 0;
+        uint32_t pipelines = 0;
+        uint32_t reloads = 0;
+
+        // changed files that couldn't be read or weren't valid SPIR-V, the old module stays
+        uint32_t failedReloads = 0;
+    };
+
+private:
+    struct Module
+    {
+        uint64_t hash = 0;
+        std::vector<uint32_t> code;
+        VkShaderModule module = VK_NULL_HANDLE;
+        Loaders::ShaderReflection reflection;
+
+        // files currently pointing at it
+        uint32_t refs = 0;
+    };
+
+    // a pipeline added here, defined with the rest since it holds a PipelineDesc
+    struct Program;
+
+    VkDevice vkDev = VK_NULL_HANDLE;
+    PipelineCache* pipelines = nullptr;
+    LayoutCache* layouts = nullptr;
+
+    // by content hash, the vector only grows past one on a collision
+    std::unordered_map<uint64_t, std::vector<Module*>> modules;
+    std::unordered_map<std::string, Module*> files;
+    std::vector<Program*> programs;
+
+    // replaced modules, destroyed once no compile can still be using them
+    std::vector<Module*> retired;
+
+    int watchFd = -1;
+    std::unordered_map<int, std::string> watches;
+
+    uint32_t reloads = 0;
+    uint32_t failedReloads = 0;
+
+    VkResult read(const std::string& path, Module** pModule, bool loose);
+    void release(Module* module);
+    VkResult build(Program* program) const;
+    void reload(const std::string& path);
+
+public:
+    // layouts can be nullptr, pipelines then need their layout filled in
+    void create(VkDevice dev, PipelineCache* pipelines, LayoutCache* layouts);
+
+    // waits for compiles still running, pipelines stay in the pipeline cache
+    void destroy();
+
+    // the module and what it expects to be bound, owned by the library. Both stay valid until
+    // the file is reloaded, load() it again after a poll() that might have reloaded it
+    VkResult load(const std::string& path, VkShaderModule* pModule, const Loaders::ShaderReflection** pReflection = nullptr);
+
+    // desc.shaders is filled in from paths (stage and entry point included), an empty layout or
+    // vertex layout comes from reflection (which fails for inputs that aren't 32 bit). Compiles
+    // on the calling thread.
+    VkResult addPipeline(const PipelineDesc& desc, const std::vector<std::string>& paths, Pipeline* pPipeline);
+
+    // the newest pipeline that's done compiling
+    VkPipeline pipeline(Pipeline pipeline);
+
+    // files in directory changing from now on get reloaded by poll(),
+    // VK_ERROR_FEATURE_NOT_PRESENT where there's no inotify
+    VkResult watch(const std::string& directory);
+
+    // reloads changed files and starts rebuilding the pipelines using them
+    void poll();
+
+    [[nodiscard]] Stats stats() const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include "staging.h"
+
+#ifdef HAS_VULKAN
+
+#include <cstring>
+#include <unordered_set>
+
+VkResult Engine::StagingRing::create(Allocator* allocator, const VkDeviceSize size, const uint32_t framesInFlight)
+{
+    this->allocator = allocator;
+    this->size = size;
+    this->frameEnds.assign(framesInFlight, 0);
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    // written once and read once by the GPU, so no point in cached memory
+    return allocator->createBuffer(
+        bufferInfo,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        0,
+        &this->buffer,
+        &this->allocation);
+}
+
+void Engine::StagingRing::destroy()
+{
+    if (this->buffer != VK_NULL_HANDLE)
+    {
+        this->allocator->destroyBuffer(this->buffer, this->allocation);
+        this->buffer = VK_NULL_HANDLE;
+    }
+
+    this->pending.clear();
+}
+
+VkResult Engine::StagingRing::copyIn(const void* data, const VkDeviceSize size, const VkDeviceSize alignment, VkDeviceSize* pOffset)
+{
+    VkDeviceSize start = (this->head + alignment - 1) / alignment * alignment;
+
+    // never split an upload across the wrap
+    if (start % this->size + size > this->size)
+    {
+        start += this->size - start % this->size;
+    }
+
+    if (start + size - this->tail > this->size)
+    {
+        return VK_ERROR_OUT_OF_POOL_MEMORY;
+    }
+
+    *pOffset = start % this->size;
+    memcpy(static_cast<char*>(this->allocation.mapped) + *pOffset, data, size);
+
+    this->head = start + size;
+    return VK_SUCCESS;
+}
+
+VkResult Engine::StagingRing::upload(
+    VkBuffer dst,
+    const VkDeviceSize dstOffset,
+    const void* data,
+    const VkDeviceSize size,
+    const VkDeviceSize alignment)
+{
+    std::lock_guard lock(this->mutex);
+
+    VkDeviceSize offset;
+    const VkResult result = this->copyIn(data, size, alignment, &offset);
+
+    if (result == VK_SUCCESS)
+    {
+        this->pending.push_back({dst, {offset, dstOffset, size}});
+    }
+
+    return result;
+}
+
+VkResult Engine::StagingRing::stage(const void* data, const VkDeviceSize size, const VkDeviceSize alignment, VkDeviceSize* pOffset)
+{
+    std::lock_guard lock(this->mutex);
+    return this->copyIn(data, size, alignment, pOffset);
+}
+
+VkBuffer Engine::StagingRing::stagingBuffer() const
+{
+    return this->buffer;
+}
+
+void Engine::StagingRing::retire(const uint32_t slot)
+{
+    std::lock_guard lock(this->mutex);
+
+    // slots finish in order, so everything before this slot's end is free
+    if (this->frameEnds[slot] > this->tail)
+    {
+        this->tail = this->frameEnds[slot];
+    }
+}
+
+bool Engine::StagingRing::empty()
+{
+    std::lock_guard lock(this->mutex);
+    return this->pending.empty();
+}
+
+void Engine::StagingRing::recordCopies(VkCommandBuffer cmdBuffer, const uint32_t slot)
+{
+    this->frameEnds[slot] = this->head;
+
+    for (const auto& copy : this->pending)
+    {
+        vkCmdCopyBuffer(cmdBuffer, this->buffer, copy.dst, 1, &copy.region);
+    }
+}
+
+void Engine::StagingRing::record(VkCommandBuffer cmdBuffer, const uint32_t slot)
+{
+    std::lock_guard lock(this->mutex);
+    this->recordCopies(cmdBuffer, slot);
+
+    if (this->pending.empty())
+    {
+        return;
+    }
+
+    this->pending.clear();
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+
+    vkCmdPipelineBarrier(
+        cmdBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        0,
+        1, &barrier,
+        0, nullptr,
+        0, nullptr);
+}
+
+void Engine::StagingRing::recordRelease(
+    VkCommandBuffer cmdBuffer,
+    const uint32_t slot,
+    const uint32_t srcFamily,
+    const uint32_t dstFamily,
+    std::vector<VkBuffer>* released)
+{
+    std::lock_guard lock(this->mutex);
+    this->recordCopies(cmdBuffer, slot);
+
+    std::vector<VkBufferMemoryBarrier> barriers;
+    std::unordered_set<VkBuffer> seen;
+
+    for (const auto& copy : this->pending)
+    {
+        // a buffer written by several copies is still only handed over once
+        if (!seen.insert(copy.dst).second)
+        {
+            continue;
+        }
+
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        barrier.srcQueueFamilyIndex = srcFamily;
+        barrier.dstQueueFamilyIndex = dstFamily;
+        barrier.buffer = copy.dst;
+        barrier.size = VK_WHOLE_SIZE;
+
+        barriers.push_back(barrier);
+        released->push_back(copy.dst);
+    }
+
+    this->pending.clear();
+
+    if (barriers.empty())
+    {
+        return;
+    }
+
+    vkCmdPipelineBarrier(
+        cmdBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0,
+        0, nullptr,
+        static_cast<uint32_t>(barriers.size()), barriers.data(),
+        0, nullptr);
+}
+
+#endif
\ No newline at end of file
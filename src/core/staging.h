@@ -0,0 +1,71 @@
+#pragma once
+#include "engine.h"
+
+#ifdef HAS_VULKAN
+
+#include <mutex>
+
+// One persistently mapped upload buffer used as a ring. Uploads are copied in
+// right away and the GPU-side copies are batched into the next recorded frame,
+// the space is handed back once that frame's fence has been waited on.
+class Engine::StagingRing
+{
+    struct Copy
+    {
+        VkBuffer dst;
+        VkBufferCopy region;
+    };
+
+    Allocator* allocator = nullptr;
+
+    VkBuffer buffer = VK_NULL_HANDLE;
+    Allocation allocation;
+
+    // absolute positions, the buffer offset is position % size
+    VkDeviceSize size = 0;
+    VkDeviceSize head = 0;
+    VkDeviceSize tail = 0;
+
+    // head at the time each frame slot was recorded
+    std::vector<VkDeviceSize> frameEnds;
+    std::vector<Copy> pending;
+
+    std::mutex mutex;
+
+    // the caller holds the lock
+    VkResult copyIn(const void* data, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* pOffset);
+
+    // records the pending copies, the caller holds the lock
+    void recordCopies(VkCommandBuffer cmdBuffer, uint32_t slot);
+
+public:
+    VkResult create(Allocator* allocator, VkDeviceSize size, uint32_t framesInFlight);
+    void destroy();
+
+    // VK_ERROR_OUT_OF_POOL_MEMORY if there's no room until some frames retire
+    VkResult upload(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size, VkDeviceSize alignment = 16);
+
+    // copies the data in for a copy out of stagingBuffer() at *pOffset that the caller records
+    // itself (into images, say), before this slot's record() so the space retires with it
+    VkResult stage(const void* data, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* pOffset);
+    [[nodiscard]] VkBuffer stagingBuffer() const;
+
+    // the slot's fence (or timeline value) has been waited on, its uploads are done
+    void retire(uint32_t slot);
+
+    [[nodiscard]] bool empty();
+
+    // records every pending copy, and one barrier making them visible to vertex input
+    void record(VkCommandBuffer cmdBuffer, uint32_t slot);
+
+    // same, but for another queue family: each written buffer gets a release barrier and ends up in released,
+    // the receiving queue has to record the matching acquire. only for buffers this queue already owns (fresh ones)
+    void recordRelease(
+        VkCommandBuffer cmdBuffer,
+        uint32_t slot,
+        uint32_t srcFamily,
+        uint32_t dstFamily,
+        std::vector<VkBuffer>* released);
+};
+
+#endif
\ No newline at end of file
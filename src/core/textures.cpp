@@ -0,0 +1,495 @@
+#include "textures.h"
+
+#ifdef HAS_VULKAN
+
+#include <algorithm>
+#include <queue>
+
+#include "allocator.h"
+#include "staging.h"
+#include "profiler.h"
+
+namespace
+{
+    double msSince(const Engine::TextureStreamer::Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Engine::TextureStreamer::Clock::now() - start).count();
+    }
+
+    VkImageMemoryBarrier levelBarrier(VkImage image, const uint32_t level, const uint32_t nLevels, VkImageLayout from, VkImageLayout to)
+    {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = from;
+        barrier.newLayout = to;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = level;
+        barrier.subresourceRange.levelCount = nLevels;
+        barrier.subresourceRange.layerCount = 1;
+
+        return barrier;
+    }
+}
+
+VkResult Engine::TextureStreamer::create(
+    VkDevice dev,
+    Allocator* allocator,
+    const float maxAnisotropy,
+    const VkDeviceSize stagingSize,
+    const uint32_t framesInFlight)
+{
+    this->vkDev = dev;
+    this->allocator = allocator;
+    this->maxAnisotropy = maxAnisotropy;
+    this->framesInFlight = framesInFlight;
+    this->stagingSize = stagingSize;
+
+    this->staging = new StagingRing();
+    return this->staging->create(allocator, stagingSize, framesInFlight);
+}
+
+void Engine::TextureStreamer::destroy()
+{
+    for (const auto stream : this->streams)
+    {
+        delete stream;
+    }
+
+    this->streams.clear();
+
+    for (const auto texture : this->textures)
+    {
+        this->retired.push_back({texture->image, texture->allocation, texture->view, 0});
+        delete texture;
+    }
+
+    this->textures.clear();
+    this->destroyRetired(true);
+
+    for (const auto& [desc, sampler] : this->samplers)
+    {
+        vkDestroySampler(this->vkDev, sampler, nullptr);
+    }
+
+    this->samplers.clear();
+
+    if (this->staging != nullptr)
+    {
+        this->staging->destroy();
+        delete this->staging;
+        this->staging = nullptr;
+    }
+}
+
+VkResult Engine::TextureStreamer::load(const std::string& path, const SamplerDesc& sampler, Texture** pTexture)
+{
+    const auto stream = new Stream();
+
+    if (!Loaders::resolve(path, &stream->file))
+    {
+        delete stream;
+        return VK_ERROR_UNKNOWN;
+    }
+
+    if (!Loaders::parseKtx2(stream->file.data(), stream->file.size(), &stream->info))
+    {
+        delete stream;
+        return VK_ERROR_FORMAT_NOT_SUPPORTED;
+    }
+
+    const auto texture = new Texture();
+    texture->format = stream->info.format;
+    texture->extent = {stream->info.width, stream->info.height};
+    texture->levels = static_cast<uint32_t>(stream->info.levels.size());
+    texture->residentLevel = texture->levels;
+    texture->sampler = this->sampler(sampler);
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = texture->format;
+    imageInfo.extent = {texture->extent.width, texture->extent.height, 1};
+    imageInfo.mipLevels = texture->levels;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkResult result = texture->sampler != VK_NULL_HANDLE ? VK_SUCCESS : VK_ERROR_INITIALIZATION_FAILED;
+
+    if (result == VK_SUCCESS)
+    {
+        result = this->allocator->createImage(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, &texture->image, &texture->allocation);
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        delete texture;
+        delete stream;
+        return result;
+    }
+
+    stream->texture = texture;
+    stream->level = texture->levels - 1;
+    stream->loadedAt = Clock::now();
+
+    this->streams.push_back(stream);
+    this->textures.push_back(texture);
+
+    *pTexture = texture;
+    return VK_SUCCESS;
+}
+
+void Engine::TextureStreamer::unload(Texture* texture)
+{
+    const auto stream = std::find_if(this->streams.begin(), this->streams.end(), [texture](const Stream* stream)
+    {
+        return stream->texture == texture;
+    });
+
+    if (stream != this->streams.end())
+    {
+        delete *stream;
+        this->streams.erase(stream);
+    }
+
+    // copies into it may have gone out with the last frame recorded
+    this->retired.push_back({texture->image, texture->allocation, texture->view, this->frame});
+
+    std::erase(this->textures, texture);
+    delete texture;
+}
+
+VkSampler Engine::TextureStreamer::sampler(const SamplerDesc& desc)
+{
+    const float anisotropy = std::min(desc.anisotropy, this->maxAnisotropy);
+    const bool anisotropic = anisotropy > 1.0f;
+
+    const auto key = std::make_tuple(desc.filter, desc.mipmapMode, desc.addressMode, anisotropic ? anisotropy : 1.0f);
+    const auto found = this->samplers.find(key);
+
+    if (found != this->samplers.end())
+    {
+        return found->second;
+    }
+
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = desc.filter;
+    samplerInfo.minFilter = desc.filter;
+    samplerInfo.mipmapMode = desc.mipmapMode;
+    samplerInfo.addressModeU = desc.addressMode;
+    samplerInfo.addressModeV = desc.addressMode;
+    samplerInfo.addressModeW = desc.addressMode;
+    samplerInfo.anisotropyEnable = anisotropic ? VK_TRUE : VK_FALSE;
+    samplerInfo.maxAnisotropy = anisotropic ? anisotropy : 1.0f;
+    samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+    samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
+
+    VkSampler sampler;
+
+    if (vkCreateSampler(this->vkDev, &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    this->samplers.emplace(key, sampler);
+    return sampler;
+}
+
+void Engine::TextureStreamer::retire(const uint32_t slot, const uint64_t frame)
+{
+    this->frame = frame;
+    this->staging->retire(slot);
+    this->destroyRetired(false);
+}
+
+void Engine::TextureStreamer::destroyRetired(const bool all)
+{
+    for (auto retired = this->retired.begin(); retired != this->retired.end();)
+    {
+        if (!all && this->frame < retired->retiredAt + this->framesInFlight)
+        {
+            ++retired;
+            continue;
+        }
+
+        if (retired->view != VK_NULL_HANDLE)
+        {
+            vkDestroyImageView(this->vkDev, retired->view, nullptr);
+        }
+
+        if (retired->image != VK_NULL_HANDLE)
+        {
+            this->allocator->destroyImage(retired->image, retired->allocation);
+        }
+
+        retired = this->retired.erase(retired);
+    }
+}
+
+bool Engine::TextureStreamer::makeResident(Texture* texture, const uint32_t level)
+{
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = texture->image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = texture->format;
+    viewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = level;
+    viewInfo.subresourceRange.levelCount = texture->levels - level;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    VkImageView view;
+
+    // the old view keeps getting used until one covering more levels works
+    if (vkCreateImageView(this->vkDev, &viewInfo, nullptr, &view) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    if (texture->view != VK_NULL_HANDLE)
+    {
+        this->retired.push_back({VK_NULL_HANDLE, {}, texture->view, this->frame});
+    }
+
+    texture->view = view;
+    texture->residentLevel = level;
+
+    return true;
+}
+
+void Engine::TextureStreamer::record(VkCommandBuffer cmdBuffer, const uint32_t slot, const uint64_t frame)
+{
+    PROFILE_ZONE("texture uploads");
+
+    this->frame = frame;
+    this->uploadedLastFrame = 0;
+
+    struct Candidate
+    {
+        size_t size;
+        size_t order;
+        Stream* stream;
+
+        bool operator>(const Candidate& other) const
+        {
+            return this->size != other.size ? this->size > other.size : this->order > other.order;
+        }
+    };
+
+    // the smallest level waiting anywhere goes next, oldest texture first among equals
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<>> queue;
+
+    for (size_t i = 0; i < this->streams.size(); i++)
+    {
+        Stream* stream = this->streams[i];
+        queue.push({stream->info.levels[stream->level].size, i, stream});
+    }
+
+    struct Copy
+    {
+        VkImage image;
+        VkBufferImageCopy region;
+    };
+
+    std::vector<VkImageMemoryBarrier> before;
+    std::vector<VkImageMemoryBarrier> after;
+    std::vector<Copy> copies;
+    std::vector<std::pair<Texture*, uint32_t>> resident;
+    std::vector<Stream*> finished;
+
+    // a frame can't stage more than its share of the ring, wrapping around wastes some of it too
+    const VkDeviceSize budget = std::min(this->budget, this->stagingSize / (this->framesInFlight + 1));
+    VkDeviceSize staged = 0;
+
+    while (!queue.empty())
+    {
+        const Candidate candidate = queue.top();
+        queue.pop();
+
+        Stream* stream = candidate.stream;
+        Texture* texture = stream->texture;
+
+        const Loaders::TextureInfo& info = stream->info;
+        const Loaders::TextureInfo::Level& level = info.levels[stream->level];
+
+        const uint32_t blockRows = (level.height + info.blockHeight - 1) / info.blockHeight;
+        const VkDeviceSize rowSize = level.size / blockRows;
+
+        // whatever fits in what's left, but a frame that hasn't uploaded anything yet always takes a row
+        const VkDeviceSize left = budget > staged ? budget - staged : 0;
+        auto rows = static_cast<uint32_t>(std::min<VkDeviceSize>(blockRows - stream->row, left / rowSize));
+
+        if (rows == 0)
+        {
+            if (staged > 0)
+            {
+                break;
+            }
+
+            rows = 1;
+        }
+
+        VkDeviceSize offset;
+        const char* data = stream->file.data() + level.offset + stream->row * rowSize;
+
+        // the ring is full until frames in flight retire
+        if (this->staging->stage(data, rows * rowSize, std::max(info.blockSize, 4u), &offset) != VK_SUCCESS)
+        {
+            break;
+        }
+
+        if (!stream->started)
+        {
+            before.push_back(levelBarrier(texture->image, 0, texture->levels, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+            stream->started = true;
+        }
+
+        const uint32_t y = stream->row * info.blockHeight;
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = offset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = stream->level;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, static_cast<int32_t>(y), 0};
+        region.imageExtent = {level.width, std::min(rows * info.blockHeight, level.height - y), 1};
+
+        copies.push_back({texture->image, region});
+        staged += rows * rowSize;
+        stream->row += rows;
+
+        // out of budget halfway through the level, the rest goes next frame
+        if (stream->row < blockRows)
+        {
+            break;
+        }
+
+        after.push_back(levelBarrier(texture->image, stream->level, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL));
+        resident.emplace_back(texture, stream->level);
+
+        if (stream->level == texture->levels - 1)
+        {
+            this->firstLevels++;
+            this->firstLevelTotal += msSince(stream->loadedAt);
+        }
+
+        if (stream->level == 0)
+        {
+            finished.push_back(stream);
+            continue;
+        }
+
+        stream->level--;
+        stream->row = 0;
+        queue.push({info.levels[stream->level].size, candidate.order, stream});
+    }
+
+    if (!before.empty())
+    {
+        vkCmdPipelineBarrier(
+            cmdBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            static_cast<uint32_t>(before.size()), before.data());
+    }
+
+    for (const auto& copy : copies)
+    {
+        vkCmdCopyBufferToImage(cmdBuffer, this->staging->stagingBuffer(), copy.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy.region);
+    }
+
+    if (!after.empty())
+    {
+        for (auto& barrier : after)
+        {
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        }
+
+        vkCmdPipelineBarrier(
+            cmdBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            static_cast<uint32_t>(after.size()), after.data());
+    }
+
+    // nothing pending in the ring itself, this just marks what this frame staged
+    this->staging->record(cmdBuffer, slot);
+
+    // the views only change once their levels have been copied, a texture finishing several
+    // levels in one frame goes straight to the finest of them
+    for (auto entry = resident.rbegin(); entry != resident.rend(); ++entry)
+    {
+        const auto [texture, level] = *entry;
+
+        if (level < texture->residentLevel)
+        {
+            this->makeResident(texture, level);
+        }
+    }
+
+    for (const auto stream : finished)
+    {
+        const double residentMs = msSince(stream->loadedAt);
+
+        this->completed++;
+        this->residentTotal += residentMs;
+        this->maxResidentMs = std::max(this->maxResidentMs, residentMs);
+
+        std::erase(this->streams, stream);
+        delete stream;
+    }
+
+    this->uploadedLastFrame = staged;
+    this->uploadedBytes += staged;
+}
+
+Engine::TextureStreamer::Stats Engine::TextureStreamer::stats() const
+{
+    Stats stats;
+    stats.budget = std::min(this->budget, this->stagingSize / (this->framesInFlight + 1));
+    stats.uploadedLastFrame = this->uploadedLastFrame;
+    stats.uploadedBytes = this->uploadedBytes;
+    stats.streaming = static_cast<uint32_t>(this->streams.size());
+
+    for (const auto stream : this->streams)
+    {
+        const Loaders::TextureInfo& info = stream->info;
+
+        for (uint32_t level = 0; level <= stream->level; level++)
+        {
+            stats.pendingBytes += info.levels[level].size;
+        }
+
+        const uint32_t blockRows = (info.levels[stream->level].height + info.blockHeight - 1) / info.blockHeight;
+        stats.pendingBytes -= info.levels[stream->level].size / blockRows * stream->row;
+    }
+
+    stats.completed = this->completed;
+    stats.firstLevelMs = this->firstLevels > 0 ? this->firstLevelTotal / this->firstLevels : 0.0;
+    stats.residentMs = this->completed > 0 ? this->residentTotal / this->completed : 0.0;
+    stats.maxResidentMs = this->maxResidentMs;
+
+    return stats;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,153 @@
+#pragma once
+#include "engine.h"
+
+#ifdef HAS_VULKAN
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <tuple>
+
+#include "loaders/loaders.h"
+
+struct Engine::SamplerDesc
+{
+    VkFilter filter = VK_FILTER_LINEAR;
+    VkSamplerMipmapMode mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+
+    // clamped to what the device supports, 1 or less turns it off
+    float anisotropy = 1.0f;
+};
+
+// A texture as far as it has streamed in. view only covers the levels that are resident
+// and is replaced as finer ones arrive, so read it again whenever it gets bound.
+struct Engine::Texture
+{
+    VkImage image = VK_NULL_HANDLE;
+    Allocation allocation;
+
+    // VK_NULL_HANDLE until the first level is in
+    VkImageView view = VK_NULL_HANDLE;
+    VkSampler sampler = VK_NULL_HANDLE;
+
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent{};
+    uint32_t levels = 0;
+
+    // finest level the view covers, levels while there's nothing to sample yet
+    uint32_t residentLevel = 0;
+};
+
+// Streams KTX2 textures into sampled images from the end of their mip chain: the smallest
+// levels of everything loaded go first, so textures show up blurry right away and sharpen
+// over the next frames. Every frame stages at most budget bytes into its own ring and
+// records the copies ahead of the frame's passes, levels too big for one frame go up in
+// bands of rows. Files are read through Loaders::resolve(), so they can be in an archive.
+class Engine::TextureStreamer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats
+    {
+        VkDeviceSize budget = 0;
+        VkDeviceSize uploadedLastFrame = 0;
+        uint64_t uploadedBytes = 0;
+
+        // textures still missing levels, and how many bytes they're missing
+        uint32_t streaming = 0;
+        uint64_t pendingBytes = 0;
+
+        // from load() to the frame recording a texture's first level and its last one,
+        // averaged over the textures that got that far, GPU time not included
+        uint32_t completed = 0;
+        double firstLevelMs = 0.0;
+        double residentMs = 0.0;
+        double maxResidentMs = 0.0;
+    };
+
+private:
+    struct Stream
+    {
+        Texture* texture;
+        Loaders::Asset file;
+        Loaders::TextureInfo info;
+
+        // next level to upload, counting down to 0, and how many block rows of it are done
+        uint32_t level;
+        uint32_t row = 0;
+
+        Clock::time_point loadedAt;
+        bool started = false;
+    };
+
+    // views, and whole textures, that frames in flight may still be sampling
+    struct Retired
+    {
+        VkImage image;
+        Allocation allocation;
+        VkImageView view;
+        uint64_t retiredAt;
+    };
+
+    VkDevice vkDev = VK_NULL_HANDLE;
+    Allocator* allocator = nullptr;
+    uint32_t framesInFlight = 1;
+    float maxAnisotropy = 0.0f;
+
+    StagingRing* staging = nullptr;
+    VkDeviceSize stagingSize = 0;
+
+    std::map<std::tuple<VkFilter, VkSamplerMipmapMode, VkSamplerAddressMode, float>, VkSampler> samplers;
+    std::vector<Texture*> textures;
+    std::vector<Stream*> streams;
+    std::vector<Retired> retired;
+
+    // the last frame given to retire() or record()
+    uint64_t frame = 0;
+
+    VkDeviceSize uploadedLastFrame = 0;
+    uint64_t uploadedBytes = 0;
+
+    uint32_t firstLevels = 0;
+    uint32_t completed = 0;
+    double firstLevelTotal = 0.0;
+    double residentTotal = 0.0;
+    double maxResidentMs = 0.0;
+
+    // points the texture's view at level and everything smaller
+    bool makeResident(Texture* texture, uint32_t level);
+    void destroyRetired(bool all);
+
+public:
+    // bytes staged per frame, up to stagingSize / (framesInFlight + 1) so there's always room
+    // in the ring. A frame always gets at least one row in, so nothing stalls on a tiny budget
+    VkDeviceSize budget = 8ull * 1024 * 1024;
+
+    // maxAnisotropy is 0 if the device doesn't have samplerAnisotropy enabled
+    VkResult create(VkDevice dev, Allocator* allocator, float maxAnisotropy, VkDeviceSize stagingSize, uint32_t framesInFlight);
+
+    // the GPU has to be done with every texture
+    void destroy();
+
+    // creates the image right away (nothing resident) and queues every level,
+    // VK_ERROR_FORMAT_NOT_SUPPORTED for files parseKtx2() doesn't take
+    VkResult load(const std::string& path, const SamplerDesc& sampler, Texture** pTexture);
+
+    // stops streaming it, and destroys it once the frames in flight are done with it
+    void unload(Texture* texture);
+
+    // cached, samplers live as long as the streamer
+    VkSampler sampler(const SamplerDesc& desc);
+
+    // the slot's fence has been waited on, its staging space is free again
+    void retire(uint32_t slot, uint64_t frame);
+
+    // stages this frame's share and records the copies and layout changes, outside any render pass
+    void record(VkCommandBuffer cmdBuffer, uint32_t slot, uint64_t frame);
+
+    [[nodiscard]] Stats stats() const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,236 @@
+#include "transfer.h"
+
+#ifdef HAS_VULKAN
+
+#include "staging.h"
+
+VkResult Engine::TransferQueue::create(
+    VkDevice dev,
+    Allocator* allocator,
+    VkQueue queue,
+    const uint32_t family,
+    const uint32_t dstFamily,
+    const VkDeviceSize stagingSize,
+    const uint32_t nBatches)
+{
+    this->vkDev = dev;
+    this->vkQueue = queue;
+    this->family = family;
+    this->dstFamily = dstFamily;
+
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+
+    VkResult result = vkCreateSemaphore(dev, &semaphoreInfo, nullptr, &this->timeline);
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = family;
+
+    result = vkCreateCommandPool(dev, &poolInfo, nullptr, &this->vkCmdPool);
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
+    std::vector<VkCommandBuffer> cmdBuffers(nBatches);
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = this->vkCmdPool;
+    allocInfo.commandBufferCount = nBatches;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
+    result = vkAllocateCommandBuffers(dev, &allocInfo, cmdBuffers.data());
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
+    for (const auto& cmdBuffer : cmdBuffers)
+    {
+        this->batches.push_back({cmdBuffer, 0});
+    }
+
+    this->staging = new StagingRing();
+    return this->staging->create(allocator, stagingSize, nBatches);
+}
+
+void Engine::TransferQueue::destroy()
+{
+    if (this->staging != nullptr)
+    {
+        this->staging->destroy();
+        delete this->staging;
+        this->staging = nullptr;
+    }
+
+    if (this->vkCmdPool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(this->vkDev, this->vkCmdPool, nullptr);
+        this->vkCmdPool = VK_NULL_HANDLE;
+        this->batches.resize(0);
+    }
+
+    if (this->timeline != VK_NULL_HANDLE)
+    {
+        vkDestroySemaphore(this->vkDev, this->timeline, nullptr);
+        this->timeline = VK_NULL_HANDLE;
+    }
+
+    this->releases.resize(0);
+}
+
+VkResult Engine::TransferQueue::upload(
+    VkBuffer dst,
+    const VkDeviceSize dstOffset,
+    const void* data,
+    const VkDeviceSize size,
+    uint64_t* pValue)
+{
+    const VkResult result = this->staging->upload(dst, dstOffset, data, size);
+
+    if (result == VK_SUCCESS)
+    {
+        *pValue = this->nextValue;
+    }
+
+    return result;
+}
+
+VkResult Engine::TransferQueue::flush()
+{
+    uint64_t completed;
+    VkResult result = vkGetSemaphoreCounterValue(this->vkDev, this->timeline, &completed);
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
+    for (uint32_t i = 0; i < this->batches.size(); i++)
+    {
+        if (this->batches[i].value <= completed)
+        {
+            this->staging->retire(i);
+        }
+    }
+
+    // retired first either way, or a full ring with nothing new to copy never frees up
+    if (this->staging->empty())
+    {
+        return VK_SUCCESS;
+    }
+
+    // the copy engine is behind, the uploads just wait for the next frame
+    Batch& batch = this->batches[this->nextBatch];
+
+    if (batch.value > completed)
+    {
+        return VK_SUCCESS;
+    }
+
+    vkResetCommandBuffer(batch.cmdBuffer, 0);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    result = vkBeginCommandBuffer(batch.cmdBuffer, &beginInfo);
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
+    std::vector<VkBuffer> released;
+    this->staging->recordRelease(batch.cmdBuffer, this->nextBatch, this->family, this->dstFamily, &released);
+
+    result = vkEndCommandBuffer(batch.cmdBuffer);
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
+    batch.value = this->nextValue++;
+
+    for (const auto& buffer : released)
+    {
+        this->releases.push_back({buffer, batch.value});
+    }
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &batch.value;
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.cmdBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &this->timeline;
+
+    this->nextBatch = (this->nextBatch + 1) % static_cast<uint32_t>(this->batches.size());
+    return vkQueueSubmit(this->vkQueue, 1, &submitInfo, VK_NULL_HANDLE);
+}
+
+uint64_t Engine::TransferQueue::acquire(VkCommandBuffer cmdBuffer)
+{
+    uint64_t completed = 0;
+    vkGetSemaphoreCounterValue(this->vkDev, this->timeline, &completed);
+
+    // releases are queued in value order, so the finished ones are at the front
+    std::vector<VkBufferMemoryBarrier> barriers;
+    auto release = this->releases.begin();
+
+    for (; release != this->releases.end() && release->value <= completed; ++release)
+    {
+        // has to match the release on the transfer queue
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+        barrier.srcQueueFamilyIndex = this->family;
+        barrier.dstQueueFamilyIndex = this->dstFamily;
+        barrier.buffer = release->buffer;
+        barrier.size = VK_WHOLE_SIZE;
+
+        barriers.push_back(barrier);
+    }
+
+    this->releases.erase(this->releases.begin(), release);
+
+    if (!barriers.empty())
+    {
+        vkCmdPipelineBarrier(
+            cmdBuffer,
+            // chains onto the timeline wait, which waits at vertex input
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            0,
+            0, nullptr,
+            static_cast<uint32_t>(barriers.size()), barriers.data(),
+            0, nullptr);
+    }
+
+    return completed;
+}
+
+#endif
\ No newline at end of file
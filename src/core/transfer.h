@@ -0,0 +1,63 @@
+#pragma once
+#include "engine.h"
+
+#ifdef HAS_VULKAN
+
+// Uploads on a dedicated transfer queue family. Each flush is one submit signalling
+// the next timeline value, the written buffers are released to the graphics family
+// and acquired by whichever frame first sees that value completed, so the graphics
+// queue never waits on a copy that isn't finished yet.
+class Engine::TransferQueue
+{
+    struct Batch
+    {
+        VkCommandBuffer cmdBuffer;
+        uint64_t value;
+    };
+
+    struct Release
+    {
+        VkBuffer buffer;
+        uint64_t value;
+    };
+
+    VkDevice vkDev = VK_NULL_HANDLE;
+    VkQueue vkQueue = VK_NULL_HANDLE;
+    uint32_t family = 0;
+    uint32_t dstFamily = 0;
+
+    VkCommandPool vkCmdPool = VK_NULL_HANDLE;
+    std::vector<Batch> batches;
+    uint32_t nextBatch = 0;
+
+    StagingRing* staging = nullptr;
+    std::vector<Release> releases;
+
+    // value signalled by the next flush
+    uint64_t nextValue = 1;
+
+public:
+    VkSemaphore timeline = VK_NULL_HANDLE;
+
+    VkResult create(
+        VkDevice dev,
+        Allocator* allocator,
+        VkQueue queue,
+        uint32_t family,
+        uint32_t dstFamily,
+        VkDeviceSize stagingSize,
+        uint32_t nBatches);
+
+    void destroy();
+
+    // the buffer is usable on dstFamily once acquire() returns at least *pValue
+    VkResult upload(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size, uint64_t* pValue);
+
+    // submits everything uploaded since the last flush, skipped while every batch is still busy, never waits
+    VkResult flush();
+
+    // records acquire barriers for every finished release, returns the last finished value
+    uint64_t acquire(VkCommandBuffer cmdBuffer);
+};
+
+#endif
\ No newline at end of file
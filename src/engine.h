@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 
 #ifdef HAS_VULKAN
@@ -11,6 +12,26 @@ namespace Engine
     static constexpr int VERSION[3] = {0, 1, 0};
 
     class Game;
+    class JobSystem;
+    struct JobCounter;
+    struct Job;
+    class Profiler;
+    struct ProfileStats;
+    struct Vec3;
+    struct Vec4;
+    struct Quat;
+    struct Mat4;
+    struct Plane;
+    struct Aabb;
+    struct Sphere;
+    struct Frustum;
+    enum class SimdLevel : uint8_t;
+    class World;
+    class Commands;
+    struct Entity;
+    class Scene;
+    struct Node;
+    class CullList;
 
 #ifdef _DEBUG
     static auto DEBUG = true;
@@ -24,9 +45,53 @@ namespace Engine
     static std::vector VK_DEVICE_EXTENSIONS = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 
     class Renderer;
+    class Allocator;
+    struct Allocation;
+    struct AllocatorStats;
+    struct DefragmentationMove;
+    class StagingRing;
+    class TransferQueue;
+    class CommandRecorder;
+    struct Mesh;
+    struct VertexLayout;
+    class GpuProfiler;
+    struct GpuScope;
+    struct GpuFrameStats;
+    class RenderGraph;
+    struct PipelineDesc;
+    class PipelineCache;
+    class LayoutCache;
+    class ShaderLibrary;
+    struct SamplerDesc;
+    struct Texture;
+    class TextureStreamer;
 #endif
 }
 
+#ifdef HAS_VULKAN
+namespace Loaders
+{
+    struct ShaderReflection;
+}
+#endif
+
 #include "core/game.h"
+#include "core/profiler.h"
+#include "core/jobs.h"
+#include "core/math.h"
+#include "core/ecs.h"
+#include "core/scene.h"
+#include "core/culling.h"
+#include "core/allocator.h"
+#include "core/staging.h"
+#include "core/transfer.h"
+#include "core/recorder.h"
+#include "core/mesh.h"
+#include "core/gpuProfiler.h"
+#include "core/renderGraph.h"
+#include "core/pipelines.h"
+#include "core/layouts.h"
+#include "core/shaders.h"
+#include "core/textures.h"
 #include "core/renderer.h"
 #include "loaders/loaders.h"
\ No newline at end of file
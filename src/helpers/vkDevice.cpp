@@ -3,6 +3,7 @@
 #include "vkSwapchain.h"
 #ifdef HAS_VULKAN
 
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 #include <vector>
@@ -24,12 +25,17 @@ uint32_t deviceScore(VkPhysicalDevice dev, VkSurfaceKHR surface)
 
     score += props.limits.maxImageDimension3D;
 
+    const bool headless = surface == VK_NULL_HANDLE;
+
     VkQueueIndices indices = vkQueueIndices(dev, surface);
-    VkSwapChainDetails swapChain = vkQuerySwapchain(dev, surface);
+    bool extensionSupport = deviceSupportsExtensions(dev, vkRequiredDeviceExtensions(headless));
 
-    bool extensionSupport = deviceSupportsExtensions(dev);
+    if (!indices.complete() || !extensionSupport)
+    {
+        return 0;
+    }
 
-    if (!indices.complete() || !extensionSupport || !swapChain.supported())
+    if (!headless && !vkQuerySwapchain(dev, surface).supported())
     {
         return 0;
     }
@@ -37,21 +43,21 @@ uint32_t deviceScore(VkPhysicalDevice dev, VkSurfaceKHR surface)
     return score;
 }
 
-bool deviceSupportsExtensions(VkPhysicalDevice dev)
+bool deviceSupportsExtensions(VkPhysicalDevice dev, const std::vector<const char*>& extensions)
 {
     uint32_t nExtensions;
     vkEnumerateDeviceExtensionProperties(dev, nullptr, &nExtensions, nullptr);
 
-    std::vector<VkExtensionProperties> extensions(nExtensions);
-    vkEnumerateDeviceExtensionProperties(dev, nullptr, &nExtensions, extensions.data());
+    std::vector<VkExtensionProperties> available(nExtensions);
+    vkEnumerateDeviceExtensionProperties(dev, nullptr, &nExtensions, available.data());
 
-    for (const auto& requested : Engine::VK_DEVICE_EXTENSIONS)
+    for (const auto& requested : extensions)
     {
         bool found = false;
 
-        for (const auto& ext : extensions)
+        for (const auto& ext : available)
         {
-            found = strcmp(ext.extensionName, requested);
+            found = strcmp(ext.extensionName, requested) == 0;
             if (found) break;
         }
 
@@ -61,4 +67,80 @@ bool deviceSupportsExtensions(VkPhysicalDevice dev)
     return true;
 }
 
+std::vector<const char*> vkRequiredDeviceExtensions(bool headless)
+{
+    std::vector<const char*> extensions;
+
+    for (const auto& ext : Engine::VK_DEVICE_EXTENSIONS)
+    {
+        if (headless && strcmp(ext, VK_KHR_SWAPCHAIN_EXTENSION_NAME) == 0)
+        {
+            continue;
+        }
+
+        extensions.push_back(ext);
+    }
+
+    return extensions;
+}
+
+bool vkSupportsTimelineSemaphores(VkPhysicalDevice dev, const uint32_t instanceVersion)
+{
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(dev, &props);
+
+    if (instanceVersion < VK_API_VERSION_1_2 || props.apiVersion < VK_API_VERSION_1_2)
+    {
+        return false;
+    }
+
+    VkPhysicalDeviceVulkan12Features features12{};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &features12;
+
+    vkGetPhysicalDeviceFeatures2(dev, &features);
+    return features12.timelineSemaphore == VK_TRUE;
+}
+
+VkDynamicRendering vkSupportsDynamicRendering(VkPhysicalDevice dev, const uint32_t instanceVersion)
+{
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(dev, &props);
+
+    const uint32_t version = std::min(instanceVersion, props.apiVersion);
+
+    // the extension needs depth/stencil resolve, which is core from 1.2
+    if (version < VK_API_VERSION_1_2)
+    {
+        return VkDynamicRendering::UNSUPPORTED;
+    }
+
+    const bool core = version >= VK_API_VERSION_1_3;
+
+    if (!core && !deviceSupportsExtensions(dev, {VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME}))
+    {
+        return VkDynamicRendering::UNSUPPORTED;
+    }
+
+    // the extension struct is still valid on 1.3, so one query covers both
+    VkPhysicalDeviceDynamicRenderingFeatures dynamicRendering{};
+    dynamicRendering.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &dynamicRendering;
+
+    vkGetPhysicalDeviceFeatures2(dev, &features);
+
+    if (dynamicRendering.dynamicRendering != VK_TRUE)
+    {
+        return VkDynamicRendering::UNSUPPORTED;
+    }
+
+    return core ? VkDynamicRendering::CORE : VkDynamicRendering::EXTENSION;
+}
+
 #endif
\ No newline at end of file
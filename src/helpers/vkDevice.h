@@ -1,9 +1,27 @@
 #pragma once
 #ifdef HAS_VULKAN
 
+#include <vector>
 #include <vulkan/vulkan.h>
 
+// a null surface scores the device for headless rendering
 uint32_t deviceScore(VkPhysicalDevice dev, VkSurfaceKHR surface);
-bool deviceSupportsExtensions(VkPhysicalDevice dev);
+bool deviceSupportsExtensions(VkPhysicalDevice dev, const std::vector<const char*>& extensions);
+
+// Engine::VK_DEVICE_EXTENSIONS, minus the presentation ones when headless
+std::vector<const char*> vkRequiredDeviceExtensions(bool headless);
+
+// needs a 1.2 instance and device, features2 isn't there on 1.0 instances
+bool vkSupportsTimelineSemaphores(VkPhysicalDevice dev, uint32_t instanceVersion);
+
+enum class VkDynamicRendering
+{
+    UNSUPPORTED,
+    EXTENSION, // VK_KHR_dynamic_rendering has to be enabled, functions end in KHR
+    CORE
+};
+
+// core on a 1.3 instance and device, 1.2 ones can still have the extension
+VkDynamicRendering vkSupportsDynamicRendering(VkPhysicalDevice dev, uint32_t instanceVersion);
 
 #endif
\ No newline at end of file
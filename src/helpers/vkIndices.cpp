@@ -6,6 +6,7 @@
 VkQueueIndices vkQueueIndices(VkPhysicalDevice dev, VkSurfaceKHR surface)
 {
     VkQueueIndices indices{};
+    indices.needsPresent = surface != VK_NULL_HANDLE;
 
     uint32_t nQueueFamilies;
     vkGetPhysicalDeviceQueueFamilyProperties(dev, &nQueueFamilies, nullptr);
@@ -18,18 +19,28 @@ VkQueueIndices vkQueueIndices(VkPhysicalDevice dev, VkSurfaceKHR surface)
     {
         if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
         {
-            indices.graphicsFamily = i;
+            if (!indices.graphicsFamily.has_value()) indices.graphicsFamily = i;
+        } else if (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT)
+        {
+            // prefer pure transfer families over async compute ones
+            if (!indices.transferFamily.has_value() || !(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT))
+            {
+                indices.transferFamily = i;
+            }
         }
 
-        VkBool32 presentSupport;
-        vkGetPhysicalDeviceSurfaceSupportKHR(dev, i, surface, &presentSupport);
-
-        if (presentSupport)
+        if (indices.needsPresent)
         {
-            indices.presentFamily = i;
+            VkBool32 presentSupport;
+            vkGetPhysicalDeviceSurfaceSupportKHR(dev, i, surface, &presentSupport);
+
+            // presenting from the graphics queue saves a queue family transfer
+            if (presentSupport && (!indices.presentFamily.has_value() || indices.graphicsFamily == i))
+            {
+                indices.presentFamily = i;
+            }
         }
 
-        if (indices.complete()) break;
         i++;
     }
 
@@ -11,17 +11,28 @@ struct VkQueueIndices
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
 
+    // a family that can copy but not draw, usually the DMA engine
+    std::optional<uint32_t> transferFamily;
+
+    // headless devices never present, so they don't need a present family
+    bool needsPresent = true;
+
     [[nodiscard]] bool complete() const
     {
-        return graphicsFamily.has_value() && presentFamily.has_value();
+        return graphicsFamily.has_value() && (presentFamily.has_value() || !needsPresent);
     }
 
     std::set<uint32_t> set()
     {
-        return {graphicsFamily.value(), presentFamily.value()};
+        std::set<uint32_t> families = {graphicsFamily.value()};
+        if (presentFamily.has_value()) families.insert(presentFamily.value());
+        if (transferFamily.has_value()) families.insert(transferFamily.value());
+
+        return families;
     }
 };
 
+// pass VK_NULL_HANDLE as the surface to skip looking for a present family
 VkQueueIndices vkQueueIndices(VkPhysicalDevice dev, VkSurfaceKHR surface);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "vkPipelineCache.h"
+#ifdef HAS_VULKAN
+
+#include <cstring>
+#include <vector>
+
+#include "loaders/loaders.h"
+
+static bool validCacheHeader(VkPhysicalDevice physDev, const Loaders::FileView& data)
+{
+    VkPipelineCacheHeaderVersionOne header;
+
+    if (data.size() < sizeof(header))
+    {
+        return false;
+    }
+
+    memcpy(&header, data.data(), sizeof(header));
+
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(physDev, &props);
+
+    // drivers are supposed to reject foreign caches themselves, but not all of them do
+    return header.headerSize >= sizeof(header) &&
+        header.headerSize <= data.size() &&
+        header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+        header.vendorID == props.vendorID &&
+        header.deviceID == props.deviceID &&
+        memcmp(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+VkResult vkLoadPipelineCache(VkDevice dev, VkPhysicalDevice physDev, const char* filename, VkPipelineCache* pCache)
+{
+    Loaders::FileView data;
+
+    if (filename == nullptr || !data.open(filename) || !validCacheHeader(physDev, data))
+    {
+        data.close();
+    }
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = data.size();
+    createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+    return vkCreatePipelineCache(dev, &createInfo, nullptr, pCache);
+}
+
+VkResult vkSavePipelineCache(VkDevice dev, VkPipelineCache cache, const char* filename)
+{
+    size_t size;
+    VkResult result = vkGetPipelineCacheData(dev, cache, &size, nullptr);
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
+    std::vector<char> data(size);
+    result = vkGetPipelineCacheData(dev, cache, &size, data.data());
+
+    if (result != VK_SUCCESS)
+    {
+        return result;
+    }
+
+    data.resize(size);
+    return Loaders::writefile(data, filename) ? VK_SUCCESS : VK_ERROR_UNKNOWN;
+}
+
+#endif
\ No newline at end of file
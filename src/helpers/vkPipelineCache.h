@@ -0,0 +1,10 @@
+#pragma once
+#ifdef HAS_VULKAN
+
+#include <vulkan/vulkan.h>
+
+// starts from an empty cache if the file is missing or was written by another device/driver
+VkResult vkLoadPipelineCache(VkDevice dev, VkPhysicalDevice physDev, const char* filename, VkPipelineCache* pCache);
+VkResult vkSavePipelineCache(VkDevice dev, VkPipelineCache cache, const char* filename);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,780 @@
+#include "loaders.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    constexpr uint32_t MAGIC = 0x43524145; // "EARC"
+    constexpr uint32_t VERSION = 1;
+
+    // compressed entries are split into blocks this big, each compressed on its own
+    constexpr uint32_t BLOCK_SIZE = 64 * 1024;
+
+    // set in a block's size when it's stored as is
+    constexpr uint32_t BLOCK_RAW = 0x80000000;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t bucketBits;
+        uint64_t namesSize;
+
+        // of everything between the header and the first payload
+        uint32_t tocCrc;
+        uint32_t alignment;
+    };
+
+    static_assert(sizeof(Header) == 32);
+    static_assert(sizeof(Loaders::Archive::Entry) == 48);
+
+    uint64_t hashName(const std::string_view name)
+    {
+        uint64_t value = 14695981039346656037ull;
+
+        for (const char c : name)
+        {
+            value = (value ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+
+        return value;
+    }
+
+    uint32_t bucketOf(const uint64_t hash, const uint32_t bits)
+    {
+        return bits == 0 ? 0 : static_cast<uint32_t>(hash >> (64 - bits));
+    }
+
+    // CRC-32 (the zlib one), 8 bytes at a time
+    constexpr std::array<std::array<uint32_t, 256>, 8> crcTables()
+    {
+        std::array<std::array<uint32_t, 256>, 8> tables{};
+
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+
+            for (int bit = 0; bit < 8; bit++)
+            {
+                crc = crc & 1 ? crc >> 1 ^ 0xEDB88320 : crc >> 1;
+            }
+
+            tables[0][i] = crc;
+        }
+
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            for (size_t t = 1; t < 8; t++)
+            {
+                tables[t][i] = tables[t - 1][i] >> 8 ^ tables[0][tables[t - 1][i] & 0xFF];
+            }
+        }
+
+        return tables;
+    }
+
+    constexpr auto CRC_TABLES = crcTables();
+
+    uint32_t crc32(const void* data, size_t size, uint32_t crc = 0)
+    {
+        auto bytes = static_cast<const unsigned char*>(data);
+        crc = ~crc;
+
+        for (; size >= 8; size -= 8, bytes += 8)
+        {
+            uint32_t low;
+            uint32_t high;
+            memcpy(&low, bytes, 4);
+            memcpy(&high, bytes + 4, 4);
+            low ^= crc;
+
+            crc = CRC_TABLES[7][low & 0xFF] ^ CRC_TABLES[6][low >> 8 & 0xFF] ^
+                CRC_TABLES[5][low >> 16 & 0xFF] ^ CRC_TABLES[4][low >> 24] ^
+                CRC_TABLES[3][high & 0xFF] ^ CRC_TABLES[2][high >> 8 & 0xFF] ^
+                CRC_TABLES[1][high >> 16 & 0xFF] ^ CRC_TABLES[0][high >> 24];
+        }
+
+        for (; size > 0; size--, bytes++)
+        {
+            crc = crc >> 8 ^ CRC_TABLES[0][(crc ^ *bytes) & 0xFF];
+        }
+
+        return ~crc;
+    }
+
+    // A small LZ77 in the style of LZ4: each sequence is a token (literal count and match
+    // length, 4 bits each, 15 meaning more bytes follow), the literals, then a 2 byte offset
+    // back into what was already decoded. The last sequence is literals only.
+    constexpr uint32_t MIN_MATCH = 4;
+    constexpr uint32_t HASH_BITS = 12;
+    constexpr size_t WILD_COPY = 16;
+
+    uint32_t read32(const unsigned char* p)
+    {
+        uint32_t value;
+        memcpy(&value, p, 4);
+        return value;
+    }
+
+    bool writeLength(size_t length, unsigned char** op, const unsigned char* end)
+    {
+        for (; length >= 255; length -= 255)
+        {
+            if (*op >= end) return false;
+            *(*op)++ = 255;
+        }
+
+        if (*op >= end) return false;
+        *(*op)++ = static_cast<unsigned char>(length);
+
+        return true;
+    }
+
+    bool writeSequence(
+        const unsigned char* literals,
+        const size_t nLiterals,
+        const uint32_t offset,
+        const size_t matchLength,
+        unsigned char** op,
+        const unsigned char* end)
+    {
+        if (*op >= end) return false;
+
+        const size_t matchCode = matchLength > 0 ? matchLength - MIN_MATCH : 0;
+        *(*op)++ = static_cast<unsigned char>(std::min<size_t>(nLiterals, 15) << 4 | std::min<size_t>(matchCode, 15));
+
+        if (nLiterals >= 15 && !writeLength(nLiterals - 15, op, end)) return false;
+        if (static_cast<size_t>(end - *op) < nLiterals) return false;
+
+        memcpy(*op, literals, nLiterals);
+        *op += nLiterals;
+
+        if (matchLength == 0)
+        {
+            return true;
+        }
+
+        if (end - *op < 2) return false;
+        *(*op)++ = static_cast<unsigned char>(offset);
+        *(*op)++ = static_cast<unsigned char>(offset >> 8);
+
+        return matchCode < 15 || writeLength(matchCode - 15, op, end);
+    }
+
+    // bytes written, 0 if it doesn't fit in capacity
+    size_t compressBlock(const unsigned char* src, const size_t size, unsigned char* dst, const size_t capacity)
+    {
+        uint32_t table[1 << HASH_BITS];
+        std::fill(std::begin(table), std::end(table), UINT32_MAX);
+
+        unsigned char* op = dst;
+        const unsigned char* end = dst + capacity;
+
+        size_t ip = 0;
+        size_t anchor = 0;
+
+        while (ip + MIN_MATCH <= size)
+        {
+            const uint32_t sequence = read32(src + ip);
+            const uint32_t hash = sequence * 2654435761u >> (32 - HASH_BITS);
+            const uint32_t candidate = table[hash];
+            table[hash] = static_cast<uint32_t>(ip);
+
+            if (candidate == UINT32_MAX || ip - candidate > 0xFFFF || read32(src + candidate) != sequence)
+            {
+                ip++;
+                continue;
+            }
+
+            size_t length = MIN_MATCH;
+
+            while (ip + length < size && src[candidate + length] == src[ip + length])
+            {
+                length++;
+            }
+
+            if (!writeSequence(src + anchor, ip - anchor, static_cast<uint32_t>(ip - candidate), length, &op, end))
+            {
+                return 0;
+            }
+
+            ip += length;
+            anchor = ip;
+        }
+
+        if (!writeSequence(src + anchor, size - anchor, 0, 0, &op, end))
+        {
+            return 0;
+        }
+
+        return op - dst;
+    }
+
+    // false for anything that isn't exactly size bytes of valid sequences
+    bool decompressBlock(const unsigned char* src, const size_t srcSize, unsigned char* dst, const size_t size)
+    {
+        size_t ip = 0;
+        size_t op = 0;
+
+        const auto readLength = [&](size_t* length)
+        {
+            unsigned char byte;
+
+            do
+            {
+                if (ip >= srcSize) return false;
+
+                byte = src[ip++];
+                *length += byte;
+            } while (byte == 255);
+
+            return true;
+        };
+
+        while (ip < srcSize)
+        {
+            const unsigned char token = src[ip++];
+            size_t nLiterals = token >> 4;
+
+            if (nLiterals == 15 && !readLength(&nLiterals)) return false;
+            if (nLiterals > srcSize - ip || nLiterals > size - op) return false;
+
+            // short runs copy a fixed 16 bytes when both sides have room, whatever lands past
+            // the run gets overwritten by what comes next
+            if (nLiterals <= WILD_COPY && srcSize - ip >= WILD_COPY && size - op >= WILD_COPY)
+            {
+                memcpy(dst + op, src + ip, WILD_COPY);
+            } else
+            {
+                memcpy(dst + op, src + ip, nLiterals);
+            }
+
+            ip += nLiterals;
+            op += nLiterals;
+
+            if (ip == srcSize)
+            {
+                break;
+            }
+
+            if (srcSize - ip < 2) return false;
+
+            const size_t offset = src[ip] | src[ip + 1] << 8;
+            ip += 2;
+
+            size_t length = token & 15;
+
+            if (length == 15 && !readLength(&length)) return false;
+            length += MIN_MATCH;
+
+            if (offset == 0 || offset > op || length > size - op) return false;
+
+            const size_t matchEnd = op + length;
+
+            // far enough back that 16 byte chunks never read what they write
+            if (offset >= WILD_COPY && size - matchEnd >= WILD_COPY)
+            {
+                for (; op < matchEnd; op += WILD_COPY)
+                {
+                    memcpy(dst + op, dst + op - offset, WILD_COPY);
+                }
+
+                op = matchEnd;
+                continue;
+            }
+
+            // overlapping copies repeat the last offset bytes, so they go forwards in steps no
+            // bigger than offset, one byte at a time for the shortest ones
+            const size_t step = offset >= length ? length : offset >= 8 ? 8 : 1;
+
+            for (; op + step <= matchEnd; op += step)
+            {
+                memcpy(dst + op, dst + op - offset, step);
+            }
+
+            for (; op < matchEnd; op++)
+            {
+                dst[op] = dst[op - offset];
+            }
+        }
+
+        return op == size;
+    }
+
+    uint64_t alignUp(const uint64_t value, const uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // padded so the entries after it are aligned
+    uint64_t bucketTableSize(const uint32_t bits)
+    {
+        return alignUp(((1ull << bits) + 1) * sizeof(uint32_t), alignof(Loaders::Archive::Entry));
+    }
+
+    struct Mount
+    {
+        const Loaders::Archive* archive;
+        std::string prefix;
+    };
+
+    std::vector<Mount> mounts;
+}
+
+bool Loaders::Archive::open(const char* filename, const bool verify)
+{
+    this->close();
+
+    if (!this->file.open(filename, {FileView::HINT_RANDOM}) || this->file.size() < sizeof(Header))
+    {
+        this->close();
+        return false;
+    }
+
+    Header header;
+    memcpy(&header, this->file.data(), sizeof(header));
+
+    if (header.magic != MAGIC || header.version != VERSION || header.bucketBits > 31)
+    {
+        this->close();
+        return false;
+    }
+
+    const uint64_t bucketsSize = bucketTableSize(header.bucketBits);
+    const uint64_t entriesSize = static_cast<uint64_t>(header.entryCount) * sizeof(Entry);
+    const uint64_t tocSize = bucketsSize + entriesSize + header.namesSize;
+
+    if (tocSize > this->file.size() - sizeof(Header) ||
+        crc32(this->file.data() + sizeof(Header), tocSize) != header.tocCrc)
+    {
+        this->close();
+        return false;
+    }
+
+    const char* toc = this->file.data() + sizeof(Header);
+
+    this->buckets = reinterpret_cast<const uint32_t*>(toc);
+    this->bucketBits = header.bucketBits;
+    this->pEntries = reinterpret_cast<const Entry*>(toc + bucketsSize);
+    this->nEntries = header.entryCount;
+    this->names = toc + bucketsSize + entriesSize;
+
+    // checked once here so nothing else has to
+    for (uint32_t i = 0; i < this->nEntries; i++)
+    {
+        const Entry& entry = this->pEntries[i];
+
+        const bool payloadFits = entry.offset <= this->file.size() && entry.storedSize <= this->file.size() - entry.offset;
+        const bool nameFits = entry.nameOffset <= header.namesSize && entry.nameSize <= header.namesSize - entry.nameOffset;
+
+        // a sequence can't expand to more than 255 times its size, anything claiming otherwise
+        // would only have us allocate whatever it says
+        const bool sizeFits = entry.flags & ENTRY_COMPRESSED ? entry.size / 255 <= entry.storedSize : entry.storedSize == entry.size;
+
+        if (!payloadFits || !nameFits || !sizeFits)
+        {
+            this->close();
+            return false;
+        }
+
+        if (verify && !this->verify(entry))
+        {
+            this->close();
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i <= (1u << this->bucketBits); i++)
+    {
+        if (this->buckets[i] > this->nEntries || (i > 0 && this->buckets[i] < this->buckets[i - 1]))
+        {
+            this->close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Loaders::Archive::close()
+{
+    this->file.close();
+
+    this->buckets = nullptr;
+    this->bucketBits = 0;
+    this->pEntries = nullptr;
+    this->nEntries = 0;
+    this->names = nullptr;
+}
+
+const Loaders::Archive::Entry* Loaders::Archive::find(const std::string_view name) const
+{
+    if (this->nEntries == 0)
+    {
+        return nullptr;
+    }
+
+    const uint64_t hash = hashName(name);
+    const uint32_t bucket = bucketOf(hash, this->bucketBits);
+
+    // about one entry per bucket, so this is a compare or two
+    for (uint32_t i = this->buckets[bucket]; i < this->buckets[bucket + 1]; i++)
+    {
+        const Entry& entry = this->pEntries[i];
+
+        if (entry.hash == hash && this->name(entry) == name)
+        {
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
+
+uint32_t Loaders::Archive::size() const
+{
+    return this->nEntries;
+}
+
+const Loaders::Archive::Entry& Loaders::Archive::entry(const uint32_t index) const
+{
+    return this->pEntries[index];
+}
+
+std::string_view Loaders::Archive::name(const Entry& entry) const
+{
+    return {this->names + entry.nameOffset, entry.nameSize};
+}
+
+const char* Loaders::Archive::view(const Entry& entry) const
+{
+    return entry.flags & ENTRY_COMPRESSED ? nullptr : this->file.data() + entry.offset;
+}
+
+bool Loaders::Archive::extract(const Entry& entry, char* dst) const
+{
+    const auto payload = reinterpret_cast<const unsigned char*>(this->file.data() + entry.offset);
+
+    if (!(entry.flags & ENTRY_COMPRESSED))
+    {
+        memcpy(dst, payload, entry.size);
+        return crc32(dst, entry.size) == entry.crc;
+    }
+
+    // a table of block sizes, then the blocks
+    const uint64_t nBlocks = (entry.size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    if (nBlocks * 4 > entry.storedSize)
+    {
+        return false;
+    }
+
+    uint64_t offset = nBlocks * 4;
+
+    for (uint64_t i = 0; i < nBlocks; i++)
+    {
+        uint32_t blockSize;
+        memcpy(&blockSize, payload + i * 4, 4);
+
+        const bool raw = blockSize & BLOCK_RAW;
+        blockSize &= ~BLOCK_RAW;
+
+        const uint64_t rawSize = std::min<uint64_t>(BLOCK_SIZE, entry.size - i * BLOCK_SIZE);
+        const auto out = reinterpret_cast<unsigned char*>(dst) + i * BLOCK_SIZE;
+
+        if (blockSize > entry.storedSize - offset)
+        {
+            return false;
+        }
+
+        if (raw)
+        {
+            if (blockSize != rawSize) return false;
+            memcpy(out, payload + offset, rawSize);
+        } else if (!decompressBlock(payload + offset, blockSize, out, rawSize))
+        {
+            return false;
+        }
+
+        offset += blockSize;
+    }
+
+    return crc32(dst, entry.size) == entry.crc;
+}
+
+bool Loaders::Archive::verify(const Entry& entry) const
+{
+    if (!(entry.flags & ENTRY_COMPRESSED))
+    {
+        return crc32(this->file.data() + entry.offset, entry.size) == entry.crc;
+    }
+
+    const std::unique_ptr<char[]> data(new char[entry.size]);
+    return this->extract(entry, data.get());
+}
+
+void Loaders::ArchiveWriter::add(std::string name, std::string path, const bool compress)
+{
+    this->inputs.push_back({std::move(name), std::move(path), compress});
+}
+
+bool Loaders::ArchiveWriter::write(const char* filename) const
+{
+    std::vector<Archive::Entry> entries(this->inputs.size());
+    std::string names;
+
+    for (size_t i = 0; i < this->inputs.size(); i++)
+    {
+        entries[i].hash = hashName(this->inputs[i].name);
+        entries[i].nameOffset = static_cast<uint32_t>(names.size());
+        entries[i].nameSize = static_cast<uint32_t>(this->inputs[i].name.size());
+
+        names += this->inputs[i].name;
+    }
+
+    // around one entry per bucket
+    uint32_t bucketBits = 0;
+
+    while ((1ull << bucketBits) < entries.size() && bucketBits < 31)
+    {
+        bucketBits++;
+    }
+
+    const uint64_t bucketsSize = bucketTableSize(bucketBits);
+    const uint64_t tocSize = bucketsSize + entries.size() * sizeof(Archive::Entry) + names.size();
+
+    const std::string tmpName = std::string(filename) + ".tmp";
+    std::ofstream out(tmpName, std::ios::binary | std::ios::trunc);
+
+    if (!out.is_open())
+    {
+        return false;
+    }
+
+    // payloads first, the table of contents needs their offsets and sizes
+    uint64_t offset = alignUp(sizeof(Header) + tocSize, Archive::ALIGNMENT);
+    std::vector<unsigned char> compressed;
+
+    for (size_t i = 0; i < this->inputs.size(); i++)
+    {
+        FileView file;
+
+        if (!file.open(this->inputs[i].path.c_str()))
+        {
+            out.close();
+            std::remove(tmpName.c_str());
+            return false;
+        }
+
+        Archive::Entry& entry = entries[i];
+        entry.offset = offset;
+        entry.size = file.size();
+        entry.storedSize = file.size();
+        entry.crc = crc32(file.data(), file.size());
+        entry.flags = 0;
+
+        const char* payload = file.data();
+
+        if (this->inputs[i].compress && file.size() > 0)
+        {
+            const uint64_t nBlocks = (file.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+            compressed.resize(nBlocks * 4 + file.size());
+
+            uint64_t size = nBlocks * 4;
+
+            for (uint64_t block = 0; block < nBlocks; block++)
+            {
+                const uint64_t rawSize = std::min<uint64_t>(BLOCK_SIZE, file.size() - block * BLOCK_SIZE);
+                const auto src = reinterpret_cast<const unsigned char*>(file.data()) + block * BLOCK_SIZE;
+
+                // anything that doesn't shrink is stored as is
+                size_t blockSize = compressBlock(src, rawSize, compressed.data() + size, rawSize - 1);
+                uint32_t header = static_cast<uint32_t>(blockSize);
+
+                if (blockSize == 0)
+                {
+                    memcpy(compressed.data() + size, src, rawSize);
+                    blockSize = rawSize;
+                    header = static_cast<uint32_t>(rawSize) | BLOCK_RAW;
+                }
+
+                memcpy(compressed.data() + block * 4, &header, 4);
+                size += blockSize;
+            }
+
+            // the block table has to pay for itself too
+            if (size < file.size())
+            {
+                entry.storedSize = size;
+                entry.flags |= Archive::ENTRY_COMPRESSED;
+                payload = reinterpret_cast<const char*>(compressed.data());
+            }
+        }
+
+        out.seekp(static_cast<std::streamoff>(offset));
+        out.write(payload, static_cast<std::streamsize>(entry.storedSize));
+
+        offset = alignUp(offset + entry.storedSize, Archive::ALIGNMENT);
+    }
+
+    // sorted by hash, so each bucket is one run of entries
+    std::vector<uint32_t> order(entries.size());
+
+    for (uint32_t i = 0; i < order.size(); i++)
+    {
+        order[i] = i;
+    }
+
+    std::sort(order.begin(), order.end(), [&entries](const uint32_t a, const uint32_t b)
+    {
+        return entries[a].hash < entries[b].hash;
+    });
+
+    std::vector<char> toc(tocSize);
+    const auto buckets = reinterpret_cast<uint32_t*>(toc.data());
+
+    for (uint32_t bucket = 0, i = 0; bucket <= (1u << bucketBits); bucket++)
+    {
+        while (i < order.size() && bucketOf(entries[order[i]].hash, bucketBits) < bucket)
+        {
+            i++;
+        }
+
+        buckets[bucket] = bucket == (1u << bucketBits) ? static_cast<uint32_t>(order.size()) : i;
+    }
+
+    for (uint32_t i = 0; i < order.size(); i++)
+    {
+        memcpy(toc.data() + bucketsSize + i * sizeof(Archive::Entry), &entries[order[i]], sizeof(Archive::Entry));
+    }
+
+    memcpy(toc.data() + bucketsSize + entries.size() * sizeof(Archive::Entry), names.data(), names.size());
+
+    Header header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.bucketBits = bucketBits;
+    header.namesSize = names.size();
+    header.tocCrc = crc32(toc.data(), toc.size());
+    header.alignment = Archive::ALIGNMENT;
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(toc.data(), static_cast<std::streamsize>(toc.size()));
+    out.close();
+
+    if (out.fail())
+    {
+        std::remove(tmpName.c_str());
+        return false;
+    }
+
+    return std::rename(tmpName.c_str(), filename) == 0;
+}
+
+const char* Loaders::Asset::data() const
+{
+    return this->pData;
+}
+
+size_t Loaders::Asset::size() const
+{
+    return this->nBytes;
+}
+
+void Loaders::mount(const Archive* archive, const std::string& prefix)
+{
+    std::string normal = prefix.empty() ? std::string() : std::filesystem::path(prefix).lexically_normal().generic_string();
+
+    // "assets/" and "assets" are the same directory, "." is no prefix at all
+    while (!normal.empty() && normal.back() == '/')
+    {
+        normal.pop_back();
+    }
+
+    if (normal == ".")
+    {
+        normal.clear();
+    }
+
+    mounts.push_back({archive, std::move(normal)});
+}
+
+void Loaders::unmount(const Archive* archive)
+{
+    std::erase_if(mounts, [archive](const Mount& mount)
+    {
+        return mount.archive == archive;
+    });
+}
+
+bool Loaders::resolve(const std::string& path, Asset* pAsset)
+{
+    pAsset->file.close();
+    pAsset->owned.reset();
+    pAsset->pData = nullptr;
+    pAsset->nBytes = 0;
+
+    if (!mounts.empty())
+    {
+        const std::string normal = std::filesystem::path(path).lexically_normal().generic_string();
+
+        for (auto mount = mounts.rbegin(); mount != mounts.rend(); ++mount)
+        {
+            std::string_view name = normal;
+
+            if (!mount->prefix.empty())
+            {
+                if (name.size() <= mount->prefix.size() || !name.starts_with(mount->prefix) || name[mount->prefix.size()] != '/')
+                {
+                    continue;
+                }
+
+                name.remove_prefix(mount->prefix.size() + 1);
+            }
+
+            const Archive::Entry* entry = mount->archive->find(name);
+
+            if (entry == nullptr)
+            {
+                continue;
+            }
+
+            pAsset->nBytes = entry->size;
+            pAsset->pData = mount->archive->view(*entry);
+
+            if (pAsset->pData == nullptr)
+            {
+                pAsset->owned.reset(new char[entry->size]);
+
+                if (!mount->archive->extract(*entry, pAsset->owned.get()))
+                {
+                    pAsset->owned.reset();
+                    pAsset->nBytes = 0;
+                    return false;
+                }
+
+                pAsset->pData = pAsset->owned.get();
+            }
+
+            return true;
+        }
+    }
+
+    if (!pAsset->file.open(path.c_str()))
+    {
+        return false;
+    }
+
+    pAsset->pData = pAsset->file.data();
+    pAsset->nBytes = pAsset->file.size();
+
+    return true;
+}
@@ -0,0 +1,726 @@
+#include "loaders.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HAS_PREAD
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define HAS_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#endif
+
+class Loaders::AsyncReader::Backend
+{
+protected:
+    struct Request
+    {
+        File file;
+        Callback callback;
+    };
+
+public:
+    virtual ~Backend() = default;
+
+    virtual void read(std::string filename, Callback callback) = 0;
+    virtual void poll() = 0;
+    virtual void wait() = 0;
+
+    [[nodiscard]] virtual uint32_t pending() const = 0;
+    [[nodiscard]] virtual bool ioUring() const = 0;
+};
+
+namespace
+{
+    using Loaders::AsyncReader;
+    using File = AsyncReader::File;
+    using Callback = AsyncReader::Callback;
+
+    // open, size, read and close with plain syscalls, what the fallback threads do
+    void readBlocking(File* file)
+    {
+#ifdef HAS_PREAD
+        const int fd = open(file->filename.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (fd < 0)
+        {
+            file->error = errno;
+            return;
+        }
+
+        const off_t size = lseek(fd, 0, SEEK_END);
+
+        if (size < 0)
+        {
+            file->error = errno;
+            close(fd);
+            return;
+        }
+
+        file->data.reset(new char[size]);
+
+        // files can shrink while they're read, whatever was there is what it gets
+        size_t offset = 0;
+
+        while (offset < static_cast<size_t>(size))
+        {
+            const auto n = pread(fd, file->data.get() + offset, size - offset, static_cast<off_t>(offset));
+
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (n < 0)
+            {
+                file->error = errno;
+                break;
+            }
+
+            if (n == 0)
+            {
+                break;
+            }
+
+            offset += n;
+        }
+
+        file->size = offset;
+        close(fd);
+#else
+        std::vector<char> buffer;
+
+        if (!Loaders::readfile(&buffer, file->filename.c_str()))
+        {
+            file->error = ENOENT;
+            return;
+        }
+
+        file->data.reset(new char[buffer.size()]);
+        file->size = buffer.size();
+        memcpy(file->data.get(), buffer.data(), buffer.size());
+#endif
+    }
+
+    class ThreadPool final : public AsyncReader::Backend
+    {
+        std::vector<std::thread> threads;
+
+        std::mutex mutex;
+        std::condition_variable queued;
+        std::condition_variable finished;
+
+        std::deque<Request> requests;
+        std::vector<Request> done;
+        bool stopping = false;
+
+        // touched by the polling thread only
+        uint32_t outstanding = 0;
+
+        void work()
+        {
+            std::unique_lock lock(this->mutex);
+
+            while (true)
+            {
+                this->queued.wait(lock, [this] { return this->stopping || !this->requests.empty(); });
+
+                if (this->stopping)
+                {
+                    return;
+                }
+
+                Request request = std::move(this->requests.front());
+                this->requests.pop_front();
+
+                lock.unlock();
+                readBlocking(&request.file);
+                lock.lock();
+
+                this->done.push_back(std::move(request));
+                this->finished.notify_all();
+            }
+        }
+
+        void complete(std::unique_lock<std::mutex>& lock)
+        {
+            std::vector<Request> completed;
+            completed.swap(this->done);
+            lock.unlock();
+
+            for (auto& request : completed)
+            {
+                this->outstanding--;
+                request.callback(request.file);
+            }
+
+            lock.lock();
+        }
+
+    public:
+        explicit ThreadPool(const uint32_t nThreads)
+        {
+            for (uint32_t i = 0; i < std::max(nThreads, 1u); i++)
+            {
+                this->threads.emplace_back(&ThreadPool::work, this);
+            }
+        }
+
+        ~ThreadPool() override
+        {
+            {
+                std::lock_guard lock(this->mutex);
+                this->stopping = true;
+            }
+
+            this->queued.notify_all();
+
+            for (auto& thread : this->threads)
+            {
+                thread.join();
+            }
+        }
+
+        void read(std::string filename, Callback callback) override
+        {
+            Request request;
+            request.file.filename = std::move(filename);
+            request.callback = std::move(callback);
+
+            {
+                std::lock_guard lock(this->mutex);
+                this->requests.push_back(std::move(request));
+            }
+
+            this->outstanding++;
+            this->queued.notify_one();
+        }
+
+        void poll() override
+        {
+            std::unique_lock lock(this->mutex);
+            this->complete(lock);
+        }
+
+        void wait() override
+        {
+            std::unique_lock lock(this->mutex);
+
+            while (this->outstanding > 0)
+            {
+                this->finished.wait(lock, [this] { return !this->done.empty(); });
+                this->complete(lock);
+            }
+        }
+
+        [[nodiscard]] uint32_t pending() const override
+        {
+            return this->outstanding;
+        }
+
+        [[nodiscard]] bool ioUring() const override
+        {
+            return false;
+        }
+    };
+
+#ifdef HAS_IO_URING
+    // Every file goes open + statx (together, both by path), then read until it's all there,
+    // then close. Closes aren't waited on, the file is handed over as soon as the read is done.
+    class IoUring final : public AsyncReader::Backend
+    {
+        enum Op : uint64_t
+        {
+            OP_OPEN,
+            OP_STAT,
+            OP_READ,
+            OP_CLOSE
+        };
+
+        // one per file in flight, fixed addresses since the kernel writes into them
+        struct Slot
+        {
+            Request request;
+            struct statx stat{};
+
+            int fd = -1;
+            int error = 0;
+            uint32_t waiting = 0;
+            size_t capacity = 0;
+        };
+
+        int ringFd = -1;
+
+        void* sqMap = nullptr;
+        size_t sqMapSize = 0;
+        void* cqMap = nullptr;
+        size_t cqMapSize = 0;
+        io_uring_sqe* sqes = nullptr;
+        size_t sqesSize = 0;
+
+        uint32_t* sqHead = nullptr;
+        uint32_t* sqTail = nullptr;
+        uint32_t* sqArray = nullptr;
+        uint32_t sqMask = 0;
+        uint32_t sqEntries = 0;
+
+        uint32_t* cqHead = nullptr;
+        uint32_t* cqTail = nullptr;
+        io_uring_cqe* cqes = nullptr;
+        uint32_t cqMask = 0;
+
+        // written to the ring but not handed to the kernel yet, and ops the kernel still owes us
+        uint32_t unsubmitted = 0;
+        uint32_t opsInFlight = 0;
+
+        std::vector<Slot> slots;
+        std::vector<uint32_t> freeSlots;
+        std::deque<Request> queue;
+        std::vector<Request> done;
+
+        static uint64_t userData(const uint32_t slot, const Op op)
+        {
+            return static_cast<uint64_t>(slot) << 2 | op;
+        }
+
+        int enter(const uint32_t toSubmit, const uint32_t minComplete) const
+        {
+            const uint32_t flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+            return static_cast<int>(syscall(__NR_io_uring_enter, this->ringFd, toSubmit, minComplete, flags, nullptr, 0));
+        }
+
+        void submit(const uint32_t minComplete)
+        {
+            while (true)
+            {
+                const int submitted = this->enter(this->unsubmitted, minComplete);
+
+                if (submitted >= 0)
+                {
+                    this->unsubmitted -= submitted;
+                    return;
+                }
+
+                if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+                {
+                    return;
+                }
+            }
+        }
+
+        io_uring_sqe* sqe()
+        {
+            // the ring is twice the files in flight, so it only fills up when nothing was submitted
+            if (this->unsubmitted == this->sqEntries)
+            {
+                this->submit(0);
+            }
+
+            const uint32_t tail = *this->sqTail;
+            const uint32_t index = tail & this->sqMask;
+
+            io_uring_sqe* entry = &this->sqes[index];
+            *entry = {};
+
+            this->sqArray[index] = index;
+            std::atomic_ref(*this->sqTail).store(tail + 1, std::memory_order_release);
+
+            this->unsubmitted++;
+            this->opsInFlight++;
+
+            return entry;
+        }
+
+        void start(const uint32_t index)
+        {
+            Slot& slot = this->slots[index];
+            slot.fd = -1;
+            slot.error = 0;
+            slot.waiting = 2;
+
+            io_uring_sqe* open = this->sqe();
+            open->opcode = IORING_OP_OPENAT;
+            open->fd = AT_FDCWD;
+            open->addr = reinterpret_cast<uint64_t>(slot.request.file.filename.c_str());
+            open->open_flags = O_RDONLY | O_CLOEXEC;
+            open->user_data = userData(index, OP_OPEN);
+
+            io_uring_sqe* stat = this->sqe();
+            stat->opcode = IORING_OP_STATX;
+            stat->fd = AT_FDCWD;
+            stat->addr = reinterpret_cast<uint64_t>(slot.request.file.filename.c_str());
+            stat->len = STATX_SIZE;
+            stat->off = reinterpret_cast<uint64_t>(&slot.stat);
+            stat->user_data = userData(index, OP_STAT);
+        }
+
+        void readMore(const uint32_t index)
+        {
+            Slot& slot = this->slots[index];
+            slot.waiting = 1;
+
+            io_uring_sqe* read = this->sqe();
+            read->opcode = IORING_OP_READ;
+            read->fd = slot.fd;
+            read->addr = reinterpret_cast<uint64_t>(slot.request.file.data.get() + slot.request.file.size);
+            read->len = static_cast<uint32_t>(std::min<size_t>(slot.capacity - slot.request.file.size, UINT32_MAX >> 1));
+            read->off = slot.request.file.size;
+            read->user_data = userData(index, OP_READ);
+        }
+
+        void finish(const uint32_t index)
+        {
+            Slot& slot = this->slots[index];
+
+            if (slot.fd >= 0)
+            {
+                io_uring_sqe* close = this->sqe();
+                close->opcode = IORING_OP_CLOSE;
+                close->fd = slot.fd;
+                close->user_data = userData(0, OP_CLOSE);
+            }
+
+            slot.request.file.error = slot.error;
+            this->done.push_back(std::move(slot.request));
+            this->freeSlots.push_back(index);
+        }
+
+        void completed(const uint64_t data, const int result)
+        {
+            this->opsInFlight--;
+
+            const auto op = static_cast<Op>(data & 3);
+            const auto index = static_cast<uint32_t>(data >> 2);
+
+            if (op == OP_CLOSE)
+            {
+                return;
+            }
+
+            Slot& slot = this->slots[index];
+            File& file = slot.request.file;
+            slot.waiting--;
+
+            if (result < 0 && slot.error == 0)
+            {
+                slot.error = -result;
+            }
+
+            if (op == OP_OPEN && result >= 0)
+            {
+                slot.fd = result;
+            }
+
+            if (op == OP_READ && result > 0)
+            {
+                file.size += result;
+            }
+
+            if (slot.waiting > 0)
+            {
+                return;
+            }
+
+            if (slot.error != 0)
+            {
+                this->finish(index);
+                return;
+            }
+
+            if (op != OP_READ)
+            {
+                // opened and sized
+                slot.capacity = slot.stat.stx_size;
+                file.data.reset(new char[slot.capacity]);
+                file.size = 0;
+            }
+
+            // short reads just go again, a read of nothing means the file shrank
+            if (file.size < slot.capacity && (op != OP_READ || result > 0))
+            {
+                this->readMore(index);
+                return;
+            }
+
+            this->finish(index);
+        }
+
+        // starts queued files into free slots and hands finished ones back
+        void pump(const uint32_t minComplete)
+        {
+            while (!this->freeSlots.empty() && !this->queue.empty())
+            {
+                const uint32_t index = this->freeSlots.back();
+                this->freeSlots.pop_back();
+
+                this->slots[index].request = std::move(this->queue.front());
+                this->queue.pop_front();
+
+                this->start(index);
+            }
+
+            if (this->unsubmitted > 0 || minComplete > 0)
+            {
+                this->submit(minComplete);
+            }
+
+            uint32_t head = *this->cqHead;
+            const uint32_t tail = std::atomic_ref(*this->cqTail).load(std::memory_order_acquire);
+
+            for (; head != tail; head++)
+            {
+                const io_uring_cqe& cqe = this->cqes[head & this->cqMask];
+                this->completed(cqe.user_data, cqe.res);
+            }
+
+            std::atomic_ref(*this->cqHead).store(head, std::memory_order_release);
+        }
+
+        void complete()
+        {
+            std::vector<Request> completed;
+            completed.swap(this->done);
+
+            for (auto& request : completed)
+            {
+                request.callback(request.file);
+            }
+        }
+
+    public:
+        // false if the kernel doesn't have io_uring or it isn't allowed (containers often block it)
+        bool create(const uint32_t maxInFlight)
+        {
+            io_uring_params params{};
+            const uint32_t entries = std::max(maxInFlight, 1u) * 2;
+
+#ifdef IORING_SETUP_COOP_TASKRUN
+            // completions are only looked at in poll() anyway, so there's no need to interrupt
+            // the thread for them (5.19+, older kernels reject the flag)
+            params.flags = IORING_SETUP_COOP_TASKRUN;
+            this->ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+
+            if (this->ringFd < 0)
+            {
+                params = {};
+                this->ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            }
+#else
+            this->ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+#endif
+
+            if (this->ringFd < 0)
+            {
+                return false;
+            }
+
+            this->sqMapSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+            this->cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+            if (params.features & IORING_FEAT_SINGLE_MMAP)
+            {
+                this->sqMapSize = this->cqMapSize = std::max(this->sqMapSize, this->cqMapSize);
+            }
+
+            this->sqMap = mmap(nullptr, this->sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ringFd, IORING_OFF_SQ_RING);
+
+            if (this->sqMap == MAP_FAILED)
+            {
+                this->sqMap = nullptr;
+                return false;
+            }
+
+            if (params.features & IORING_FEAT_SINGLE_MMAP)
+            {
+                this->cqMap = this->sqMap;
+            } else
+            {
+                this->cqMap = mmap(nullptr, this->cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ringFd, IORING_OFF_CQ_RING);
+
+                if (this->cqMap == MAP_FAILED)
+                {
+                    this->cqMap = nullptr;
+                    return false;
+                }
+            }
+
+            this->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+            void* sqes = mmap(nullptr, this->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ringFd, IORING_OFF_SQES);
+
+            if (sqes == MAP_FAILED)
+            {
+                return false;
+            }
+
+            const auto sq = static_cast<char*>(this->sqMap);
+            const auto cq = static_cast<char*>(this->cqMap);
+
+            this->sqes = static_cast<io_uring_sqe*>(sqes);
+            this->sqHead = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+            this->sqTail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+            this->sqArray = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+            this->sqMask = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+            this->sqEntries = params.sq_entries;
+
+            this->cqHead = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+            this->cqTail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+            this->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+            this->cqMask = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+
+            // two ops per file at most, plus closes, which fit in the completion ring being twice
+            // the size (and the kernel holds on to overflowing completions since 5.5 anyway)
+            this->slots.resize(params.sq_entries / 2);
+
+            for (uint32_t i = this->slots.size(); i > 0; i--)
+            {
+                this->freeSlots.push_back(i - 1);
+            }
+
+            return true;
+        }
+
+        ~IoUring() override
+        {
+            this->queue.clear();
+
+            if (this->ringFd >= 0)
+            {
+                while (this->opsInFlight > 0)
+                {
+                    this->pump(1);
+                }
+            }
+
+            if (this->sqes != nullptr)
+            {
+                munmap(this->sqes, this->sqesSize);
+            }
+
+            if (this->cqMap != nullptr && this->cqMap != this->sqMap)
+            {
+                munmap(this->cqMap, this->cqMapSize);
+            }
+
+            if (this->sqMap != nullptr)
+            {
+                munmap(this->sqMap, this->sqMapSize);
+            }
+
+            if (this->ringFd >= 0)
+            {
+                close(this->ringFd);
+            }
+        }
+
+        void read(std::string filename, Callback callback) override
+        {
+            Request request;
+            request.file.filename = std::move(filename);
+            request.callback = std::move(callback);
+
+            this->queue.push_back(std::move(request));
+        }
+
+        void poll() override
+        {
+            this->pump(0);
+            this->complete();
+        }
+
+        void wait() override
+        {
+            while (this->pending() > 0)
+            {
+                // files that finish on submission (a failed open, say) don't leave anything to wait on
+                this->pump(this->done.empty() && this->opsInFlight > 0 ? 1 : 0);
+                this->complete();
+            }
+
+            // only closes left, don't keep their completions around
+            this->pump(0);
+        }
+
+        [[nodiscard]] uint32_t pending() const override
+        {
+            return this->queue.size() + this->done.size() + (this->slots.size() - this->freeSlots.size());
+        }
+
+        [[nodiscard]] bool ioUring() const override
+        {
+            return true;
+        }
+    };
+#endif
+}
+
+Loaders::AsyncReader::~AsyncReader()
+{
+    this->destroy();
+}
+
+bool Loaders::AsyncReader::create(const uint32_t maxInFlight, const uint32_t threads, const bool ioUring)
+{
+    this->destroy();
+
+#ifdef HAS_IO_URING
+    if (ioUring)
+    {
+        const auto ring = new IoUring();
+
+        if (ring->create(maxInFlight))
+        {
+            this->backend = ring;
+            return true;
+        }
+
+        delete ring;
+    }
+#endif
+
+    this->backend = new ThreadPool(threads);
+    return true;
+}
+
+void Loaders::AsyncReader::destroy()
+{
+    delete this->backend;
+    this->backend = nullptr;
+}
+
+void Loaders::AsyncReader::read(std::string filename, Callback callback)
+{
+    this->backend->read(std::move(filename), std::move(callback));
+}
+
+void Loaders::AsyncReader::poll()
+{
+    this->backend->poll();
+}
+
+void Loaders::AsyncReader::wait()
+{
+    this->backend->wait();
+}
+
+uint32_t Loaders::AsyncReader::pending() const
+{
+    return this->backend != nullptr ? this->backend->pending() : 0;
+}
+
+bool Loaders::AsyncReader::usesIoUring() const
+{
+    return this->backend != nullptr && this->backend->ioUring();
+}
@@ -0,0 +1,1240 @@
+#include "loaders.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+namespace
+{
+    // Just enough JSON for glTF. Everything big is in the binary buffers, so a tree of values is fine.
+    struct Json
+    {
+        enum Type : uint8_t
+        {
+            NUL,
+            BOOLEAN,
+            NUMBER,
+            STRING,
+            ARRAY,
+            OBJECT
+        };
+
+        Type type = NUL;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+
+        // the elements of arrays and the values of objects, keys has the names that go with them
+        std::vector<Json> values;
+        std::vector<std::string> keys;
+
+        // NUL for missing keys, indices out of range and anything that isn't an object or array
+        const Json& operator[](const std::string_view key) const
+        {
+            static const Json missing;
+
+            for (size_t i = 0; i < this->keys.size(); i++)
+            {
+                if (this->keys[i] == key)
+                {
+                    return this->values[i];
+                }
+            }
+
+            return missing;
+        }
+
+        const Json& operator[](const size_t index) const
+        {
+            static const Json missing;
+            return this->type == ARRAY && index < this->values.size() ? this->values[index] : missing;
+        }
+
+        [[nodiscard]] size_t size() const
+        {
+            return this->type == ARRAY ? this->values.size() : 0;
+        }
+
+        [[nodiscard]] double numberOr(const double fallback) const
+        {
+            return this->type == NUMBER ? this->number : fallback;
+        }
+
+        // glTF indices and sizes, SIZE_MAX for anything that isn't a whole non-negative number
+        [[nodiscard]] size_t index() const
+        {
+            if (this->type != NUMBER || this->number < 0.0 || this->number > 9007199254740992.0 || this->number != std::floor(this->number))
+            {
+                return SIZE_MAX;
+            }
+
+            return static_cast<size_t>(this->number);
+        }
+
+        [[nodiscard]] size_t indexOr(const size_t fallback) const
+        {
+            return this->type == NUL ? fallback : this->index();
+        }
+    };
+
+    class JsonParser
+    {
+        // deep enough for anything real, shallow enough not to run out of stack
+        static constexpr uint32_t MAX_DEPTH = 128;
+
+        const char* p;
+        const char* end;
+        uint32_t depth = 0;
+
+        void skipWhitespace()
+        {
+            while (this->p < this->end && (*this->p == ' ' || *this->p == '\t' || *this->p == '\n' || *this->p == '\r'))
+            {
+                this->p++;
+            }
+        }
+
+        bool literal(const std::string_view word)
+        {
+            if (static_cast<size_t>(this->end - this->p) < word.size() || std::string_view(this->p, word.size()) != word)
+            {
+                return false;
+            }
+
+            this->p += word.size();
+            return true;
+        }
+
+        bool hex4(uint32_t* value)
+        {
+            if (this->end - this->p < 4)
+            {
+                return false;
+            }
+
+            *value = 0;
+
+            for (int i = 0; i < 4; i++)
+            {
+                const char c = *this->p++;
+                *value <<= 4;
+
+                if (c >= '0' && c <= '9') *value |= c - '0';
+                else if (c >= 'a' && c <= 'f') *value |= c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F') *value |= c - 'A' + 10;
+                else return false;
+            }
+
+            return true;
+        }
+
+        bool parseString(std::string* out)
+        {
+            // past the opening quote
+            this->p++;
+            out->clear();
+
+            while (this->p < this->end && *this->p != '"')
+            {
+                if (*this->p != '\\')
+                {
+                    out->push_back(*this->p++);
+                    continue;
+                }
+
+                if (++this->p >= this->end)
+                {
+                    return false;
+                }
+
+                const char escape = *this->p++;
+
+                switch (escape)
+                {
+                case '"': out->push_back('"'); break;
+                case '\\': out->push_back('\\'); break;
+                case '/': out->push_back('/'); break;
+                case 'b': out->push_back('\b'); break;
+                case 'f': out->push_back('\f'); break;
+                case 'n': out->push_back('\n'); break;
+                case 'r': out->push_back('\r'); break;
+                case 't': out->push_back('\t'); break;
+                case 'u':
+                {
+                    uint32_t code;
+
+                    if (!this->hex4(&code))
+                    {
+                        return false;
+                    }
+
+                    // surrogate pairs, lone halves come out as they are
+                    if (code >= 0xD800 && code < 0xDC00 && this->end - this->p >= 6 && this->p[0] == '\\' && this->p[1] == 'u')
+                    {
+                        const char* pair = this->p;
+                        this->p += 2;
+                        uint32_t low;
+
+                        if (this->hex4(&low) && low >= 0xDC00 && low < 0xE000)
+                        {
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        else
+                        {
+                            this->p = pair;
+                        }
+                    }
+
+                    if (code < 0x80)
+                    {
+                        out->push_back(static_cast<char>(code));
+                    }
+                    else if (code < 0x800)
+                    {
+                        out->push_back(static_cast<char>(0xC0 | code >> 6));
+                        out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    }
+                    else if (code < 0x10000)
+                    {
+                        out->push_back(static_cast<char>(0xE0 | code >> 12));
+                        out->push_back(static_cast<char>(0x80 | (code >> 6 & 0x3F)));
+                        out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    }
+                    else
+                    {
+                        out->push_back(static_cast<char>(0xF0 | code >> 18));
+                        out->push_back(static_cast<char>(0x80 | (code >> 12 & 0x3F)));
+                        out->push_back(static_cast<char>(0x80 | (code >> 6 & 0x3F)));
+                        out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    }
+
+                    break;
+                }
+                default:
+                    return false;
+                }
+            }
+
+            if (this->p >= this->end)
+            {
+                return false;
+            }
+
+            this->p++;
+            return true;
+        }
+
+        bool parseValue(Json* value)
+        {
+            this->skipWhitespace();
+
+            if (this->p >= this->end)
+            {
+                return false;
+            }
+
+            switch (*this->p)
+            {
+            case '{':
+            case '[':
+            {
+                const bool object = *this->p == '{';
+                const char close = object ? '}' : ']';
+
+                if (++this->depth > MAX_DEPTH)
+                {
+                    return false;
+                }
+
+                value->type = object ? Json::OBJECT : Json::ARRAY;
+                this->p++;
+                this->skipWhitespace();
+
+                if (this->p < this->end && *this->p == close)
+                {
+                    this->p++;
+                    this->depth--;
+                    return true;
+                }
+
+                while (true)
+                {
+                    if (object)
+                    {
+                        this->skipWhitespace();
+
+                        if (this->p >= this->end || *this->p != '"' || !this->parseString(&value->keys.emplace_back()))
+                        {
+                            return false;
+                        }
+
+                        this->skipWhitespace();
+
+                        if (this->p >= this->end || *this->p++ != ':')
+                        {
+                            return false;
+                        }
+                    }
+
+                    if (!this->parseValue(&value->values.emplace_back()))
+                    {
+                        return false;
+                    }
+
+                    this->skipWhitespace();
+
+                    if (this->p >= this->end)
+                    {
+                        return false;
+                    }
+
+                    const char c = *this->p++;
+
+                    if (c == close)
+                    {
+                        break;
+                    }
+
+                    if (c != ',')
+                    {
+                        return false;
+                    }
+                }
+
+                this->depth--;
+                return true;
+            }
+            case '"':
+                value->type = Json::STRING;
+                return this->parseString(&value->string);
+            case 't':
+                value->type = Json::BOOLEAN;
+                value->boolean = true;
+                return this->literal("true");
+            case 'f':
+                value->type = Json::BOOLEAN;
+                return this->literal("false");
+            case 'n':
+                return this->literal("null");
+            default:
+            {
+                value->type = Json::NUMBER;
+                const auto [next, error] = std::from_chars(this->p, this->end, value->number);
+
+                if (error != std::errc() || next == this->p)
+                {
+                    return false;
+                }
+
+                this->p = next;
+                return true;
+            }
+            }
+        }
+
+    public:
+        JsonParser(const char* data, const size_t size) : p(data), end(data + size) {}
+
+        bool parse(Json* root)
+        {
+            if (!this->parseValue(root))
+            {
+                return false;
+            }
+
+            this->skipWhitespace();
+
+            // GLB pads its JSON chunk with spaces, but some writers use zeros
+            while (this->p < this->end && *this->p == '\0')
+            {
+                this->p++;
+            }
+
+            return this->p == this->end;
+        }
+    };
+
+    constexpr uint32_t GLB_MAGIC = 0x46546C67;
+    constexpr uint32_t GLB_JSON = 0x4E4F534A;
+    constexpr uint32_t GLB_BIN = 0x004E4942;
+
+    // node hierarchies deeper than this are treated as broken
+    constexpr size_t MAX_NODE_DEPTH = 1024;
+
+    // elements of an accessor without a buffer view
+    constexpr size_t MAX_UNBACKED = 1u << 24;
+
+    constexpr uint32_t MODE_TRIANGLES = 4;
+    constexpr uint32_t MODE_TRIANGLE_STRIP = 5;
+    constexpr uint32_t MODE_TRIANGLE_FAN = 6;
+
+    struct Buffer
+    {
+        Loaders::FileView file;
+        std::vector<char> decoded;
+
+        const char* data = nullptr;
+        size_t size = 0;
+    };
+
+    struct Document
+    {
+        Json json;
+        std::vector<Buffer> buffers;
+    };
+
+    bool decodeBase64(const std::string_view text, std::vector<char>* out)
+    {
+        uint32_t bits = 0;
+        int nBits = 0;
+
+        out->clear();
+        out->reserve(text.size() / 4 * 3);
+
+        for (const char c : text)
+        {
+            uint32_t value;
+
+            if (c >= 'A' && c <= 'Z') value = c - 'A';
+            else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+            else if (c >= '0' && c <= '9') value = c - '0' + 52;
+            else if (c == '+' || c == '-') value = 62;
+            else if (c == '/' || c == '_') value = 63;
+            else if (c == '=') break;
+            else return false;
+
+            bits = bits << 6 | value;
+            nBits += 6;
+
+            if (nBits >= 8)
+            {
+                nBits -= 8;
+                out->push_back(static_cast<char>(bits >> nBits & 0xFF));
+            }
+        }
+
+        return true;
+    }
+
+    // relative URIs can have %20 and friends in them
+    std::string decodeUri(const std::string& uri)
+    {
+        std::string path;
+
+        for (size_t i = 0; i < uri.size(); i++)
+        {
+            if (uri[i] == '%' && i + 2 < uri.size() && isxdigit(static_cast<unsigned char>(uri[i + 1])) && isxdigit(static_cast<unsigned char>(uri[i + 2])))
+            {
+                path.push_back(static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16)));
+                i += 2;
+                continue;
+            }
+
+            path.push_back(uri[i]);
+        }
+
+        return path;
+    }
+
+    bool loadDocument(const char* filename, Loaders::FileView* file, Document* document)
+    {
+        if (!file->open(filename))
+        {
+            return false;
+        }
+
+        const char* json = file->data();
+        size_t jsonSize = file->size();
+
+        const char* bin = nullptr;
+        size_t binSize = 0;
+
+        uint32_t magic = 0;
+
+        if (file->size() >= 4)
+        {
+            memcpy(&magic, file->data(), 4);
+        }
+
+        if (magic == GLB_MAGIC)
+        {
+            uint32_t header[3];
+
+            if (file->size() < 20)
+            {
+                return false;
+            }
+
+            memcpy(header, file->data(), sizeof(header));
+
+            if (header[1] != 2 || header[2] > file->size())
+            {
+                return false;
+            }
+
+            json = nullptr;
+            size_t offset = 12;
+
+            // a JSON chunk, then maybe a BIN one, anything else is skipped
+            while (offset + 8 <= header[2])
+            {
+                uint32_t chunk[2];
+                memcpy(chunk, file->data() + offset, sizeof(chunk));
+                offset += 8;
+
+                if (chunk[0] > header[2] - offset)
+                {
+                    return false;
+                }
+
+                if (chunk[1] == GLB_JSON && json == nullptr)
+                {
+                    json = file->data() + offset;
+                    jsonSize = chunk[0];
+                }
+                else if (chunk[1] == GLB_BIN && bin == nullptr)
+                {
+                    bin = file->data() + offset;
+                    binSize = chunk[0];
+                }
+
+                offset += (static_cast<size_t>(chunk[0]) + 3) & ~static_cast<size_t>(3);
+            }
+
+            if (json == nullptr)
+            {
+                return false;
+            }
+        }
+
+        // files written with a BOM still parse
+        if (jsonSize >= 3 && memcmp(json, "\xEF\xBB\xBF", 3) == 0)
+        {
+            json += 3;
+            jsonSize -= 3;
+        }
+
+        if (!JsonParser(json, jsonSize).parse(&document->json) || document->json.type != Json::OBJECT)
+        {
+            return false;
+        }
+
+        const Json& asset = document->json["asset"];
+        const std::string& version = asset["version"].string;
+
+        if (version.empty() || version[0] != '2')
+        {
+            return false;
+        }
+
+        // compressed geometry and the like, which can't be read without the extension
+        if (document->json["extensionsRequired"].size() > 0)
+        {
+            return false;
+        }
+
+        const Json& buffers = document->json["buffers"];
+        const std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+
+        document->buffers.resize(buffers.size());
+
+        for (size_t i = 0; i < buffers.size(); i++)
+        {
+            Buffer& buffer = document->buffers[i];
+            const Json& uri = buffers[i]["uri"];
+            const size_t byteLength = buffers[i]["byteLength"].index();
+
+            if (byteLength == SIZE_MAX)
+            {
+                return false;
+            }
+
+            if (uri.type == Json::NUL)
+            {
+                // only the first buffer of a .glb can be without one, it's the BIN chunk
+                if (i != 0 || bin == nullptr)
+                {
+                    return false;
+                }
+
+                buffer.data = bin;
+                buffer.size = binSize;
+            }
+            else if (uri.string.compare(0, 5, "data:") == 0)
+            {
+                const size_t comma = uri.string.find(',');
+
+                if (comma == std::string::npos || comma < 12 || uri.string.compare(comma - 7, 7, ";base64") != 0 ||
+                    !decodeBase64(std::string_view(uri.string).substr(comma + 1), &buffer.decoded))
+                {
+                    return false;
+                }
+
+                buffer.data = buffer.decoded.data();
+                buffer.size = buffer.decoded.size();
+            }
+            else
+            {
+                if (!buffer.file.open((directory / decodeUri(uri.string)).string().c_str()))
+                {
+                    return false;
+                }
+
+                buffer.data = buffer.file.data();
+                buffer.size = buffer.file.size();
+            }
+
+            if (buffer.size < byteLength)
+            {
+                return false;
+            }
+
+            buffer.size = byteLength;
+        }
+
+        return true;
+    }
+
+    uint32_t componentCount(const std::string& type)
+    {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+
+        return 0;
+    }
+
+    uint32_t componentSize(const uint32_t componentType)
+    {
+        switch (componentType)
+        {
+        case 5120:
+        case 5121:
+            return 1;
+        case 5122:
+        case 5123:
+            return 2;
+        case 5125:
+        case 5126:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    // an accessor's elements, checked against its buffer view, nullptr data for one without a view
+    struct View
+    {
+        const char* data = nullptr;
+        size_t count = 0;
+        size_t stride = 0;
+        uint32_t componentType = 0;
+        bool normalized = false;
+    };
+
+    bool accessorView(const Document& document, const size_t index, const uint32_t components, View* view)
+    {
+        const Json& accessor = document.json["accessors"][index];
+
+        if (accessor.type != Json::OBJECT || accessor["sparse"].type != Json::NUL || componentCount(accessor["type"].string) != components)
+        {
+            return false;
+        }
+
+        const size_t componentType = accessor["componentType"].index();
+
+        if (componentType > UINT32_MAX)
+        {
+            return false;
+        }
+
+        view->componentType = static_cast<uint32_t>(componentType);
+        view->count = accessor["count"].index();
+        view->normalized = accessor["normalized"].boolean;
+
+        const size_t elementSize = static_cast<size_t>(componentSize(view->componentType)) * components;
+        const size_t byteOffset = accessor["byteOffset"].indexOr(0);
+
+        if (elementSize == 0 || view->count == SIZE_MAX || byteOffset == SIZE_MAX)
+        {
+            return false;
+        }
+
+        // all zeros, as far as anything here cares, and not worth allocating gigabytes of
+        if (accessor["bufferView"].type == Json::NUL)
+        {
+            view->stride = elementSize;
+            return view->count <= MAX_UNBACKED;
+        }
+
+        const Json& bufferView = document.json["bufferViews"][accessor["bufferView"].index()];
+        const size_t buffer = bufferView["buffer"].index();
+        const size_t viewOffset = bufferView["byteOffset"].indexOr(0);
+        const size_t viewLength = bufferView["byteLength"].index();
+
+        view->stride = bufferView["byteStride"].indexOr(elementSize);
+
+        if (buffer >= document.buffers.size() || viewOffset == SIZE_MAX || viewLength == SIZE_MAX || view->stride < elementSize ||
+            viewOffset > document.buffers[buffer].size || viewLength > document.buffers[buffer].size - viewOffset)
+        {
+            return false;
+        }
+
+        // the last element ends inside the view, without overflowing on the way
+        if (view->count > 0 && (byteOffset > viewLength || viewLength - byteOffset < elementSize ||
+            view->count - 1 > (viewLength - byteOffset - elementSize) / view->stride))
+        {
+            return false;
+        }
+
+        view->data = document.buffers[buffer].data + viewOffset + byteOffset;
+        return true;
+    }
+
+    float component(const View& view, const char* element, const uint32_t i)
+    {
+        switch (view.componentType)
+        {
+        case 5120:
+        {
+            int8_t value;
+            memcpy(&value, element + i, 1);
+            return view.normalized ? std::max(value / 127.0f, -1.0f) : value;
+        }
+        case 5121:
+        {
+            uint8_t value;
+            memcpy(&value, element + i, 1);
+            return view.normalized ? value / 255.0f : value;
+        }
+        case 5122:
+        {
+            int16_t value;
+            memcpy(&value, element + i * 2, 2);
+            return view.normalized ? std::max(value / 32767.0f, -1.0f) : value;
+        }
+        case 5123:
+        {
+            uint16_t value;
+            memcpy(&value, element + i * 2, 2);
+            return view.normalized ? value / 65535.0f : value;
+        }
+        case 5125:
+        {
+            uint32_t value;
+            memcpy(&value, element + i * 4, 4);
+            return static_cast<float>(value);
+        }
+        default:
+        {
+            float value;
+            memcpy(&value, element + i * 4, 4);
+            return value;
+        }
+        }
+    }
+
+    bool readFloats(const Document& document, const size_t index, const uint32_t components, std::vector<float>* out)
+    {
+        View view;
+
+        if (!accessorView(document, index, components, &view))
+        {
+            return false;
+        }
+
+        out->assign(view.count * components, 0.0f);
+
+        if (view.data == nullptr)
+        {
+            return true;
+        }
+
+        for (size_t i = 0; i < view.count; i++)
+        {
+            const char* element = view.data + i * view.stride;
+
+            for (uint32_t c = 0; c < components; c++)
+            {
+                (*out)[i * components + c] = component(view, element, c);
+            }
+        }
+
+        return true;
+    }
+
+    // read as integers, floats only hold them exactly up to 2^24 (and normalized doesn't apply)
+    uint32_t indexComponent(const View& view, const char* element)
+    {
+        switch (view.componentType)
+        {
+        case 5121:
+        {
+            uint8_t value;
+            memcpy(&value, element, 1);
+            return value;
+        }
+        case 5123:
+        {
+            uint16_t value;
+            memcpy(&value, element, 2);
+            return value;
+        }
+        default:
+        {
+            uint32_t value;
+            memcpy(&value, element, 4);
+            return value;
+        }
+        }
+    }
+
+    bool readIndices(const Document& document, const size_t index, std::vector<uint32_t>* out)
+    {
+        View view;
+
+        if (!accessorView(document, index, 1, &view) || (view.componentType != 5121 && view.componentType != 5123 && view.componentType != 5125))
+        {
+            return false;
+        }
+
+        out->assign(view.count, 0);
+
+        if (view.data == nullptr)
+        {
+            return true;
+        }
+
+        for (size_t i = 0; i < view.count; i++)
+        {
+            (*out)[i] = indexComponent(view, view.data + i * view.stride);
+        }
+
+        return true;
+    }
+
+    // column major, like glTF has them
+    using Matrix = std::array<float, 16>;
+
+    constexpr Matrix IDENTITY = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+    Matrix multiply(const Matrix& a, const Matrix& b)
+    {
+        Matrix result{};
+
+        for (int column = 0; column < 4; column++)
+        {
+            for (int row = 0; row < 4; row++)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    result[column * 4 + row] += a[k * 4 + row] * b[column * 4 + k];
+                }
+            }
+        }
+
+        return result;
+    }
+
+    Matrix localTransform(const Json& node)
+    {
+        const Json& matrix = node["matrix"];
+
+        if (matrix.size() == 16)
+        {
+            Matrix result;
+
+            for (size_t i = 0; i < 16; i++)
+            {
+                result[i] = static_cast<float>(matrix[i].numberOr(IDENTITY[i]));
+            }
+
+            return result;
+        }
+
+        const Json& t = node["translation"];
+        const Json& r = node["rotation"];
+        const Json& s = node["scale"];
+
+        const float x = static_cast<float>(r[0].numberOr(0.0));
+        const float y = static_cast<float>(r[1].numberOr(0.0));
+        const float z = static_cast<float>(r[2].numberOr(0.0));
+        const float w = static_cast<float>(r[3].numberOr(1.0));
+
+        const float sx = static_cast<float>(s[0].numberOr(1.0));
+        const float sy = static_cast<float>(s[1].numberOr(1.0));
+        const float sz = static_cast<float>(s[2].numberOr(1.0));
+
+        // T * R * S
+        return {
+            (1 - 2 * (y * y + z * z)) * sx, 2 * (x * y + z * w) * sx, 2 * (x * z - y * w) * sx, 0,
+            2 * (x * y - z * w) * sy, (1 - 2 * (x * x + z * z)) * sy, 2 * (y * z + x * w) * sy, 0,
+            2 * (x * z + y * w) * sz, 2 * (y * z - x * w) * sz, (1 - 2 * (x * x + y * y)) * sz, 0,
+            static_cast<float>(t[0].numberOr(0.0)), static_cast<float>(t[1].numberOr(0.0)), static_cast<float>(t[2].numberOr(0.0)), 1
+        };
+    }
+
+    void cross(const float* a, const float* b, float* out)
+    {
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    void normalize(float* v)
+    {
+        const float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+
+        if (length > 0.0f)
+        {
+            v[0] /= length;
+            v[1] /= length;
+            v[2] /= length;
+        }
+    }
+
+    class Importer
+    {
+        const Document& document;
+        Loaders::MeshData* mesh;
+        bool hasUvs;
+
+        // nodes have to form separate trees, so each one is only reached once. Otherwise a node
+        // listed twice by its parent, and so on down, makes exponentially many copies
+        std::vector<bool> visited;
+        size_t depth = 0;
+
+        bool addPrimitive(const Json& primitive, const Matrix& transform)
+        {
+            const size_t mode = primitive["mode"].indexOr(MODE_TRIANGLES);
+
+            if (mode == SIZE_MAX)
+            {
+                return false;
+            }
+
+            // points and lines have nothing to draw in a triangle mesh
+            if (mode != MODE_TRIANGLES && mode != MODE_TRIANGLE_STRIP && mode != MODE_TRIANGLE_FAN)
+            {
+                return true;
+            }
+
+            const Json& attributes = primitive["attributes"];
+
+            std::vector<float> positions;
+            std::vector<float> normals;
+            std::vector<float> uvs;
+            std::vector<uint32_t> indices;
+
+            if (attributes["POSITION"].type == Json::NUL)
+            {
+                return true;
+            }
+
+            if (!readFloats(this->document, attributes["POSITION"].index(), 3, &positions))
+            {
+                return false;
+            }
+
+            const size_t vertexCount = positions.size() / 3;
+
+            if (attributes["NORMAL"].type != Json::NUL &&
+                (!readFloats(this->document, attributes["NORMAL"].index(), 3, &normals) || normals.size() != positions.size()))
+            {
+                return false;
+            }
+
+            if (attributes["TEXCOORD_0"].type != Json::NUL &&
+                (!readFloats(this->document, attributes["TEXCOORD_0"].index(), 2, &uvs) || uvs.size() / 2 != vertexCount))
+            {
+                return false;
+            }
+
+            if (primitive["indices"].type != Json::NUL)
+            {
+                if (!readIndices(this->document, primitive["indices"].index(), &indices))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                indices.resize(vertexCount);
+
+                for (size_t i = 0; i < vertexCount; i++)
+                {
+                    indices[i] = static_cast<uint32_t>(i);
+                }
+            }
+
+            for (const uint32_t index : indices)
+            {
+                if (index >= vertexCount)
+                {
+                    return false;
+                }
+            }
+
+            // mirrored transforms turn the triangles inside out
+            float axes[3];
+            cross(&transform[0], &transform[4], axes);
+            const bool flip = axes[0] * transform[8] + axes[1] * transform[9] + axes[2] * transform[10] < 0.0f;
+
+            std::vector<uint32_t> triangles;
+
+            if (mode == MODE_TRIANGLES)
+            {
+                triangles.assign(indices.begin(), indices.end() - static_cast<std::ptrdiff_t>(indices.size() % 3));
+            }
+            else
+            {
+                for (size_t i = 2; i < indices.size(); i++)
+                {
+                    // every other triangle of a strip is wound the other way
+                    if (mode == MODE_TRIANGLE_FAN)
+                    {
+                        triangles.insert(triangles.end(), {indices[0], indices[i - 1], indices[i]});
+                    }
+                    else if (i % 2 == 0)
+                    {
+                        triangles.insert(triangles.end(), {indices[i - 2], indices[i - 1], indices[i]});
+                    }
+                    else
+                    {
+                        triangles.insert(triangles.end(), {indices[i - 1], indices[i - 2], indices[i]});
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < triangles.size() && flip; i += 3)
+            {
+                std::swap(triangles[i + 1], triangles[i + 2]);
+            }
+
+            // normals go through the cofactors of the upper 3x3, which is the inverse transpose
+            // scaled by the determinant, fine once they're normalized and flipped back for mirrors
+            float normalMatrix[9];
+            cross(&transform[4], &transform[8], normalMatrix);
+            cross(&transform[8], &transform[0], normalMatrix + 3);
+            cross(&transform[0], &transform[4], normalMatrix + 6);
+
+            for (float& value : normalMatrix)
+            {
+                value = flip ? -value : value;
+            }
+
+            const auto transformPosition = [&transform](const float* p, float* out)
+            {
+                for (int row = 0; row < 3; row++)
+                {
+                    out[row] = transform[row] * p[0] + transform[4 + row] * p[1] + transform[8 + row] * p[2] + transform[12 + row];
+                }
+            };
+
+            auto& out = *this->mesh;
+            const uint32_t base = out.vertexCount();
+
+            if (!normals.empty())
+            {
+                for (size_t v = 0; v < vertexCount; v++)
+                {
+                    float position[3];
+                    transformPosition(&positions[v * 3], position);
+                    out.positions.insert(out.positions.end(), position, position + 3);
+
+                    const float* n = &normals[v * 3];
+                    float normal[3];
+
+                    for (int row = 0; row < 3; row++)
+                    {
+                        normal[row] = normalMatrix[row] * n[0] + normalMatrix[3 + row] * n[1] + normalMatrix[6 + row] * n[2];
+                    }
+
+                    normalize(normal);
+                    out.normals.insert(out.normals.end(), normal, normal + 3);
+
+                    if (this->hasUvs)
+                    {
+                        out.uvs.push_back(uvs.empty() ? 0.0f : uvs[v * 2]);
+                        out.uvs.push_back(uvs.empty() ? 0.0f : uvs[v * 2 + 1]);
+                    }
+                }
+
+                for (const uint32_t index : triangles)
+                {
+                    out.indices.push_back(base + index);
+                }
+
+                return true;
+            }
+
+            // flat normals, so every corner needs a vertex of its own
+            for (size_t t = 0; t < triangles.size(); t += 3)
+            {
+                float corners[9];
+
+                for (int c = 0; c < 3; c++)
+                {
+                    transformPosition(&positions[triangles[t + c] * 3], corners + c * 3);
+                }
+
+                const float e1[3] = {corners[3] - corners[0], corners[4] - corners[1], corners[5] - corners[2]};
+                const float e2[3] = {corners[6] - corners[0], corners[7] - corners[1], corners[8] - corners[2]};
+                float normal[3];
+                cross(e1, e2, normal);
+                normalize(normal);
+
+                for (int c = 0; c < 3; c++)
+                {
+                    out.indices.push_back(out.vertexCount());
+                    out.positions.insert(out.positions.end(), corners + c * 3, corners + c * 3 + 3);
+                    out.normals.insert(out.normals.end(), normal, normal + 3);
+
+                    if (this->hasUvs)
+                    {
+                        out.uvs.push_back(uvs.empty() ? 0.0f : uvs[triangles[t + c] * 2]);
+                        out.uvs.push_back(uvs.empty() ? 0.0f : uvs[triangles[t + c] * 2 + 1]);
+                    }
+                }
+            }
+
+            return true;
+        }
+
+    public:
+        Importer(const Document& document, Loaders::MeshData* mesh, const bool hasUvs)
+            : document(document), mesh(mesh), hasUvs(hasUvs), visited(document.json["nodes"].size(), false) {}
+
+        bool addNode(const size_t index, const Matrix& parent)
+        {
+            const Json& node = this->document.json["nodes"][index];
+
+            if (node.type != Json::OBJECT || this->depth >= MAX_NODE_DEPTH || this->visited[index])
+            {
+                return false;
+            }
+
+            this->visited[index] = true;
+
+            const Matrix transform = multiply(parent, localTransform(node));
+
+            if (node["mesh"].type != Json::NUL)
+            {
+                const Json& primitives = this->document.json["meshes"][node["mesh"].index()]["primitives"];
+
+                for (size_t i = 0; i < primitives.size(); i++)
+                {
+                    if (!this->addPrimitive(primitives[i], transform))
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            this->depth++;
+            const Json& children = node["children"];
+
+            for (size_t i = 0; i < children.size(); i++)
+            {
+                if (!this->addNode(children[i].index(), transform))
+                {
+                    return false;
+                }
+            }
+
+            this->depth--;
+            return true;
+        }
+    };
+}
+
+bool Loaders::importGltf(const char* filename, MeshData* pMesh)
+{
+    *pMesh = MeshData{};
+
+    FileView file;
+    Document document;
+
+    if (!loadDocument(filename, &file, &document))
+    {
+        return false;
+    }
+
+    const Json& json = document.json;
+    const Json& nodes = json["nodes"];
+
+    // uvs for everything as soon as anything has them, zeros where they're missing
+    bool hasUvs = false;
+    const Json& meshes = json["meshes"];
+
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        const Json& primitives = meshes[i]["primitives"];
+
+        for (size_t j = 0; j < primitives.size(); j++)
+        {
+            hasUvs |= primitives[j]["attributes"]["TEXCOORD_0"].type != Json::NUL;
+        }
+    }
+
+    std::vector<size_t> roots;
+    const Json& scene = json["scenes"][json["scene"].indexOr(0)];
+
+    if (scene.type == Json::OBJECT)
+    {
+        for (size_t i = 0; i < scene["nodes"].size(); i++)
+        {
+            roots.push_back(scene["nodes"][i].index());
+        }
+    }
+    else
+    {
+        // no scenes, so every node nothing else has as a child
+        std::vector<bool> child(nodes.size(), false);
+
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            const Json& children = nodes[i]["children"];
+
+            for (size_t j = 0; j < children.size(); j++)
+            {
+                if (children[j].index() < child.size())
+                {
+                    child[children[j].index()] = true;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            if (!child[i])
+            {
+                roots.push_back(i);
+            }
+        }
+    }
+
+    Importer importer(document, pMesh, hasUvs);
+
+    for (const size_t root : roots)
+    {
+        if (!importer.addNode(root, IDENTITY))
+        {
+            *pMesh = MeshData{};
+            return false;
+        }
+    }
+
+    if (pMesh->vertexCount() > UINT32_MAX / 3 || pMesh->indices.size() > UINT32_MAX)
+    {
+        *pMesh = MeshData{};
+        return false;
+    }
+
+    return true;
+}
@@ -1,5 +1,8 @@
 #include "loaders.h"
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
+#include <string>
 
 bool Loaders::readfile(std::vector<char>* buffer, const char* filename)
 {
@@ -19,3 +22,201 @@ bool Loaders::readfile(std::vector<char>* buffer, const char* filename)
     file.close();
     return true;
 }
+
+bool Loaders::writefile(const std::vector<char>& buffer, const char* filename)
+{
+    const std::string tmpName = std::string(filename) + ".tmp";
+    std::ofstream file(tmpName, std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    file.close();
+
+    if (file.fail())
+    {
+        std::remove(tmpName.c_str());
+        return false;
+    }
+
+    return std::rename(tmpName.c_str(), filename) == 0;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+Loaders::FileView::~FileView()
+{
+    this->close();
+}
+
+Loaders::FileView::FileView(FileView&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+Loaders::FileView& Loaders::FileView::operator=(FileView&& other) noexcept
+{
+    if (this != &other)
+    {
+        this->close();
+
+        this->fallback = std::move(other.fallback);
+        this->pData = this->fallback.empty() ? other.pData : this->fallback.data();
+        this->nBytes = other.nBytes;
+
+        other.pData = nullptr;
+        other.nBytes = 0;
+    }
+
+    return *this;
+}
+
+bool Loaders::FileView::open(const char* filename)
+{
+    return this->open(filename, Options());
+}
+
+bool Loaders::FileView::open(const char* filename, const Options& options)
+{
+    this->close();
+
+#ifdef HAS_MMAP
+    const int fd = ::open(filename, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info{};
+
+    if (fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // mapping nothing isn't allowed
+    if (info.st_size == 0)
+    {
+        ::close(fd);
+        return true;
+    }
+
+    int flags = MAP_PRIVATE;
+
+#ifdef MAP_POPULATE
+    if (options.populate)
+    {
+        flags |= MAP_POPULATE;
+    }
+#endif
+
+    void* data = mmap(nullptr, info.st_size, PROT_READ, flags, fd, 0);
+
+    // the mapping keeps the file alive by itself
+    ::close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    this->pData = static_cast<const char*>(data);
+    this->nBytes = info.st_size;
+
+    const int advice = options.hint == HINT_SEQUENTIAL ? MADV_SEQUENTIAL : options.hint == HINT_RANDOM ? MADV_RANDOM : MADV_NORMAL;
+    madvise(data, this->nBytes, advice);
+
+#ifdef MADV_HUGEPAGE
+    if (options.hugePages)
+    {
+        madvise(data, this->nBytes, MADV_HUGEPAGE);
+    }
+#endif
+
+    return true;
+#else
+    if (!readfile(&this->fallback, filename))
+    {
+        return false;
+    }
+
+    this->pData = this->fallback.data();
+    this->nBytes = this->fallback.size();
+
+    return true;
+#endif
+}
+
+void Loaders::FileView::close()
+{
+#ifdef HAS_MMAP
+    if (this->pData != nullptr && this->fallback.empty())
+    {
+        munmap(const_cast<char*>(this->pData), this->nBytes);
+    }
+#endif
+
+    this->fallback.clear();
+    this->fallback.shrink_to_fit();
+    this->pData = nullptr;
+    this->nBytes = 0;
+}
+
+const char* Loaders::FileView::data() const
+{
+    return this->pData;
+}
+
+size_t Loaders::FileView::size() const
+{
+    return this->nBytes;
+}
+
+bool Loaders::FileView::empty() const
+{
+    return this->nBytes == 0;
+}
+
+#ifdef HAS_MMAP
+// madvise wants page aligned ranges, so the start is rounded down to its page
+static void advise(const char* data, const size_t nBytes, size_t offset, size_t size, const int advice)
+{
+    if (data == nullptr || offset >= nBytes)
+    {
+        return;
+    }
+
+    size = std::min(size, nBytes - offset);
+
+    const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t aligned = offset / page * page;
+
+    madvise(const_cast<char*>(data) + aligned, size + offset - aligned, advice);
+}
+#endif
+
+void Loaders::FileView::willNeed(const size_t offset, const size_t size) const
+{
+#ifdef HAS_MMAP
+    advise(this->pData, this->nBytes, offset, size, MADV_WILLNEED);
+#endif
+}
+
+void Loaders::FileView::dontNeed(const size_t offset, const size_t size) const
+{
+#ifdef HAS_MMAP
+    // the mapping is private and read-only, so the pages just get faulted in again if touched
+    advise(this->pData, this->nBytes, offset, size, MADV_DONTNEED);
+#endif
+}
@@ -1,4 +1,9 @@
 #pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #ifdef HAS_VULKAN
@@ -7,11 +12,380 @@
 
 namespace Loaders
 {
+    // A read-only view of a whole file, mapped instead of copied so the data comes straight
+    // out of the page cache. Unmapped when it goes away. Files replaced while mapped (like
+    // writefile() does) keep their old contents in the view.
+    class FileView
+    {
+        const char* pData = nullptr;
+        size_t nBytes = 0;
+
+        // only used where there's no mmap
+        std::vector<char> fallback;
+
+    public:
+        enum Hint : uint8_t
+        {
+            HINT_NORMAL,
+            HINT_SEQUENTIAL,
+            HINT_RANDOM
+        };
+
+        struct Options
+        {
+            Hint hint = HINT_SEQUENTIAL;
+
+            // faults every page in up front instead of as it's touched
+            bool populate = false;
+
+            // asks for transparent huge pages, only happens for read-only file THP (Linux)
+            bool hugePages = false;
+        };
+
+        FileView() = default;
+        ~FileView();
+
+        FileView(FileView&& other) noexcept;
+        FileView& operator=(FileView&& other) noexcept;
+
+        FileView(const FileView&) = delete;
+        FileView& operator=(const FileView&) = delete;
+
+        // drops whatever was open before, empty files open fine with a size of 0
+        bool open(const char* filename);
+        bool open(const char* filename, const Options& options);
+        void close();
+
+        // page aligned, so words or any other type can be read from it directly
+        [[nodiscard]] const char* data() const;
+        [[nodiscard]] size_t size() const;
+        [[nodiscard]] bool empty() const;
+
+        // hints for streaming through it, the range gets read ahead or its pages handed back
+        void willNeed(size_t offset, size_t size) const;
+        void dontNeed(size_t offset, size_t size) const;
+    };
+
     bool readfile(std::vector<char>* buffer, const char* filename);
 
+    // writes to a temporary file first, so a crash never leaves a half-written file behind
+    bool writefile(const std::vector<char>& buffer, const char* filename);
+
+    // An engine archive, many files in one that are found by name without touching the disk.
+    // It's laid out as a header, a bucket table indexed by the top bits of a name's hash, the
+    // entries sorted by that hash, the names, and then the payloads, each aligned so it can be
+    // used straight out of the mapping. Entries can be compressed in independent blocks, and
+    // every one has a CRC of its data. Little-endian only, like everything it runs on.
+    class Archive
+    {
+    public:
+        static constexpr uint32_t ENTRY_COMPRESSED = 1;
+
+        // as stored in the file
+        struct Entry
+        {
+            uint64_t hash;
+            uint64_t offset;
+
+            // in the archive, and once decompressed
+            uint64_t storedSize;
+            uint64_t size;
+
+            uint32_t nameOffset;
+            uint32_t nameSize;
+
+            // of the decompressed data
+            uint32_t crc;
+            uint32_t flags;
+        };
+
+    private:
+        FileView file;
+
+        const uint32_t* buckets = nullptr;
+        uint32_t bucketBits = 0;
+
+        const Entry* pEntries = nullptr;
+        uint32_t nEntries = 0;
+
+        const char* names = nullptr;
+
+    public:
+        // the table of contents is always checked, verify checks every entry's data too
+        bool open(const char* filename, bool verify = false);
+        void close();
+
+        // nullptr if it isn't in here
+        [[nodiscard]] const Entry* find(std::string_view name) const;
+
+        [[nodiscard]] uint32_t size() const;
+        [[nodiscard]] const Entry& entry(uint32_t index) const;
+        [[nodiscard]] std::string_view name(const Entry& entry) const;
+
+        // the data in place, nullptr for compressed entries
+        [[nodiscard]] const char* view(const Entry& entry) const;
+
+        // decompresses or copies into dst (entry.size bytes), false if it's corrupt
+        bool extract(const Entry& entry, char* dst) const;
+        [[nodiscard]] bool verify(const Entry& entry) const;
+
+        // payloads start on multiples of this
+        static constexpr uint32_t ALIGNMENT = 64;
+    };
+
+    // Builds archives, files are only read once write() gets to them.
+    class ArchiveWriter
+    {
+        struct Input
+        {
+            std::string name;
+            std::string path;
+            bool compress;
+        };
+
+        std::vector<Input> inputs;
+
+    public:
+        // name is what find() takes, compressed entries that don't get smaller are stored as they are
+        void add(std::string name, std::string path, bool compress);
+
+        // through a temporary file like writefile(), false if an input couldn't be read
+        bool write(const char* filename) const;
+    };
+
+    // What resolve() found, a view into a mounted archive or a loose file, or the decompressed
+    // data. Views into archives need the archive to stay open.
+    class Asset
+    {
+        FileView file;
+        std::unique_ptr<char[]> owned;
+
+        const char* pData = nullptr;
+        size_t nBytes = 0;
+
+        friend bool resolve(const std::string& path, Asset* pAsset);
+
+    public:
+        [[nodiscard]] const char* data() const;
+        [[nodiscard]] size_t size() const;
+    };
+
+    // paths under prefix are looked up in the archive (minus the prefix) before the disk,
+    // later mounts first. Not thread safe, mount before loading from other threads.
+    void mount(const Archive* archive, const std::string& prefix = "");
+    void unmount(const Archive* archive);
+
+    bool resolve(const std::string& path, Asset* pAsset);
+
+    // Reads whole files in the background, many at once. On Linux the opens, reads and closes
+    // go through io_uring in batches, so thousands of small files cost a handful of syscalls
+    // instead of four each. Elsewhere (or when io_uring isn't allowed) a few threads do plain
+    // reads instead. Callbacks run on whichever thread calls poll() or wait().
+    class AsyncReader
+    {
+    public:
+        struct File
+        {
+            std::string filename;
+
+            // move it out to keep it, it's freed after the callback otherwise
+            std::unique_ptr<char[]> data;
+            size_t size = 0;
+
+            // 0, or the errno of whatever failed
+            int error = 0;
+        };
+
+        using Callback = std::function<void(File& file)>;
+
+        // io_uring or the thread pool, both in async.cpp
+        class Backend;
+
+    private:
+        Backend* backend = nullptr;
+
+    public:
+        AsyncReader() = default;
+        ~AsyncReader();
+
+        AsyncReader(const AsyncReader&) = delete;
+        AsyncReader& operator=(const AsyncReader&) = delete;
+
+        // maxInFlight files are read at once, the rest queue up. threads is what the fallback
+        // gets, ioUring = false always uses it
+        bool create(uint32_t maxInFlight = 256, uint32_t threads = 4, bool ioUring = true);
+
+        // waits for reads still going, their callbacks don't run
+        void destroy();
+
+        void read(std::string filename, Callback callback);
+
+        // starts what's queued and runs the callbacks of finished reads, never blocks
+        void poll();
+
+        // until every read so far has had its callback run
+        void wait();
+
+        // queued or in flight, callbacks not run yet
+        [[nodiscard]] uint32_t pending() const;
+        [[nodiscard]] bool usesIoUring() const;
+    };
+
+    // triangles as the importer hands them over, one array per attribute. positions have 3
+    // floats per vertex, normals 3 and uvs 2, either of those can be empty
+    struct MeshData
+    {
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<float> uvs;
+        std::vector<uint32_t> indices;
+
+        [[nodiscard]] uint32_t vertexCount() const;
+    };
+
+    // glTF 2.0, .gltf (buffers in .bin files or data URIs) or .glb. Every triangle primitive of the
+    // default scene goes into the one mesh with its node's transform applied, POSITION, NORMAL and
+    // TEXCOORD_0 are kept. Primitives without normals get flat ones, like the spec wants. False
+    // for files that don't parse, point outside their buffers or need an extension
+    bool importGltf(const char* filename, MeshData* pMesh);
+
+    // Merges identical vertices and drops degenerate triangles, then orders the triangles for the
+    // post-transform cache (Tipsify) and sorts patches of them so the ones facing outwards go first
+    // for less overdraw, see Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced
+    // Overdraw". Vertices end up in the order they're first used in, so fetches stay sequential too.
+    void optimizeMesh(MeshData* pMesh, uint32_t cacheSize = 16);
+
+    // average cache misses per triangle on a FIFO cache of cacheSize, 3 is the worst and 0.5 about the best
+    float cacheMissRatio(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = 16);
+
+    // What's in a cooked mesh, pointing into the data it was parsed from. The vertex and index data
+    // are exactly what the GPU buffers hold, so they can be uploaded straight out of a FileView.
+    // Positions are quantized to 16 bits over the bounding box, 1 in w, and need scaling by
+    // boundsMax - boundsMin and moving by boundsMin (fold it into the model matrix). Normals are 8 bit
+    // snorm, uvs half floats. The layout is always location 0 position, 1 normal and 2 uv.
+    struct MeshInfo
+    {
+        enum Format : uint32_t
+        {
+            FORMAT_UNORM16X4 = 1,
+            FORMAT_SNORM8X4 = 2,
+            FORMAT_FLOAT16X2 = 3
+        };
+
+        struct Attribute
+        {
+            uint32_t location;
+            Format format;
+            uint32_t offset;
+        };
+
+        static constexpr uint32_t MAX_ATTRIBUTES = 3;
+
+        uint32_t vertexCount = 0;
+        uint32_t vertexStride = 0;
+        uint32_t attributeCount = 0;
+        Attribute attributes[MAX_ATTRIBUTES]{};
+
+        // 2 bytes per index when every vertex fits, 4 otherwise
+        uint32_t indexCount = 0;
+        uint32_t indexSize = 0;
+
+        float boundsMin[3]{};
+        float boundsMax[3]{};
+
+        const char* vertices = nullptr;
+        const char* indices = nullptr;
+    };
+
+    // only checks the header and that everything it points to is in the data, no copies
+    bool parseMesh(const char* data, size_t size, MeshInfo* pInfo);
+
+    // quantizes the mesh as it is, run optimizeMesh() on it first. False if it has no triangles
+    bool writeMesh(const MeshData& mesh, std::vector<char>* out);
+
 #ifdef HAS_VULKAN
 
-    VkResult loadShaderModule(VkDevice device, const char* filename, VkShaderModule* pShader);
+    // what a shader expects to be bound, read out of its SPIR-V
+    struct ShaderReflection
+    {
+        struct Binding
+        {
+            uint32_t set;
+            uint32_t binding;
+            VkDescriptorType type;
+
+            // 0 for runtime sized arrays
+            uint32_t count;
+            std::string name;
+        };
+
+        struct VertexInput
+        {
+            uint32_t location;
+            VkFormat format;
+            std::string name;
+        };
+
+        struct SpecializationConstant
+        {
+            uint32_t id;
+            uint32_t size;
+            uint64_t defaultValue;
+            std::string name;
+        };
+
+        VkShaderStageFlagBits stage = VK_SHADER_STAGE_ALL;
+        std::string entryPoint;
+
+        std::vector<Binding> bindings;
+
+        // sorted by location, vertex shaders only
+        std::vector<VertexInput> inputs;
+        std::vector<SpecializationConstant> specializationConstants;
+
+        // size 0 without push constants
+        VkPushConstantRange pushConstants{};
+    };
+
+    // pReflection is filled in too when it isn't nullptr
+    VkResult loadShaderModule(VkDevice device, const char* filename, VkShaderModule* pShader, ShaderReflection* pReflection = nullptr);
+
+    // only the first entry point is looked at, false if the code isn't valid SPIR-V
+    bool reflectShader(const uint32_t* code, size_t nWords, ShaderReflection* pReflection);
+
+    // a 2D texture and its mip chain, as laid out in a KTX2 file
+    struct TextureInfo
+    {
+        struct Level
+        {
+            // into the file's data
+            size_t offset;
+            size_t size;
+
+            uint32_t width;
+            uint32_t height;
+        };
+
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        uint32_t width = 0;
+        uint32_t height = 0;
+
+        // texels per block and bytes per block, 1x1 for uncompressed formats
+        uint32_t blockWidth = 1;
+        uint32_t blockHeight = 1;
+        uint32_t blockSize = 0;
+
+        // level 0 is the full size one
+        std::vector<Level> levels;
+    };
+
+    // KTX2 without supercompression and with one layer and face, false for anything else, formats
+    // it doesn't know the block size of, and levels that don't match their size or don't fit in size
+    bool parseKtx2(const char* data, size_t size, TextureInfo* pInfo);
+
+    // levels from the full size one down, tightly packed. The data format descriptor is left
+    // empty, so other tools may want the file run through ktx first
+    bool writeKtx2(VkFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<char>>& levels, std::vector<char>* out);
 
 #endif
 
@@ -0,0 +1,776 @@
+#include "loaders.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr uint32_t MAGIC = 0x48534D45; // "EMSH"
+    constexpr uint32_t VERSION = 1;
+
+    // vertex and index data start on multiples of this, the same as archive payloads
+    constexpr size_t DATA_ALIGNMENT = 64;
+
+    struct Attribute
+    {
+        uint32_t location;
+        uint32_t format;
+        uint32_t offset;
+    };
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+
+        uint32_t vertexCount;
+        uint32_t vertexStride;
+        uint32_t indexCount;
+        uint32_t indexSize;
+
+        uint32_t attributeCount;
+        uint32_t reserved;
+
+        float boundsMin[3];
+        float boundsMax[3];
+
+        Attribute attributes[Loaders::MeshInfo::MAX_ATTRIBUTES];
+        uint32_t padding;
+
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+    };
+
+    static_assert(sizeof(Header) == 112);
+
+    size_t align(const size_t offset)
+    {
+        return (offset + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+    }
+
+    uint32_t formatSize(const uint32_t format)
+    {
+        switch (format)
+        {
+        case Loaders::MeshInfo::FORMAT_UNORM16X4:
+            return 8;
+        case Loaders::MeshInfo::FORMAT_SNORM8X4:
+        case Loaders::MeshInfo::FORMAT_FLOAT16X2:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    // round to nearest even, too big turns into infinity
+    uint16_t toHalf(const float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, 4);
+
+        const auto sign = static_cast<uint16_t>(bits >> 16 & 0x8000);
+        const uint32_t magnitude = bits & 0x7FFFFFFF;
+
+        if (magnitude > 0x7F800000)
+        {
+            return sign | 0x7E00;
+        }
+
+        if (magnitude >= 0x47800000)
+        {
+            return sign | 0x7C00;
+        }
+
+        // subnormal halves count in steps of 2^-24
+        if (magnitude < 0x38800000)
+        {
+            return sign | static_cast<uint16_t>(std::nearbyint(std::fabs(value) * 16777216.0f));
+        }
+
+        // rebias the exponent (127 - 15), a carry out of the mantissa rounds up into it
+        uint32_t half = (magnitude - 0x38000000) >> 13;
+        const uint32_t rest = magnitude & 0x1FFF;
+
+        if (rest > 0x1000 || (rest == 0x1000 && (half & 1) != 0))
+        {
+            half++;
+        }
+
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // FIFO cache, a vertex is in it while fewer than cacheSize misses happened since it was loaded
+    class CacheSim
+    {
+        std::vector<uint32_t> loadedAt;
+        uint32_t cacheSize;
+        uint32_t time;
+
+    public:
+        CacheSim(const uint32_t vertexCount, const uint32_t cacheSize) : loadedAt(vertexCount, 0), cacheSize(cacheSize), time(cacheSize + 1) {}
+
+        void reset()
+        {
+            // everything loaded so far falls out at once
+            this->time += this->cacheSize + 1;
+        }
+
+        uint32_t triangle(const uint32_t* corners)
+        {
+            uint32_t misses = 0;
+
+            for (int c = 0; c < 3; c++)
+            {
+                if (this->time - this->loadedAt[corners[c]] > this->cacheSize)
+                {
+                    this->loadedAt[corners[c]] = this->time++;
+                    misses++;
+                }
+            }
+
+            return misses;
+        }
+    };
+
+    // merges vertices that are the same in every attribute, and drops triangles that lost an area doing that
+    void weld(Loaders::MeshData* mesh)
+    {
+        const uint32_t vertexCount = mesh->vertexCount();
+        const bool hasNormals = !mesh->normals.empty();
+        const bool hasUvs = !mesh->uvs.empty();
+
+        const auto hash = [mesh, hasNormals, hasUvs](const uint32_t v)
+        {
+            uint64_t h = 0;
+
+            const auto add = [&h](const float* values, const int count)
+            {
+                for (int i = 0; i < count; i++)
+                {
+                    uint32_t bits;
+                    memcpy(&bits, &values[i], 4);
+                    h = (h ^ bits) * 0x9E3779B97F4A7C15ull;
+                    h ^= h >> 29;
+                }
+            };
+
+            add(&mesh->positions[v * 3], 3);
+
+            if (hasNormals) add(&mesh->normals[v * 3], 3);
+            if (hasUvs) add(&mesh->uvs[v * 2], 2);
+
+            return h;
+        };
+
+        const auto equal = [mesh, hasNormals, hasUvs](const uint32_t a, const uint32_t b)
+        {
+            return memcmp(&mesh->positions[a * 3], &mesh->positions[b * 3], 12) == 0 &&
+                (!hasNormals || memcmp(&mesh->normals[a * 3], &mesh->normals[b * 3], 12) == 0) &&
+                (!hasUvs || memcmp(&mesh->uvs[a * 2], &mesh->uvs[b * 2], 8) == 0);
+        };
+
+        // open addressing with linear probing, kept under half full
+        size_t tableSize = 1;
+
+        while (tableSize < static_cast<size_t>(vertexCount) * 2)
+        {
+            tableSize <<= 1;
+        }
+
+        std::vector<uint32_t> table(tableSize, UINT32_MAX);
+        std::vector<uint32_t> remap(vertexCount);
+        uint32_t unique = 0;
+
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            size_t slot = hash(v) & (tableSize - 1);
+
+            while (table[slot] != UINT32_MAX && !equal(table[slot], v))
+            {
+                slot = (slot + 1) & (tableSize - 1);
+            }
+
+            if (table[slot] == UINT32_MAX)
+            {
+                // moved down in place, the first of its kind is never behind a later one
+                table[slot] = unique;
+
+                if (unique != v)
+                {
+                    memcpy(&mesh->positions[unique * 3], &mesh->positions[v * 3], 12);
+
+                    if (hasNormals) memcpy(&mesh->normals[unique * 3], &mesh->normals[v * 3], 12);
+                    if (hasUvs) memcpy(&mesh->uvs[unique * 2], &mesh->uvs[v * 2], 8);
+                }
+
+                unique++;
+            }
+
+            remap[v] = table[slot];
+        }
+
+        mesh->positions.resize(static_cast<size_t>(unique) * 3);
+        mesh->normals.resize(hasNormals ? static_cast<size_t>(unique) * 3 : 0);
+        mesh->uvs.resize(hasUvs ? static_cast<size_t>(unique) * 2 : 0);
+
+        size_t kept = 0;
+
+        for (size_t i = 0; i + 2 < mesh->indices.size(); i += 3)
+        {
+            const uint32_t a = remap[mesh->indices[i]];
+            const uint32_t b = remap[mesh->indices[i + 1]];
+            const uint32_t c = remap[mesh->indices[i + 2]];
+
+            if (a != b && b != c && c != a)
+            {
+                mesh->indices[kept++] = a;
+                mesh->indices[kept++] = b;
+                mesh->indices[kept++] = c;
+            }
+        }
+
+        mesh->indices.resize(kept);
+    }
+
+    // Tipsify: fans out around a vertex, then moves on to whichever vertex of those it just emitted
+    // will still be in the cache after its remaining triangles go out. With none of those left it
+    // backtracks through the recently used vertices, and then just takes the next one with triangles
+    std::vector<uint32_t> tipsify(const std::vector<uint32_t>& indices, const uint32_t vertexCount, const uint32_t cacheSize)
+    {
+        const size_t triangleCount = indices.size() / 3;
+
+        // triangles around each vertex
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        std::vector<uint32_t> live(vertexCount, 0);
+
+        for (const uint32_t index : indices)
+        {
+            live[index]++;
+        }
+
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            offsets[v + 1] = offsets[v] + live[v];
+        }
+
+        std::vector<uint32_t> adjacency(indices.size());
+        std::vector<uint32_t> filled(offsets.begin(), offsets.end() - 1);
+
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            adjacency[filled[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        std::vector<uint32_t> loadedAt(vertexCount, 0);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> deadEnd;
+        std::vector<uint32_t> candidates;
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+
+        uint32_t time = cacheSize + 1;
+        uint32_t cursor = 0;
+
+        const auto nextLive = [&]
+        {
+            while (!deadEnd.empty())
+            {
+                const uint32_t v = deadEnd.back();
+                deadEnd.pop_back();
+
+                if (live[v] > 0)
+                {
+                    return v;
+                }
+            }
+
+            for (; cursor < vertexCount; cursor++)
+            {
+                if (live[cursor] > 0)
+                {
+                    return cursor;
+                }
+            }
+
+            return UINT32_MAX;
+        };
+
+        uint32_t fanning = nextLive();
+
+        while (fanning != UINT32_MAX)
+        {
+            candidates.clear();
+
+            for (uint32_t i = offsets[fanning]; i < offsets[fanning + 1]; i++)
+            {
+                const uint32_t triangle = adjacency[i];
+
+                if (emitted[triangle])
+                {
+                    continue;
+                }
+
+                emitted[triangle] = true;
+
+                for (int c = 0; c < 3; c++)
+                {
+                    const uint32_t v = indices[triangle * 3 + c];
+
+                    result.push_back(v);
+                    deadEnd.push_back(v);
+                    candidates.push_back(v);
+                    live[v]--;
+
+                    if (time - loadedAt[v] > cacheSize)
+                    {
+                        loadedAt[v] = time++;
+                    }
+                }
+            }
+
+            uint32_t best = UINT32_MAX;
+            int64_t bestPriority = -1;
+
+            for (const uint32_t v : candidates)
+            {
+                if (live[v] == 0)
+                {
+                    continue;
+                }
+
+                // how long it's been in the cache, if fanning around it won't push it out
+                int64_t priority = 0;
+
+                if (time - loadedAt[v] + 2 * static_cast<uint64_t>(live[v]) <= cacheSize)
+                {
+                    priority = time - loadedAt[v];
+                }
+
+                if (priority > bestPriority)
+                {
+                    best = v;
+                    bestPriority = priority;
+                }
+            }
+
+            fanning = best != UINT32_MAX ? best : nextLive();
+        }
+
+        return result;
+    }
+
+    // Splits the triangles into patches and sorts them so the ones facing away from the middle of
+    // the mesh are drawn first, those are the likeliest to cover the rest. Patches start wherever the
+    // cache order jumped somewhere new (all three vertices missed), and are split further where that
+    // costs little, as long as the cache miss ratio stays within threshold of what it was.
+    void sortPatches(Loaders::MeshData* mesh, const uint32_t cacheSize, const float threshold)
+    {
+        const std::vector<uint32_t>& indices = mesh->indices;
+        const auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        const uint32_t vertexCount = mesh->vertexCount();
+
+        std::vector<uint32_t> hard;
+        CacheSim cache(vertexCount, cacheSize);
+
+        for (uint32_t t = 0; t < triangleCount; t++)
+        {
+            if (cache.triangle(&indices[t * 3]) == 3 || t == 0)
+            {
+                hard.push_back(t);
+            }
+        }
+
+        hard.push_back(triangleCount);
+
+        std::vector<uint32_t> patches;
+
+        for (size_t h = 0; h + 1 < hard.size(); h++)
+        {
+            const uint32_t start = hard[h];
+            const uint32_t end = hard[h + 1];
+
+            cache.reset();
+            uint32_t misses = 0;
+
+            for (uint32_t t = start; t < end; t++)
+            {
+                misses += cache.triangle(&indices[t * 3]);
+            }
+
+            const float limit = threshold * static_cast<float>(misses) / static_cast<float>(end - start);
+
+            // again from a cold cache, cutting wherever the patch so far is at least as good as the whole
+            cache.reset();
+            uint32_t patchStart = start;
+            uint32_t patchMisses = 0;
+            patches.push_back(start);
+
+            for (uint32_t t = start; t < end; t++)
+            {
+                patchMisses += cache.triangle(&indices[t * 3]);
+
+                if (t + 1 < end && static_cast<float>(patchMisses) <= limit * static_cast<float>(t + 1 - patchStart))
+                {
+                    patches.push_back(t + 1);
+                    patchStart = t + 1;
+                    patchMisses = 0;
+                    cache.reset();
+                }
+            }
+        }
+
+        patches.push_back(triangleCount);
+
+        const float* positions = mesh->positions.data();
+        double middle[3] = {0.0, 0.0, 0.0};
+
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                middle[i] += positions[v * 3 + i];
+            }
+        }
+
+        for (double& value : middle)
+        {
+            value /= std::max(vertexCount, 1u);
+        }
+
+        struct Patch
+        {
+            uint32_t start;
+            uint32_t end;
+            float key;
+        };
+
+        std::vector<Patch> sorted;
+        sorted.reserve(patches.size() - 1);
+
+        for (size_t p = 0; p + 1 < patches.size(); p++)
+        {
+            // area weighted, the cross products are twice the area along the normal
+            double normal[3] = {0.0, 0.0, 0.0};
+            double centre[3] = {0.0, 0.0, 0.0};
+            double area = 0.0;
+
+            for (uint32_t t = patches[p]; t < patches[p + 1]; t++)
+            {
+                const float* a = &positions[indices[t * 3] * 3];
+                const float* b = &positions[indices[t * 3 + 1] * 3];
+                const float* c = &positions[indices[t * 3 + 2] * 3];
+
+                const double e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+                const double e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+                const double n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+                const double triangleArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+                for (int i = 0; i < 3; i++)
+                {
+                    normal[i] += n[i];
+                    centre[i] += (a[i] + b[i] + c[i]) / 3.0 * triangleArea;
+                }
+
+                area += triangleArea;
+            }
+
+            const double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            double key = 0.0;
+
+            if (area > 0.0 && length > 0.0)
+            {
+                for (int i = 0; i < 3; i++)
+                {
+                    key += (centre[i] / area - middle[i]) * normal[i] / length;
+                }
+            }
+
+            sorted.push_back({patches[p], patches[p + 1], static_cast<float>(key)});
+        }
+
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Patch& a, const Patch& b)
+        {
+            return a.key > b.key;
+        });
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+
+        for (const Patch& patch : sorted)
+        {
+            result.insert(result.end(), indices.begin() + patch.start * 3, indices.begin() + patch.end * 3);
+        }
+
+        mesh->indices = std::move(result);
+    }
+
+    // vertices in the order the indices first use them
+    void reorderVertices(Loaders::MeshData* mesh)
+    {
+        const uint32_t vertexCount = mesh->vertexCount();
+        std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+        uint32_t next = 0;
+
+        for (uint32_t& index : mesh->indices)
+        {
+            if (remap[index] == UINT32_MAX)
+            {
+                remap[index] = next++;
+            }
+
+            index = remap[index];
+        }
+
+        const auto reorder = [&remap, next](std::vector<float>* values, const uint32_t components)
+        {
+            if (values->empty())
+            {
+                return;
+            }
+
+            std::vector<float> result(static_cast<size_t>(next) * components);
+
+            for (uint32_t v = 0; v < remap.size(); v++)
+            {
+                if (remap[v] != UINT32_MAX)
+                {
+                    std::copy_n(values->begin() + static_cast<size_t>(v) * components, components, result.begin() + static_cast<size_t>(remap[v]) * components);
+                }
+            }
+
+            *values = std::move(result);
+        };
+
+        reorder(&mesh->positions, 3);
+        reorder(&mesh->normals, 3);
+        reorder(&mesh->uvs, 2);
+    }
+}
+
+uint32_t Loaders::MeshData::vertexCount() const
+{
+    return static_cast<uint32_t>(this->positions.size() / 3);
+}
+
+void Loaders::optimizeMesh(MeshData* pMesh, const uint32_t cacheSize)
+{
+    pMesh->indices.resize(pMesh->indices.size() - pMesh->indices.size() % 3);
+
+    // left alone, writeMesh() turns it down anyway
+    for (const uint32_t index : pMesh->indices)
+    {
+        if (index >= pMesh->vertexCount())
+        {
+            return;
+        }
+    }
+
+    weld(pMesh);
+
+    if (pMesh->indices.empty())
+    {
+        return;
+    }
+
+    pMesh->indices = tipsify(pMesh->indices, pMesh->vertexCount(), cacheSize);
+
+    // a few percent more cache misses buys a lot smaller patches to sort
+    sortPatches(pMesh, cacheSize, 1.05f);
+    reorderVertices(pMesh);
+}
+
+float Loaders::cacheMissRatio(const std::vector<uint32_t>& indices, const uint32_t vertexCount, const uint32_t cacheSize)
+{
+    const size_t triangleCount = indices.size() / 3;
+
+    if (triangleCount == 0)
+    {
+        return 0.0f;
+    }
+
+    CacheSim cache(vertexCount, cacheSize);
+    uint64_t misses = 0;
+
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        misses += cache.triangle(&indices[t * 3]);
+    }
+
+    return static_cast<float>(static_cast<double>(misses) / static_cast<double>(triangleCount));
+}
+
+bool Loaders::parseMesh(const char* data, const size_t size, MeshInfo* pInfo)
+{
+    Header header;
+
+    if (size < sizeof(Header))
+    {
+        return false;
+    }
+
+    memcpy(&header, data, sizeof(Header));
+
+    if (header.magic != MAGIC || header.version != VERSION || header.attributeCount > MeshInfo::MAX_ATTRIBUTES ||
+        (header.indexSize != 2 && header.indexSize != 4) || header.vertexStride == 0)
+    {
+        return false;
+    }
+
+    const uint64_t vertexBytes = static_cast<uint64_t>(header.vertexCount) * header.vertexStride;
+    const uint64_t indexBytes = static_cast<uint64_t>(header.indexCount) * header.indexSize;
+
+    if (header.vertexOffset > size || vertexBytes > size - header.vertexOffset ||
+        header.indexOffset > size || indexBytes > size - header.indexOffset)
+    {
+        return false;
+    }
+
+    *pInfo = MeshInfo{};
+    pInfo->vertexCount = header.vertexCount;
+    pInfo->vertexStride = header.vertexStride;
+    pInfo->attributeCount = header.attributeCount;
+    pInfo->indexCount = header.indexCount;
+    pInfo->indexSize = header.indexSize;
+    pInfo->vertices = data + header.vertexOffset;
+    pInfo->indices = data + header.indexOffset;
+
+    memcpy(pInfo->boundsMin, header.boundsMin, sizeof(header.boundsMin));
+    memcpy(pInfo->boundsMax, header.boundsMax, sizeof(header.boundsMax));
+
+    for (uint32_t i = 0; i < header.attributeCount; i++)
+    {
+        const Attribute& attribute = header.attributes[i];
+        const uint32_t attributeSize = formatSize(attribute.format);
+
+        if (attributeSize == 0 || attribute.offset > header.vertexStride || attributeSize > header.vertexStride - attribute.offset)
+        {
+            return false;
+        }
+
+        pInfo->attributes[i] = {attribute.location, static_cast<MeshInfo::Format>(attribute.format), attribute.offset};
+    }
+
+    return true;
+}
+
+bool Loaders::writeMesh(const MeshData& mesh, std::vector<char>* out)
+{
+    const uint32_t vertexCount = mesh.vertexCount();
+
+    if (mesh.indices.size() < 3 || mesh.indices.size() > UINT32_MAX ||
+        (!mesh.normals.empty() && mesh.normals.size() != mesh.positions.size()) ||
+        (!mesh.uvs.empty() && mesh.uvs.size() / 2 != vertexCount))
+    {
+        return false;
+    }
+
+    for (const uint32_t index : mesh.indices)
+    {
+        if (index >= vertexCount)
+        {
+            return false;
+        }
+    }
+
+    Header header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.vertexCount = vertexCount;
+    header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    header.indexSize = vertexCount <= 65536 ? 2 : 4;
+
+    const auto addAttribute = [&header](const uint32_t location, const MeshInfo::Format format)
+    {
+        header.attributes[header.attributeCount++] = {location, format, header.vertexStride};
+        header.vertexStride += formatSize(format);
+    };
+
+    addAttribute(0, MeshInfo::FORMAT_UNORM16X4);
+
+    if (!mesh.normals.empty()) addAttribute(1, MeshInfo::FORMAT_SNORM8X4);
+    if (!mesh.uvs.empty()) addAttribute(2, MeshInfo::FORMAT_FLOAT16X2);
+
+    for (int i = 0; i < 3; i++)
+    {
+        header.boundsMin[i] = vertexCount > 0 ? INFINITY : 0.0f;
+        header.boundsMax[i] = vertexCount > 0 ? -INFINITY : 0.0f;
+    }
+
+    for (uint32_t v = 0; v < vertexCount; v++)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            header.boundsMin[i] = std::min(header.boundsMin[i], mesh.positions[v * 3 + i]);
+            header.boundsMax[i] = std::max(header.boundsMax[i], mesh.positions[v * 3 + i]);
+        }
+    }
+
+    header.vertexOffset = align(sizeof(Header));
+    header.indexOffset = align(header.vertexOffset + static_cast<size_t>(vertexCount) * header.vertexStride);
+
+    out->assign(header.indexOffset + static_cast<size_t>(header.indexCount) * header.indexSize, 0);
+    memcpy(out->data(), &header, sizeof(Header));
+
+    float scale[3];
+
+    for (int i = 0; i < 3; i++)
+    {
+        const float extent = header.boundsMax[i] - header.boundsMin[i];
+        scale[i] = extent > 0.0f ? 65535.0f / extent : 0.0f;
+    }
+
+    char* vertex = out->data() + header.vertexOffset;
+
+    for (uint32_t v = 0; v < vertexCount; v++, vertex += header.vertexStride)
+    {
+        uint16_t position[4] = {0, 0, 0, 65535};
+
+        for (int i = 0; i < 3; i++)
+        {
+            const float q = std::round((mesh.positions[v * 3 + i] - header.boundsMin[i]) * scale[i]);
+            position[i] = static_cast<uint16_t>(std::isnan(q) ? 0.0f : std::clamp(q, 0.0f, 65535.0f));
+        }
+
+        memcpy(vertex, position, sizeof(position));
+        uint32_t offset = sizeof(position);
+
+        if (!mesh.normals.empty())
+        {
+            int8_t normal[4] = {0, 0, 0, 0};
+
+            for (int i = 0; i < 3; i++)
+            {
+                const float q = std::round(mesh.normals[v * 3 + i] * 127.0f);
+                normal[i] = static_cast<int8_t>(std::isnan(q) ? 0.0f : std::clamp(q, -127.0f, 127.0f));
+            }
+
+            memcpy(vertex + offset, normal, sizeof(normal));
+            offset += sizeof(normal);
+        }
+
+        if (!mesh.uvs.empty())
+        {
+            const uint16_t uv[2] = {toHalf(mesh.uvs[v * 2]), toHalf(mesh.uvs[v * 2 + 1])};
+            memcpy(vertex + offset, uv, sizeof(uv));
+        }
+    }
+
+    char* indices = out->data() + header.indexOffset;
+
+    if (header.indexSize == 4)
+    {
+        memcpy(indices, mesh.indices.data(), mesh.indices.size() * 4);
+    }
+    else
+    {
+        for (size_t i = 0; i < mesh.indices.size(); i++)
+        {
+            const auto index = static_cast<uint16_t>(mesh.indices[i]);
+            memcpy(indices + i * 2, &index, 2);
+        }
+    }
+
+    return true;
+}
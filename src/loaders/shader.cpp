@@ -1,19 +1,27 @@
 #include "loaders.h"
 #ifdef HAS_VULKAN
 
-VkResult Loaders::loadShaderModule(VkDevice device, const char* filename, VkShaderModule* pShader)
+VkResult Loaders::loadShaderModule(VkDevice device, const char* filename, VkShaderModule* pShader, ShaderReflection* pReflection)
 {
-    std::vector<char> buffer;
+    Asset asset;
 
-    if (!readfile(&buffer, filename))
+    if (!resolve(filename, &asset) || asset.size() % 4 != 0)
     {
         return VK_ERROR_UNKNOWN;
     }
 
+    // mappings and archive payloads are aligned, so the words can be read in place
+    const auto code = reinterpret_cast<const uint32_t*>(asset.data());
+
+    if (pReflection != nullptr && !reflectShader(code, asset.size() / 4, pReflection))
+    {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = buffer.size();
-    createInfo.pCode = reinterpret_cast<uint32_t*>(buffer.data());
+    createInfo.codeSize = asset.size();
+    createInfo.pCode = code;
 
     return vkCreateShaderModule(device, &createInfo, nullptr, pShader);
 }
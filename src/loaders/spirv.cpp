@@ -0,0 +1,558 @@
+#include "loaders.h"
+#ifdef HAS_VULKAN
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    constexpr uint32_t MAGIC = 0x07230203;
+    constexpr uint32_t HEADER_WORDS = 5;
+
+    // the spec's universal limit, the id table is sized by the header so it can't be trusted
+    constexpr uint32_t MAX_BOUND = 4194303;
+
+    // only what reflection needs, numbers are from the SPIR-V spec
+    enum Op : uint32_t
+    {
+        OP_NAME = 5,
+        OP_ENTRY_POINT = 15,
+        OP_TYPE_BOOL = 20,
+        OP_TYPE_INT = 21,
+        OP_TYPE_FLOAT = 22,
+        OP_TYPE_VECTOR = 23,
+        OP_TYPE_MATRIX = 24,
+        OP_TYPE_IMAGE = 25,
+        OP_TYPE_SAMPLER = 26,
+        OP_TYPE_SAMPLED_IMAGE = 27,
+        OP_TYPE_ARRAY = 28,
+        OP_TYPE_RUNTIME_ARRAY = 29,
+        OP_TYPE_STRUCT = 30,
+        OP_TYPE_POINTER = 32,
+        OP_CONSTANT = 43,
+        OP_SPEC_CONSTANT_TRUE = 48,
+        OP_SPEC_CONSTANT_FALSE = 49,
+        OP_SPEC_CONSTANT = 50,
+        OP_VARIABLE = 59,
+        OP_DECORATE = 71,
+        OP_MEMBER_DECORATE = 72
+    };
+
+    enum Decoration : uint32_t
+    {
+        DECORATION_SPEC_ID = 1,
+        DECORATION_BUFFER_BLOCK = 3,
+        DECORATION_ARRAY_STRIDE = 6,
+        DECORATION_MATRIX_STRIDE = 7,
+        DECORATION_BUILT_IN = 11,
+        DECORATION_LOCATION = 30,
+        DECORATION_BINDING = 33,
+        DECORATION_DESCRIPTOR_SET = 34,
+        DECORATION_OFFSET = 35
+    };
+
+    enum StorageClass : uint32_t
+    {
+        STORAGE_UNIFORM_CONSTANT = 0,
+        STORAGE_INPUT = 1,
+        STORAGE_UNIFORM = 2,
+        STORAGE_PUSH_CONSTANT = 9,
+        STORAGE_STORAGE_BUFFER = 12
+    };
+
+    constexpr uint32_t DIM_BUFFER = 5;
+    constexpr uint32_t DIM_SUBPASS_DATA = 6;
+    constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Id
+    {
+        // word offsets of the instruction defining it and of its OpName, 0 for none
+        uint32_t definition = 0;
+        uint32_t name = 0;
+
+        uint32_t set = NONE;
+        uint32_t binding = NONE;
+        uint32_t location = NONE;
+        uint32_t specId = NONE;
+        uint32_t arrayStride = 0;
+
+        bool builtIn = false;
+        bool bufferBlock = false;
+    };
+
+    struct MemberDecoration
+    {
+        uint32_t structId;
+        uint32_t member;
+        uint32_t decoration;
+        uint32_t value;
+    };
+
+    class Module
+    {
+        const uint32_t* code;
+        size_t nWords;
+
+    public:
+        std::vector<Id> ids;
+        std::vector<MemberDecoration> members;
+        std::vector<uint32_t> variables;
+        std::vector<uint32_t> specConstants;
+
+        Module(const uint32_t* code, const size_t nWords) : code(code), nWords(nWords) {}
+
+        [[nodiscard]] uint32_t op(const uint32_t id) const
+        {
+            return id < this->ids.size() && this->ids[id].definition != 0 ? this->code[this->ids[id].definition] & 0xFFFF : 0;
+        }
+
+        // word i of the instruction defining id, i = 1 is the first operand
+        [[nodiscard]] uint32_t word(const uint32_t id, const uint32_t i) const
+        {
+            const uint32_t at = this->ids[id].definition;
+            return i < (this->code[at] >> 16) ? this->code[at + i] : 0;
+        }
+
+        // literal strings are nul terminated and padded to whole words, but don't trust that
+        [[nodiscard]] std::string string(const uint32_t at) const
+        {
+            const uint32_t end = (this->code[at] >> 16) + at;
+            uint32_t first = at + 1;
+
+            // OpName's string comes after the target, OpEntryPoint's after the model and id
+            switch (this->code[at] & 0xFFFF)
+            {
+                case OP_NAME:
+                    first = at + 2;
+                    break;
+                case OP_ENTRY_POINT:
+                    first = at + 3;
+                    break;
+                default:
+                    break;
+            }
+
+            if (first >= end)
+            {
+                return {};
+            }
+
+            const auto chars = reinterpret_cast<const char*>(this->code + first);
+            return {chars, strnlen(chars, (end - first) * 4)};
+        }
+
+        [[nodiscard]] std::string name(const uint32_t id) const
+        {
+            return this->ids[id].name != 0 ? this->string(this->ids[id].name) : std::string();
+        }
+
+        [[nodiscard]] uint32_t member(const uint32_t structId, const uint32_t member, const uint32_t decoration) const
+        {
+            for (const auto& entry : this->members)
+            {
+                if (entry.structId == structId && entry.member == member && entry.decoration == decoration)
+                {
+                    return entry.value;
+                }
+            }
+
+            return NONE;
+        }
+
+        [[nodiscard]] uint32_t constant(const uint32_t id) const
+        {
+            const uint32_t op = this->op(id);
+            return op == OP_CONSTANT || op == OP_SPEC_CONSTANT ? this->word(id, 3) : 0;
+        }
+
+        // bytes a type takes up in a block, matrices need the stride their struct member was given
+        [[nodiscard]] uint32_t size(const uint32_t type, const uint32_t matrixStride, const uint32_t depth) const
+        {
+            if (depth > 16)
+            {
+                return 0;
+            }
+
+            switch (this->op(type))
+            {
+                case OP_TYPE_BOOL:
+                    return 4;
+                case OP_TYPE_INT:
+                case OP_TYPE_FLOAT:
+                    return this->word(type, 2) / 8;
+                case OP_TYPE_VECTOR:
+                    return this->word(type, 3) * this->size(this->word(type, 2), 0, depth + 1);
+                case OP_TYPE_MATRIX:
+                {
+                    const uint32_t columns = this->word(type, 3);
+                    return matrixStride != NONE && matrixStride != 0
+                        ? columns * matrixStride
+                        : columns * this->size(this->word(type, 2), 0, depth + 1);
+                }
+                case OP_TYPE_ARRAY:
+                {
+                    const uint32_t length = this->constant(this->word(type, 3));
+                    const uint32_t stride = this->ids[type].arrayStride;
+
+                    return length * (stride != 0 ? stride : this->size(this->word(type, 2), matrixStride, depth + 1));
+                }
+                case OP_TYPE_STRUCT:
+                {
+                    uint32_t end = 0;
+                    const uint32_t nMembers = (this->code[this->ids[type].definition] >> 16) - 2;
+
+                    for (uint32_t i = 0; i < nMembers; i++)
+                    {
+                        const uint32_t offset = this->member(type, i, DECORATION_OFFSET);
+                        const uint32_t memberSize = this->size(this->word(type, 2 + i), this->member(type, i, DECORATION_MATRIX_STRIDE), depth + 1);
+
+                        end = std::max(end, (offset != NONE ? offset : 0) + memberSize);
+                    }
+
+                    return end;
+                }
+                default:
+                    return 0;
+            }
+        }
+    };
+
+    VkShaderStageFlagBits stageOf(const uint32_t executionModel)
+    {
+        switch (executionModel)
+        {
+            case 0:
+                return VK_SHADER_STAGE_VERTEX_BIT;
+            case 1:
+                return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+            case 2:
+                return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+            case 3:
+                return VK_SHADER_STAGE_GEOMETRY_BIT;
+            case 4:
+                return VK_SHADER_STAGE_FRAGMENT_BIT;
+            case 5:
+                return VK_SHADER_STAGE_COMPUTE_BIT;
+            default:
+                return VK_SHADER_STAGE_ALL;
+        }
+    }
+
+    // 32 bit scalars and vectors, which is all vertex inputs tend to be
+    VkFormat formatOf(const Module& module, const uint32_t type)
+    {
+        uint32_t components = 1;
+        uint32_t scalar = type;
+
+        if (module.op(type) == OP_TYPE_VECTOR)
+        {
+            components = module.word(type, 3);
+            scalar = module.word(type, 2);
+        }
+
+        const uint32_t op = module.op(scalar);
+
+        if ((op != OP_TYPE_FLOAT && op != OP_TYPE_INT) || module.word(scalar, 2) != 32 || components < 1 || components > 4)
+        {
+            return VK_FORMAT_UNDEFINED;
+        }
+
+        static constexpr VkFormat FLOATS[] = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+        static constexpr VkFormat INTS[] = {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT};
+        static constexpr VkFormat UINTS[] = {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT};
+
+        if (op == OP_TYPE_FLOAT)
+        {
+            return FLOATS[components - 1];
+        }
+
+        return module.word(scalar, 3) != 0 ? INTS[components - 1] : UINTS[components - 1];
+    }
+
+    // VK_DESCRIPTOR_TYPE_MAX_ENUM for anything that isn't a descriptor
+    VkDescriptorType descriptorTypeOf(const Module& module, const uint32_t type, const uint32_t storage)
+    {
+        switch (module.op(type))
+        {
+            case OP_TYPE_SAMPLER:
+                return VK_DESCRIPTOR_TYPE_SAMPLER;
+            case OP_TYPE_SAMPLED_IMAGE:
+                return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            case OP_TYPE_IMAGE:
+            {
+                const uint32_t dim = module.word(type, 3);
+                const bool storageImage = module.word(type, 7) == 2;
+
+                if (dim == DIM_SUBPASS_DATA)
+                {
+                    return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+                }
+
+                if (dim == DIM_BUFFER)
+                {
+                    return storageImage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+                }
+
+                return storageImage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            }
+            case OP_TYPE_STRUCT:
+                if (storage == STORAGE_STORAGE_BUFFER || module.ids[type].bufferBlock)
+                {
+                    return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                }
+
+                return storage == STORAGE_UNIFORM ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_MAX_ENUM;
+            default:
+                return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+        }
+    }
+}
+
+bool Loaders::reflectShader(const uint32_t* code, const size_t nWords, ShaderReflection* pReflection)
+{
+    if (nWords < HEADER_WORDS || code[0] != MAGIC || code[3] > MAX_BOUND)
+    {
+        return false;
+    }
+
+    Module module(code, nWords);
+    module.ids.resize(code[3]);
+
+    uint32_t entryPoint = 0;
+
+    // one pass to index everything, definitions come before uses but decorations come first
+    for (size_t at = HEADER_WORDS; at < nWords;)
+    {
+        const uint32_t count = code[at] >> 16;
+        const uint32_t op = code[at] & 0xFFFF;
+
+        if (count == 0 || at + count > nWords)
+        {
+            return false;
+        }
+
+        const uint32_t* words = code + at;
+        const auto offset = static_cast<uint32_t>(at);
+        at += count;
+
+        // the instructions reflection reads from never have fewer than 2 words
+        if (count < 2)
+        {
+            continue;
+        }
+
+        switch (op)
+        {
+            case OP_NAME:
+                if (words[1] < module.ids.size()) module.ids[words[1]].name = offset;
+                break;
+            case OP_ENTRY_POINT:
+                if (entryPoint == 0 && count >= 4) entryPoint = offset;
+                break;
+            case OP_DECORATE:
+            {
+                if (count < 3 || words[1] >= module.ids.size()) break;
+
+                Id& id = module.ids[words[1]];
+                const uint32_t value = count >= 4 ? words[3] : 0;
+
+                switch (words[2])
+                {
+                    case DECORATION_SPEC_ID: id.specId = value; break;
+                    case DECORATION_BUFFER_BLOCK: id.bufferBlock = true; break;
+                    case DECORATION_ARRAY_STRIDE: id.arrayStride = value; break;
+                    case DECORATION_BUILT_IN: id.builtIn = true; break;
+                    case DECORATION_LOCATION: id.location = value; break;
+                    case DECORATION_BINDING: id.binding = value; break;
+                    case DECORATION_DESCRIPTOR_SET: id.set = value; break;
+                    default: break;
+                }
+
+                break;
+            }
+            case OP_MEMBER_DECORATE:
+                if (count >= 4) module.members.push_back({words[1], words[2], words[3], count >= 5 ? words[4] : 0});
+                break;
+            case OP_TYPE_BOOL:
+            case OP_TYPE_INT:
+            case OP_TYPE_FLOAT:
+            case OP_TYPE_VECTOR:
+            case OP_TYPE_MATRIX:
+            case OP_TYPE_IMAGE:
+            case OP_TYPE_SAMPLER:
+            case OP_TYPE_SAMPLED_IMAGE:
+            case OP_TYPE_ARRAY:
+            case OP_TYPE_RUNTIME_ARRAY:
+            case OP_TYPE_STRUCT:
+            case OP_TYPE_POINTER:
+                if (words[1] < module.ids.size()) module.ids[words[1]].definition = offset;
+                break;
+            case OP_CONSTANT:
+            case OP_SPEC_CONSTANT_TRUE:
+            case OP_SPEC_CONSTANT_FALSE:
+            case OP_SPEC_CONSTANT:
+                if (count < 3 || words[2] >= module.ids.size()) break;
+                module.ids[words[2]].definition = offset;
+                if (op != OP_CONSTANT) module.specConstants.push_back(words[2]);
+                break;
+            case OP_VARIABLE:
+                if (count < 4 || words[2] >= module.ids.size()) break;
+                module.ids[words[2]].definition = offset;
+                module.variables.push_back(words[2]);
+                break;
+            default:
+                break;
+        }
+    }
+
+    *pReflection = ShaderReflection{};
+
+    if (entryPoint != 0)
+    {
+        pReflection->stage = stageOf(code[entryPoint + 1]);
+        pReflection->entryPoint = module.string(entryPoint);
+    }
+
+    for (const uint32_t variable : module.variables)
+    {
+        const Id& id = module.ids[variable];
+        const uint32_t storage = module.word(variable, 3);
+        const uint32_t pointer = module.word(variable, 1);
+
+        if (module.op(pointer) != OP_TYPE_POINTER)
+        {
+            return false;
+        }
+
+        uint32_t type = module.word(pointer, 3);
+
+        if (storage == STORAGE_INPUT)
+        {
+            if (pReflection->stage != VK_SHADER_STAGE_VERTEX_BIT || id.builtIn || id.location == NONE || module.op(type) == OP_TYPE_STRUCT)
+            {
+                continue;
+            }
+
+            // matrices take one location per column
+            uint32_t columns = 1;
+
+            if (module.op(type) == OP_TYPE_MATRIX)
+            {
+                columns = module.word(type, 3);
+                type = module.word(type, 2);
+
+                if (columns < 2 || columns > 4)
+                {
+                    return false;
+                }
+            }
+
+            for (uint32_t i = 0; i < columns; i++)
+            {
+                pReflection->inputs.push_back({id.location + i, formatOf(module, type), module.name(variable)});
+            }
+
+            continue;
+        }
+
+        if (storage == STORAGE_PUSH_CONSTANT)
+        {
+            // the range starts at the first member, so several stages can each have their own part
+            uint32_t first = NONE;
+
+            for (const auto& member : module.members)
+            {
+                if (member.structId == type && member.decoration == DECORATION_OFFSET)
+                {
+                    first = std::min(first, member.value);
+                }
+            }
+
+            first = first != NONE ? first : 0;
+            const uint32_t end = module.size(type, NONE, 0);
+
+            pReflection->pushConstants.stageFlags = pReflection->stage;
+            pReflection->pushConstants.offset = first;
+            pReflection->pushConstants.size = end > first ? end - first : 0;
+            continue;
+        }
+
+        if (storage != STORAGE_UNIFORM_CONSTANT && storage != STORAGE_UNIFORM && storage != STORAGE_STORAGE_BUFFER)
+        {
+            continue;
+        }
+
+        uint32_t count = 1;
+
+        for (uint32_t depth = 0; depth < 8; depth++)
+        {
+            const uint32_t op = module.op(type);
+
+            if (op == OP_TYPE_ARRAY)
+            {
+                count *= module.constant(module.word(type, 3));
+            } else if (op == OP_TYPE_RUNTIME_ARRAY)
+            {
+                count = 0;
+            } else
+            {
+                break;
+            }
+
+            type = module.word(type, 2);
+        }
+
+        const VkDescriptorType descriptorType = descriptorTypeOf(module, type, storage);
+
+        if (descriptorType == VK_DESCRIPTOR_TYPE_MAX_ENUM)
+        {
+            continue;
+        }
+
+        pReflection->bindings.push_back({
+            id.set != NONE ? id.set : 0,
+            id.binding != NONE ? id.binding : 0,
+            descriptorType,
+            count,
+            module.name(variable)
+        });
+    }
+
+    for (const uint32_t constant : module.specConstants)
+    {
+        const Id& id = module.ids[constant];
+
+        if (id.specId == NONE)
+        {
+            continue;
+        }
+
+        ShaderReflection::SpecializationConstant spec{id.specId, 4, 0, module.name(constant)};
+        const uint32_t op = module.op(constant);
+
+        if (op == OP_SPEC_CONSTANT_TRUE)
+        {
+            spec.defaultValue = 1;
+        } else if (op == OP_SPEC_CONSTANT)
+        {
+            spec.size = std::max(module.size(module.word(constant, 1), NONE, 0), 4u);
+            spec.defaultValue = module.word(constant, 3);
+
+            if (spec.size == 8)
+            {
+                spec.defaultValue |= static_cast<uint64_t>(module.word(constant, 4)) << 32;
+            }
+        }
+
+        pReflection->specializationConstants.push_back(spec);
+    }
+
+    std::sort(pReflection->inputs.begin(), pReflection->inputs.end(), [](const auto& a, const auto& b)
+    {
+        return a.location < b.location;
+    });
+
+    return true;
+}
+
+#endif
\ No newline at end of file
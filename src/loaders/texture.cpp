@@ -0,0 +1,250 @@
+#include "loaders.h"
+#ifdef HAS_VULKAN
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    constexpr unsigned char IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+    struct Header
+    {
+        unsigned char identifier[12];
+        uint32_t vkFormat;
+        uint32_t typeSize;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;
+        uint32_t layerCount;
+        uint32_t faceCount;
+        uint32_t levelCount;
+        uint32_t supercompressionScheme;
+
+        uint32_t dfdByteOffset;
+        uint32_t dfdByteLength;
+        uint32_t kvdByteOffset;
+        uint32_t kvdByteLength;
+        uint64_t sgdByteOffset;
+        uint64_t sgdByteLength;
+    };
+
+    struct LevelIndex
+    {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint64_t uncompressedByteLength;
+    };
+
+    static_assert(sizeof(Header) == 80);
+    static_assert(sizeof(LevelIndex) == 24);
+
+    struct FormatInfo
+    {
+        VkFormat format;
+        uint32_t blockWidth;
+        uint32_t blockHeight;
+        uint32_t blockSize;
+        uint32_t typeSize;
+    };
+
+    // only power of two block sizes, so a staging offset aligned for one is aligned for any smaller one
+    constexpr FormatInfo FORMATS[] = {
+        {VK_FORMAT_R8_UNORM, 1, 1, 1, 1},
+        {VK_FORMAT_R8_SNORM, 1, 1, 1, 1},
+        {VK_FORMAT_R8_UINT, 1, 1, 1, 1},
+        {VK_FORMAT_R8G8_UNORM, 1, 1, 2, 1},
+        {VK_FORMAT_R8G8_SNORM, 1, 1, 2, 1},
+        {VK_FORMAT_R8G8B8A8_UNORM, 1, 1, 4, 1},
+        {VK_FORMAT_R8G8B8A8_SRGB, 1, 1, 4, 1},
+        {VK_FORMAT_R8G8B8A8_SNORM, 1, 1, 4, 1},
+        {VK_FORMAT_R8G8B8A8_UINT, 1, 1, 4, 1},
+        {VK_FORMAT_B8G8R8A8_UNORM, 1, 1, 4, 1},
+        {VK_FORMAT_B8G8R8A8_SRGB, 1, 1, 4, 1},
+        {VK_FORMAT_R16_UNORM, 1, 1, 2, 2},
+        {VK_FORMAT_R16_SFLOAT, 1, 1, 2, 2},
+        {VK_FORMAT_R16G16_UNORM, 1, 1, 4, 2},
+        {VK_FORMAT_R16G16_SFLOAT, 1, 1, 4, 2},
+        {VK_FORMAT_R16G16B16A16_UNORM, 1, 1, 8, 2},
+        {VK_FORMAT_R16G16B16A16_SFLOAT, 1, 1, 8, 2},
+        {VK_FORMAT_R32_SFLOAT, 1, 1, 4, 4},
+        {VK_FORMAT_R32G32_SFLOAT, 1, 1, 8, 4},
+        {VK_FORMAT_R32G32B32A32_SFLOAT, 1, 1, 16, 4},
+        {VK_FORMAT_BC1_RGB_UNORM_BLOCK, 4, 4, 8, 1},
+        {VK_FORMAT_BC1_RGB_SRGB_BLOCK, 4, 4, 8, 1},
+        {VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 4, 4, 8, 1},
+        {VK_FORMAT_BC1_RGBA_SRGB_BLOCK, 4, 4, 8, 1},
+        {VK_FORMAT_BC2_UNORM_BLOCK, 4, 4, 16, 1},
+        {VK_FORMAT_BC2_SRGB_BLOCK, 4, 4, 16, 1},
+        {VK_FORMAT_BC3_UNORM_BLOCK, 4, 4, 16, 1},
+        {VK_FORMAT_BC3_SRGB_BLOCK, 4, 4, 16, 1},
+        {VK_FORMAT_BC4_UNORM_BLOCK, 4, 4, 8, 1},
+        {VK_FORMAT_BC4_SNORM_BLOCK, 4, 4, 8, 1},
+        {VK_FORMAT_BC5_UNORM_BLOCK, 4, 4, 16, 1},
+        {VK_FORMAT_BC5_SNORM_BLOCK, 4, 4, 16, 1},
+        {VK_FORMAT_BC6H_UFLOAT_BLOCK, 4, 4, 16, 1},
+        {VK_FORMAT_BC6H_SFLOAT_BLOCK, 4, 4, 16, 1},
+        {VK_FORMAT_BC7_UNORM_BLOCK, 4, 4, 16, 1},
+        {VK_FORMAT_BC7_SRGB_BLOCK, 4, 4, 16, 1},
+    };
+
+    const FormatInfo* findFormat(const VkFormat format)
+    {
+        for (const auto& info : FORMATS)
+        {
+            if (info.format == format)
+            {
+                return &info;
+            }
+        }
+
+        return nullptr;
+    }
+
+    uint64_t levelSize(const FormatInfo& format, const uint32_t width, const uint32_t height)
+    {
+        const uint64_t blocksX = (width + format.blockWidth - 1) / format.blockWidth;
+        const uint64_t blocksY = (height + format.blockHeight - 1) / format.blockHeight;
+
+        return blocksX * blocksY * format.blockSize;
+    }
+
+    uint32_t maxLevels(const uint32_t width, const uint32_t height)
+    {
+        uint32_t levels = 1;
+
+        for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+        {
+            levels++;
+        }
+
+        return levels;
+    }
+}
+
+bool Loaders::parseKtx2(const char* data, const size_t size, TextureInfo* pInfo)
+{
+    Header header;
+
+    if (size < sizeof(header))
+    {
+        return false;
+    }
+
+    memcpy(&header, data, sizeof(header));
+
+    // no arrays, cubemaps, volumes or supercompression
+    if (memcmp(header.identifier, IDENTIFIER, sizeof(IDENTIFIER)) != 0 ||
+        header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth > 1 ||
+        header.layerCount > 1 || header.faceCount != 1 || header.supercompressionScheme != 0)
+    {
+        return false;
+    }
+
+    const auto format = findFormat(static_cast<VkFormat>(header.vkFormat));
+
+    // 0 levels asks for them to be generated, which isn't done here, so it's just the one
+    const uint32_t nLevels = std::max(header.levelCount, 1u);
+
+    if (format == nullptr || nLevels > maxLevels(header.pixelWidth, header.pixelHeight) ||
+        sizeof(Header) + nLevels * sizeof(LevelIndex) > size)
+    {
+        return false;
+    }
+
+    pInfo->format = format->format;
+    pInfo->width = header.pixelWidth;
+    pInfo->height = header.pixelHeight;
+    pInfo->blockWidth = format->blockWidth;
+    pInfo->blockHeight = format->blockHeight;
+    pInfo->blockSize = format->blockSize;
+    pInfo->levels.resize(nLevels);
+
+    for (uint32_t i = 0; i < nLevels; i++)
+    {
+        LevelIndex index;
+        memcpy(&index, data + sizeof(Header) + i * sizeof(LevelIndex), sizeof(index));
+
+        TextureInfo::Level& level = pInfo->levels[i];
+        level.width = std::max(header.pixelWidth >> i, 1u);
+        level.height = std::max(header.pixelHeight >> i, 1u);
+
+        // uploads copy straight from the file, so the offsets have to suit a buffer copy
+        if (index.byteLength != levelSize(*format, level.width, level.height) ||
+            index.byteOffset % std::max(format->blockSize, 4u) != 0 ||
+            index.byteOffset > size || index.byteLength > size - index.byteOffset)
+        {
+            pInfo->levels.clear();
+            return false;
+        }
+
+        level.offset = index.byteOffset;
+        level.size = index.byteLength;
+    }
+
+    return true;
+}
+
+bool Loaders::writeKtx2(
+    const VkFormat format,
+    const uint32_t width,
+    const uint32_t height,
+    const std::vector<std::vector<char>>& levels,
+    std::vector<char>* out)
+{
+    const auto info = findFormat(format);
+
+    if (info == nullptr || width == 0 || height == 0 || levels.empty() || levels.size() > maxLevels(width, height))
+    {
+        return false;
+    }
+
+    const auto nLevels = static_cast<uint32_t>(levels.size());
+    const uint32_t alignment = std::max(info->blockSize, 4u);
+
+    Header header{};
+    memcpy(header.identifier, IDENTIFIER, sizeof(IDENTIFIER));
+    header.vkFormat = format;
+    header.typeSize = info->typeSize;
+    header.pixelWidth = width;
+    header.pixelHeight = height;
+    header.faceCount = 1;
+    header.levelCount = nLevels;
+
+    // just dfdTotalSize, with no descriptor blocks after it
+    header.dfdByteOffset = static_cast<uint32_t>(sizeof(Header) + nLevels * sizeof(LevelIndex));
+    header.dfdByteLength = 4;
+
+    std::vector<LevelIndex> indices(nLevels);
+
+    // the smallest level goes first, so a reader streaming from the front gets the mip tail early
+    uint64_t offset = header.dfdByteOffset + header.dfdByteLength;
+
+    for (uint32_t i = nLevels; i-- > 0;)
+    {
+        const uint64_t expected = levelSize(*info, std::max(width >> i, 1u), std::max(height >> i, 1u));
+
+        if (levels[i].size() != expected)
+        {
+            return false;
+        }
+
+        offset = (offset + alignment - 1) / alignment * alignment;
+        indices[i] = {offset, expected, expected};
+        offset += expected;
+    }
+
+    out->assign(offset, 0);
+    memcpy(out->data(), &header, sizeof(header));
+    memcpy(out->data() + sizeof(header), indices.data(), indices.size() * sizeof(LevelIndex));
+    memcpy(out->data() + header.dfdByteOffset, &header.dfdByteLength, 4);
+
+    for (uint32_t i = 0; i < nLevels; i++)
+    {
+        memcpy(out->data() + indices[i].byteOffset, levels[i].data(), levels[i].size());
+    }
+
+    return true;
+}
+
+#endif
\ No newline at end of file
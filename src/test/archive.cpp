@@ -0,0 +1,222 @@
+#include "loaders/loaders.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include "random.h"
+
+using Test::random;
+
+namespace
+{
+    // random bytes, runs of text and mostly one byte, so some entries compress and some don't
+    std::vector<char> contents(const uint32_t index, uint32_t* seed)
+    {
+        const size_t size = index == 0 ? 0 : random(seed) % (index < 6 ? 400000 : 5000);
+        std::vector<char> data(size);
+
+        for (size_t i = 0; i < size; i++)
+        {
+            switch (index % 3)
+            {
+            case 0:
+                data[i] = static_cast<char>(random(seed));
+                break;
+            case 1:
+                data[i] = "abcabcxyz"[i % 9];
+                break;
+            default:
+                data[i] = random(seed) % 4 != 0 ? 'a' : static_cast<char>(random(seed));
+                break;
+            }
+        }
+
+        return data;
+    }
+
+    bool equal(const char* data, const size_t size, const std::vector<char>& expected)
+    {
+        return size == expected.size() && (size == 0 || memcmp(data, expected.data(), size) == 0);
+    }
+}
+
+// Packs a few hundred files, some compressed, reads every one back through find(), extract() and
+// mounted resolve(), then opens corrupted copies to make sure they read safely.
+int main()
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "engine_test_archive";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    constexpr uint32_t nFiles = 300;
+    uint32_t seed = 3;
+
+    std::vector<std::vector<char>> files;
+    Loaders::ArchiveWriter writer;
+
+    for (uint32_t i = 0; i < nFiles; i++)
+    {
+        files.push_back(contents(i, &seed));
+
+        const std::string path = (directory / ("f" + std::to_string(i))).string();
+
+        if (!Loaders::writefile(files.back(), path.c_str()))
+        {
+            std::cerr << "failed to write " << path << '\n';
+            return 1;
+        }
+
+        writer.add("dir/f" + std::to_string(i), path, i % 2 == 0);
+    }
+
+    const std::string archivePath = (directory / "test.arc").string();
+
+    if (!writer.write(archivePath.c_str()))
+    {
+        std::cerr << "failed to write the archive" << '\n';
+        return 1;
+    }
+
+    Loaders::Archive archive;
+
+    if (!archive.open(archivePath.c_str(), true) || archive.size() != nFiles)
+    {
+        std::cerr << "failed to open the archive" << '\n';
+        return 1;
+    }
+
+    uint32_t compressed = 0;
+
+    for (uint32_t i = 0; i < nFiles; i++)
+    {
+        const std::string name = "dir/f" + std::to_string(i);
+        const Loaders::Archive::Entry* entry = archive.find(name);
+
+        if (entry == nullptr || archive.name(*entry) != name || entry->offset % Loaders::Archive::ALIGNMENT != 0)
+        {
+            std::cerr << "couldn't find " << name << '\n';
+            return 1;
+        }
+
+        std::vector<char> extracted(entry->size);
+
+        if (!archive.extract(*entry, extracted.data()) || !equal(extracted.data(), extracted.size(), files[i]))
+        {
+            std::cerr << name << " came out different" << '\n';
+            return 1;
+        }
+
+        // stored ones are read in place
+        if (!(entry->flags & Loaders::Archive::ENTRY_COMPRESSED))
+        {
+            const char* view = archive.view(*entry);
+
+            if (entry->size > 0 && (view == nullptr || !equal(view, entry->size, files[i])))
+            {
+                std::cerr << name << " reads different in place" << '\n';
+                return 1;
+            }
+        } else
+        {
+            compressed++;
+        }
+    }
+
+    // the repeating ones at least have to shrink
+    if (compressed == 0)
+    {
+        std::cerr << "nothing got compressed" << '\n';
+        return 1;
+    }
+
+    if (archive.find("dir/missing") != nullptr || archive.find("") != nullptr)
+    {
+        std::cerr << "found a file that isn't there" << '\n';
+        return 1;
+    }
+
+    Loaders::mount(&archive, "assets/");
+    Loaders::Asset asset;
+
+    if (!Loaders::resolve("assets/dir/f7", &asset) || !equal(asset.data(), asset.size(), files[7]) ||
+        !Loaders::resolve("assets/x/../dir/f8", &asset) || !equal(asset.data(), asset.size(), files[8]) ||
+        Loaders::resolve("assets/dir/missing", &asset))
+    {
+        std::cerr << "mounted archive resolved wrong" << '\n';
+        return 1;
+    }
+
+    // anything not in it still comes off the disk
+    const std::string loose = (directory / "f9").string();
+
+    if (!Loaders::resolve(loose, &asset) || !equal(asset.data(), asset.size(), files[9]))
+    {
+        std::cerr << "loose file resolved wrong" << '\n';
+        return 1;
+    }
+
+    Loaders::unmount(&archive);
+
+    if (Loaders::resolve("assets/dir/f7", &asset))
+    {
+        std::cerr << "still resolved after unmount" << '\n';
+        return 1;
+    }
+
+    archive.close();
+
+    // flipped bits and truncations, whatever still opens is read without going out of bounds
+    // (which is what the sanitizer builds are for)
+    std::vector<char> original;
+
+    if (!Loaders::readfile(&original, archivePath.c_str()))
+    {
+        std::cerr << "failed to read the archive back" << '\n';
+        return 1;
+    }
+
+    const std::string corruptPath = (directory / "corrupt.arc").string();
+
+    for (uint32_t i = 0; i < 500; i++)
+    {
+        std::vector<char> corrupt = original;
+
+        for (uint32_t j = 0; j < 4; j++)
+        {
+            corrupt[random(&seed) % corrupt.size()] ^= static_cast<char>(1 << (random(&seed) % 8));
+        }
+
+        if (i % 10 == 0)
+        {
+            corrupt.resize(random(&seed) % corrupt.size());
+        }
+
+        Loaders::writefile(corrupt, corruptPath.c_str());
+        Loaders::Archive damaged;
+
+        if (!damaged.open(corruptPath.c_str()))
+        {
+            continue;
+        }
+
+        for (uint32_t j = 0; j < damaged.size(); j++)
+        {
+            const Loaders::Archive::Entry& entry = damaged.entry(j);
+
+            // a bit flip can claim gigabytes
+            if (entry.size > 1 << 20)
+            {
+                continue;
+            }
+
+            std::vector<char> extracted(entry.size);
+            damaged.extract(entry, extracted.data());
+        }
+    }
+
+    std::filesystem::remove_all(directory);
+
+    std::cout << "archive round trip passed (" << compressed << " compressed)" << '\n';
+    return 0;
+}
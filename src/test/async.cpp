@@ -0,0 +1,187 @@
+#include "loaders/loaders.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+
+#include "random.h"
+
+using Test::random;
+
+namespace
+{
+    struct Expected
+    {
+        std::string filename;
+        std::vector<char> data;
+        bool missing = false;
+    };
+
+    // mostly small files like a level load, a few big ones, some empty and some that aren't there
+    std::vector<Expected> files(const std::filesystem::path& directory)
+    {
+        uint32_t seed = 5;
+        std::vector<Expected> expected(600);
+
+        for (uint32_t i = 0; i < expected.size(); i++)
+        {
+            Expected& file = expected[i];
+            file.filename = (directory / ("f" + std::to_string(i))).string();
+            file.missing = i % 50 == 7;
+
+            if (file.missing)
+            {
+                continue;
+            }
+
+            const size_t size = i % 40 == 0 ? 0 : i % 97 == 1 ? 1000000 + random(&seed) % 300000 : random(&seed) % 20000;
+            file.data.resize(size);
+
+            for (char& byte : file.data)
+            {
+                byte = static_cast<char>(random(&seed));
+            }
+
+            if (!Loaders::writefile(file.data, file.filename.c_str()))
+            {
+                std::cerr << "failed to write " << file.filename << '\n';
+                return {};
+            }
+        }
+
+        return expected;
+    }
+
+    // every file's callback once, with its contents or the error, including reads queued from
+    // inside a callback
+    bool readAll(Loaders::AsyncReader* reader, const std::vector<Expected>& expected)
+    {
+        std::vector<uint32_t> calls(expected.size(), 0);
+        bool correct = true;
+
+        std::function<void(uint32_t)> read = [&](const uint32_t i)
+        {
+            reader->read(expected[i].filename, [&, i](Loaders::AsyncReader::File& file)
+            {
+                calls[i]++;
+
+                const Expected& want = expected[i];
+                const bool matches = want.missing ?
+                    file.error == ENOENT && file.size == 0 :
+                    file.error == 0 && file.filename == want.filename && file.size == want.data.size() &&
+                        (file.size == 0 || memcmp(file.data.get(), want.data.data(), file.size) == 0);
+
+                if (!matches)
+                {
+                    std::cerr << file.filename << " read wrong (error " << file.error << ", " << file.size << " bytes)" << '\n';
+                    correct = false;
+                }
+
+                // the second half is only asked for once the first half arrives
+                if (i * 2 < expected.size())
+                {
+                    read(static_cast<uint32_t>(i + expected.size() / 2));
+                }
+            });
+        };
+
+        for (uint32_t i = 0; i < expected.size() / 2; i++)
+        {
+            read(i);
+        }
+
+        if (reader->pending() == 0)
+        {
+            std::cerr << "nothing pending after queueing reads" << '\n';
+            return false;
+        }
+
+        // a few polls first, they shouldn't block or lose anything
+        for (uint32_t i = 0; i < 10; i++)
+        {
+            reader->poll();
+        }
+
+        reader->wait();
+
+        if (reader->pending() != 0)
+        {
+            std::cerr << reader->pending() << " reads still pending after wait()" << '\n';
+            return false;
+        }
+
+        for (uint32_t i = 0; i < calls.size(); i++)
+        {
+            if (calls[i] != 1)
+            {
+                std::cerr << expected[i].filename << "'s callback ran " << calls[i] << " times" << '\n';
+                return false;
+            }
+        }
+
+        return correct;
+    }
+
+    bool test(const std::vector<Expected>& expected, const bool ioUring)
+    {
+        // fewer in flight than there are files, so the rest queue up
+        Loaders::AsyncReader reader;
+
+        if (!reader.create(16, 4, ioUring) || (reader.usesIoUring() && !ioUring))
+        {
+            std::cerr << "failed to create the reader" << '\n';
+            return false;
+        }
+
+        if (!readAll(&reader, expected) || !readAll(&reader, expected))
+        {
+            std::cerr << "failed with " << (reader.usesIoUring() ? "io_uring" : "the thread pool") << '\n';
+            return false;
+        }
+
+        // reads still going when it's destroyed don't call back
+        bool called = false;
+
+        for (const Expected& file : expected)
+        {
+            reader.read(file.filename, [&called](Loaders::AsyncReader::File&) { called = true; });
+        }
+
+        reader.destroy();
+
+        if (called || reader.pending() != 0)
+        {
+            std::cerr << "destroyed reader ran callbacks" << '\n';
+            return false;
+        }
+
+        return true;
+    }
+}
+
+// Reads a few hundred files of mixed sizes through both backends, checking every callback runs
+// once with the right contents or error. If io_uring isn't allowed here both runs use the pool.
+int main()
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "engine_test_async";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    const std::vector<Expected> expected = files(directory);
+
+    if (expected.empty() || !test(expected, false) || !test(expected, true))
+    {
+        return 1;
+    }
+
+    Loaders::AsyncReader reader;
+    reader.create();
+    const bool ioUring = reader.usesIoUring();
+
+    std::filesystem::remove_all(directory);
+
+    std::cout << "async reads passed" << (ioUring ? "" : " (without io_uring)") << '\n';
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include "engine.h"
+
+#include <iostream>
+
+#include "random.h"
+
+using Engine::Aabb;
+using Engine::CullList;
+using Engine::Frustum;
+using Engine::JobSystem;
+using Engine::Mat4;
+using Engine::SimdLevel;
+using Engine::Sphere;
+using Engine::Vec3;
+using Test::random;
+
+namespace
+{
+    // what intersects() says, unless growing or shrinking it a little changes the answer, since
+    // the kernels can round differently (fma and all) right on a plane
+    int expected(const Frustum& frustum, const Sphere& sphere)
+    {
+        const bool inside = Engine::intersects(frustum, sphere);
+        const bool clear = Engine::intersects(frustum, Sphere{sphere.center, sphere.radius + 1e-3f}) == inside &&
+            Engine::intersects(frustum, Sphere{sphere.center, sphere.radius - 1e-3f}) == inside;
+
+        return clear ? inside : -1;
+    }
+
+    int expected(const Frustum& frustum, const Aabb& box)
+    {
+        const Vec3 margin = {1e-3f, 1e-3f, 1e-3f};
+        const bool inside = Engine::intersects(frustum, box);
+        const bool clear = Engine::intersects(frustum, Aabb{box.min - margin, box.max + margin}) == inside &&
+            Engine::intersects(frustum, Aabb{box.min + margin, box.max - margin}) == inside;
+
+        return clear ? inside : -1;
+    }
+
+    // random spheres and boxes around a camera, some counts under a batch, some over one and some
+    // enough to be split between jobs, culled the same as intersects() one at a time says
+    bool matchesIntersects(const Frustum& frustum, JobSystem* jobs)
+    {
+        uint32_t seed = 3;
+
+        for (const uint32_t count : {0u, 1u, 7u, 4095u, 4096u, 4097u, 20000u, 100003u})
+        {
+            CullList list;
+            std::vector<uint32_t> spheres;
+            std::vector<uint32_t> boxes;
+            uint32_t added = 0;
+
+            for (uint32_t i = 0; added < count; i++)
+            {
+                const Vec3 center = {random(&seed, -150.0f, 150.0f), random(&seed, -50.0f, 50.0f), random(&seed, -150.0f, 150.0f)};
+
+                if (i % 3 != 0)
+                {
+                    const Sphere sphere = {center, random(&seed, 0.1f, 3.0f)};
+                    const int inside = expected(frustum, sphere);
+
+                    if (inside < 0)
+                    {
+                        continue;
+                    }
+
+                    list.add(sphere, i);
+
+                    if (inside)
+                    {
+                        spheres.push_back(i);
+                    }
+                } else
+                {
+                    const Vec3 extent = {random(&seed, 0.1f, 3.0f), random(&seed, 0.1f, 3.0f), random(&seed, 0.1f, 3.0f)};
+                    const Aabb box = {center - extent, center + extent};
+                    const int inside = expected(frustum, box);
+
+                    if (inside < 0)
+                    {
+                        continue;
+                    }
+
+                    list.add(box, i);
+
+                    if (inside)
+                    {
+                        boxes.push_back(i);
+                    }
+                }
+
+                added++;
+            }
+
+            // spheres first, then boxes
+            spheres.insert(spheres.end(), boxes.begin(), boxes.end());
+
+            // replaced, not appended to
+            std::vector<uint32_t> visible = {123};
+            const size_t found = list.cull(frustum, &visible, jobs);
+
+            if (found != visible.size() || visible != spheres)
+            {
+                std::cerr << "culled " << visible.size() << " of " << count << " objects visible instead of " << spheres.size() << '\n';
+                return false;
+            }
+
+            // and with no planes to be behind, everything
+            list.cull(Frustum{}, &visible, jobs);
+
+            if (visible.size() != count || list.size() != count)
+            {
+                std::cerr << "default frustum culled " << count - visible.size() << " of " << count << " objects" << '\n';
+                return false;
+            }
+
+            list.clear();
+
+            if (list.size() != 0 || list.cull(frustum, &visible, jobs) != 0 || !visible.empty())
+            {
+                std::cerr << "cleared list still has objects" << '\n';
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+int main()
+{
+    JobSystem jobs(4);
+    const SimdLevel level = Engine::simdLevel();
+
+    const Frustum frustum = Frustum::fromMatrix(Mat4::perspective(1.0f, 1.5f, 0.1f, 100.0f) * Mat4::lookAt({0, 0, 0}, {1, 0, -1}, {0, 1, 0}));
+
+    // every kernel this CPU has, serial and split between jobs
+    for (uint32_t i = 0; i <= static_cast<uint32_t>(Engine::supportedSimdLevel()); i++)
+    {
+        Engine::setSimdLevel(static_cast<SimdLevel>(i));
+
+        if (!matchesIntersects(frustum, nullptr) || !matchesIntersects(frustum, &jobs))
+        {
+            std::cerr << "failed at simd level " << i << '\n';
+            return 1;
+        }
+    }
+
+    Engine::setSimdLevel(level);
+
+    std::cout << "culling passed" << '\n';
+    return 0;
+}
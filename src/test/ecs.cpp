@@ -0,0 +1,452 @@
+#include "engine.h"
+
+#include <iostream>
+#include <unordered_map>
+
+#include "random.h"
+
+using Engine::Commands;
+using Engine::Entity;
+using Engine::JobSystem;
+using Engine::World;
+using Test::random;
+
+namespace
+{
+    struct Position
+    {
+        float x, y, z;
+    };
+
+    struct Velocity
+    {
+        float x, y, z;
+    };
+
+    struct Tag
+    {
+    };
+
+    struct Health
+    {
+        int value;
+    };
+
+    // bigger than most chunks' worth of anything else, and over-aligned
+    struct Big
+    {
+        char bytes[20000];
+    };
+
+    struct alignas(32) Aligned
+    {
+        double values[4];
+    };
+
+    enum Components : uint32_t
+    {
+        HAS_POSITION = 1,
+        HAS_VELOCITY = 2,
+        HAS_TAG = 4,
+        HAS_HEALTH = 8
+    };
+
+    // what the world should have for an entity, positions carry the entity's id in x
+    struct Expected
+    {
+        Entity entity;
+        uint32_t components;
+        float id;
+    };
+
+    bool matches(const World& world, const Expected& expected)
+    {
+        const Position* position = world.get<Position>(expected.entity);
+        const Velocity* velocity = world.get<Velocity>(expected.entity);
+
+        return world.alive(expected.entity) &&
+            (position != nullptr) == ((expected.components & HAS_POSITION) != 0) &&
+            (velocity != nullptr) == ((expected.components & HAS_VELOCITY) != 0) &&
+            world.has<Tag>(expected.entity) == ((expected.components & HAS_TAG) != 0) &&
+            world.has<Health>(expected.entity) == ((expected.components & HAS_HEALTH) != 0) &&
+            (position == nullptr || position->x == expected.id) &&
+            (velocity == nullptr || (velocity->x == expected.id && velocity->y == 1.0f));
+    }
+
+    // random creates, destroys, adds and removes against a map of what should be there, so
+    // entities keep moving between archetypes and chunks get filled, emptied and reused
+    bool randomized(World* world, std::unordered_map<uint32_t, Expected>* expected)
+    {
+        uint32_t seed = 3;
+        std::vector<Entity> created;
+
+        for (uint32_t i = 0; i < 100000; i++)
+        {
+            const uint32_t op = random(&seed) % 10;
+            const float id = static_cast<float>(i);
+
+            if (op < 4 || expected->empty())
+            {
+                const uint32_t components = random(&seed) % 16;
+                Entity entity;
+
+                switch (components & (HAS_POSITION | HAS_VELOCITY))
+                {
+                case 0:
+                    entity = world->create();
+                    break;
+                case HAS_POSITION:
+                    entity = world->create(Position{id, 0, 0});
+                    break;
+                case HAS_VELOCITY:
+                    entity = world->create(Velocity{id, 1, 1});
+                    break;
+                default:
+                    entity = world->create(Position{id, 0, 0}, Velocity{id, 1, 1});
+                    break;
+                }
+
+                if (components & HAS_TAG)
+                {
+                    world->add<Tag>(entity);
+                }
+
+                if (components & HAS_HEALTH)
+                {
+                    world->add(entity, Health{static_cast<int>(i)});
+                }
+
+                (*expected)[entity.index] = {entity, components, id};
+                created.push_back(entity);
+                continue;
+            }
+
+            // anything that's alive, found through one that was created
+            auto found = expected->end();
+
+            while (found == expected->end())
+            {
+                found = expected->find(created[random(&seed) % static_cast<uint32_t>(created.size())].index);
+            }
+
+            Expected& entity = found->second;
+
+            switch (op)
+            {
+            case 4:
+                if (!world->destroy(entity.entity) || world->alive(entity.entity) || world->destroy(entity.entity))
+                {
+                    std::cerr << "destroying entity " << entity.entity.index << " went wrong" << '\n';
+                    return false;
+                }
+
+                expected->erase(found);
+                continue;
+            case 5:
+                if (entity.components & HAS_POSITION)
+                {
+                    world->remove<Position>(entity.entity);
+                } else
+                {
+                    world->add(entity.entity, Position{entity.id, 0, 0});
+                }
+
+                entity.components ^= HAS_POSITION;
+                break;
+            case 6:
+                if (entity.components & HAS_TAG)
+                {
+                    world->remove<Tag>(entity.entity);
+                } else
+                {
+                    world->add<Tag>(entity.entity);
+                }
+
+                entity.components ^= HAS_TAG;
+                break;
+            case 7:
+                if (entity.components & HAS_HEALTH)
+                {
+                    world->remove<Health>(entity.entity);
+                } else
+                {
+                    world->add(entity.entity, Health{7});
+                }
+
+                entity.components ^= HAS_HEALTH;
+                break;
+            default:
+                break;
+            }
+
+            if (!matches(*world, entity))
+            {
+                std::cerr << "entity " << entity.entity.index << " has the wrong components after op " << i << '\n';
+                return false;
+            }
+        }
+
+        if (world->size() != expected->size())
+        {
+            std::cerr << "world has " << world->size() << " entities instead of " << expected->size() << '\n';
+            return false;
+        }
+
+        for (const auto& [index, entity] : *expected)
+        {
+            if (!matches(*world, entity))
+            {
+                std::cerr << "entity " << index << " has the wrong components" << '\n';
+                return false;
+            }
+        }
+
+        // every one of each query exactly once, in chunks aligned like eachChunk() says
+        size_t all = 0;
+        size_t moving = 0;
+        bool aligned = true;
+
+        world->each<>([&](const Entity entity)
+        {
+            all += expected->contains(entity.index) && expected->at(entity.index).entity == entity;
+        });
+
+        world->eachChunk<const Position, const Velocity>([&](const uint32_t count, const Entity*, const Position* positions, const Velocity* velocities)
+        {
+            moving += count;
+            aligned &= count > 0 && reinterpret_cast<uintptr_t>(positions) % 64 == 0 && reinterpret_cast<uintptr_t>(velocities) % 64 == 0;
+        });
+
+        size_t expectedMoving = 0;
+
+        for (const auto& [index, entity] : *expected)
+        {
+            expectedMoving += (entity.components & (HAS_POSITION | HAS_VELOCITY)) == (HAS_POSITION | HAS_VELOCITY);
+        }
+
+        if (all != expected->size() || moving != expectedMoving || !aligned)
+        {
+            std::cerr << "queries found " << all << " and " << moving << " entities instead of " << expected->size() << " and " << expectedMoving << '\n';
+            return false;
+        }
+
+        // handles to destroyed entities stay dead, even once their slot is reused
+        for (const Entity entity : created)
+        {
+            const auto found = expected->find(entity.index);
+
+            if ((found == expected->end() || !(found->second.entity == entity)) && (world->alive(entity) || world->get<Position>(entity) != nullptr))
+            {
+                std::cerr << "destroyed entity " << entity.index << " is still alive" << '\n';
+                return false;
+            }
+        }
+
+        if (world->alive(Entity{}) || world->alive(Entity{999999999, 1}))
+        {
+            std::cerr << "null or made up handle is alive" << '\n';
+            return false;
+        }
+
+        return true;
+    }
+
+    bool layout(World* world)
+    {
+        const Entity first = world->create(Big{}, Aligned{{1, 2, 3, 4}});
+        const Entity second = world->create(Big{}, Aligned{{5, 6, 7, 8}});
+
+        world->get<Big>(first)->bytes[19999] = 9;
+
+        if (world->get<Aligned>(second)->values[0] != 5 || reinterpret_cast<uintptr_t>(world->get<Aligned>(first)) % 32 != 0)
+        {
+            std::cerr << "over-aligned component stored wrong" << '\n';
+            return false;
+        }
+
+        // moved to another archetype with the rest of its data
+        world->remove<Aligned>(first);
+
+        if (world->get<Big>(first)->bytes[19999] != 9)
+        {
+            std::cerr << "big component lost its data moving archetype" << '\n';
+            return false;
+        }
+
+        world->destroy(first);
+
+        if (world->get<Aligned>(second)->values[3] != 8)
+        {
+            std::cerr << "destroying an entity broke another" << '\n';
+            return false;
+        }
+
+        world->destroy(second);
+
+        // no structural changes while a query runs
+        bool refused = true;
+
+        world->each<Position>([&](const Entity entity, Position&)
+        {
+            refused &= !world->destroy(entity) && !world->create(Position{}) && !world->add<Tag>(entity);
+        });
+
+        if (!refused)
+        {
+            std::cerr << "changed the world during a query" << '\n';
+            return false;
+        }
+
+        // a reused slot gets a new generation
+        const Entity entity = world->create();
+        world->destroy(entity);
+        const Entity reused = world->create();
+
+        if (reused.index != entity.index || reused.generation == entity.generation || world->alive(entity))
+        {
+            std::cerr << "reused slot kept its generation" << '\n';
+            return false;
+        }
+
+        world->destroy(reused);
+        return true;
+    }
+
+    // parallelEach() visits every entity once from several threads, recording commands as it goes
+    bool parallel(World* world, std::unordered_map<uint32_t, Expected>* expected)
+    {
+        JobSystem jobs(4);
+        Commands commands;
+
+        size_t moving = 0;
+        size_t destroyed = 0;
+
+        for (const auto& [index, entity] : *expected)
+        {
+            if ((entity.components & (HAS_POSITION | HAS_VELOCITY)) == (HAS_POSITION | HAS_VELOCITY))
+            {
+                moving++;
+                destroyed += static_cast<int>(entity.id) % 3 == 0;
+            }
+        }
+
+        const size_t before = world->size();
+        std::atomic<size_t> visited{0};
+
+        world->parallelEach<Position, const Velocity>(&jobs, [&](const Entity entity, Position& position, const Velocity& velocity)
+        {
+            visited.fetch_add(1, std::memory_order_relaxed);
+            position.z += velocity.z;
+
+            if (static_cast<int>(position.x) % 3 == 0)
+            {
+                commands.destroy(entity);
+            } else
+            {
+                commands.add<Tag>(entity);
+            }
+
+            commands.create(Health{1});
+        }, 2);
+
+        if (visited.load() != moving || commands.size() != moving * 2)
+        {
+            std::cerr << "parallelEach() visited " << visited.load() << " of " << moving << " entities" << '\n';
+            return false;
+        }
+
+        bool once = true;
+
+        world->each<const Position, const Velocity>([&once](Entity, const Position& position, const Velocity&)
+        {
+            once &= position.z == 1.0f;
+        });
+
+        if (!once)
+        {
+            std::cerr << "parallelEach() visited an entity more than once" << '\n';
+            return false;
+        }
+
+        if (!world->apply(&commands) || commands.size() != 0 || world->size() != before - destroyed + moving)
+        {
+            std::cerr << "applying the recorded commands left " << world->size() << " entities" << '\n';
+            return false;
+        }
+
+        size_t tagged = 0;
+
+        world->each<const Position, const Velocity, const Tag>([&tagged](Entity, const Position&, const Velocity&, const Tag&)
+        {
+            tagged++;
+        });
+
+        size_t expectedTagged = 0;
+
+        for (const auto& [index, entity] : *expected)
+        {
+            expectedTagged += (entity.components & (HAS_POSITION | HAS_VELOCITY)) == (HAS_POSITION | HAS_VELOCITY) && static_cast<int>(entity.id) % 3 != 0;
+        }
+
+        if (tagged != expectedTagged)
+        {
+            std::cerr << tagged << " entities tagged instead of " << expectedTagged << '\n';
+            return false;
+        }
+
+        // commands on one entity apply in order, and nothing after it's destroyed
+        const Entity entity = world->create(Health{1});
+
+        commands.add(entity, Health{2});
+        commands.remove<Health>(entity);
+        commands.add(entity, Health{4});
+        world->apply(&commands);
+
+        if (world->get<Health>(entity) == nullptr || world->get<Health>(entity)->value != 4)
+        {
+            std::cerr << "commands applied out of order" << '\n';
+            return false;
+        }
+
+        commands.destroy(entity);
+        commands.add(entity, Health{5});
+        world->apply(&commands);
+
+        if (world->alive(entity))
+        {
+            std::cerr << "destroyed entity came back" << '\n';
+            return false;
+        }
+
+        return true;
+    }
+}
+
+int main()
+{
+    World world;
+    std::unordered_map<uint32_t, Expected> expected;
+
+    if (!randomized(&world, &expected) || !layout(&world) || !parallel(&world, &expected))
+    {
+        return 1;
+    }
+
+    // every chunk goes back once the entities are gone
+    std::vector<Entity> entities;
+    world.each<>([&entities](const Entity entity) { entities.push_back(entity); });
+
+    for (const Entity entity : entities)
+    {
+        world.destroy(entity);
+    }
+
+    if (world.size() != 0 || world.chunkCount() != 0)
+    {
+        std::cerr << world.chunkCount() << " chunks left in an empty world" << '\n';
+        return 1;
+    }
+
+    std::cout << "ecs passed (" << world.archetypeCount() << " archetypes)" << '\n';
+    return 0;
+}
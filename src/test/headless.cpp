@@ -0,0 +1,154 @@
+#include "core/renderer.h"
+
+#include <iostream>
+
+#ifndef HAS_VULKAN
+
+int main()
+{
+    std::cerr << "couldn't find Vulkan" << '\n';
+    return 1;
+}
+
+#else
+
+#include "engine.h"
+
+using Engine::Game;
+using Engine::Renderer;
+
+int terminate(const Renderer* renderer, int code)
+{
+    delete renderer;
+    return code;
+}
+
+int main()
+{
+    constexpr int version[] = {0, 1, 0};
+    const auto game = new Game("Test", version);
+    const auto renderer = new Renderer(game);
+
+    renderer->readback = true;
+
+    const VkResult instResult = renderer->createInstance(0, nullptr);
+
+    if (instResult == VK_SUCCESS)
+    {
+        std::cout << "created instance successfully!" << '\n';
+    } else
+    {
+        std::cerr << "failed to create renderer: " << instResult << '\n';
+        return terminate(renderer, 1);
+    }
+
+    const VkResult devResult = renderer->createDevice(VK_NULL_HANDLE);
+
+    if (devResult == VK_SUCCESS)
+    {
+        std::cout << "created headless device successfully!" << '\n';
+    } else
+    {
+        std::cerr << "failed to create device (" << devResult << ')' << '\n';
+        return terminate(renderer, 1);
+    }
+
+    constexpr uint32_t width = 64;
+    constexpr uint32_t height = 64;
+
+    const VkResult offscreenResult = renderer->createOffscreen(width, height);
+
+    if (offscreenResult == VK_SUCCESS)
+    {
+        std::cout << "created offscreen targets successfully!" << '\n';
+    } else
+    {
+        std::cerr << "failed to create offscreen targets (" << offscreenResult << ')' << '\n';
+        return terminate(renderer, 1);
+    }
+
+    // packed by the test_assets target, the shaders below come out of it when it's there
+    Loaders::Archive assets;
+
+    if (assets.open("shaders.arc", true))
+    {
+        Loaders::mount(&assets, "../src/test/shaders/compiled");
+        std::cout << "mounted shaders.arc (" << assets.size() << " files)" << '\n';
+    }
+
+    VkShaderModule vertShader;
+    VkShaderModule fragShader;
+
+    std::cout << "vertex shader result: " <<
+        Loaders::loadShaderModule(renderer->vkDev, "../src/test/shaders/compiled/triangle.vert.spv", &vertShader) << '\n';
+
+    std::cout << "fragment shader result: "  <<
+        Loaders::loadShaderModule(renderer->vkDev, "../src/test/shaders/compiled/triangle.frag.spv", &fragShader) << '\n';
+
+    VkPipelineShaderStageCreateInfo vertInfo{};
+    vertInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    vertInfo.module = vertShader;
+    vertInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+    vertInfo.pName = "main";
+
+    VkPipelineShaderStageCreateInfo fragInfo{};
+    fragInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    fragInfo.module = fragShader;
+    fragInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    fragInfo.pName = "main";
+
+    const VkResult pipelineResult = renderer->createRenderPipeline({vertInfo, fragInfo});
+
+    vkDestroyShaderModule(renderer->vkDev, vertShader, nullptr);
+    vkDestroyShaderModule(renderer->vkDev, fragShader, nullptr);
+    Loaders::unmount(&assets);
+
+    if (pipelineResult == VK_SUCCESS)
+    {
+        std::cout << "created pipeline successfully!" << '\n';
+    } else
+    {
+        std::cerr << "failed to create pipeline (" << pipelineResult << ')' << '\n';
+        return terminate(renderer, 1);
+    }
+
+    // the shaders make up the vertices themselves
+    Engine::Mesh triangle{};
+    triangle.vertexCount = 3;
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        renderer->draw(&triangle);
+        const VkResult renderResult = renderer->render();
+
+        if (renderResult != VK_SUCCESS)
+        {
+            std::cerr << "failed to render frame " << i << " (" << renderResult << ')' << '\n';
+            return terminate(renderer, 1);
+        }
+    }
+
+    std::vector<char> pixels;
+    const VkResult readResult = renderer->readPixels(&pixels);
+
+    if (readResult != VK_SUCCESS)
+    {
+        std::cerr << "failed to read pixels (" << readResult << ')' << '\n';
+        return terminate(renderer, 1);
+    }
+
+    // the triangle covers the middle of the image, the clear colour is black
+    const size_t center = ((height / 2) * width + width / 2) * 4;
+    const auto* pixel = reinterpret_cast<const unsigned char*>(&pixels[center]);
+
+    if (pixel[0] == 0 && pixel[1] == 0 && pixel[2] == 0)
+    {
+        std::cerr << "triangle missing from the readback" << '\n';
+        return terminate(renderer, 1);
+    }
+
+    std::cout << "rendered headless successfully!" << '\n';
+    return terminate(renderer, 0);
+}
+
+#endif
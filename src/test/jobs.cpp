@@ -0,0 +1,205 @@
+#include "engine.h"
+
+#include <iostream>
+#include <thread>
+
+using Engine::JobCounter;
+using Engine::JobSystem;
+
+namespace
+{
+    // more than a worker's ring and deque hold, so slots get reused while jobs are still queued
+    bool counted(JobSystem* jobs)
+    {
+        std::atomic<uint64_t> sum{0};
+
+        for (uint32_t round = 0; round < 20; round++)
+        {
+            JobCounter counter;
+
+            for (uint32_t i = 0; i < 10000; i++)
+            {
+                jobs->run([&sum, i] { sum.fetch_add(i, std::memory_order_relaxed); }, &counter);
+            }
+
+            jobs->wait(&counter);
+
+            if (counter.value.load() != 0)
+            {
+                std::cerr << "counter still at " << counter.value.load() << " after wait()" << '\n';
+                return false;
+            }
+        }
+
+        const uint64_t expected = 20ull * (9999ull * 10000 / 2);
+
+        if (sum.load() != expected)
+        {
+            std::cerr << "jobs summed to " << sum.load() << " instead of " << expected << '\n';
+            return false;
+        }
+
+        return true;
+    }
+
+    // every dependent has to see all of what it runs after
+    bool dependencies(JobSystem* jobs)
+    {
+        JobCounter first;
+        JobCounter second;
+        std::atomic<uint32_t> done{0};
+        std::atomic<uint32_t> early{0};
+
+        for (uint32_t i = 0; i < 500; i++)
+        {
+            jobs->run([&done] { done.fetch_add(1); }, &first);
+        }
+
+        for (uint32_t i = 0; i < 500; i++)
+        {
+            jobs->runAfter(&first, [&done, &early]
+            {
+                if (done.load() < 500)
+                {
+                    early.fetch_add(1);
+                }
+            }, &second);
+        }
+
+        jobs->wait(&second);
+
+        if (early.load() != 0)
+        {
+            std::cerr << early.load() << " dependent jobs ran before what they depend on" << '\n';
+            return false;
+        }
+
+        // after a counter that's already at zero it just runs
+        JobCounter third;
+        std::atomic<bool> ran{false};
+
+        jobs->runAfter(&first, [&ran] { ran.store(true); }, &third);
+        jobs->wait(&third);
+
+        if (!ran.load())
+        {
+            std::cerr << "job after a finished counter never ran" << '\n';
+            return false;
+        }
+
+        return true;
+    }
+
+    // each index once, also from inside another parallelFor
+    bool parallelFor(JobSystem* jobs)
+    {
+        constexpr uint32_t outer = 64;
+        constexpr uint32_t inner = 4096;
+
+        std::vector<uint8_t> hits(outer * inner, 0);
+        uint8_t* pHits = hits.data();
+
+        jobs->parallelFor(outer, 1, [jobs, pHits](const uint32_t begin, const uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                uint8_t* row = pHits + i * inner;
+
+                jobs->parallelFor(inner, 256, [row](const uint32_t first, const uint32_t last)
+                {
+                    for (uint32_t j = first; j < last; j++)
+                    {
+                        row[j]++;
+                    }
+                });
+            }
+        });
+
+        for (size_t i = 0; i < hits.size(); i++)
+        {
+            if (hits[i] != 1)
+            {
+                std::cerr << "parallelFor hit index " << i << ' ' << static_cast<int>(hits[i]) << " times" << '\n';
+                return false;
+            }
+        }
+
+        // batches that don't divide the count, and nothing at all
+        std::vector<uint8_t> uneven(1001, 0);
+        uint8_t* pUneven = uneven.data();
+
+        jobs->parallelFor(1001, 64, [pUneven](const uint32_t begin, const uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                pUneven[i]++;
+            }
+        });
+
+        jobs->parallelFor(0, 64, [](uint32_t, uint32_t) { std::abort(); });
+
+        for (const uint8_t hit : uneven)
+        {
+            if (hit != 1)
+            {
+                std::cerr << "uneven parallelFor missed or repeated an index" << '\n';
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // threads that aren't workers go through the shared queue
+    bool foreign(JobSystem* jobs)
+    {
+        std::atomic<uint32_t> total{0};
+        std::thread threads[2];
+
+        for (auto& thread : threads)
+        {
+            thread = std::thread([jobs, &total]
+            {
+                JobCounter counter;
+
+                for (uint32_t i = 0; i < 2000; i++)
+                {
+                    jobs->run([&total] { total.fetch_add(1); }, &counter);
+                }
+
+                jobs->wait(&counter);
+            });
+        }
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        if (total.load() != 4000)
+        {
+            std::cerr << "jobs from other threads ran " << total.load() << " times instead of 4000" << '\n';
+            return false;
+        }
+
+        return true;
+    }
+}
+
+int main()
+{
+    // the calling thread plus a few, more than the cores here doesn't matter
+    for (const uint32_t threads : {1u, 4u})
+    {
+        JobSystem jobs(threads);
+
+        if (!counted(&jobs) || !dependencies(&jobs) || !parallelFor(&jobs) || !foreign(&jobs))
+        {
+            std::cerr << "failed with " << threads << " threads" << '\n';
+            return 1;
+        }
+    }
+
+    std::cout << "jobs ran correctly!" << '\n';
+    return 0;
+}
@@ -0,0 +1,245 @@
+#include "loaders/loaders.h"
+
+#include <iostream>
+
+#ifndef HAS_VULKAN
+
+int main()
+{
+    std::cerr << "couldn't find Vulkan" << '\n';
+    return 1;
+}
+
+#else
+
+#include <algorithm>
+#include <cstring>
+
+#include "random.h"
+
+using Loaders::TextureInfo;
+using Test::random;
+
+namespace
+{
+    struct Format
+    {
+        VkFormat format;
+        uint32_t blockWidth;
+        uint32_t blockSize;
+    };
+
+    // a few of each kind parseKtx2() knows
+    constexpr Format FORMATS[] = {
+        {VK_FORMAT_R8_UNORM, 1, 1},
+        {VK_FORMAT_R8G8_UNORM, 1, 2},
+        {VK_FORMAT_R8G8B8A8_SRGB, 1, 4},
+        {VK_FORMAT_R16G16B16A16_SFLOAT, 1, 8},
+        {VK_FORMAT_R32G32B32A32_SFLOAT, 1, 16},
+        {VK_FORMAT_BC1_RGB_UNORM_BLOCK, 4, 8},
+        {VK_FORMAT_BC3_SRGB_BLOCK, 4, 16},
+        {VK_FORMAT_BC7_UNORM_BLOCK, 4, 16},
+    };
+
+    std::vector<std::vector<char>> levels(const Format& format, const uint32_t width, const uint32_t height, const uint32_t count, uint32_t* seed)
+    {
+        std::vector<std::vector<char>> data(count);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const uint32_t blocksX = (std::max(width >> i, 1u) + format.blockWidth - 1) / format.blockWidth;
+            const uint32_t blocksY = (std::max(height >> i, 1u) + format.blockWidth - 1) / format.blockWidth;
+
+            data[i].resize(static_cast<size_t>(blocksX) * blocksY * format.blockSize);
+
+            for (char& byte : data[i])
+            {
+                byte = static_cast<char>(random(seed));
+            }
+        }
+
+        return data;
+    }
+
+    uint32_t maxLevels(const uint32_t width, const uint32_t height)
+    {
+        uint32_t count = 1;
+
+        for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+        {
+            count++;
+        }
+
+        return count;
+    }
+
+    // odd sizes, strips and partial mip chains in every format, written and parsed back
+    bool roundTrip()
+    {
+        uint32_t seed = 13;
+
+        for (uint32_t i = 0; i < 400; i++)
+        {
+            const Format& format = FORMATS[i % std::size(FORMATS)];
+            const uint32_t width = i % 7 == 0 ? 1 : 1 + random(&seed) % 300;
+            const uint32_t height = i % 11 == 0 ? 1 : 1 + random(&seed) % 300;
+            const uint32_t count = 1 + random(&seed) % maxLevels(width, height);
+
+            const std::vector<std::vector<char>> data = levels(format, width, height, count, &seed);
+            std::vector<char> file;
+            TextureInfo info;
+
+            if (!Loaders::writeKtx2(format.format, width, height, data, &file) || !Loaders::parseKtx2(file.data(), file.size(), &info))
+            {
+                std::cerr << "failed to round trip a " << width << 'x' << height << " texture with " << count << " levels" << '\n';
+                return false;
+            }
+
+            if (info.format != format.format || info.width != width || info.height != height || info.levels.size() != count ||
+                info.blockWidth != format.blockWidth || info.blockHeight != format.blockWidth || info.blockSize != format.blockSize)
+            {
+                std::cerr << "parsed a " << width << 'x' << height << " texture wrong" << '\n';
+                return false;
+            }
+
+            for (uint32_t j = 0; j < count; j++)
+            {
+                const TextureInfo::Level& level = info.levels[j];
+
+                if (level.width != std::max(width >> j, 1u) || level.height != std::max(height >> j, 1u) ||
+                    level.size != data[j].size() || level.offset % std::max(format.blockSize, 4u) != 0 ||
+                    memcmp(file.data() + level.offset, data[j].data(), level.size) != 0)
+                {
+                    std::cerr << "level " << j << " of a " << width << 'x' << height << " texture came out different" << '\n';
+                    return false;
+                }
+
+                // smallest first, so streaming from the front gets the mip tail early
+                if (j > 0 && level.offset > info.levels[j - 1].offset)
+                {
+                    std::cerr << "level " << j << " comes after a bigger one" << '\n';
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool rejected()
+    {
+        uint32_t seed = 17;
+        const std::vector<std::vector<char>> data = levels(FORMATS[2], 64, 32, 7, &seed);
+        std::vector<char> file;
+        TextureInfo info;
+
+        // levels of the wrong size, too many, none, and formats it doesn't know
+        std::vector<std::vector<char>> wrong = data;
+        wrong[3].pop_back();
+
+        if (Loaders::writeKtx2(FORMATS[2].format, 64, 32, wrong, &file) ||
+            Loaders::writeKtx2(FORMATS[2].format, 64, 16, data, &file) ||
+            Loaders::writeKtx2(FORMATS[2].format, 64, 32, {}, &file) ||
+            Loaders::writeKtx2(FORMATS[2].format, 0, 32, data, &file) ||
+            Loaders::writeKtx2(VK_FORMAT_UNDEFINED, 64, 32, data, &file))
+        {
+            std::cerr << "wrote a texture it shouldn't have" << '\n';
+            return false;
+        }
+
+        std::vector<char> original;
+
+        if (!Loaders::writeKtx2(FORMATS[2].format, 64, 32, data, &original))
+        {
+            std::cerr << "failed to write a texture" << '\n';
+            return false;
+        }
+
+        const auto patched = [&original](const size_t offset, const uint32_t value)
+        {
+            std::vector<char> copy = original;
+            memcpy(copy.data() + offset, &value, 4);
+            return copy;
+        };
+
+        // identifier, format, depth, layers, faces, levels, supercompression
+        const std::vector<char> files[] = {
+            patched(0, 0),
+            patched(12, VK_FORMAT_UNDEFINED),
+            patched(28, 2),
+            patched(32, 2),
+            patched(36, 6),
+            patched(40, 8),
+            patched(44, 1),
+        };
+
+        for (const auto& bad : files)
+        {
+            if (Loaders::parseKtx2(bad.data(), bad.size(), &info))
+            {
+                std::cerr << "parsed a texture it doesn't support" << '\n';
+                return false;
+            }
+        }
+
+        // 0 levels means generate them, so it's read as just the first
+        const std::vector<char> generate = patched(40, 0);
+
+        if (!Loaders::parseKtx2(generate.data(), generate.size(), &info) || info.levels.size() != 1)
+        {
+            std::cerr << "texture asking for generated levels parsed wrong" << '\n';
+            return false;
+        }
+
+        for (size_t size = 0; size < original.size(); size += 1 + size / 8)
+        {
+            if (Loaders::parseKtx2(original.data(), size, &info))
+            {
+                std::cerr << "parsed a texture cut off at " << size << " bytes" << '\n';
+                return false;
+            }
+        }
+
+        // flipped bits, whatever still parses has to stay inside the file
+        for (uint32_t i = 0; i < 20000; i++)
+        {
+            std::vector<char> corrupt = original;
+
+            for (uint32_t j = 0; j < 1 + i % 3; j++)
+            {
+                // mostly the header and level index, that's what gets checked
+                const size_t at = random(&seed) % (i % 4 == 0 ? corrupt.size() : 80 + 7 * 24);
+                corrupt[at] ^= static_cast<char>(1 << random(&seed) % 8);
+            }
+
+            if (!Loaders::parseKtx2(corrupt.data(), corrupt.size(), &info))
+            {
+                continue;
+            }
+
+            for (const TextureInfo::Level& level : info.levels)
+            {
+                if (level.offset > corrupt.size() || level.size > corrupt.size() - level.offset)
+                {
+                    std::cerr << "corrupted texture has a level outside the file" << '\n';
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+}
+
+int main()
+{
+    if (!roundTrip() || !rejected())
+    {
+        return 1;
+    }
+
+    std::cout << "ktx2 round trip passed" << '\n';
+    return 0;
+}
+
+#endif
@@ -0,0 +1,303 @@
+#include "engine.h"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "random.h"
+
+using Engine::Mat4;
+using Engine::Quat;
+using Engine::SimdLevel;
+using Engine::Vec3;
+using Engine::Vec4;
+using Test::random;
+
+namespace
+{
+    // counts around every width the kernels go through, with leftovers for the scalar tail
+    constexpr size_t COUNTS[] = {0, 1, 3, 5, 7, 9, 17, 33, 1001};
+
+    bool near(const float a, const float b, const float tolerance)
+    {
+        return std::fabs(a - b) <= tolerance * (1.0f + std::fabs(b));
+    }
+
+    bool near(const Vec3 a, const Vec3 b, const float tolerance)
+    {
+        return near(a.x, b.x, tolerance) && near(a.y, b.y, tolerance) && near(a.z, b.z, tolerance);
+    }
+
+    bool near(const Mat4& a, const Mat4& b, const float tolerance)
+    {
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            if (!near(a.m[i], b.m[i], tolerance))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // the same rotation either way round
+    bool near(const Quat& a, const Quat& b, const float tolerance)
+    {
+        return std::fabs(Engine::dot(a, b)) >= 1.0f - tolerance;
+    }
+
+    Mat4 randomTrs(uint32_t* seed)
+    {
+        const Vec3 axis = {random(seed, -1.0f, 1.0f), random(seed, -1.0f, 1.0f), random(seed, -1.0f, 1.0f) + 0.01f};
+
+        return Mat4::trs(
+            {random(seed, -10.0f, 10.0f), random(seed, -10.0f, 10.0f), random(seed, -10.0f, 10.0f)},
+            Quat::axisAngle(axis, random(seed, -3.14f, 3.14f)),
+            {random(seed, 0.5f, 2.0f), random(seed, 0.5f, 2.0f), random(seed, 0.5f, 2.0f)});
+    }
+
+    // anything, transformPoints() and transformPoint() both ignore the bottom row
+    Mat4 randomMatrix(uint32_t* seed)
+    {
+        Mat4 result;
+
+        for (float& value : result.m)
+        {
+            value = random(seed, -2.0f, 2.0f);
+        }
+
+        return result;
+    }
+
+    Vec4 project(const Mat4& a, const Vec3 p)
+    {
+        const Vec4 clip = a * Vec4{p.x, p.y, p.z, 1.0f};
+        return {clip.x / clip.w, clip.y / clip.w, clip.z / clip.w, clip.w};
+    }
+
+    bool transformsPoints(uint32_t* seed)
+    {
+        for (const size_t count : COUNTS)
+        {
+            const Mat4 a = randomMatrix(seed);
+            std::vector<float> x(count);
+            std::vector<float> y(count);
+            std::vector<float> z(count);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                x[i] = random(seed, -100.0f, 100.0f);
+                y[i] = random(seed, -100.0f, 100.0f);
+                z[i] = random(seed, -100.0f, 100.0f);
+            }
+
+            std::vector<float> outX(count);
+            std::vector<float> outY(count);
+            std::vector<float> outZ(count);
+            Engine::transformPoints(a, x.data(), y.data(), z.data(), outX.data(), outY.data(), outZ.data(), count);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                if (!near(Vec3{outX[i], outY[i], outZ[i]}, Engine::transformPoint(a, {x[i], y[i], z[i]}), 1e-5f))
+                {
+                    std::cerr << "transformPoints() differs at " << i << " of " << count << '\n';
+                    return false;
+                }
+            }
+
+            // and written over its own input
+            Engine::transformPoints(a, x.data(), y.data(), z.data(), x.data(), y.data(), z.data(), count);
+
+            if (x != outX || y != outY || z != outZ)
+            {
+                std::cerr << "transformPoints() in place differs for " << count << " points" << '\n';
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool multipliesMatrices(uint32_t* seed)
+    {
+        for (const size_t count : COUNTS)
+        {
+            const Mat4 single = randomTrs(seed);
+            std::vector<Mat4> a(count);
+            std::vector<Mat4> b(count);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                a[i] = randomTrs(seed);
+                b[i] = randomTrs(seed);
+            }
+
+            std::vector<Mat4> pairs(count);
+            std::vector<Mat4> batch(count);
+            Engine::multiplyMatrices(a.data(), b.data(), pairs.data(), count);
+            Engine::multiplyMatrices(single, b.data(), batch.data(), count);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                if (!near(pairs[i], a[i] * b[i], 1e-5f) || !near(batch[i], single * b[i], 1e-5f))
+                {
+                    std::cerr << "multiplyMatrices() differs at " << i << " of " << count << '\n';
+                    return false;
+                }
+            }
+
+            // out the same array as either input
+            std::vector<Mat4> intoA = a;
+            std::vector<Mat4> intoB = b;
+            Engine::multiplyMatrices(intoA.data(), b.data(), intoA.data(), count);
+            Engine::multiplyMatrices(a.data(), intoB.data(), intoB.data(), count);
+
+            std::vector<Mat4> batchInPlace = b;
+            Engine::multiplyMatrices(single, batchInPlace.data(), batchInPlace.data(), count);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                if (!near(intoA[i], pairs[i], 0.0f) || !near(intoB[i], pairs[i], 0.0f) || !near(batchInPlace[i], batch[i], 0.0f))
+                {
+                    std::cerr << "multiplyMatrices() in place differs at " << i << " of " << count << '\n';
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool inverts(uint32_t* seed)
+    {
+        const Mat4 identity;
+
+        for (uint32_t i = 0; i < 1000; i++)
+        {
+            const Mat4 trs = randomTrs(seed);
+            const Mat4 projection = Mat4::perspective(random(seed, 0.5f, 2.0f), random(seed, 0.5f, 2.0f), random(seed, 0.01f, 1.0f), random(seed, 10.0f, 1000.0f));
+
+            if (!near(Engine::inverse(trs) * trs, identity, 1e-4f) || !near(trs * Engine::inverse(trs), identity, 1e-4f) ||
+                !near(Engine::inverse(projection) * projection, identity, 1e-4f))
+            {
+                std::cerr << "inverse() doesn't give back the identity" << '\n';
+                return false;
+            }
+
+            if (!near(Engine::affineInverse(trs) * trs, identity, 1e-4f) || !near(Engine::affineInverse(trs), Engine::inverse(trs), 1e-4f))
+            {
+                std::cerr << "affineInverse() doesn't give back the identity" << '\n';
+                return false;
+            }
+        }
+
+        Mat4 zeros;
+
+        for (float& value : zeros.m)
+        {
+            value = 0.0f;
+        }
+
+        if (!near(Engine::inverse(Mat4::scaling({1.0f, 0.0f, 1.0f})), zeros, 0.0f))
+        {
+            std::cerr << "inverse() of a singular matrix isn't all zeros" << '\n';
+            return false;
+        }
+
+        return true;
+    }
+
+    // turning part of the way between two angles round the same axis is the angle in between, as
+    // long as they're less than half a turn apart, otherwise the other way round is shorter
+    bool slerps(uint32_t* seed)
+    {
+        for (uint32_t i = 0; i < 1000; i++)
+        {
+            const Vec3 axis = {random(seed, -1.0f, 1.0f), random(seed, -1.0f, 1.0f), random(seed, -1.0f, 1.0f) + 0.01f};
+            const float from = random(seed, -3.0f, 3.0f);
+            const float to = from + random(seed, -3.0f, 3.0f);
+            const float t = random(seed, 0.0f, 1.0f);
+
+            const Quat a = Quat::axisAngle(axis, from);
+            const Quat b = Quat::axisAngle(axis, to);
+
+            if (!near(Engine::slerp(a, b, t), Quat::axisAngle(axis, from + (to - from) * t), 1e-4f) ||
+                !near(Engine::slerp(a, b, 0.0f), a, 1e-5f) || !near(Engine::slerp(a, b, 1.0f), b, 1e-5f))
+            {
+                std::cerr << "slerp() from " << from << " to " << to << " at " << t << " turned the wrong amount" << '\n';
+                return false;
+            }
+
+            // close enough that it lerps, still unit length
+            const Quat close = Engine::slerp(a, Quat::axisAngle(axis, from + 1e-3f), t);
+
+            if (!near(Engine::dot(close, close), 1.0f, 1e-5f) || !near(close, Quat::axisAngle(axis, from + 1e-3f * t), 1e-5f))
+            {
+                std::cerr << "slerp() between close rotations is off" << '\n';
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // depth from 0 at near to 1 at far and y pointing down in clip space
+    bool vulkanConventions()
+    {
+        const Mat4 perspective = Mat4::perspective(1.0f, 1.5f, 0.1f, 100.0f);
+
+        if (!near(project(perspective, {0.0f, 0.0f, -0.1f}).z, 0.0f, 1e-5f) || !near(project(perspective, {0.0f, 0.0f, -100.0f}).z, 1.0f, 1e-5f) ||
+            project(perspective, {0.0f, 0.0f, -1.0f}).w <= 0.0f || project(perspective, {0.0f, 1.0f, -2.0f}).y >= 0.0f ||
+            project(perspective, {1.0f, 0.0f, -2.0f}).x <= 0.0f)
+        {
+            std::cerr << "perspective() doesn't follow Vulkan's depth and y" << '\n';
+            return false;
+        }
+
+        const Mat4 orthographic = Mat4::orthographic(-2.0f, 2.0f, -1.0f, 1.0f, 0.5f, 10.0f);
+
+        if (!near(project(orthographic, {0.0f, 0.0f, -0.5f}).z, 0.0f, 1e-5f) || !near(project(orthographic, {0.0f, 0.0f, -10.0f}).z, 1.0f, 1e-5f) ||
+            !near(project(orthographic, {0.0f, 1.0f, -1.0f}).y, -1.0f, 1e-5f) || !near(project(orthographic, {2.0f, 0.0f, -1.0f}).x, 1.0f, 1e-5f))
+        {
+            std::cerr << "orthographic() doesn't follow Vulkan's depth and y" << '\n';
+            return false;
+        }
+
+        // the eye at the origin looking down -z with up still up
+        const Vec3 eye = {1.0f, 2.0f, 3.0f};
+        const Mat4 view = Mat4::lookAt(eye, {4.0f, 2.0f, -1.0f}, {0.0f, 1.0f, 0.0f});
+
+        if (!near(Engine::transformPoint(view, eye), Vec3{}, 1e-5f) || !near(Engine::transformPoint(view, {4.0f, 2.0f, -1.0f}), Vec3{0.0f, 0.0f, -5.0f}, 1e-5f) ||
+            !near(Engine::transformPoint(view, eye + Vec3{0.0f, 1.0f, 0.0f}), Vec3{0.0f, 1.0f, 0.0f}, 1e-5f))
+        {
+            std::cerr << "lookAt() doesn't look down -z" << '\n';
+            return false;
+        }
+
+        return true;
+    }
+}
+
+int main()
+{
+    const SimdLevel level = Engine::simdLevel();
+
+    // every kernel this CPU has against the inline operators
+    for (uint32_t i = 0; i <= static_cast<uint32_t>(Engine::supportedSimdLevel()); i++)
+    {
+        Engine::setSimdLevel(static_cast<SimdLevel>(i));
+        uint32_t seed = 5;
+
+        if (!transformsPoints(&seed) || !multipliesMatrices(&seed) || !inverts(&seed) || !slerps(&seed) || !vulkanConventions())
+        {
+            std::cerr << "failed at simd level " << i << '\n';
+            return 1;
+        }
+    }
+
+    Engine::setSimdLevel(level);
+
+    std::cout << "math passed" << '\n';
+    return 0;
+}
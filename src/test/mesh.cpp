@@ -0,0 +1,528 @@
+#include "loaders/loaders.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <set>
+
+#include "random.h"
+
+using Loaders::MeshData;
+using Loaders::MeshInfo;
+using Test::random;
+
+namespace
+{
+    void put(std::vector<char>* out, const void* data, const size_t size)
+    {
+        out->insert(out->end(), static_cast<const char*>(data), static_cast<const char*>(data) + size);
+    }
+
+    bool writeText(const std::filesystem::path& path, const std::string& text)
+    {
+        return Loaders::writefile(std::vector<char>(text.begin(), text.end()), path.string().c_str());
+    }
+
+    std::string base64(const std::vector<char>& data)
+    {
+        constexpr const char* DIGITS = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string out;
+
+        for (size_t i = 0; i < data.size(); i += 3)
+        {
+            uint32_t value = static_cast<uint8_t>(data[i]) << 16;
+            value |= i + 1 < data.size() ? static_cast<uint8_t>(data[i + 1]) << 8 : 0;
+            value |= i + 2 < data.size() ? static_cast<uint8_t>(data[i + 2]) : 0;
+
+            out += DIGITS[value >> 18];
+            out += DIGITS[value >> 12 & 63];
+            out += i + 1 < data.size() ? DIGITS[value >> 6 & 63] : '=';
+            out += i + 2 < data.size() ? DIGITS[value & 63] : '=';
+        }
+
+        return out;
+    }
+
+    float halfToFloat(const uint16_t half)
+    {
+        const int exponent = half >> 10 & 31;
+        const int mantissa = half & 1023;
+        const float sign = half & 0x8000 ? -1.0f : 1.0f;
+
+        if (exponent == 31)
+        {
+            return sign * INFINITY;
+        }
+
+        return sign * (exponent == 0 ? std::ldexp(static_cast<float>(mantissa), -24) : std::ldexp(static_cast<float>(mantissa + 1024), exponent - 25));
+    }
+
+    // A quad with normals, uvs and 16 bit indices, under it a node mirrored in x drawing a strip
+    // of normalized byte positions without normals (so they're made flat), and a line primitive
+    // that gets skipped. The quad's indices are also stored as u8 and u32 for the other accessors.
+    struct Model
+    {
+        std::vector<char> buffer;
+        size_t stripOffset = 0;
+        size_t bytesOffset = 0;
+        size_t wordsOffset = 0;
+
+        Model()
+        {
+            constexpr float positions[] = {0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0};
+            constexpr float normals[] = {0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1};
+            constexpr float uvs[] = {0, 0, 1, 0, 1, 1, 0, 1};
+            constexpr uint16_t indices[] = {0, 1, 2, 0, 2, 3};
+            constexpr uint8_t strip[] = {0, 0, 0, 0, 255, 0, 0, 0, 0, 255, 0, 0, 255, 255, 0, 0};
+            constexpr uint8_t bytes[] = {0, 1, 2, 0, 2, 3, 0, 0};
+            constexpr uint32_t words[] = {0, 1, 2, 0, 2, 3};
+
+            put(&this->buffer, positions, sizeof(positions));
+            put(&this->buffer, normals, sizeof(normals));
+            put(&this->buffer, uvs, sizeof(uvs));
+            put(&this->buffer, indices, sizeof(indices));
+
+            this->stripOffset = this->buffer.size();
+            put(&this->buffer, strip, sizeof(strip));
+
+            this->bytesOffset = this->buffer.size();
+            put(&this->buffer, bytes, sizeof(bytes));
+
+            this->wordsOffset = this->buffer.size();
+            put(&this->buffer, words, sizeof(words));
+        }
+
+        // uri is left out for the .glb's own buffer, indices picks the quad's index accessor
+        [[nodiscard]] std::string json(const std::string& uri, const uint32_t indices = 3) const
+        {
+            const std::string source = uri.empty() ? "" : ",\"uri\":\"" + uri + "\"";
+
+            return
+                R"({"asset":{"version":"2.0"},"scene":0,"scenes":[{"nodes":[0]}],)"
+                R"("nodes":[{"mesh":0,"children":[1]},{"mesh":1,"scale":[-2,1,1],"translation":[10,0,0]}],)"
+                R"("meshes":[{"primitives":[{"attributes":{"POSITION":0,"NORMAL":1,"TEXCOORD_0":2},"indices":)" + std::to_string(indices) + R"(}]},)"
+                R"({"primitives":[{"attributes":{"POSITION":4},"mode":5},{"attributes":{"POSITION":0},"mode":1}]}],)"
+                R"("buffers":[{"byteLength":)" + std::to_string(this->buffer.size()) + source + R"(}],)"
+                R"("bufferViews":[{"buffer":0,"byteLength":48},{"buffer":0,"byteOffset":48,"byteLength":48},)"
+                R"({"buffer":0,"byteOffset":96,"byteLength":32},{"buffer":0,"byteOffset":128,"byteLength":12},)"
+                R"({"buffer":0,"byteOffset":)" + std::to_string(this->stripOffset) + R"(,"byteLength":16,"byteStride":4},)"
+                R"({"buffer":0,"byteOffset":)" + std::to_string(this->bytesOffset) + R"(,"byteLength":6},)"
+                R"({"buffer":0,"byteOffset":)" + std::to_string(this->wordsOffset) + R"(,"byteLength":24}],)"
+                R"("accessors":[{"bufferView":0,"componentType":5126,"count":4,"type":"VEC3"},)"
+                R"({"bufferView":1,"componentType":5126,"count":4,"type":"VEC3"},)"
+                R"({"bufferView":2,"componentType":5126,"count":4,"type":"VEC2"},)"
+                R"({"bufferView":3,"componentType":5123,"count":6,"type":"SCALAR"},)"
+                R"({"bufferView":4,"componentType":5121,"normalized":true,"count":4,"type":"VEC3"},)"
+                R"({"bufferView":5,"componentType":5121,"normalized":true,"count":6,"type":"SCALAR"},)"
+                R"({"bufferView":6,"componentType":5125,"count":6,"type":"SCALAR"}]})";
+        }
+
+        [[nodiscard]] std::vector<char> glb() const
+        {
+            std::string json = this->json("");
+
+            while (json.size() % 4 != 0)
+            {
+                json += ' ';
+            }
+
+            std::vector<char> binary = this->buffer;
+            binary.resize((binary.size() + 3) / 4 * 4, 0);
+
+            const uint32_t header[] = {0x46546C67, 2, static_cast<uint32_t>(12 + 8 + json.size() + 8 + binary.size())};
+            const uint32_t jsonChunk[] = {static_cast<uint32_t>(json.size()), 0x4E4F534A};
+            const uint32_t binaryChunk[] = {static_cast<uint32_t>(binary.size()), 0x004E4942};
+
+            std::vector<char> out;
+            put(&out, header, sizeof(header));
+            put(&out, jsonChunk, sizeof(jsonChunk));
+            put(&out, json.data(), json.size());
+            put(&out, binaryChunk, sizeof(binaryChunk));
+            put(&out, binary.data(), binary.size());
+
+            return out;
+        }
+    };
+
+    // each triangle's normal has to face the way it's wound, mirrored or not
+    bool facesOutwards(const MeshData& mesh)
+    {
+        for (size_t i = 0; i < mesh.indices.size(); i += 3)
+        {
+            const float* a = &mesh.positions[mesh.indices[i] * 3];
+            const float* b = &mesh.positions[mesh.indices[i + 1] * 3];
+            const float* c = &mesh.positions[mesh.indices[i + 2] * 3];
+            const float* normal = &mesh.normals[mesh.indices[i] * 3];
+
+            const float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+            const float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+            const float facing[3] = {ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0]};
+
+            if (facing[0] * normal[0] + facing[1] * normal[1] + facing[2] * normal[2] <= 0.0f)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool importGltf(const std::filesystem::path& directory)
+    {
+        const Model model;
+        MeshData reference;
+
+        if (!writeText(directory / "scene.gltf", model.json("data:application/octet-stream;base64," + base64(model.buffer))) ||
+            !Loaders::importGltf((directory / "scene.gltf").string().c_str(), &reference))
+        {
+            std::cerr << "failed to import the .gltf" << '\n';
+            return false;
+        }
+
+        // the quad's 2 triangles and the strip's 2 with 6 flat shaded vertices, the lines skipped
+        if (reference.indices.size() != 12 || reference.vertexCount() != 10 || reference.normals.size() != 30 || reference.uvs.size() != 20)
+        {
+            std::cerr << "imported " << reference.indices.size() / 3 << " triangles and " << reference.vertexCount() << " vertices" << '\n';
+            return false;
+        }
+
+        if (!facesOutwards(reference))
+        {
+            std::cerr << "imported normals face the wrong way" << '\n';
+            return false;
+        }
+
+        // the same scene as a separate (escaped) .bin and as a .glb, and with 8 and 32 bit indices
+        const std::pair<std::string, std::string> variants[] = {
+            {"external.gltf", model.json("scene%20data.bin")},
+            {"bytes.gltf", model.json("scene%20data.bin", 5)},
+            {"words.gltf", model.json("scene%20data.bin", 6)}
+        };
+
+        if (!Loaders::writefile(model.buffer, (directory / "scene data.bin").string().c_str()) ||
+            !Loaders::writefile(model.glb(), (directory / "model.glb").string().c_str()))
+        {
+            std::cerr << "failed to write the model" << '\n';
+            return false;
+        }
+
+        for (const auto& [name, json] : variants)
+        {
+            writeText(directory / name, json);
+        }
+
+        for (const char* name : {"external.gltf", "bytes.gltf", "words.gltf", "model.glb"})
+        {
+            MeshData mesh;
+
+            if (!Loaders::importGltf((directory / name).string().c_str(), &mesh) ||
+                mesh.positions != reference.positions || mesh.normals != reference.normals || mesh.indices != reference.indices)
+            {
+                std::cerr << name << " imported different" << '\n';
+                return false;
+            }
+        }
+
+        // a triangle out of an accessor without a buffer view, with the given mode, component type
+        // and nodes, scene 0 is node 0 unless they say otherwise
+        const auto zeros = [](const std::string& mode, const std::string& componentType, const std::string& nodes)
+        {
+            return
+                R"({"asset":{"version":"2.0"},"nodes":)" + nodes + R"(,"scenes":[{"nodes":[0]}],)"
+                R"("meshes":[{"primitives":[{"attributes":{"POSITION":0},"mode":)" + mode + "}]}],"
+                R"("accessors":[{"componentType":)" + componentType + R"(,"count":3,"type":"VEC3"}]})";
+        };
+
+        MeshData triangle;
+        writeText(directory / "zeros.gltf", zeros("4", "5126", R"([{"mesh":0}])"));
+
+        if (!Loaders::importGltf((directory / "zeros.gltf").string().c_str(), &triangle) || triangle.vertexCount() != 3)
+        {
+            std::cerr << "failed to import a triangle without a buffer view" << '\n';
+            return false;
+        }
+
+        // 30 nodes each listing the next one twice, 2^30 triangles if nodes could be reached twice
+        std::string doubling = "[";
+
+        for (uint32_t i = 0; i < 30; i++)
+        {
+            doubling += R"({"children":[)" + std::to_string(i + 1) + "," + std::to_string(i + 1) + "]},";
+        }
+
+        doubling += R"({"mesh":0}])";
+
+        // missing extensions, old versions, nesting that would blow the stack, node cycles, nodes
+        // reached twice and numbers that aren't whole
+        const std::string rejected[] = {
+            R"({"asset":{"version":"2.0"},"extensionsRequired":["KHR_draco_mesh_compression"]})",
+            R"({"asset":{"version":"1.0"}})",
+            std::string(100000, '['),
+            R"({"asset":{"version":"2.0"},"nodes":[{"children":[1]},{"children":[0]}],"scenes":[{"nodes":[0]}]})",
+            R"({"asset":{"version":"2.0"},"buffers":[{"byteLength":3,"uri":"data:,QUJD"}]})",
+            zeros("4", "5126", doubling),
+            zeros("4", "5126", R"([{"children":[1,1]},{"mesh":0}])"),
+            zeros("4", "5126", R"([{"children":[2]},{"children":[2]},{"mesh":0}],"scene":1,"scenes":[{},{"nodes":[0,1]}])"),
+            zeros("4", "5126", R"([{"mesh":0}],"scene":1,"scenes":[{},{"nodes":[0,0]}])"),
+            zeros("4", "1e30", R"([{"mesh":0}])"),
+            zeros("4", "-1", R"([{"mesh":0}])"),
+            zeros("4", "5126.5", R"([{"mesh":0}])"),
+            zeros("1e30", "5126", R"([{"mesh":0}])"),
+            zeros("-1", "5126", R"([{"mesh":0}])"),
+            zeros("4.5", "5126", R"([{"mesh":0}])"),
+            zeros(R"("4")", "5126", R"([{"mesh":0}])")
+        };
+
+        for (const auto& json : rejected)
+        {
+            MeshData mesh;
+            writeText(directory / "rejected.gltf", json);
+
+            if (Loaders::importGltf((directory / "rejected.gltf").string().c_str(), &mesh))
+            {
+                std::cerr << "imported a file it should have rejected: " << json.substr(0, 80) << '\n';
+                return false;
+            }
+        }
+
+        // whatever corrupted copies do, nothing gets read out of bounds and what imports cooks
+        std::vector<char> glb = model.glb();
+        uint32_t seed = 5;
+
+        for (uint32_t i = 0; i < 2000; i++)
+        {
+            std::vector<char> corrupt = glb;
+
+            for (uint32_t j = random(&seed) % 8; j < 8; j++)
+            {
+                corrupt[random(&seed) % corrupt.size()] = static_cast<char>(random(&seed));
+            }
+
+            if (i % 4 == 0)
+            {
+                corrupt.resize(random(&seed) % corrupt.size());
+            }
+
+            Loaders::writefile(corrupt, (directory / "corrupt.glb").string().c_str());
+
+            MeshData mesh;
+
+            if (!Loaders::importGltf((directory / "corrupt.glb").string().c_str(), &mesh) || mesh.indices.empty())
+            {
+                continue;
+            }
+
+            Loaders::optimizeMesh(&mesh);
+
+            std::vector<char> cooked;
+            MeshInfo info;
+
+            if (Loaders::writeMesh(mesh, &cooked) && !Loaders::parseMesh(cooked.data(), cooked.size(), &info))
+            {
+                std::cerr << "cooked a corrupted import that doesn't parse" << '\n';
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // triangles by their vertices' attributes, starting from the smallest vertex, degenerate ones left out
+    std::multiset<std::vector<float>> triangles(const MeshData& mesh)
+    {
+        std::multiset<std::vector<float>> out;
+
+        const auto vertex = [&mesh](const uint32_t index)
+        {
+            std::vector<float> attributes(mesh.positions.begin() + index * 3, mesh.positions.begin() + index * 3 + 3);
+            attributes.insert(attributes.end(), mesh.normals.begin() + index * 3, mesh.normals.begin() + index * 3 + 3);
+            attributes.insert(attributes.end(), mesh.uvs.begin() + index * 2, mesh.uvs.begin() + index * 2 + 2);
+            return attributes;
+        };
+
+        for (size_t i = 0; i < mesh.indices.size(); i += 3)
+        {
+            std::vector<float> corners[3] = {vertex(mesh.indices[i]), vertex(mesh.indices[i + 1]), vertex(mesh.indices[i + 2])};
+
+            if (corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2])
+            {
+                continue;
+            }
+
+            const size_t first = std::min_element(corners, corners + 3) - corners;
+            std::vector<float> triangle;
+
+            for (size_t j = 0; j < 3; j++)
+            {
+                triangle.insert(triangle.end(), corners[(first + j) % 3].begin(), corners[(first + j) % 3].end());
+            }
+
+            out.insert(triangle);
+        }
+
+        return out;
+    }
+
+    // random meshes (with plenty of duplicates and degenerates) through optimizeMesh(), writeMesh()
+    // and parseMesh(), the smaller ones with 16 bit indices and the big ones with 32
+    bool cookMeshes()
+    {
+        uint32_t seed = 1;
+
+        for (uint32_t trial = 0; trial < 12; trial++)
+        {
+            MeshData mesh;
+            const uint32_t nVertices = 3 + random(&seed) % (trial < 10 ? 300 : 80000);
+            const uint32_t nTriangles = 1 + random(&seed) % (nVertices * 3);
+
+            for (uint32_t i = 0; i < nVertices; i++)
+            {
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    mesh.positions.push_back(static_cast<float>(random(&seed) % 50) - 20.0f);
+                    mesh.normals.push_back(static_cast<float>(random(&seed) % 3) - 1.0f);
+                }
+
+                mesh.uvs.push_back(static_cast<float>(random(&seed) % 5) * 0.25f);
+                mesh.uvs.push_back(std::ldexp(1.0f, -static_cast<int>(random(&seed) % 20)));
+            }
+
+            for (uint32_t i = 0; i < nTriangles * 3; i++)
+            {
+                mesh.indices.push_back(random(&seed) % nVertices);
+            }
+
+            const auto before = triangles(mesh);
+            Loaders::optimizeMesh(&mesh);
+
+            if (triangles(mesh) != before || before.size() * 3 != mesh.indices.size())
+            {
+                std::cerr << "optimizeMesh() changed the triangles of mesh " << trial << '\n';
+                return false;
+            }
+
+            // vertices in the order they're first used
+            uint32_t next = 0;
+
+            for (const uint32_t index : mesh.indices)
+            {
+                if (index > next)
+                {
+                    std::cerr << "vertex " << index << " used before " << next << '\n';
+                    return false;
+                }
+
+                next += index == next;
+            }
+
+            std::vector<char> cooked;
+            MeshInfo info;
+
+            if (!Loaders::writeMesh(mesh, &cooked) || !Loaders::parseMesh(cooked.data(), cooked.size(), &info))
+            {
+                std::cerr << "mesh " << trial << " didn't cook" << '\n';
+                return false;
+            }
+
+            if (info.vertexCount != mesh.vertexCount() || info.indexCount != mesh.indices.size() ||
+                info.indexSize != (mesh.vertexCount() <= 65536 ? 2u : 4u) || info.vertexStride != 16 || info.attributeCount != 3 ||
+                (info.vertices - cooked.data()) % 64 != 0 || (info.indices - cooked.data()) % 64 != 0)
+            {
+                std::cerr << "mesh " << trial << " cooked with the wrong layout" << '\n';
+                return false;
+            }
+
+            for (uint32_t i = 0; i < info.vertexCount; i++)
+            {
+                const char* vertex = info.vertices + i * info.vertexStride;
+
+                uint16_t position[4];
+                int8_t normal[4];
+                uint16_t uv[2];
+
+                memcpy(position, vertex, 8);
+                memcpy(normal, vertex + 8, 4);
+                memcpy(uv, vertex + 12, 4);
+
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    const float extent = info.boundsMax[j] - info.boundsMin[j];
+                    const float decoded = info.boundsMin[j] + position[j] / 65535.0f * extent;
+
+                    if (std::fabs(decoded - mesh.positions[i * 3 + j]) > extent / 65535.0f * 0.51f + 1e-5f ||
+                        normal[j] != static_cast<int>(mesh.normals[i * 3 + j] * 127.0f))
+                    {
+                        std::cerr << "vertex " << i << " of mesh " << trial << " quantized wrong" << '\n';
+                        return false;
+                    }
+                }
+
+                // the uvs are all exact in half precision
+                if (position[3] != 65535 || halfToFloat(uv[0]) != mesh.uvs[i * 2] || halfToFloat(uv[1]) != mesh.uvs[i * 2 + 1])
+                {
+                    std::cerr << "vertex " << i << " of mesh " << trial << " has the wrong w or uvs" << '\n';
+                    return false;
+                }
+            }
+
+            for (uint32_t i = 0; i < info.indexCount; i++)
+            {
+                uint32_t index = 0;
+                memcpy(&index, info.indices + i * info.indexSize, info.indexSize);
+
+                if (index != mesh.indices[i])
+                {
+                    std::cerr << "index " << i << " of mesh " << trial << " cooked wrong" << '\n';
+                    return false;
+                }
+            }
+
+            // truncated and corrupted headers either fail or point inside what's there
+            for (uint32_t i = 0; i < 500; i++)
+            {
+                std::vector<char> corrupt = cooked;
+
+                if (i % 2 == 0)
+                {
+                    corrupt.resize(random(&seed) % corrupt.size());
+                } else
+                {
+                    corrupt[random(&seed) % std::min<size_t>(corrupt.size(), 128)] = static_cast<char>(random(&seed));
+                }
+
+                MeshInfo damaged;
+
+                if (Loaders::parseMesh(corrupt.data(), corrupt.size(), &damaged) &&
+                    (damaged.vertices + static_cast<size_t>(damaged.vertexCount) * damaged.vertexStride > corrupt.data() + corrupt.size() ||
+                    damaged.indices + static_cast<size_t>(damaged.indexCount) * damaged.indexSize > corrupt.data() + corrupt.size()))
+                {
+                    std::cerr << "parsed a corrupted mesh pointing outside its data" << '\n';
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+}
+
+// glTF scenes imported every way they can be stored, then random meshes cooked and parsed back
+int main()
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "engine_test_mesh";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    const bool passed = importGltf(directory) && cookMeshes();
+    std::filesystem::remove_all(directory);
+
+    if (!passed)
+    {
+        return 1;
+    }
+
+    std::cout << "mesh import and cooking passed" << '\n';
+    return 0;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+
+// The one small LCG the tests (and benches) draw from, so every run sees the same numbers and a
+// failure can be reproduced from its seed.
+namespace Test
+{
+    // 24 random bits
+    inline uint32_t random(uint32_t* seed)
+    {
+        *seed = *seed * 1664525u + 1013904223u;
+        return *seed >> 8;
+    }
+
+    // from min up to max
+    inline float random(uint32_t* seed, const float min, const float max)
+    {
+        return min + (max - min) * static_cast<float>(random(seed)) / static_cast<float>(1 << 24);
+    }
+}
@@ -26,6 +26,12 @@ int main()
 using Engine::Game;
 using Engine::Renderer;
 
+void onResize(GLFWwindow* win, int width, int height)
+{
+    const auto renderer = static_cast<Renderer*>(glfwGetWindowUserPointer(win));
+    renderer->resize(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+}
+
 int terminate(const Renderer* renderer, int code)
 {
     delete renderer;
@@ -43,7 +49,7 @@ int main()
     }
 
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
     uint32_t nExtensions;
     const char* const* extensions = glfwGetRequiredInstanceExtensions(&nExtensions);
@@ -51,6 +57,7 @@ int main()
     constexpr int version[] = {0, 1, 0};
     const auto game = new Game("Test", version);
     const auto renderer = new Renderer(game);
+    renderer->pipelineCachePath = "pipelines.cache";
 
     const VkResult instResult = renderer->createInstance(nExtensions, extensions);
 
@@ -105,14 +112,18 @@ int main()
         return terminate(renderer, 1);
     }
 
+    // the library owns the modules, and reloads them when the .spv files are recompiled
+    constexpr auto shaderDir = "../src/test/shaders/compiled";
+    Engine::ShaderLibrary* shaders = renderer->shaders;
+
     VkShaderModule vertShader;
     VkShaderModule fragShader;
 
     std::cout << "vertex shader result: " <<
-        Loaders::loadShaderModule(renderer->vkDev, "../src/test/shaders/compiled/triangle.vert.spv", &vertShader) << '\n';
+        shaders->load(std::string(shaderDir) + "/triangle.vert.spv", &vertShader) << '\n';
 
     std::cout << "fragment shader result: "  <<
-        Loaders::loadShaderModule(renderer->vkDev, "../src/test/shaders/compiled/triangle.frag.spv", &fragShader) << '\n';
+        shaders->load(std::string(shaderDir) + "/triangle.frag.spv", &fragShader) << '\n';
 
     VkPipelineShaderStageCreateInfo vertInfo{};
     vertInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -137,12 +148,49 @@ int main()
         return terminate(renderer, 1);
     }
 
+    Engine::PipelineDesc trianglePipelineDesc;
+    trianglePipelineDesc.colorFormat = renderer->targetFormat();
+
+    Engine::ShaderLibrary::Pipeline trianglePipeline;
+    const VkResult reloadResult = shaders->addPipeline(
+        trianglePipelineDesc,
+        {std::string(shaderDir) + "/triangle.vert.spv", std::string(shaderDir) + "/triangle.frag.spv"},
+        &trianglePipeline);
+
+    if (reloadResult == VK_SUCCESS && shaders->watch(shaderDir) == VK_SUCCESS)
+    {
+        std::cout << "watching " << shaderDir << " for shader changes" << '\n';
+    }
+
+    glfwSetWindowUserPointer(win, renderer);
+    glfwSetFramebufferSizeCallback(win, onResize);
+
+    // the shaders make up the vertices themselves
+    Engine::Mesh triangle{};
+    triangle.vertexCount = 3;
+
     while (!glfwWindowShouldClose(win))
     {
         glfwPollEvents();
+        renderer->draw(&triangle, reloadResult == VK_SUCCESS ? shaders->pipeline(trianglePipeline) : VK_NULL_HANDLE);
         renderer->render();
     }
 
+#ifdef ENABLE_PROFILING
+    for (const char* zone : {"frame", "acquire", "record", "submit", "present"})
+    {
+        const Engine::ProfileStats stats = Engine::Profiler::stats(zone);
+
+        std::cout << zone << ": " << stats.p50 << "ms p50, " << stats.p99 << "ms p99 over "
+            << stats.frames << " frames" << '\n';
+    }
+
+    if (Engine::Profiler::exportTrace("cpu_trace.json"))
+    {
+        std::cout << "CPU trace written to cpu_trace.json" << '\n';
+    }
+#endif
+
     return terminate(renderer, 0);
 }
 
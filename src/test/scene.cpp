@@ -0,0 +1,250 @@
+#include "engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "random.h"
+
+using Engine::JobSystem;
+using Engine::Mat4;
+using Engine::Node;
+using Engine::Quat;
+using Engine::Scene;
+using Engine::Vec3;
+using Test::random;
+
+namespace
+{
+    // the world matrix the slow way, up the parent chain
+    Mat4 reference(const Scene& scene, const Node node)
+    {
+        Vec3 translation;
+        Quat rotation;
+        Vec3 scale;
+        scene.getLocal(node, &translation, &rotation, &scale);
+
+        const Mat4 local = Mat4::trs(translation, rotation, scale);
+        const Node parent = scene.getParent(node);
+
+        return parent ? reference(scene, parent) * local : local;
+    }
+
+    bool matchesReference(const Scene& scene, const Node node, const float tolerance)
+    {
+        const Mat4* world = scene.getWorld(node);
+
+        if (world == nullptr)
+        {
+            return false;
+        }
+
+        const Mat4 expected = reference(scene, node);
+
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            if (std::fabs(world->m[i] - expected.m[i]) > tolerance * (1.0f + std::fabs(expected.m[i])))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // random creates, destroys, reparents and moves, with every world matrix compared to the
+    // parent chain after each update(), which goes through jobs half the time
+    bool randomized(JobSystem* jobs)
+    {
+        uint32_t seed = 7;
+
+        for (uint32_t round = 0; round < 10; round++)
+        {
+            Scene scene;
+            std::vector<Node> live;
+            std::vector<Node> dead;
+
+            for (uint32_t step = 0; step < 3000; step++)
+            {
+                const uint32_t op = random(&seed) % 100;
+
+                if (op < 35 || live.empty())
+                {
+                    const Node parent = !live.empty() && random(&seed) % 4 != 0 ? live[random(&seed) % static_cast<uint32_t>(live.size())] : Node{};
+                    const Vec3 axis = {random(&seed, -1.0f, 1.0f), random(&seed, -1.0f, 1.0f), random(&seed, -1.0f, 1.0f) + 1.5f};
+                    const Node node = scene.create(
+                        parent,
+                        {random(&seed, -1.0f, 1.0f), random(&seed, -1.0f, 1.0f), random(&seed, -1.0f, 1.0f)},
+                        Quat::axisAngle(axis, random(&seed, -1.0f, 1.0f)),
+                        {1.0f + random(&seed, -1.0f, 1.0f) * 0.2f, 1.0f, 1.0f});
+
+                    if (!node)
+                    {
+                        std::cerr << "failed to create a node" << '\n';
+                        return false;
+                    }
+
+                    live.push_back(node);
+                } else if (op < 40)
+                {
+                    if (!scene.destroy(live[random(&seed) % static_cast<uint32_t>(live.size())]))
+                    {
+                        std::cerr << "failed to destroy a node" << '\n';
+                        return false;
+                    }
+
+                    // everything under it goes too
+                    std::vector<Node> kept;
+
+                    for (const Node node : live)
+                    {
+                        (scene.alive(node) ? kept : dead).push_back(node);
+                    }
+
+                    live = std::move(kept);
+                } else if (op < 48)
+                {
+                    const Node node = live[random(&seed) % static_cast<uint32_t>(live.size())];
+                    const Node parent = random(&seed) % 5 == 0 ? Node{} : live[random(&seed) % static_cast<uint32_t>(live.size())];
+
+                    bool cycle = false;
+
+                    for (Node ancestor = parent; ancestor; ancestor = scene.getParent(ancestor))
+                    {
+                        cycle |= ancestor == node;
+                    }
+
+                    const bool moved = scene.setParent(node, parent);
+
+                    if (moved == cycle || (moved && !(scene.getParent(node) == parent)))
+                    {
+                        std::cerr << "setParent() " << (cycle ? "made a cycle" : "refused a valid parent") << '\n';
+                        return false;
+                    }
+                } else if (op < 80)
+                {
+                    const Node node = live[random(&seed) % static_cast<uint32_t>(live.size())];
+
+                    switch (random(&seed) % 4)
+                    {
+                    case 0:
+                        scene.setTranslation(node, {random(&seed, -1.0f, 1.0f), random(&seed, -1.0f, 1.0f), random(&seed, -1.0f, 1.0f)});
+                        break;
+                    case 1:
+                        scene.setRotation(node, Quat::axisAngle({random(&seed, -1.0f, 1.0f), 1.5f, random(&seed, -1.0f, 1.0f)}, random(&seed, -1.0f, 1.0f)));
+                        break;
+                    case 2:
+                        scene.setScale(node, {1.0f + random(&seed, -1.0f, 1.0f) * 0.1f, 1.0f, 1.0f + random(&seed, -1.0f, 1.0f) * 0.1f});
+                        break;
+                    default:
+                        scene.setLocal(node, {random(&seed, -1.0f, 1.0f), random(&seed, -1.0f, 1.0f), random(&seed, -1.0f, 1.0f)}, {}, {1.0f, 1.0f, 1.0f});
+                        break;
+                    }
+                } else if (op < 84)
+                {
+                    // enough at once that update() scans for dirty rows instead of sorting them
+                    for (size_t i = 0; i < live.size() / 8 + 1; i++)
+                    {
+                        scene.setTranslation(live[random(&seed) % static_cast<uint32_t>(live.size())], {random(&seed, -1.0f, 1.0f), random(&seed, -1.0f, 1.0f), random(&seed, -1.0f, 1.0f)});
+                    }
+                }
+
+                if (op < 90 && step % 97 != 0)
+                {
+                    continue;
+                }
+
+                scene.update(random(&seed) % 2 != 0 ? jobs : nullptr);
+
+                if (scene.size() != live.size())
+                {
+                    std::cerr << "scene has " << scene.size() << " nodes instead of " << live.size() << '\n';
+                    return false;
+                }
+
+                for (const Node node : live)
+                {
+                    if (!matchesReference(scene, node, 1e-3f))
+                    {
+                        std::cerr << "world matrix differs in round " << round << " step " << step << '\n';
+                        return false;
+                    }
+                }
+
+                for (const Node node : dead)
+                {
+                    if (scene.alive(node) || scene.getWorld(node) != nullptr)
+                    {
+                        std::cerr << "destroyed node is still alive" << '\n';
+                        return false;
+                    }
+                }
+
+                // nothing moved since
+                if (scene.update(jobs) != 0)
+                {
+                    std::cerr << "update() recomputed nodes that didn't move" << '\n';
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // deep and wide enough that update() splits subtrees between jobs
+    bool large(JobSystem* jobs)
+    {
+        uint32_t seed = 11;
+        Scene scene;
+        std::vector<Node> nodes;
+
+        for (uint32_t i = 0; i < 100000; i++)
+        {
+            const Node parent = i == 0 ? Node{} : nodes[i > 10 ? i - 1 - (random(&seed) % std::min(i - 1, 50u)) : 0];
+            nodes.push_back(scene.create(parent, {random(&seed, -1.0f, 1.0f), random(&seed, -1.0f, 1.0f), random(&seed, -1.0f, 1.0f)}, {}, {1.0f, 1.0f, 1.0f}));
+        }
+
+        scene.update(jobs);
+
+        for (uint32_t frame = 0; frame < 5; frame++)
+        {
+            for (uint32_t i = 0; i < 3000; i++)
+            {
+                scene.setRotation(nodes[random(&seed) % static_cast<uint32_t>(nodes.size())], Quat::axisAngle({0.0f, 1.0f, 0.0f}, random(&seed, -1.0f, 1.0f)));
+            }
+
+            // and once with everything under the root moving
+            if (frame % 2 == 0)
+            {
+                scene.setTranslation(nodes[0], {random(&seed, -1.0f, 1.0f), 0.0f, 0.0f});
+            }
+
+            scene.update(jobs);
+
+            for (uint32_t i = 0; i < 2000; i++)
+            {
+                if (!matchesReference(scene, nodes[random(&seed) % static_cast<uint32_t>(nodes.size())], 1e-2f))
+                {
+                    std::cerr << "world matrix differs in frame " << frame << " of the large scene" << '\n';
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+}
+
+int main()
+{
+    JobSystem jobs(4);
+
+    if (!randomized(&jobs) || !large(&jobs))
+    {
+        return 1;
+    }
+
+    std::cout << "scene passed" << '\n';
+    return 0;
+}
@@ -0,0 +1,436 @@
+#include "loaders/loaders.h"
+
+#include <iostream>
+
+#ifndef HAS_VULKAN
+
+int main()
+{
+    std::cerr << "couldn't find Vulkan" << '\n';
+    return 1;
+}
+
+#else
+
+#include <cstring>
+
+#include "engine.h"
+#include "random.h"
+
+using Engine::LayoutCache;
+using Engine::VertexLayout;
+using Loaders::ShaderReflection;
+using Test::random;
+
+namespace
+{
+    constexpr size_t HEADER_WORDS = 5;
+
+    // just enough of an assembler to write the module below by hand
+    class Assembler
+    {
+    public:
+        std::vector<uint32_t> words = {0x07230203, 0x00010000, 0, 0, 0};
+
+        void op(const uint32_t opcode, const std::vector<uint32_t>& operands)
+        {
+            this->words.push_back(static_cast<uint32_t>(operands.size() + 1) << 16 | opcode);
+            this->words.insert(this->words.end(), operands.begin(), operands.end());
+        }
+
+        // nul terminated and padded to whole words, after the operands before it
+        void op(const uint32_t opcode, std::vector<uint32_t> operands, const char* string, const std::vector<uint32_t>& after = {})
+        {
+            std::vector<uint32_t> packed((strlen(string) + 4) / 4, 0);
+            memcpy(packed.data(), string, strlen(string));
+
+            operands.insert(operands.end(), packed.begin(), packed.end());
+            operands.insert(operands.end(), after.begin(), after.end());
+            this->op(opcode, operands);
+        }
+    };
+
+    enum : uint32_t
+    {
+        NAME = 5,
+        MEMBER_NAME = 6,
+        ENTRY_POINT = 15,
+        TYPE_BOOL = 20,
+        TYPE_INT = 21,
+        TYPE_FLOAT = 22,
+        TYPE_VECTOR = 23,
+        TYPE_MATRIX = 24,
+        TYPE_IMAGE = 25,
+        TYPE_SAMPLER = 26,
+        TYPE_SAMPLED_IMAGE = 27,
+        TYPE_ARRAY = 28,
+        TYPE_RUNTIME_ARRAY = 29,
+        TYPE_STRUCT = 30,
+        TYPE_POINTER = 32,
+        CONSTANT = 43,
+        SPEC_CONSTANT_TRUE = 48,
+        SPEC_CONSTANT = 50,
+        VARIABLE = 59,
+        DECORATE = 71,
+        MEMBER_DECORATE = 72
+    };
+
+    // a vertex shader with one of every kind of binding, arrays of them, push constants that
+    // don't start at 0, vertex inputs out of order (a matrix among them) and spec constants
+    std::vector<uint32_t> module()
+    {
+        Assembler a;
+
+        a.op(ENTRY_POINT, {0, 1}, "main", {33, 35, 39, 40});
+
+        a.op(NAME, {9}, "camera");
+        a.op(NAME, {14}, "textures");
+        a.op(NAME, {18}, "images");
+        a.op(NAME, {21}, "nearest");
+        a.op(NAME, {24}, "texels");
+        a.op(NAME, {28}, "particles");
+        a.op(NAME, {33}, "position");
+        a.op(NAME, {35}, "model");
+        a.op(NAME, {39}, "ids");
+        a.op(NAME, {41}, "count");
+        a.op(MEMBER_NAME, {7, 0}, "viewProjection");
+
+        // set, binding
+        const uint32_t bindings[][3] = {{9, 0, 0}, {14, 1, 2}, {18, 1, 3}, {21, 2, 0}, {24, 2, 1}, {28, 0, 1}};
+
+        for (const auto& binding : bindings)
+        {
+            a.op(DECORATE, {binding[0], 34, binding[1]});
+            a.op(DECORATE, {binding[0], 33, binding[2]});
+        }
+
+        a.op(DECORATE, {33, 30, 6});
+        a.op(DECORATE, {35, 30, 1});
+        a.op(DECORATE, {39, 30, 0});
+        a.op(DECORATE, {40, 11, 42});
+        a.op(DECORATE, {26, 6, 16});
+        a.op(DECORATE, {41, 1, 3});
+        a.op(DECORATE, {42, 1, 5});
+        a.op(DECORATE, {45, 1, 7});
+
+        a.op(MEMBER_DECORATE, {7, 0, 35, 0});
+        a.op(MEMBER_DECORATE, {7, 0, 7, 16});
+        a.op(MEMBER_DECORATE, {7, 1, 35, 64});
+        a.op(MEMBER_DECORATE, {25, 0, 35, 0});
+        a.op(MEMBER_DECORATE, {29, 0, 35, 16});
+        a.op(MEMBER_DECORATE, {29, 1, 35, 32});
+        a.op(MEMBER_DECORATE, {29, 1, 7, 16});
+
+        a.op(TYPE_FLOAT, {2, 32});
+        a.op(TYPE_VECTOR, {3, 2, 4});
+        a.op(TYPE_MATRIX, {4, 3, 4});
+        a.op(TYPE_INT, {5, 32, 0});
+        a.op(CONSTANT, {5, 6, 4});
+
+        // uniform buffer
+        a.op(TYPE_STRUCT, {7, 4, 3});
+        a.op(TYPE_POINTER, {8, 2, 7});
+        a.op(VARIABLE, {8, 9, 2});
+
+        // 4 combined image samplers
+        a.op(TYPE_IMAGE, {10, 2, 1, 0, 0, 0, 1, 0});
+        a.op(TYPE_SAMPLED_IMAGE, {11, 10});
+        a.op(TYPE_ARRAY, {12, 11, 6});
+        a.op(TYPE_POINTER, {13, 0, 12});
+        a.op(VARIABLE, {13, 14, 0});
+
+        // a runtime sized array of storage images
+        a.op(TYPE_IMAGE, {15, 2, 1, 0, 0, 0, 2, 1});
+        a.op(TYPE_RUNTIME_ARRAY, {16, 15});
+        a.op(TYPE_POINTER, {17, 0, 16});
+        a.op(VARIABLE, {17, 18, 0});
+
+        a.op(TYPE_SAMPLER, {19});
+        a.op(TYPE_POINTER, {20, 0, 19});
+        a.op(VARIABLE, {20, 21, 0});
+
+        // uniform texel buffer
+        a.op(TYPE_IMAGE, {22, 2, 5, 0, 0, 0, 1, 0});
+        a.op(TYPE_POINTER, {23, 0, 22});
+        a.op(VARIABLE, {23, 24, 0});
+
+        // storage buffer
+        a.op(TYPE_RUNTIME_ARRAY, {26, 3});
+        a.op(TYPE_STRUCT, {25, 26});
+        a.op(TYPE_POINTER, {27, 12, 25});
+        a.op(VARIABLE, {27, 28, 12});
+
+        // push constants, a vec4 at 16 and a mat4 at 32
+        a.op(TYPE_STRUCT, {29, 3, 4});
+        a.op(TYPE_POINTER, {30, 9, 29});
+        a.op(VARIABLE, {30, 31, 9});
+
+        // inputs
+        a.op(TYPE_POINTER, {32, 1, 3});
+        a.op(VARIABLE, {32, 33, 1});
+        a.op(TYPE_POINTER, {34, 1, 4});
+        a.op(VARIABLE, {34, 35, 1});
+        a.op(TYPE_INT, {36, 32, 1});
+        a.op(TYPE_VECTOR, {37, 36, 2});
+        a.op(TYPE_POINTER, {38, 1, 37});
+        a.op(VARIABLE, {38, 39, 1});
+        a.op(VARIABLE, {38, 40, 1});
+
+        // spec constants, 32 bit, bool and 64 bit
+        a.op(SPEC_CONSTANT, {5, 41, 77});
+        a.op(TYPE_BOOL, {43});
+        a.op(SPEC_CONSTANT_TRUE, {43, 42});
+        a.op(TYPE_INT, {44, 64, 0});
+        a.op(SPEC_CONSTANT, {44, 45, 0x89ABCDEF, 0x01234567});
+
+        a.words[3] = 46;
+        return a.words;
+    }
+
+    // a vertex shader with just a vec2 of floats the given size at location 0
+    std::vector<uint32_t> vec2Input(const uint32_t bits)
+    {
+        Assembler a;
+
+        a.op(ENTRY_POINT, {0, 1}, "main", {5});
+        a.op(DECORATE, {5, 30, 0});
+        a.op(TYPE_FLOAT, {2, bits});
+        a.op(TYPE_VECTOR, {3, 2, 2});
+        a.op(TYPE_POINTER, {4, 1, 3});
+        a.op(VARIABLE, {4, 5, 1});
+
+        a.words[3] = 6;
+        return a.words;
+    }
+
+    bool binding(const ShaderReflection& reflection, const char* name, const uint32_t set, const uint32_t index, const VkDescriptorType type, const uint32_t count)
+    {
+        for (const auto& found : reflection.bindings)
+        {
+            if (found.name == name)
+            {
+                if (found.set == set && found.binding == index && found.type == type && found.count == count)
+                {
+                    return true;
+                }
+
+                std::cerr << name << " reflected as set " << found.set << " binding " << found.binding << " type " << found.type << " count " << found.count << '\n';
+                return false;
+            }
+        }
+
+        std::cerr << name << " wasn't reflected" << '\n';
+        return false;
+    }
+
+    bool everything()
+    {
+        const std::vector<uint32_t> code = module();
+        ShaderReflection reflection;
+
+        if (!Loaders::reflectShader(code.data(), code.size(), &reflection))
+        {
+            std::cerr << "failed to reflect the assembled module" << '\n';
+            return false;
+        }
+
+        if (reflection.stage != VK_SHADER_STAGE_VERTEX_BIT || reflection.entryPoint != "main" || reflection.bindings.size() != 6)
+        {
+            std::cerr << "reflected the wrong stage or entry point, or " << reflection.bindings.size() << " bindings" << '\n';
+            return false;
+        }
+
+        if (!binding(reflection, "camera", 0, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1) ||
+            !binding(reflection, "textures", 1, 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4) ||
+            !binding(reflection, "images", 1, 3, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 0) ||
+            !binding(reflection, "nearest", 2, 0, VK_DESCRIPTOR_TYPE_SAMPLER, 1) ||
+            !binding(reflection, "texels", 2, 1, VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1) ||
+            !binding(reflection, "particles", 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1))
+        {
+            return false;
+        }
+
+        if (reflection.pushConstants.stageFlags != VK_SHADER_STAGE_VERTEX_BIT || reflection.pushConstants.offset != 16 || reflection.pushConstants.size != 80)
+        {
+            std::cerr << "push constants reflected as " << reflection.pushConstants.offset << '+' << reflection.pushConstants.size << '\n';
+            return false;
+        }
+
+        // sorted by location, one per matrix column, and no built-ins
+        const std::pair<uint32_t, VkFormat> inputs[] = {
+            {0, VK_FORMAT_R32G32_SINT},
+            {1, VK_FORMAT_R32G32B32A32_SFLOAT},
+            {2, VK_FORMAT_R32G32B32A32_SFLOAT},
+            {3, VK_FORMAT_R32G32B32A32_SFLOAT},
+            {4, VK_FORMAT_R32G32B32A32_SFLOAT},
+            {6, VK_FORMAT_R32G32B32A32_SFLOAT},
+        };
+
+        bool inputsMatch = reflection.inputs.size() == std::size(inputs);
+
+        for (size_t i = 0; inputsMatch && i < std::size(inputs); i++)
+        {
+            inputsMatch = reflection.inputs[i].location == inputs[i].first && reflection.inputs[i].format == inputs[i].second;
+        }
+
+        if (!inputsMatch || reflection.inputs[0].name != "ids" || reflection.inputs[5].name != "position")
+        {
+            std::cerr << "reflected " << reflection.inputs.size() << " vertex inputs wrong" << '\n';
+            return false;
+        }
+
+        const auto& constants = reflection.specializationConstants;
+
+        if (constants.size() != 3 ||
+            constants[0].id != 3 || constants[0].size != 4 || constants[0].defaultValue != 77 || constants[0].name != "count" ||
+            constants[1].id != 5 || constants[1].size != 4 || constants[1].defaultValue != 1 ||
+            constants[2].id != 7 || constants[2].size != 8 || constants[2].defaultValue != 0x0123456789ABCDEF)
+        {
+            std::cerr << "reflected " << constants.size() << " specialization constants wrong" << '\n';
+            return false;
+        }
+
+        return true;
+    }
+
+    // interleaved in location order, and inputs without a format fail instead of making an
+    // attribute of size 0
+    bool vertexLayouts()
+    {
+        const std::vector<uint32_t> code = module();
+        ShaderReflection reflection;
+        VertexLayout layout;
+
+        if (!Loaders::reflectShader(code.data(), code.size(), &reflection) || LayoutCache::vertexLayout(reflection, &layout) != VK_SUCCESS)
+        {
+            std::cerr << "failed to make a vertex layout" << '\n';
+            return false;
+        }
+
+        const uint32_t offsets[] = {0, 8, 24, 40, 56, 72};
+        bool offsetsMatch = layout.attributes.size() == std::size(offsets);
+
+        for (size_t i = 0; offsetsMatch && i < std::size(offsets); i++)
+        {
+            offsetsMatch = layout.attributes[i].offset == offsets[i] && layout.attributes[i].binding == 0;
+        }
+
+        if (!offsetsMatch || layout.bindings.size() != 1 || layout.bindings[0].stride != 88)
+        {
+            std::cerr << "vertex layout came out wrong" << '\n';
+            return false;
+        }
+
+        for (const uint32_t bits : {16u, 32u, 64u})
+        {
+            const std::vector<uint32_t> narrow = vec2Input(bits);
+            VertexLayout untouched;
+
+            if (!Loaders::reflectShader(narrow.data(), narrow.size(), &reflection) || reflection.inputs.size() != 1)
+            {
+                std::cerr << "failed to reflect a vec2 of " << bits << " bit floats" << '\n';
+                return false;
+            }
+
+            const VkResult result = LayoutCache::vertexLayout(reflection, &untouched);
+            const bool expected = bits == 32 ?
+                result == VK_SUCCESS && reflection.inputs[0].format == VK_FORMAT_R32G32_SFLOAT && untouched.bindings[0].stride == 8 :
+                result == VK_ERROR_FORMAT_NOT_SUPPORTED && reflection.inputs[0].format == VK_FORMAT_UNDEFINED && untouched.attributes.empty();
+
+            if (!expected)
+            {
+                std::cerr << "vertex layout for a vec2 of " << bits << " bit floats returned " << result << '\n';
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // the compiled test shaders, nothing bound and gl_VertexIndex isn't an input
+    bool compiled()
+    {
+        const std::pair<const char*, VkShaderStageFlagBits> shaders[] = {
+            {"../src/test/shaders/compiled/triangle.vert.spv", VK_SHADER_STAGE_VERTEX_BIT},
+            {"../src/test/shaders/compiled/triangle.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT},
+        };
+
+        for (const auto& [filename, stage] : shaders)
+        {
+            std::vector<char> buffer;
+
+            if (!Loaders::readfile(&buffer, filename))
+            {
+                std::cerr << "failed to read " << filename << '\n';
+                return false;
+            }
+
+            std::vector<uint32_t> code(buffer.size() / 4);
+            memcpy(code.data(), buffer.data(), code.size() * 4);
+
+            ShaderReflection reflection;
+
+            if (!Loaders::reflectShader(code.data(), code.size(), &reflection) || reflection.stage != stage ||
+                reflection.entryPoint != "main" || !reflection.bindings.empty() || !reflection.inputs.empty() ||
+                reflection.pushConstants.size != 0)
+            {
+                std::cerr << filename << " reflected wrong" << '\n';
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // flipped bits, truncations and garbage, whatever's accepted is read without going out of
+    // bounds (which is what the sanitizer builds are for)
+    bool corrupted()
+    {
+        const std::vector<uint32_t> original = module();
+        ShaderReflection reflection;
+        uint32_t seed = 9;
+
+        const uint32_t magic[] = {0x07230203};
+
+        if (Loaders::reflectShader(magic, 1, &reflection) || Loaders::reflectShader(original.data() + 1, original.size() - 1, &reflection))
+        {
+            std::cerr << "reflected something that isn't SPIR-V" << '\n';
+            return false;
+        }
+
+        for (uint32_t i = 0; i < 20000; i++)
+        {
+            std::vector<uint32_t> code = original;
+
+            for (uint32_t j = 0; j < 1 + i % 4; j++)
+            {
+                const size_t at = HEADER_WORDS + random(&seed) % (code.size() - HEADER_WORDS);
+
+                // small values hit ids and counts, the rest anything
+                code[at] = i % 2 == 0 ? code[at] ^ 1u << random(&seed) % 32 : random(&seed) % 64;
+            }
+
+            if (i % 8 == 0)
+            {
+                code.resize(HEADER_WORDS + i % (code.size() - HEADER_WORDS));
+            }
+
+            Loaders::reflectShader(code.data(), code.size(), &reflection);
+        }
+
+        return true;
+    }
+}
+
+int main()
+{
+    if (!everything() || !vertexLayouts() || !compiled() || !corrupted())
+    {
+        return 1;
+    }
+
+    std::cout << "spirv reflection passed" << '\n';
+    return 0;
+}
+
+#endif
@@ -0,0 +1,134 @@
+#include "core/renderer.h"
+
+#include <iostream>
+
+#ifndef HAS_VULKAN
+
+int main()
+{
+    std::cerr << "couldn't find Vulkan" << '\n';
+    return 1;
+}
+
+#else
+
+#include "engine.h"
+
+using Engine::Game;
+using Engine::Mesh;
+using Engine::Renderer;
+
+int terminate(Renderer* renderer, std::vector<Mesh>* meshes, int code)
+{
+    for (auto& mesh : *meshes)
+    {
+        renderer->destroyMesh(&mesh);
+    }
+
+    delete renderer;
+    return code;
+}
+
+// Fills the upload ring until createMesh() says it's full, then renders until the copies have
+// retired and checks there's room again, on the transfer queue if the device has one.
+int main()
+{
+    constexpr int version[] = {0, 1, 0};
+    const auto game = new Game("Test", version);
+    const auto renderer = new Renderer(game);
+    std::vector<Mesh> meshes;
+
+    // a few meshes fill it
+    constexpr uint32_t vertexCount = 4096;
+    constexpr uint32_t vertexStride = 16;
+    renderer->stagingSize = 8 * vertexCount * vertexStride;
+
+    const VkResult instResult = renderer->createInstance(0, nullptr);
+
+    if (instResult != VK_SUCCESS)
+    {
+        std::cerr << "failed to create renderer: " << instResult << '\n';
+        return terminate(renderer, &meshes, 1);
+    }
+
+    const VkResult devResult = renderer->createDevice(VK_NULL_HANDLE);
+
+    if (devResult != VK_SUCCESS)
+    {
+        std::cerr << "failed to create device (" << devResult << ')' << '\n';
+        return terminate(renderer, &meshes, 1);
+    }
+
+    const VkResult offscreenResult = renderer->createOffscreen(64, 64);
+
+    if (offscreenResult != VK_SUCCESS)
+    {
+        std::cerr << "failed to create offscreen targets (" << offscreenResult << ')' << '\n';
+        return terminate(renderer, &meshes, 1);
+    }
+
+    const std::vector<char> vertices(vertexCount * vertexStride, 1);
+    VkResult result = VK_SUCCESS;
+
+    while (result == VK_SUCCESS)
+    {
+        Mesh mesh{};
+        result = renderer->createMesh(vertices.data(), vertexCount, vertexStride, nullptr, 0, &mesh);
+
+        if (result == VK_SUCCESS)
+        {
+            meshes.push_back(mesh);
+        }
+
+        // the ring can't be bigger than what was asked for
+        if (meshes.size() > 8)
+        {
+            std::cerr << "staged more than the ring holds" << '\n';
+            return terminate(renderer, &meshes, 1);
+        }
+    }
+
+    if (result != VK_ERROR_OUT_OF_POOL_MEMORY || meshes.empty())
+    {
+        std::cerr << "failed to fill the ring (" << result << ')' << '\n';
+        return terminate(renderer, &meshes, 1);
+    }
+
+    std::cout << "filled the ring with " << meshes.size() << " meshes" << '\n';
+
+    // the copies go out with the first frame and retire a few frames later
+    constexpr uint32_t maxFrames = 16;
+
+    for (uint32_t i = 0; i < maxFrames; i++)
+    {
+        const VkResult renderResult = renderer->render();
+
+        if (renderResult != VK_SUCCESS)
+        {
+            std::cerr << "failed to render frame " << i << " (" << renderResult << ')' << '\n';
+            return terminate(renderer, &meshes, 1);
+        }
+
+        Mesh mesh{};
+        result = renderer->createMesh(vertices.data(), vertexCount, vertexStride, nullptr, 0, &mesh);
+
+        if (result == VK_SUCCESS)
+        {
+            meshes.push_back(mesh);
+            std::cout << "uploaded again after " << i + 1 << " frames" << '\n';
+
+            return terminate(renderer, &meshes, 0);
+        }
+
+        if (result != VK_ERROR_OUT_OF_POOL_MEMORY)
+        {
+            std::cerr << "failed to create mesh (" << result << ')' << '\n';
+            return terminate(renderer, &meshes, 1);
+        }
+    }
+
+    std::cerr << "the ring never freed up after " << maxFrames << " frames" << '\n';
+    return terminate(renderer, &meshes, 1);
+}
+
+#endif
@@ -0,0 +1,48 @@
+#include "loaders/loaders.h"
+
+#include <iomanip>
+#include <iostream>
+
+// imports a glTF model, optimizes it and writes it out as a mesh for Renderer::loadMesh()
+int main(const int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cerr << "usage: cook <model.gltf|model.glb> <mesh>" << '\n';
+        return 1;
+    }
+
+    Loaders::MeshData mesh;
+
+    if (!Loaders::importGltf(argv[1], &mesh))
+    {
+        std::cerr << "couldn't import " << argv[1] << '\n';
+        return 1;
+    }
+
+    const float before = Loaders::cacheMissRatio(mesh.indices, mesh.vertexCount());
+    const uint32_t vertices = mesh.vertexCount();
+
+    Loaders::optimizeMesh(&mesh);
+
+    std::vector<char> cooked;
+
+    if (!Loaders::writeMesh(mesh, &cooked))
+    {
+        std::cerr << argv[1] << " has no triangles" << '\n';
+        return 1;
+    }
+
+    if (!Loaders::writefile(cooked, argv[2]))
+    {
+        std::cerr << "couldn't write " << argv[2] << '\n';
+        return 1;
+    }
+
+    std::cout << std::fixed << std::setprecision(3)
+        << "cooked " << mesh.indices.size() / 3 << " triangles, " << vertices << " vertices welded to " << mesh.vertexCount()
+        << ", cache miss ratio " << before << " to " << Loaders::cacheMissRatio(mesh.indices, mesh.vertexCount())
+        << ", " << cooked.size() << " bytes" << '\n';
+
+    return 0;
+}
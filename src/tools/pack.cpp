@@ -0,0 +1,82 @@
+#include "loaders/loaders.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+// packs every file under a directory into an archive, named by their path relative to it
+int main(const int argc, char** argv)
+{
+    bool compress = false;
+    int first = 1;
+
+    if (argc > 1 && strcmp(argv[1], "-c") == 0)
+    {
+        compress = true;
+        first++;
+    }
+
+    if (argc - first != 2)
+    {
+        std::cerr << "usage: pack [-c] <archive> <directory>" << '\n';
+        return 1;
+    }
+
+    const std::filesystem::path output = std::filesystem::absolute(argv[first]).lexically_normal();
+    const std::filesystem::path directory = argv[first + 1];
+
+    std::error_code error;
+    std::vector<std::filesystem::path> files;
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error))
+    {
+        // an archive packed into itself would only contain the last one
+        if (entry.is_regular_file() && std::filesystem::absolute(entry.path()).lexically_normal() != output)
+        {
+            files.push_back(entry.path());
+        }
+    }
+
+    if (error)
+    {
+        std::cerr << "couldn't read " << directory << ": " << error.message() << '\n';
+        return 1;
+    }
+
+    // same input, same archive
+    std::sort(files.begin(), files.end());
+
+    Loaders::ArchiveWriter writer;
+
+    for (const auto& file : files)
+    {
+        writer.add(file.lexically_relative(directory).generic_string(), file.string(), compress);
+    }
+
+    if (!writer.write(argv[first]))
+    {
+        std::cerr << "couldn't write " << argv[first] << '\n';
+        return 1;
+    }
+
+    Loaders::Archive archive;
+
+    if (!archive.open(argv[first], true))
+    {
+        std::cerr << "wrote " << argv[first] << " but it doesn't read back" << '\n';
+        return 1;
+    }
+
+    uint64_t size = 0;
+    uint64_t stored = 0;
+
+    for (uint32_t i = 0; i < archive.size(); i++)
+    {
+        size += archive.entry(i).size;
+        stored += archive.entry(i).storedSize;
+    }
+
+    std::cout << "packed " << archive.size() << " files, " << size << " bytes into " << stored << '\n';
+    return 0;
+}